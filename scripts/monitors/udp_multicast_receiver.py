@@ -0,0 +1,225 @@
+#!/usr/bin/env python3
+"""
+udp_multicast_receiver.py
+Reference receiver for the UDP publisher in multicast mode
+
+Joins the group, delivers events in sequence order and recovers gaps by
+sending NACKs to the publisher (the source address of the datagrams).
+Sequence ranges the publisher no longer buffers are reported as lost.
+
+Usage:
+    python3 udp_multicast_receiver.py [group] [port] [--iface ADDR] [--drop N] [--quiet]
+
+Default: 239.1.1.1 9999
+--iface  IPv4 address of the interface to join on (default: any)
+--drop   Discard every Nth new datagram, to exercise recovery
+--quiet  Print only gaps, recoveries and the final summary
+"""
+
+import argparse
+import json
+import socket
+import struct
+import sys
+import time
+from datetime import datetime
+
+SEQ_MAGIC = b"BLSQ"
+NACK_MAGIC = b"BLNK"
+META_MAGIC = b"BLSH"
+SEQ_HEADER = struct.Struct("!4sBBHQQ")      # magic, version, flags, reserved, session, seq
+NACK = struct.Struct("!4sIQQI")             # magic, reserved, session, first, count
+
+FLAG_RETRANSMIT = 1
+FLAG_HEARTBEAT = 2
+FLAG_LOST = 4
+
+NACK_RETRY_SEC = 0.2
+MAX_NACK_COUNT = 1024
+
+
+def now():
+    return datetime.now().strftime('%H:%M:%S')
+
+
+class Receiver:
+    def __init__(self, sock, quiet):
+        self.sock = sock
+        self.quiet = quiet
+        self.session = None
+        self.sender = None
+        self.next_seq = None        # next sequence to deliver
+        self.pending = {}           # seq -> payload, received out of order
+        self.nacked = {}            # first missing seq -> time of last NACK
+        self.stats = dict(delivered=0, duplicates=0, recovered=0, lost=0, nacks=0)
+
+    def reset(self, session, sender, seq):
+        if self.session is not None:
+            print(f"[{now()}] Publisher restarted, new session {session:016x}")
+        self.session = session
+        self.sender = sender
+        self.next_seq = seq
+        self.pending.clear()
+        self.nacked.clear()
+
+    def deliver(self, seq, payload):
+        self.stats["delivered"] += 1
+        if self.quiet:
+            return
+        # Strip the optional metadata header, see udp_publisher.c
+        if payload[:4] == META_MAGIC and len(payload) >= 8:
+            payload = payload[struct.unpack("!H", payload[6:8])[0]:]
+        text = payload.decode("utf-8", errors="replace").rstrip("\n")
+        try:
+            event = json.loads(text)
+            print(f"[{now()}] #{seq} {event.get('type', '?')} "
+                  f"{event.get('db', '')}.{event.get('table', '')}")
+        except json.JSONDecodeError:
+            print(f"[{now()}] #{seq} {text[:200]}")
+
+    def drain(self):
+        while self.next_seq in self.pending:
+            self.deliver(self.next_seq, self.pending.pop(self.next_seq))
+            self.next_seq += 1
+        # Gaps below next_seq are closed
+        for first in [f for f in self.nacked if f < self.next_seq]:
+            del self.nacked[first]
+
+    def nack(self, first, last):
+        count = min(last - first + 1, MAX_NACK_COUNT)
+        if count <= 0:
+            return
+        sent = self.nacked.get(first)
+        if sent is not None and time.monotonic() - sent < NACK_RETRY_SEC:
+            return
+        self.nacked[first] = time.monotonic()
+        self.stats["nacks"] += 1
+        self.sock.sendto(NACK.pack(NACK_MAGIC, 0, self.session, first, count), self.sender)
+        print(f"[{now()}] Gap {first}..{first + count - 1}, NACK sent")
+
+    def missing_upto(self, last):
+        # First contiguous run of missing sequences at or after next_seq
+        first = self.next_seq
+        end = first
+        while end <= last and end not in self.pending:
+            end += 1
+        return first, end - 1
+
+    def request_gaps(self, last):
+        if self.next_seq is None or last < self.next_seq:
+            return
+        first, end = self.missing_upto(last)
+        self.nack(first, end)
+
+    def on_datagram(self, data, sender):
+        if len(data) < SEQ_HEADER.size:
+            return
+        magic, _version, flags, _res, session, seq = SEQ_HEADER.unpack_from(data)
+        if magic != SEQ_MAGIC:
+            return
+        payload = data[SEQ_HEADER.size:]
+
+        if session != self.session:
+            # Join at the first sequence seen, or right after a heartbeat
+            start = seq + 1 if flags & FLAG_HEARTBEAT else seq
+            self.reset(session, sender, max(start, 1))
+        self.sender = sender
+
+        if flags & FLAG_HEARTBEAT:
+            self.request_gaps(seq)
+            return
+
+        if flags & FLAG_LOST:
+            count = struct.unpack("!I", payload[:4])[0] if len(payload) >= 4 else 0
+            lost_end = seq + count
+            if lost_end > self.next_seq:
+                skipped = lost_end - max(seq, self.next_seq)
+                self.stats["lost"] += skipped
+                print(f"[{now()}] {skipped} event(s) from #{max(seq, self.next_seq)} "
+                      f"no longer buffered by the publisher, skipped")
+                if seq <= self.next_seq:
+                    self.next_seq = lost_end
+                    self.drain()
+            return
+
+        if seq < self.next_seq or seq in self.pending:
+            self.stats["duplicates"] += 1
+            return
+        if flags & FLAG_RETRANSMIT:
+            self.stats["recovered"] += 1
+        if seq == self.next_seq:
+            self.deliver(seq, payload)
+            self.next_seq += 1
+            self.drain()
+        else:
+            self.pending[seq] = payload
+            self.request_gaps(seq - 1)
+
+    def on_idle(self):
+        if self.pending:
+            self.request_gaps(max(self.pending) - 1)
+
+
+def open_socket(group, port, iface):
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM, socket.IPPROTO_UDP)
+    sock.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+    if hasattr(socket, "SO_REUSEPORT"):
+        sock.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEPORT, 1)
+    sock.bind(("", port))
+    mreq = struct.pack("4s4s", socket.inet_aton(group), socket.inet_aton(iface))
+    sock.setsockopt(socket.IPPROTO_IP, socket.IP_ADD_MEMBERSHIP, mreq)
+    sock.settimeout(NACK_RETRY_SEC)
+    return sock
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Binlog UDP multicast receiver")
+    parser.add_argument("group", nargs="?", default="239.1.1.1")
+    parser.add_argument("port", nargs="?", type=int, default=9999)
+    parser.add_argument("--iface", default="0.0.0.0")
+    parser.add_argument("--drop", type=int, default=0)
+    parser.add_argument("--quiet", action="store_true")
+    args = parser.parse_args()
+
+    print("=" * 60)
+    print("UDP Multicast Binlog Event Receiver")
+    print("=" * 60)
+    print(f"Group: {args.group}:{args.port}")
+    if args.drop:
+        print(f"Dropping every {args.drop}th datagram")
+    print("Press Ctrl+C to stop")
+    print("=" * 60)
+    print()
+
+    sock = open_socket(args.group, args.port, args.iface)
+    receiver = Receiver(sock, args.quiet)
+    received = 0
+
+    try:
+        while True:
+            try:
+                data, sender = sock.recvfrom(65535)
+            except socket.timeout:
+                receiver.on_idle()
+                continue
+            received += 1
+            retransmit = len(data) > 5 and data[5] & FLAG_RETRANSMIT
+            if args.drop and not retransmit and received % args.drop == 0:
+                continue
+            receiver.on_datagram(data, sender)
+    except KeyboardInterrupt:
+        pass
+    finally:
+        sock.close()
+
+    s = receiver.stats
+    print()
+    print("=" * 60)
+    print(f"Delivered {s['delivered']} event(s), recovered {s['recovered']}, "
+          f"lost {s['lost']}, duplicates {s['duplicates']}, NACKs {s['nacks']}")
+    print("=" * 60)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
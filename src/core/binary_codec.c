@@ -0,0 +1,253 @@
+// binary_codec.c
+// Binary column encoders, SHA-256 and content-addressed blob store
+
+#include "binary_codec.h"
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <tmmintrin.h>
+#define HAVE_SSSE3_BASE64 1
+#endif
+
+static const char b64_chars[] =
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+static const char hex_chars[] = "0123456789abcdef";
+
+// ============================================================================
+// BASE64
+// ============================================================================
+
+static size_t base64_encode_scalar(const unsigned char *src, size_t len, char *dst) {
+    char *out = dst;
+    size_t i = 0;
+
+    for (; i + 3 <= len; i += 3) {
+        uint32_t v = ((uint32_t)src[i] << 16) | ((uint32_t)src[i + 1] << 8) | src[i + 2];
+        *out++ = b64_chars[(v >> 18) & 0x3F];
+        *out++ = b64_chars[(v >> 12) & 0x3F];
+        *out++ = b64_chars[(v >> 6) & 0x3F];
+        *out++ = b64_chars[v & 0x3F];
+    }
+
+    if (i < len) {
+        uint32_t v = (uint32_t)src[i] << 16;
+        if (i + 1 < len) v |= (uint32_t)src[i + 1] << 8;
+        *out++ = b64_chars[(v >> 18) & 0x3F];
+        *out++ = b64_chars[(v >> 12) & 0x3F];
+        *out++ = (i + 1 < len) ? b64_chars[(v >> 6) & 0x3F] : '=';
+        *out++ = '=';
+    }
+
+    *out = '\0';
+    return out - dst;
+}
+
+#ifdef HAVE_SSSE3_BASE64
+// Split 12 input bytes into 16 6-bit indices, one per byte lane
+__attribute__((target("ssse3")))
+static inline __m128i b64_reshuffle(__m128i in) {
+    in = _mm_shuffle_epi8(in, _mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7,
+                                           4, 5, 3, 4, 1, 2, 0, 1));
+    const __m128i t0 = _mm_and_si128(in, _mm_set1_epi32(0x0fc0fc00));
+    const __m128i t1 = _mm_mulhi_epu16(t0, _mm_set1_epi32(0x04000040));
+    const __m128i t2 = _mm_and_si128(in, _mm_set1_epi32(0x003f03f0));
+    const __m128i t3 = _mm_mullo_epi16(t2, _mm_set1_epi32(0x01000010));
+    return _mm_or_si128(t1, t3);
+}
+
+// Map 6-bit indices to the base64 alphabet by adding a per-range offset
+__attribute__((target("ssse3")))
+static inline __m128i b64_translate(__m128i in) {
+    const __m128i lut = _mm_setr_epi8(65, 71, -4, -4, -4, -4, -4, -4,
+                                      -4, -4, -4, -4, -19, -16, 0, 0);
+    __m128i idx = _mm_subs_epu8(in, _mm_set1_epi8(51));
+    __m128i mask = _mm_cmpgt_epi8(in, _mm_set1_epi8(25));
+    idx = _mm_sub_epi8(idx, mask);
+    return _mm_add_epi8(in, _mm_shuffle_epi8(lut, idx));
+}
+
+__attribute__((target("ssse3")))
+static size_t base64_encode_ssse3(const unsigned char *src, size_t len, char *dst) {
+    char *out = dst;
+
+    // Each step consumes 12 bytes but loads 16, so stop while 16 remain
+    while (len >= 16) {
+        __m128i in = _mm_loadu_si128((const __m128i *)src);
+        _mm_storeu_si128((__m128i *)out, b64_translate(b64_reshuffle(in)));
+        src += 12;
+        len -= 12;
+        out += 16;
+    }
+
+    return (out - dst) + base64_encode_scalar(src, len, out);
+}
+
+static int cpu_has_ssse3(void) {
+    static int cached = -1;
+    if (cached < 0) {
+        __builtin_cpu_init();
+        cached = __builtin_cpu_supports("ssse3") ? 1 : 0;
+    }
+    return cached;
+}
+#endif
+
+size_t base64_encode(const unsigned char *src, size_t len, char *dst) {
+#ifdef HAVE_SSSE3_BASE64
+    if (len >= 16 && cpu_has_ssse3()) {
+        return base64_encode_ssse3(src, len, dst);
+    }
+#endif
+    return base64_encode_scalar(src, len, dst);
+}
+
+const char* base64_impl_name(void) {
+#ifdef HAVE_SSSE3_BASE64
+    if (cpu_has_ssse3()) return "ssse3";
+#endif
+    return "scalar";
+}
+
+// ============================================================================
+// HEX
+// ============================================================================
+
+size_t hex_encode(const unsigned char *src, size_t len, char *dst) {
+    for (size_t i = 0; i < len; i++) {
+        dst[2 * i]     = hex_chars[src[i] >> 4];
+        dst[2 * i + 1] = hex_chars[src[i] & 0x0F];
+    }
+    dst[2 * len] = '\0';
+    return 2 * len;
+}
+
+// ============================================================================
+// SHA-256 (FIPS 180-4)
+// ============================================================================
+
+static const uint32_t sha256_k[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+#define ROTR32(x, n) (((x) >> (n)) | ((x) << (32 - (n))))
+
+static void sha256_block(uint32_t h[8], const unsigned char *blk) {
+    uint32_t w[64];
+    for (int i = 0; i < 16; i++) {
+        w[i] = ((uint32_t)blk[4 * i] << 24) | ((uint32_t)blk[4 * i + 1] << 16) |
+               ((uint32_t)blk[4 * i + 2] << 8) | (uint32_t)blk[4 * i + 3];
+    }
+    for (int i = 16; i < 64; i++) {
+        uint32_t s0 = ROTR32(w[i - 15], 7) ^ ROTR32(w[i - 15], 18) ^ (w[i - 15] >> 3);
+        uint32_t s1 = ROTR32(w[i - 2], 17) ^ ROTR32(w[i - 2], 19) ^ (w[i - 2] >> 10);
+        w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+    }
+
+    uint32_t a = h[0], b = h[1], c = h[2], d = h[3];
+    uint32_t e = h[4], f = h[5], g = h[6], k = h[7];
+
+    for (int i = 0; i < 64; i++) {
+        uint32_t S1 = ROTR32(e, 6) ^ ROTR32(e, 11) ^ ROTR32(e, 25);
+        uint32_t ch = (e & f) ^ (~e & g);
+        uint32_t t1 = k + S1 + ch + sha256_k[i] + w[i];
+        uint32_t S0 = ROTR32(a, 2) ^ ROTR32(a, 13) ^ ROTR32(a, 22);
+        uint32_t mj = (a & b) ^ (a & c) ^ (b & c);
+        uint32_t t2 = S0 + mj;
+        k = g; g = f; f = e; e = d + t1;
+        d = c; c = b; b = a; a = t1 + t2;
+    }
+
+    h[0] += a; h[1] += b; h[2] += c; h[3] += d;
+    h[4] += e; h[5] += f; h[6] += g; h[7] += k;
+}
+
+void sha256(const void *data, size_t len, unsigned char out[SHA256_DIGEST_LEN]) {
+    uint32_t h[8] = {
+        0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+        0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+    };
+    const unsigned char *p = data;
+    size_t left = len;
+
+    while (left >= 64) {
+        sha256_block(h, p);
+        p += 64;
+        left -= 64;
+    }
+
+    // Final block(s): remaining bytes, 0x80, zero pad, 64-bit bit length
+    unsigned char tail[128] = {0};
+    memcpy(tail, p, left);
+    tail[left] = 0x80;
+    size_t tail_len = (left < 56) ? 64 : 128;
+    uint64_t bits = (uint64_t)len * 8;
+    for (int i = 0; i < 8; i++) {
+        tail[tail_len - 1 - i] = (unsigned char)(bits >> (8 * i));
+    }
+    sha256_block(h, tail);
+    if (tail_len == 128) sha256_block(h, tail + 64);
+
+    for (int i = 0; i < 8; i++) {
+        out[4 * i]     = (unsigned char)(h[i] >> 24);
+        out[4 * i + 1] = (unsigned char)(h[i] >> 16);
+        out[4 * i + 2] = (unsigned char)(h[i] >> 8);
+        out[4 * i + 3] = (unsigned char)h[i];
+    }
+}
+
+// ============================================================================
+// BLOB STORE
+// ============================================================================
+
+int blob_store_put(const char *dir, const unsigned char *data, size_t len,
+                   char hex_out[SHA256_HEX_LEN + 1]) {
+    unsigned char digest[SHA256_DIGEST_LEN];
+    sha256(data, len, digest);
+    hex_encode(digest, SHA256_DIGEST_LEN, hex_out);
+
+    if (!dir || !dir[0]) return -1;
+
+    char path[1024];
+    snprintf(path, sizeof(path), "%s/%.2s", dir, hex_out);
+    if (mkdir(dir, 0755) != 0 && errno != EEXIST) return -1;
+    if (mkdir(path, 0755) != 0 && errno != EEXIST) return -1;
+
+    snprintf(path, sizeof(path), "%s/%.2s/%s", dir, hex_out, hex_out);
+
+    // Content addressed: an existing file already holds these bytes
+    if (access(path, F_OK) == 0) return 0;
+
+    char tmp[1100];
+    snprintf(tmp, sizeof(tmp), "%s.tmp.%d", path, (int)getpid());
+
+    FILE *fp = fopen(tmp, "wb");
+    if (!fp) return -1;
+    if (len > 0 && fwrite(data, 1, len, fp) != len) {
+        fclose(fp);
+        unlink(tmp);
+        return -1;
+    }
+    if (fclose(fp) != 0) {
+        unlink(tmp);
+        return -1;
+    }
+
+    if (rename(tmp, path) != 0) {
+        unlink(tmp);
+        return -1;
+    }
+    return 0;
+}
@@ -2,8 +2,8 @@
 // MySQL/MariaDB binlog streamer with modular publisher plugin system
 //
 // Build:
-//   gcc -O2 -Wall binlog_stream_modular.c publisher_loader.c logger.c -o binlog_stream 
-//       -lmysqlclient -lz -luuid -ljson-c -lpthread -ldl
+//   gcc -O2 -Wall binlog_stream_modular.c publisher_loader.c logger.c binary_codec.c -o binlog_stream 
+//       -lmysqlclient -lz -ljson-c -lpthread -ldl
 
 #include <mysql/mysql.h>
 #include <stdint.h>
@@ -16,16 +16,26 @@
 #include <time.h>
 #include <signal.h>
 #include <sys/socket.h>
-#include <uuid/uuid.h>
 #include <json-c/json.h>
 #include <stdarg.h>
 #include <pthread.h>
 #include <errno.h>
 #include <ctype.h>
+#include <fnmatch.h>
+#include <regex.h>
 #include "banner.h"
 
 #include "logger.h"
 #include "publisher_loader.h"
+#include "binary_codec.h"
+#include "metrics.h"
+#include "plugin_host.h"
+#include "column_batch.h"
+#include "lookup_cache.h"
+#include "json_binary.h"
+#include "stage_profiler.h"
+#include "schema_resolver.h"
+#include "control_server.h"
 
 // Event types
 #define EVT_QUERY_EVENT            2
@@ -33,12 +43,17 @@
 #define EVT_FORMAT_DESCRIPTION    15
 #define EVT_XID                   16
 #define EVT_TABLE_MAP             19
+#define EVT_HEARTBEAT             27
 #define EVT_WRITE_ROWSv1          23
 #define EVT_UPDATE_ROWSv1         24
 #define EVT_DELETE_ROWSv1         25
 #define EVT_WRITE_ROWSv2          30
 #define EVT_UPDATE_ROWSv2         31
 #define EVT_DELETE_ROWSv2         32
+#define EVT_GTID                  33
+#define EVT_ANONYMOUS_GTID        34
+#define EVT_HEARTBEAT_V2          35
+#define EVT_PARTIAL_UPDATE_ROWS   39
 #define EVT_MARIA_GTID                    162
 #define EVT_MARIA_WRITE_ROWS_COMPRESSED   166
 #define EVT_MARIA_UPDATE_ROWS_COMPRESSED  167
@@ -65,6 +80,7 @@
 #define MT_TIMESTAMP2  17
 #define MT_DATETIME2   18
 #define MT_TIME2       19
+#define MT_JSON       245
 #define MT_NEWDECIMAL 246
 #define MT_ENUM       247
 #define MT_SET        248
@@ -83,26 +99,110 @@ typedef struct {
     int index;
 } column_info_t;
 
+#define BINARY_MODE_BASE64   0   // full value, base64 string
+#define BINARY_MODE_HEX      1   // full value, hex string
+#define BINARY_MODE_PREVIEW  2   // first preview_bytes, marked as truncated
+#define BINARY_MODE_SPILL    3   // > spill_threshold goes to the blob store
+
+#define MYSQL_BINARY_CHARSET 63
+
+#define PARTIAL_JSON_FULL    0   // rebuild the document from the before image
+#define PARTIAL_JSON_PATCH   1   // always {"json_patch":[...]} (RFC 6902 ops)
+
+// Output options for BLOB/GEOMETRY columns
+typedef struct {
+    char name[128];                 // column name (per-column overrides only)
+    int mode;
+    uint32_t preview_bytes;
+    uint32_t spill_threshold;
+    int is_default;                 // global default, applies to binary charset only
+} binary_column_t;
+
+#define ENRICH_MAX_RULES   8        // per captured table
+#define ENRICH_KEY_MAX     256      // longest join key, as JSON text
+#define ENRICH_MAX_COLUMNS 32       // added columns per rule
+
+// Enrichment: add columns of a lookup table to each row, joined on one
+// column. The lookup table is cached in a hash index, loaded once through
+// the metadata connection and kept current from its own rows events.
+typedef struct {
+    char column[128];               // join column in the captured table
+    char src_db[128];               // lookup table
+    char src_tbl[128];
+    char key[128];                  // its key column
+    char **columns;                 // its columns added to each row
+    int column_count;
+    char prefix[64];                // prepended to the added column names
+    lookup_cache_t *cache;          // key -> JSON value of each column
+    uint64_t src_generation;        // lookup table map the indexes below belong to
+    int *src_idx;                   // [0] key, [1..] columns; -1 = missing
+} enrich_rule_t;
+
+// Capture name: exact, a glob ("orders_*") or a POSIX extended regex
+// written between slashes ("/^orders_[0-9]{4}$/")
+#define NAME_EXACT  0
+#define NAME_GLOB   1
+#define NAME_REGEX  2
+
+typedef struct {
+    int kind;
+    regex_t re;                     // NAME_REGEX only
+} name_pattern_t;
+
 // Table configuration
 typedef struct {
     char name[128];
+    name_pattern_t match;
     //char primary_key[128];
     char **primary_keys;
     int pk_count;
     column_info_t *columns;
     int column_count;
     int capture_all_columns;
+    binary_column_t *binary_columns;
+    int binary_column_count;
+    enrich_rule_t *enrich;
+    int enrich_count;
+    int priority;                   // PUBLISHER_PRIORITY_* used for load shedding
 } table_config_t;
 
 // Database configuration
 typedef struct {
     char name[128];
+    name_pattern_t match;
     int capture_dml;
     int capture_ddl;
     table_config_t *tables;
     int table_count;
 } database_config_t;
 
+// Output profile table projection
+typedef struct {
+    char db[128];
+    char tbl[128];
+    char **columns;
+    int column_count;
+    uint64_t map_generation;        // table map the names below belong to
+    const char **names;             // projected name by column index, NULL = excluded
+} profile_table_t;
+
+#define PROFILE_FORMAT_OBJECT     0   // rows as {"col":value}
+#define PROFILE_FORMAT_ARRAY      1   // rows as [value,...] plus a "columns" list
+#define PROFILE_FORMAT_COLUMNAR   2   // typed column vectors via publish_columnar
+
+#define PROFILE_ENVELOPE_FULL     0   // type, txn, db, table, primary_key, rows
+#define PROFILE_ENVELOPE_MINIMAL  1   // type, db, table, rows
+
+// Output profile: how a publisher wants rows encoded. Publishers declaring
+// identical profiles share one registry entry and therefore one encoding.
+typedef struct {
+    char *key;                      // canonical form used for de-duplication
+    int format;
+    int envelope;
+    profile_table_t *tables;
+    int table_count;
+} output_profile_t;
+
 // Main configuration
 typedef struct {
     const char *log_level;
@@ -121,14 +221,39 @@ typedef struct {
     int server_id;
     char binlog_file[256];
     int64_t binlog_position;
+    int64_t start_time;             // epoch seconds to seek to, 0 = unset
     int save_last_position;
     uint64_t save_position_event_count;
     char checkpoint_file[512];
 
+    char metrics_file[512];         // Prometheus text file, empty = disabled
+    int metrics_interval;
+    int profiling_enabled;          // per-stage timing and thread CPU
+    int profiling_interval;         // seconds between summary lines
+    int startup_threads;            // publisher load/start threads, 0 = one each
+    int startup_timeout_ms;         // max wait for critical publishers, 0 = no limit
+    char control_socket[108];       // watermark / WAIT_FOR socket, empty = disabled
+    int control_max_clients;
+    int control_mode;               // socket file permissions, 0 = 0600
+    int watermark_interval_ms;      // WATERMARK events to opted-in publishers, 0 = off
+
     publisher_manager_t *publisher_manager;
 
     database_config_t *databases;
     int database_count;
+    int capture_patterns;           // any database or table name is a pattern
+
+    output_profile_t *profiles;     // [0] is the default profile
+    int profile_count;
+
+    binary_column_t binary;         // default BLOB/GEOMETRY output
+    char blob_store_dir[512];       // spill target, empty = no spill
+
+    int partial_json;               // PARTIAL_JSON_* output of partial JSON updates
+    int coalesce_max_rows;          // merge consecutive rows events, 0 = off
+    int schema_threads;             // async schema resolver threads, 0 = inline
+    int schema_max_parked;          // parked rows events before the stream waits
+    size_t coalesce_max_bytes;      // upper bound of one merged message
 
 } config_t;
 
@@ -146,8 +271,21 @@ static char current_binlog[256] = "";
 static uint64_t current_position = 4;
 static uint64_t events_received = 0;
 static uint64_t events_since_save = 0;
-static char current_txn_id[37] = "";
+// "<server uuid>:<gno>" is the longest form (57 chars)
+#define TXN_ID_MAX 64
+
+static char current_txn_id[TXN_ID_MAX] = "";
 static int in_transaction = 0;
+static char pending_gtid_txn[TXN_ID_MAX] = "";  // from the GTID event announcing the next txn
+static uint32_t current_server_id = 0;          // header of the event being parsed
+static uint64_t current_event_start = 0;        // its position in current_binlog
+static uint64_t txn_start_position = 0;         // where the current txn can be read again:
+static int txn_start_pinned = 0;                // its GTID event, else its first event
+static uint32_t current_event_time = 0;         // its header timestamp
+static int64_t txn_last_committed = 0;          // MySQL logical clock of the
+static int64_t txn_sequence_number = 0;         // current txn, 0 = unknown
+static const char *current_event_type = NULL;   // routing metadata of the message
+static const char *current_event_key = NULL;    // being published, see cdc_event_t
 
 static config_t g_config;
 static pthread_mutex_t checkpoint_mutex = PTHREAD_MUTEX_INITIALIZER;
@@ -162,22 +300,30 @@ typedef struct {
     uint16_t *metadata;
     unsigned char *real_types;
     char **column_names;
+    uint32_t column_name_count;     // entries in column_names
     int column_names_fetched;
+    int schema_pending;             // column names not resolved yet, rows are parked
+    const char **include_names;     // captured name by column index, NULL = skipped
+    unsigned char *column_binary;   // 1 = binary charset (BLOB, not TEXT)
+    unsigned char *column_unsigned; // 1 = UNSIGNED integer column
+    const binary_column_t **binary_opts; // output options by column index
+    int captured;                   // rows go to publishers
+    int lookup_source;              // rows refresh enrichment caches
+    int priority;                   // PUBLISHER_PRIORITY_* of the table
+    database_config_t *db_cfg;      // capture config of db / tbl, NULL = none
+    table_config_t *tbl_cfg;
+    int join_idx[ENRICH_MAX_RULES]; // join column of each tbl_cfg enrich rule, -1 = missing
 } table_map_t;
 
-static table_map_t g_map = {0, "", "", 0, NULL, NULL, NULL, NULL, 0};
+static table_map_t g_map = {0, "", "", 0, NULL, NULL, NULL, NULL, 0, 0, 0, NULL, NULL, NULL,
+                            NULL, 0, 0, 0, NULL, NULL};
+static uint64_t g_map_generation = 0;   // bumped whenever g_map column names are rebuilt
 static enum_cache_t *g_enum_cache = NULL;
 
 // ============================================================================
 // BASIC UTILS
 // ============================================================================
 
-static void generate_txn_id(char *out) {
-    uuid_t uuid;
-    uuid_generate(uuid);
-    uuid_unparse_lower(uuid, out);
-}
-
 static uint16_t le16(const unsigned char *p){
     return (uint16_t)p[0] | ((uint16_t)p[1] << 8);
 }
@@ -196,6 +342,107 @@ static uint64_t le64(const unsigned char *p){
     for (int i = 7; i >= 0; --i) v = (v << 8) | p[i];
     return v;
 }
+
+static const char hex_digits[] = "0123456789abcdef";
+
+static char* put_hex(char *out, uint64_t v, int width) {
+    for (int i = width - 1; i >= 0; i--) {
+        out[i] = hex_digits[v & 0xF];
+        v >>= 4;
+    }
+    return out + width;
+}
+
+static char* put_dec(char *out, uint64_t v) {
+    char tmp[20];
+    int n = 0;
+    do {
+        tmp[n++] = (char)('0' + v % 10);
+        v /= 10;
+    } while (v);
+    while (n) *out++ = tmp[--n];
+    return out;
+}
+
+// Transaction id for the transaction starting at the current event. The
+// GTID is used when the server sent one; otherwise the id is derived from
+// the binlog coordinates, "<server_id>-<file index>-<start pos>" in fixed
+// width hex. Either way a replay produces the same id.
+static void generate_txn_id(char *out) {
+    if (pending_gtid_txn[0]) {
+        memcpy(out, pending_gtid_txn, TXN_ID_MAX);
+        return;
+    }
+
+    char *p = out;
+    p = put_hex(p, current_server_id, 8);
+    *p++ = '-';
+    p = put_hex(p, (uint32_t)publisher_binlog_file_index(current_binlog), 6);
+    *p++ = '-';
+    p = put_hex(p, current_event_start, 16);
+    *p = '\0';
+}
+
+// Logical clock of (ANONYMOUS_)GTID_LOG_EVENT: ... lt_type(1)
+// last_committed(8) sequence_number(8), present since MySQL 5.7
+#define LOGICAL_TIMESTAMP_TYPECODE 2
+
+static void parse_logical_clock(const unsigned char *p, uint32_t len) {
+    txn_last_committed = 0;
+    txn_sequence_number = 0;
+    if (len < 42 || p[25] != LOGICAL_TIMESTAMP_TYPECODE) return;
+
+    txn_last_committed = (int64_t)le64(p + 26);
+    txn_sequence_number = (int64_t)le64(p + 34);
+}
+
+// MySQL GTID_LOG_EVENT: flags(1) sid(16) gno(8) ...
+static void parse_gtid(const unsigned char *p, uint32_t len) {
+    if (len < 25) return;
+
+    parse_logical_clock(p, len);
+
+    const unsigned char *sid = p + 1;
+    uint64_t gno = le64(p + 17);
+
+    char *o = pending_gtid_txn;
+    for (int i = 0; i < 16; i++) {
+        if (i == 4 || i == 6 || i == 8 || i == 10) *o++ = '-';
+        *o++ = hex_digits[sid[i] >> 4];
+        *o++ = hex_digits[sid[i] & 0xF];
+    }
+    *o++ = ':';
+    o = put_dec(o, gno);
+    *o = '\0';
+}
+
+// MariaDB GTID_EVENT: seq_no(8) domain_id(4) flags(1) ..., server id from header
+static void parse_maria_gtid(const unsigned char *p, uint32_t len) {
+    if (len < 12) return;
+
+    uint64_t seq_no = le64(p);
+    uint32_t domain_id = le32(p + 8);
+
+    char *o = pending_gtid_txn;
+    o = put_dec(o, domain_id);
+    *o++ = '-';
+    o = put_dec(o, current_server_id);
+    *o++ = '-';
+    o = put_dec(o, seq_no);
+    *o = '\0';
+}
+
+static void publish_progress(void);
+
+static void end_transaction(void) {
+    publish_progress();
+    in_transaction = 0;
+    txn_start_pinned = 0;
+    current_txn_id[0] = '\0';
+    pending_gtid_txn[0] = '\0';
+    txn_last_committed = 0;
+    txn_sequence_number = 0;
+}
 static int bit_get(const unsigned char *bits, int idx){
     return (bits[idx >> 3] >> (idx & 7)) & 1;
 }
@@ -253,36 +500,78 @@ static void free_enum_cache(void) {
 // CONFIG HELPERS
 // ============================================================================
 
+// Classify name and compile it if it is a regex. Names that do not fit the
+// size bytes of the config field are refused: a cut pattern would match
+// other tables than the one configured.
+static int compile_name_pattern(const char *name, size_t size, name_pattern_t *m) {
+    size_t len = strlen(name);
+    m->kind = NAME_EXACT;
+    if(len >= size) {
+        log_error("Capture name or pattern longer than %zu characters: %s", size - 1, name);
+        return -1;
+    }
+    if(len >= 2 && name[0] == '/' && name[len - 1] == '/') {
+        char expr[len - 1];
+        snprintf(expr, sizeof(expr), "%.*s", (int)(len - 2), name + 1);
+        int rc = regcomp(&m->re, expr, REG_EXTENDED | REG_NOSUB);
+        if(rc != 0) {
+            char err[128];
+            regerror(rc, &m->re, err, sizeof(err));
+            log_error("Invalid capture pattern %s: %s", name, err);
+            return -1;
+        }
+        m->kind = NAME_REGEX;
+    } else if(strpbrk(name, "*?[")) {
+        m->kind = NAME_GLOB;
+    }
+    return 0;
+}
+
+static void free_name_pattern(name_pattern_t *m) {
+    if(m->kind == NAME_REGEX) regfree(&m->re);
+    m->kind = NAME_EXACT;
+}
+
+static int name_pattern_match(const name_pattern_t *m, const char *pattern, const char *name) {
+    if(m->kind == NAME_GLOB) return fnmatch(pattern, name, 0) == 0;
+    if(m->kind == NAME_REGEX) return regexec(&m->re, name, 0, NULL, 0) == 0;
+    return 0;
+}
+
+// Exact names win; otherwise the first matching pattern in config order.
+// Not for the rows path: parse_table_map memoizes the result per table id.
 static database_config_t* find_database_config(const char *db) {
     for(int i = 0; i < g_config.database_count; i++) {
-        if(strcmp(g_config.databases[i].name, db) == 0) {
+        if(g_config.databases[i].match.kind == NAME_EXACT &&
+           strcmp(g_config.databases[i].name, db) == 0) {
             return &g_config.databases[i];
         }
     }
+    if(!g_config.capture_patterns) return NULL;
+    for(int i = 0; i < g_config.database_count; i++) {
+        database_config_t *db_cfg = &g_config.databases[i];
+        if(name_pattern_match(&db_cfg->match, db_cfg->name, db)) return db_cfg;
+    }
     return NULL;
 }
 
-static table_config_t* find_table_config(const char *db, const char *table) {
-    database_config_t *db_cfg = find_database_config(db);
+static table_config_t* find_table_in(database_config_t *db_cfg, const char *table) {
     if(!db_cfg) return NULL;
 
     for(int i = 0; i < db_cfg->table_count; i++) {
-        if(strcmp(db_cfg->tables[i].name, table) == 0) {
+        if(db_cfg->tables[i].match.kind == NAME_EXACT &&
+           strcmp(db_cfg->tables[i].name, table) == 0) {
             return &db_cfg->tables[i];
         }
     }
+    if(!g_config.capture_patterns) return NULL;
+    for(int i = 0; i < db_cfg->table_count; i++) {
+        table_config_t *tbl_cfg = &db_cfg->tables[i];
+        if(name_pattern_match(&tbl_cfg->match, tbl_cfg->name, table)) return tbl_cfg;
+    }
     return NULL;
 }
 
-static int should_capture_table(const char *db, const char *table) {
-    return find_table_config(db, table) != NULL;
-}
-
-static int should_capture_dml(const char *db) {
-    database_config_t *db_cfg = find_database_config(db);
-    return db_cfg ? db_cfg->capture_dml : 0;
-}
-
 static int should_capture_ddl(const char *db) {
     database_config_t *db_cfg = find_database_config(db);
     return db_cfg ? db_cfg->capture_ddl : 0;
@@ -298,6 +587,351 @@ static int parse_log_level(const char *str) {
     return LOG_INFO;
 }
 
+// ============================================================================
+// OUTPUT PROFILES
+// ============================================================================
+
+static void free_output_profile(output_profile_t *prof) {
+    free(prof->key);
+    for (int i = 0; i < prof->table_count; i++) {
+        profile_table_t *pt = &prof->tables[i];
+        for (int j = 0; j < pt->column_count; j++) free(pt->columns[j]);
+        free(pt->columns);
+        free(pt->names);
+    }
+    free(prof->tables);
+    memset(prof, 0, sizeof(*prof));
+}
+
+// Parse an "output_profile" object into prof and build its canonical key
+static int parse_output_profile(json_object *obj, output_profile_t *prof) {
+    memset(prof, 0, sizeof(*prof));
+
+    if (obj) {
+        json_object *format = json_object_object_get(obj, "format");
+        if (format) {
+            const char *f = json_object_get_string(format);
+            if (strcasecmp(f, "array") == 0) prof->format = PROFILE_FORMAT_ARRAY;
+            else if (strcasecmp(f, "columnar") == 0) prof->format = PROFILE_FORMAT_COLUMNAR;
+            else if (strcasecmp(f, "object") != 0 && strcasecmp(f, "json") != 0)
+                log_warn("Unknown output_profile format '%s', using object", f);
+        }
+
+        json_object *envelope = json_object_object_get(obj, "envelope");
+        if (envelope) {
+            const char *e = json_object_get_string(envelope);
+            if (strcasecmp(e, "minimal") == 0) prof->envelope = PROFILE_ENVELOPE_MINIMAL;
+            else if (strcasecmp(e, "full") != 0)
+                log_warn("Unknown output_profile envelope '%s', using full", e);
+        }
+
+        json_object *columns = json_object_object_get(obj, "columns");
+        if (columns && json_object_is_type(columns, json_type_object)) {
+            int count = 0;
+            json_object_object_foreach(columns, k0, v0) { (void)k0; (void)v0; count++; }
+            prof->tables = calloc(count ? count : 1, sizeof(profile_table_t));
+            if (!prof->tables) return -1;
+
+            json_object_object_foreach(columns, name, cols) {
+                const char *dot = strchr(name, '.');
+                if (!dot || !json_object_is_type(cols, json_type_array)) {
+                    log_warn("output_profile columns key '%s' must be \"db.table\": [columns]", name);
+                    continue;
+                }
+                profile_table_t *pt = &prof->tables[prof->table_count++];
+                snprintf(pt->db, sizeof(pt->db), "%.*s", (int)(dot - name), name);
+                snprintf(pt->tbl, sizeof(pt->tbl), "%s", dot + 1);
+                pt->column_count = json_object_array_length(cols);
+                pt->columns = calloc(pt->column_count ? pt->column_count : 1, sizeof(char*));
+                for (int i = 0; i < pt->column_count; i++) {
+                    pt->columns[i] = strdup(json_object_get_string(json_object_array_get_idx(cols, i)));
+                }
+            }
+        }
+    }
+
+    // Canonical key: format|envelope|db.tbl:c1,c2;...
+    size_t cap = 64;
+    for (int i = 0; i < prof->table_count; i++) {
+        cap += strlen(prof->tables[i].db) + strlen(prof->tables[i].tbl) + 3;
+        for (int j = 0; j < prof->tables[i].column_count; j++)
+            cap += strlen(prof->tables[i].columns[j]) + 1;
+    }
+    prof->key = malloc(cap);
+    if (!prof->key) return -1;
+    size_t off = snprintf(prof->key, cap, "%d|%d|", prof->format, prof->envelope);
+    for (int i = 0; i < prof->table_count; i++) {
+        profile_table_t *pt = &prof->tables[i];
+        off += snprintf(prof->key + off, cap - off, "%s.%s:", pt->db, pt->tbl);
+        for (int j = 0; j < pt->column_count; j++)
+            off += snprintf(prof->key + off, cap - off, "%s,", pt->columns[j]);
+        off += snprintf(prof->key + off, cap - off, ";");
+    }
+    return 0;
+}
+
+// Register a profile and return its id; identical profiles share an id
+static int register_output_profile(config_t *cfg, json_object *obj) {
+    output_profile_t prof;
+    if (parse_output_profile(obj, &prof) != 0) {
+        free_output_profile(&prof);
+        return 0;
+    }
+
+    for (int i = 0; i < cfg->profile_count; i++) {
+        if (strcmp(cfg->profiles[i].key, prof.key) == 0) {
+            free_output_profile(&prof);
+            return i;
+        }
+    }
+
+    output_profile_t *np = realloc(cfg->profiles, (cfg->profile_count + 1) * sizeof(output_profile_t));
+    if (!np) {
+        free_output_profile(&prof);
+        return 0;
+    }
+    cfg->profiles = np;
+    cfg->profiles[cfg->profile_count] = prof;
+    log_debug("Registered output profile %d: %s", cfg->profile_count, prof.key);
+    return cfg->profile_count++;
+}
+
+// Column names for the current table map as seen through a profile
+static const char** profile_projection(output_profile_t *prof) {
+    profile_table_t *pt = NULL;
+    for (int i = 0; i < prof->table_count; i++) {
+        if (strcmp(prof->tables[i].db, g_map.db) == 0 &&
+            strcmp(prof->tables[i].tbl, g_map.tbl) == 0) {
+            pt = &prof->tables[i];
+            break;
+        }
+    }
+    if (!pt || !g_map.include_names) return g_map.include_names;
+
+    if (pt->names && pt->map_generation == g_map_generation) {
+        return pt->names;
+    }
+
+    free(pt->names);
+    pt->names = calloc(g_map.ncols ? g_map.ncols : 1, sizeof(char*));
+    if (!pt->names) return g_map.include_names;
+
+    for (int j = 0; j < pt->column_count; j++) {
+        int found = 0;
+        for (uint32_t i = 0; i < g_map.ncols; i++) {
+            if (g_map.include_names[i] && strcmp(g_map.include_names[i], pt->columns[j]) == 0) {
+                pt->names[i] = g_map.include_names[i];
+                found = 1;
+                break;
+            }
+        }
+        if (!found) {
+            log_warn("Output profile column %s.%s.%s is not captured",
+                     pt->db, pt->tbl, pt->columns[j]);
+        }
+    }
+    pt->map_generation = g_map_generation;
+    return pt->names;
+}
+
+// ============================================================================
+// BINARY COLUMN OPTIONS
+// ============================================================================
+
+static int parse_binary_mode(const char *mode) {
+    if (!mode) return BINARY_MODE_BASE64;
+    if (strcasecmp(mode, "base64") == 0) return BINARY_MODE_BASE64;
+    if (strcasecmp(mode, "hex") == 0) return BINARY_MODE_HEX;
+    if (strcasecmp(mode, "preview") == 0) return BINARY_MODE_PREVIEW;
+    if (strcasecmp(mode, "spill") == 0) return BINARY_MODE_SPILL;
+    log_warn("Unknown binary mode '%s', using base64", mode);
+    return BINARY_MODE_BASE64;
+}
+
+// Accepts "mode" or {"mode":..., "preview_bytes":N, "spill_threshold":N};
+// unset fields inherit from base
+static void parse_binary_column(json_object *obj, const binary_column_t *base,
+                                binary_column_t *out) {
+    char name[sizeof(out->name)];
+    memcpy(name, out->name, sizeof(name));
+    *out = *base;
+    memcpy(out->name, name, sizeof(name));
+    out->is_default = 0;
+
+    if (json_object_is_type(obj, json_type_string)) {
+        out->mode = parse_binary_mode(json_object_get_string(obj));
+        return;
+    }
+
+    json_object *mode = json_object_object_get(obj, "mode");
+    if (mode) out->mode = parse_binary_mode(json_object_get_string(mode));
+
+    json_object *preview = json_object_object_get(obj, "preview_bytes");
+    if (preview) out->preview_bytes = json_object_get_int(preview);
+
+    json_object *threshold = json_object_object_get(obj, "spill_threshold");
+    if (threshold) out->spill_threshold = json_object_get_int(threshold);
+}
+
+// Output options for a BLOB/GEOMETRY column of the current table map
+static const binary_column_t* resolve_binary_column(table_config_t *tbl_cfg, uint32_t idx) {
+    if (tbl_cfg && g_map.column_names && g_map.column_names[idx]) {
+        for (int i = 0; i < tbl_cfg->binary_column_count; i++) {
+            if (strcmp(tbl_cfg->binary_columns[i].name, g_map.column_names[idx]) == 0) {
+                return &tbl_cfg->binary_columns[i];
+            }
+        }
+    }
+    return &g_config.binary;
+}
+
+// ============================================================================
+// ENRICHMENT CONFIG
+// ============================================================================
+
+// "enrich": [{"column": "account_id", "table": "crm.accounts", "key": "id",
+//             "columns": ["name", "region"], "prefix": "account_"}]
+// A table without a schema is looked up in db.
+static void parse_enrich_rules(json_object *arr, const char *db, table_config_t *tbl_cfg) {
+    int count = json_object_array_length(arr);
+    if (count > ENRICH_MAX_RULES) {
+        log_warn("Table %s.%s: only the first %d enrich rules are used",
+                 db, tbl_cfg->name, ENRICH_MAX_RULES);
+        count = ENRICH_MAX_RULES;
+    }
+    tbl_cfg->enrich = calloc(count ? count : 1, sizeof(enrich_rule_t));
+    if (!tbl_cfg->enrich) return;
+
+    for (int i = 0; i < count; i++) {
+        json_object *obj = json_object_array_get_idx(arr, i);
+        json_object *column = json_object_object_get(obj, "column");
+        json_object *table = json_object_object_get(obj, "table");
+        json_object *key = json_object_object_get(obj, "key");
+        json_object *columns = json_object_object_get(obj, "columns");
+        if (!column || !table || !key || !columns ||
+            !json_object_is_type(columns, json_type_array) ||
+            json_object_array_length(columns) == 0 ||
+            json_object_array_length(columns) > ENRICH_MAX_COLUMNS) {
+            log_warn("Table %s.%s: enrich rule %d needs column, table, key and 1-%d columns",
+                     db, tbl_cfg->name, i, ENRICH_MAX_COLUMNS);
+            continue;
+        }
+
+        enrich_rule_t *r = &tbl_cfg->enrich[tbl_cfg->enrich_count];
+        snprintf(r->column, sizeof(r->column), "%s", json_object_get_string(column));
+        snprintf(r->key, sizeof(r->key), "%s", json_object_get_string(key));
+
+        const char *t = json_object_get_string(table);
+        const char *dot = strchr(t, '.');
+        if (dot) {
+            snprintf(r->src_db, sizeof(r->src_db), "%.*s", (int)(dot - t), t);
+            snprintf(r->src_tbl, sizeof(r->src_tbl), "%s", dot + 1);
+        } else {
+            snprintf(r->src_db, sizeof(r->src_db), "%s", db);
+            snprintf(r->src_tbl, sizeof(r->src_tbl), "%s", t);
+        }
+
+        json_object *prefix = json_object_object_get(obj, "prefix");
+        if (prefix) snprintf(r->prefix, sizeof(r->prefix), "%s", json_object_get_string(prefix));
+
+        r->column_count = json_object_array_length(columns);
+        r->columns = calloc(r->column_count, sizeof(char*));
+        r->src_idx = calloc(r->column_count + 1, sizeof(int));
+        r->cache = lookup_cache_create(r->column_count);
+        if (!r->columns || !r->src_idx || !r->cache) {
+            free(r->columns);
+            free(r->src_idx);
+            lookup_cache_destroy(r->cache);
+            memset(r, 0, sizeof(*r));
+            continue;
+        }
+        for (int c = 0; c < r->column_count; c++) {
+            r->columns[c] = strdup(json_object_get_string(json_object_array_get_idx(columns, c)));
+        }
+        tbl_cfg->enrich_count++;
+    }
+}
+
+static void free_enrich_rules(table_config_t *tbl_cfg) {
+    for (int i = 0; i < tbl_cfg->enrich_count; i++) {
+        enrich_rule_t *r = &tbl_cfg->enrich[i];
+        for (int c = 0; c < r->column_count; c++) free(r->columns[c]);
+        free(r->columns);
+        free(r->src_idx);
+        lookup_cache_destroy(r->cache);
+    }
+    free(tbl_cfg->enrich);
+    tbl_cfg->enrich = NULL;
+    tbl_cfg->enrich_count = 0;
+}
+
+// Is db.table the lookup table of any enrich rule?
+static int is_lookup_source(const char *db, const char *table) {
+    for (int i = 0; i < g_config.database_count; i++) {
+        database_config_t *db_cfg = &g_config.databases[i];
+        for (int j = 0; j < db_cfg->table_count; j++) {
+            table_config_t *tbl_cfg = &db_cfg->tables[j];
+            for (int k = 0; k < tbl_cfg->enrich_count; k++) {
+                if (strcmp(tbl_cfg->enrich[k].src_db, db) == 0 &&
+                    strcmp(tbl_cfg->enrich[k].src_tbl, table) == 0) {
+                    return 1;
+                }
+            }
+        }
+    }
+    return 0;
+}
+
+// ============================================================================
+// LOAD SHEDDING CONFIG
+// ============================================================================
+
+// "shedding": {"sample_at": 0.5, "drop_at": 0.8, "sample_rate": 10,
+//              "max_queue_bytes": 67108864, "max_lag_sec": 30,
+//              "spill_file": "./data/spill/kafka.jsonl",
+//              "priorities": {"billing.*": "critical", "analytics.clicks": "low"}}
+static void parse_shedding(json_object *obj, publisher_instance_t *inst) {
+    publisher_shedding_t *s = &inst->shed;
+    s->enabled = 1;
+    s->sample_at = 0.5;
+    s->drop_at = 0.8;
+    s->sample_rate = 10;
+
+    json_object *v;
+    if ((v = json_object_object_get(obj, "sample_at"))) s->sample_at = json_object_get_double(v);
+    if ((v = json_object_object_get(obj, "drop_at"))) s->drop_at = json_object_get_double(v);
+    if ((v = json_object_object_get(obj, "sample_rate"))) s->sample_rate = json_object_get_int(v);
+    if ((v = json_object_object_get(obj, "max_queue_bytes"))) s->max_bytes = (size_t)json_object_get_int64(v);
+    if ((v = json_object_object_get(obj, "max_lag_sec"))) s->max_lag_sec = (uint32_t)json_object_get_int(v);
+    if ((v = json_object_object_get(obj, "spill_file"))) {
+        snprintf(s->spill_path, sizeof(s->spill_path), "%s", json_object_get_string(v));
+    }
+    if (s->sample_rate < 1) s->sample_rate = 1;
+    if (s->drop_at < s->sample_at) s->drop_at = s->sample_at;
+
+    json_object *priorities = json_object_object_get(obj, "priorities");
+    if (priorities && json_object_is_type(priorities, json_type_object)) {
+        int count = 0;
+        json_object_object_foreach(priorities, k0, v0) { (void)k0; (void)v0; count++; }
+        s->rules = calloc(count ? count : 1, sizeof(publisher_priority_rule_t));
+        if (!s->rules) return;
+
+        json_object_object_foreach(priorities, name, prio) {
+            int priority = publisher_priority_parse(json_object_get_string(prio));
+            const char *dot = strchr(name, '.');
+            if (priority < 0 || !dot) {
+                log_warn("Publisher %s: ignoring priority '%s' for '%s' (want db.table: critical|normal|low)",
+                         inst->name, json_object_get_string(prio), name);
+                continue;
+            }
+            publisher_priority_rule_t *r = &s->rules[s->rule_count++];
+            snprintf(r->db, sizeof(r->db), "%.*s", (int)(dot - name), name);
+            snprintf(r->table, sizeof(r->table), "%s", dot + 1);
+            r->priority = priority;
+        }
+    }
+}
+
 // ============================================================================
 // CONFIG PARSING (JSON)
 // ============================================================================
@@ -343,6 +977,13 @@ static int load_config(const char *filename, config_t *cfg) {
     cfg->max_log_count = 10;
     cfg->max_file_size = 10 * 1024 * 1024;
     strcpy(cfg->checkpoint_file, "binlog_checkpoint.dat");
+    cfg->binary.mode = BINARY_MODE_BASE64;
+    cfg->binary.preview_bytes = 200;
+    cfg->binary.spill_threshold = 64 * 1024;
+    cfg->binary.is_default = 1;
+    cfg->metrics_interval = 15;
+    cfg->profiling_interval = 60;
+    cfg->schema_max_parked = 10000;
 
     FILE *fp = fopen(filename, "r");
     if(!fp) {
@@ -434,6 +1075,24 @@ static int load_config(const char *filename, config_t *cfg) {
         json_object *binlog_position = json_object_object_get(replication, "binlog_position");
         if(binlog_position) cfg->binlog_position = json_object_get_int64(binlog_position);
 
+        // Epoch seconds or "YYYY-MM-DD HH:MM:SS" in UTC
+        json_object *start_time = json_object_object_get(replication, "start_time");
+        if(start_time && json_object_is_type(start_time, json_type_int)) {
+            cfg->start_time = json_object_get_int64(start_time);
+        } else if(start_time) {
+            const char *st = json_object_get_string(start_time);
+            struct tm tm;
+            memset(&tm, 0, sizeof(tm));
+            if(sscanf(st, "%d-%d-%d%*1[ T]%d:%d:%d", &tm.tm_year, &tm.tm_mon, &tm.tm_mday,
+                      &tm.tm_hour, &tm.tm_min, &tm.tm_sec) == 6) {
+                tm.tm_year -= 1900;
+                tm.tm_mon -= 1;
+                cfg->start_time = (int64_t)timegm(&tm);
+            } else {
+                log_warn("Invalid replication.start_time '%s', ignored", st);
+            }
+        }
+
         json_object *save_last_position = json_object_object_get(replication, "save_last_position");
         if(save_last_position) cfg->save_last_position = json_object_get_boolean(save_last_position);
 
@@ -445,6 +1104,98 @@ static int load_config(const char *filename, config_t *cfg) {
         
     }
 
+    json_object *metrics = json_object_object_get(root, "metrics");
+    if(metrics) {
+        json_object *file = json_object_object_get(metrics, "file");
+        if(file) strncpy(cfg->metrics_file, json_object_get_string(file), sizeof(cfg->metrics_file) - 1);
+
+        json_object *interval = json_object_object_get(metrics, "interval_sec");
+        if(interval) cfg->metrics_interval = json_object_get_int(interval);
+    }
+
+    json_object *resolver = json_object_object_get(root, "schema_resolver");
+    if(resolver) {
+        json_object *threads = json_object_object_get(resolver, "threads");
+        if(threads) cfg->schema_threads = json_object_get_int(threads);
+
+        json_object *max_parked = json_object_object_get(resolver, "max_parked_events");
+        if(max_parked) cfg->schema_max_parked = json_object_get_int(max_parked);
+        if(cfg->schema_max_parked < 1) cfg->schema_max_parked = 1;
+    }
+
+    json_object *control = json_object_object_get(root, "control");
+    if(control) {
+        json_object *socket_path = json_object_object_get(control, "socket");
+        if(socket_path) strncpy(cfg->control_socket, json_object_get_string(socket_path), sizeof(cfg->control_socket) - 1);
+
+        json_object *clients = json_object_object_get(control, "max_clients");
+        if(clients) cfg->control_max_clients = json_object_get_int(clients);
+
+        // Octal string ("0660"), like a file mode
+        json_object *mode = json_object_object_get(control, "mode");
+        if(mode) cfg->control_mode = (int)strtol(json_object_get_string(mode), NULL, 8);
+    }
+
+    json_object *watermark = json_object_object_get(root, "watermark");
+    if(watermark) {
+        json_object *interval = json_object_object_get(watermark, "interval_ms");
+        if(interval) cfg->watermark_interval_ms = json_object_get_int(interval);
+        if(cfg->watermark_interval_ms < 0) cfg->watermark_interval_ms = 0;
+    }
+
+    json_object *profiling = json_object_object_get(root, "profiling");
+    if(profiling) {
+        json_object *enabled = json_object_object_get(profiling, "enabled");
+        if(enabled) cfg->profiling_enabled = json_object_get_boolean(enabled);
+
+        json_object *interval = json_object_object_get(profiling, "interval_sec");
+        if(interval) cfg->profiling_interval = json_object_get_int(interval);
+    }
+    // Before the publisher pool below: its workers register with the
+    // profiler as they start
+    profiler_init(cfg->profiling_enabled, cfg->profiling_interval);
+
+    json_object *startup = json_object_object_get(root, "startup");
+    if(startup) {
+        json_object *threads = json_object_object_get(startup, "threads");
+        if(threads) cfg->startup_threads = json_object_get_int(threads);
+
+        json_object *timeout = json_object_object_get(startup, "timeout_ms");
+        if(timeout) cfg->startup_timeout_ms = json_object_get_int(timeout);
+    }
+
+    json_object *binary_output = json_object_object_get(root, "binary_output");
+    if(binary_output) {
+        parse_binary_column(binary_output, &cfg->binary, &cfg->binary);
+        cfg->binary.is_default = 1;
+
+        json_object *spill_dir = json_object_object_get(binary_output, "spill_dir");
+        if(spill_dir) strncpy(cfg->blob_store_dir, json_object_get_string(spill_dir), sizeof(cfg->blob_store_dir) - 1);
+
+        if(cfg->binary.mode == BINARY_MODE_SPILL && !cfg->blob_store_dir[0]) {
+            log_warn("binary_output mode 'spill' without spill_dir, large values will be truncated");
+        }
+    }
+
+    json_object *partial_json = json_object_object_get(root, "partial_json");
+    if(partial_json) {
+        const char *mode = json_object_get_string(partial_json);
+        if(strcasecmp(mode, "patch") == 0) cfg->partial_json = PARTIAL_JSON_PATCH;
+        else if(strcasecmp(mode, "full") == 0) cfg->partial_json = PARTIAL_JSON_FULL;
+        else log_warn("Unknown partial_json mode '%s', using full", mode);
+    }
+
+    json_object *coalesce = json_object_object_get(root, "coalesce");
+    if(coalesce) {
+        json_object *max_rows = json_object_object_get(coalesce, "max_rows");
+        cfg->coalesce_max_rows = max_rows ? json_object_get_int(max_rows) : 500;
+
+        json_object *max_bytes = json_object_object_get(coalesce, "max_bytes");
+        cfg->coalesce_max_bytes = max_bytes ? (size_t)json_object_get_int64(max_bytes) : 262144;
+        if(cfg->coalesce_max_bytes < 32768) cfg->coalesce_max_bytes = 32768;
+    }
+
+    int bad_patterns = 0;
     json_object *capture = json_object_object_get(root, "capture");
     if(capture) {
         json_object *databases = json_object_object_get(capture, "databases");
@@ -458,6 +1209,8 @@ static int load_config(const char *filename, config_t *cfg) {
                 json_object_object_foreach(db_wrapper, db_name, db_obj) {
                     database_config_t *db_cfg = &cfg->databases[cfg->database_count++];
                     strncpy(db_cfg->name, db_name, sizeof(db_cfg->name) - 1);
+                    if(compile_name_pattern(db_name, sizeof(db_cfg->name), &db_cfg->match) != 0) bad_patterns++;
+                    if(db_cfg->match.kind != NAME_EXACT) cfg->capture_patterns = 1;
 
                     json_object *capture_dml = json_object_object_get(db_obj, "capture_dml");
                     db_cfg->capture_dml = capture_dml ? json_object_get_boolean(capture_dml) : 1;
@@ -476,6 +1229,8 @@ static int load_config(const char *filename, config_t *cfg) {
                             json_object_object_foreach(tbl_wrapper, tbl_name, tbl_obj) {
                                 table_config_t *tbl_cfg = &db_cfg->tables[db_cfg->table_count++];
                                 strncpy(tbl_cfg->name, tbl_name, sizeof(tbl_cfg->name) - 1);
+                                if(compile_name_pattern(tbl_name, sizeof(tbl_cfg->name), &tbl_cfg->match) != 0) bad_patterns++;
+                                if(tbl_cfg->match.kind != NAME_EXACT) cfg->capture_patterns = 1;
 
                                 json_object *primary_key = json_object_object_get(tbl_obj, "primary_key");
                                 if (primary_key) {
@@ -504,6 +1259,32 @@ static int load_config(const char *filename, config_t *cfg) {
                                 }
 
 
+                                json_object *binary_columns = json_object_object_get(tbl_obj, "binary_columns");
+                                if(binary_columns && json_object_is_type(binary_columns, json_type_object)) {
+                                    int bc_count = 0;
+                                    json_object_object_foreach(binary_columns, bk0, bv0) { (void)bk0; (void)bv0; bc_count++; }
+                                    tbl_cfg->binary_columns = calloc(bc_count ? bc_count : 1, sizeof(binary_column_t));
+                                    json_object_object_foreach(binary_columns, bc_name, bc_obj) {
+                                        binary_column_t *bc = &tbl_cfg->binary_columns[tbl_cfg->binary_column_count++];
+                                        strncpy(bc->name, bc_name, sizeof(bc->name) - 1);
+                                        parse_binary_column(bc_obj, &cfg->binary, bc);
+                                    }
+                                }
+
+                                json_object *enrich = json_object_object_get(tbl_obj, "enrich");
+                                if(enrich && json_object_is_type(enrich, json_type_array)) {
+                                    parse_enrich_rules(enrich, db_name, tbl_cfg);
+                                }
+
+                                tbl_cfg->priority = PUBLISHER_PRIORITY_NORMAL;
+                                json_object *priority = json_object_object_get(tbl_obj, "priority");
+                                if(priority) {
+                                    int p = publisher_priority_parse(json_object_get_string(priority));
+                                    if(p >= 0) tbl_cfg->priority = p;
+                                    else log_warn("Table %s.%s: unknown priority '%s', using normal",
+                                                  db_name, tbl_name, json_object_get_string(priority));
+                                }
+
                                 json_object *columns = json_object_object_get(tbl_obj, "columns");
                                 if(columns && json_object_is_type(columns, json_type_array)) {
                                     int col_count = json_object_array_length(columns);
@@ -543,6 +1324,11 @@ static int load_config(const char *filename, config_t *cfg) {
         }
     }
 
+    if(bad_patterns > 0) {
+        json_object_put(root);
+        return -1;
+    }
+
     // ========================================================================
     // LOAD PUBLISHER PLUGINS
     // ========================================================================
@@ -554,6 +1340,22 @@ static int load_config(const char *filename, config_t *cfg) {
         return -1;
     }
     
+    // Profile 0 is the default encoding used by publishers without a profile
+    register_output_profile(cfg, NULL);
+
+    // Optional shared worker pool instead of one thread per publisher
+    json_object *pool_obj = json_object_object_get(root, "publisher_pool");
+    if (pool_obj) {
+        json_object *enabled = json_object_object_get(pool_obj, "enabled");
+        if (!enabled || json_object_get_boolean(enabled)) {
+            json_object *threads = json_object_object_get(pool_obj, "threads");
+            json_object *quantum = json_object_object_get(pool_obj, "quantum");
+            publisher_manager_enable_pool(cfg->publisher_manager,
+                                          threads ? json_object_get_int(threads) : 0,
+                                          quantum ? json_object_get_int(quantum) : 0);
+        }
+    }
+
     json_object *publishers = json_object_object_get(root, "publishers");
     if(publishers && json_object_is_type(publishers, json_type_array)) {
         int pub_count = json_object_array_length(publishers);
@@ -569,6 +1371,13 @@ static int load_config(const char *filename, config_t *cfg) {
                 json_object *lib_obj = json_object_object_get(plugin_obj, "library_path");
                 json_object *active_obj = json_object_object_get(plugin_obj, "active");
                 json_object *max_queu_obj = json_object_object_get(plugin_obj, "max_queu_depth");
+                json_object *dedicated_obj = json_object_object_get(plugin_obj, "dedicated_thread");
+                json_object *critical_obj = json_object_object_get(plugin_obj, "critical");
+                json_object *isolation_obj = json_object_object_get(plugin_obj, "isolation");
+                json_object *ring_kb_obj = json_object_object_get(plugin_obj, "host_ring_kb");
+                json_object *shedding_obj = json_object_object_get(plugin_obj, "shedding");
+                json_object *watermarks_obj = json_object_object_get(plugin_obj, "watermarks");
+                json_object *routing_key_obj = json_object_object_get(plugin_obj, "routing_key");
                 
                 if (!name_obj || !lib_obj) {
                     log_warn("Plugin missing required fields (name, library_path)");
@@ -617,17 +1426,57 @@ static int load_config(const char *filename, config_t *cfg) {
                     }
                 }
                 
-                // Load plugin
+                int profile_id = register_output_profile(cfg,
+                                        json_object_object_get(plugin_obj, "output_profile"));
+                
+                // The host ring carries JSON events only
+                const char *isolation = isolation_obj ? json_object_get_string(isolation_obj) : NULL;
+                int out_of_process = isolation && strcasecmp(isolation, "process") == 0;
+                int columnar = profile_id >= 0 && profile_id < cfg->profile_count &&
+                               cfg->profiles[profile_id].format == PROFILE_FORMAT_COLUMNAR;
+                
+                // Apply mode reads primary_key and rows as objects
+                json_object *mode_obj = config_obj ? json_object_object_get(config_obj, "mode") : NULL;
+                int apply_mode = mode_obj && strcasecmp(json_object_get_string(mode_obj), "apply") == 0;
+                int full_objects = profile_id >= 0 && profile_id < cfg->profile_count &&
+                                   cfg->profiles[profile_id].format == PROFILE_FORMAT_OBJECT &&
+                                   cfg->profiles[profile_id].envelope == PROFILE_ENVELOPE_FULL;
+                
+                // Register plugin; it is loaded and started in parallel by main()
                 publisher_instance_t *inst = NULL;
-                if (publisher_manager_load_plugin(
+                if (out_of_process && columnar) {
+                    log_error("Publisher %s: a columnar output profile cannot be used with "
+                              "isolation \"process\", not registered", name);
+                } else if (apply_mode && !full_objects) {
+                    log_error("Publisher %s: mode \"apply\" needs the \"full\" envelope and "
+                              "\"object\" format, not registered", name);
+                } else if (publisher_manager_add_plugin(
                         cfg->publisher_manager,
                         name,
                         lib_path,
                         &config,
                         &inst) == 0) {
-                    log_info("Loaded publisher plugin: %s", name);
+                    inst->profile_id = profile_id;
+                    inst->dedicated_thread = dedicated_obj ? json_object_get_boolean(dedicated_obj) : 0;
+                    inst->pool = inst->dedicated_thread ? NULL : cfg->publisher_manager->pool;
+                    inst->critical = critical_obj ? json_object_get_boolean(critical_obj) : 1;
+                    inst->watermarks = watermarks_obj ? json_object_get_boolean(watermarks_obj) : 0;
+                    inst->routing_key = routing_key_obj ? json_object_get_boolean(routing_key_obj) : 0;
+                    if (shedding_obj && json_object_is_type(shedding_obj, json_type_object)) {
+                        parse_shedding(shedding_obj, inst);
+                    }
+                    if (out_of_process) {
+                        inst->out_of_process = 1;
+                        if (ring_kb_obj) inst->host_ring_size = (size_t)json_object_get_int(ring_kb_obj) << 10;
+                    } else if (isolation && strcasecmp(isolation, "none") != 0) {
+                        log_warn("Unknown isolation '%s' for %s, loading in process", isolation, name);
+                    }
+                    log_info("Registered publisher plugin: %s (output profile %d, %s%s%s)", name, profile_id,
+                             inst->pool ? "shared pool" : "dedicated thread",
+                             inst->critical ? "" : ", non-critical",
+                             inst->out_of_process ? ", host process" : "");
                 } else {
-                    log_warn("Failed to load publisher plugin: %s", name);
+                    log_warn("Failed to register publisher plugin: %s", name);
                 }
                 
                 // Cleanup temporary arrays (strings are owned by JSON)
@@ -759,6 +1608,22 @@ static void announce_checksum(MYSQL *mysql)
     }
 }
 
+// Ask the primary for a HEARTBEAT after interval_ms without events, so an
+// idle stream still ticks the watermark
+static void announce_heartbeat(MYSQL *mysql, int interval_ms)
+{
+    if (!mysql || interval_ms <= 0) return;
+
+    char sql[96];
+    unsigned long long ns = (unsigned long long)interval_ms * 1000000ULL;
+    snprintf(sql, sizeof(sql), "SET @master_heartbeat_period = %llu", ns);
+    if (mysql_query(mysql, sql) != 0) {
+        log_warn("Cannot set heartbeat period: %s", mysql_error(mysql));
+    }
+    snprintf(sql, sizeof(sql), "SET @source_heartbeat_period = %llu", ns);
+    (void)mysql_query(mysql, sql);
+}
+
 static int get_master_position(MYSQL *mysql, char *file_out, size_t file_size,
                                uint64_t *pos_out)
 {
@@ -780,22 +1645,203 @@ static int get_master_position(MYSQL *mysql, char *file_out, size_t file_size,
     return 0;
 }
 
-static int mariadb_decompress_rows(const unsigned char *in, size_t in_len,
-                                   unsigned char **out, size_t *out_len)
-{
-    if(in_len < 2) return -1;
-    uint8_t header = in[0];
-    unsigned header_size = header & 0x07;
-    unsigned algo = (header & 0x70) >> 4;
-    if(header_size == 0 || 1 + header_size > in_len || algo != 0) return -1;
+// ============================================================================
+// START TIME SEEK
+// ============================================================================
 
-    size_t expected = 0;
-    for(unsigned i = 0; i < header_size; ++i){
-        expected |= (size_t)in[1 + i] << (8 * i);
+#define BINLOG_DUMP_NON_BLOCK 1     // dump ends at the end of the binlog instead of waiting
+
+// Dump connection of its own, reading file from pos; closed by seek_close
+static MYSQL* seek_open(const char *file, uint64_t pos, MYSQL_RPL *rpl) {
+    MYSQL *m = mysql_init(NULL);
+    if(!m) return NULL;
+    if(!mysql_real_connect(m, g_config.host, g_config.username, g_config.password,
+                           NULL, g_config.port, NULL, 0)) {
+        log_error("start_time seek: connect: %s", mysql_error(m));
+        mysql_close(m);
+        return NULL;
     }
+    announce_checksum(m);
 
-    *out = (unsigned char*)malloc(expected ? expected : 1);
-    if(!*out) return -1;
+    memset(rpl, 0, sizeof(*rpl));
+    rpl->file_name_length = strlen(file);
+    rpl->file_name = file;
+    rpl->start_position = pos;
+    rpl->server_id = g_config.server_id;
+    rpl->flags = BINLOG_DUMP_NON_BLOCK;
+    if(mysql_binlog_open(m, rpl) != 0) {
+        log_error("start_time seek: cannot read %s: %s", file, mysql_error(m));
+        mysql_close(m);
+        return NULL;
+    }
+    return m;
+}
+
+static void seek_close(MYSQL *m, MYSQL_RPL *rpl) {
+    mysql_binlog_close(m, rpl);
+    mysql_close(m);
+}
+
+// Header timestamp of the first real event of a binlog file
+static int seek_first_timestamp(const char *file, uint32_t *ts) {
+    MYSQL_RPL rpl;
+    MYSQL *m = seek_open(file, 4, &rpl);
+    if(!m) return -1;
+
+    int rc = -1;
+    while(mysql_binlog_fetch(m, &rpl) == 0 && rpl.size >= 20) {
+        const unsigned char *ev = rpl.buffer + 1;
+        if(le32(ev) == 0 || ev[4] == EVT_ROTATE) continue;   // artificial rotate
+        *ts = le32(ev);
+        rc = 0;
+        break;
+    }
+    seek_close(m, &rpl);
+    return rc;
+}
+
+// Position of the first transaction in file that starts at or after
+// start_time, from event headers only. *pos is 0 if the file ends first.
+static int seek_scan_file(const char *file, uint32_t start_time, uint64_t *pos) {
+    MYSQL_RPL rpl;
+    MYSQL *m = seek_open(file, 4, &rpl);
+    if(!m) return -1;
+
+    *pos = 0;
+    uint64_t events = 0;
+    uint8_t prev_type = 0;
+    uint64_t prev_start = 0;
+    int rc = 0;
+
+    while(keep_running) {
+        if(mysql_binlog_fetch(m, &rpl) != 0) {
+            log_error("start_time seek: reading %s: %s", file, mysql_error(m));
+            rc = -1;
+            break;
+        }
+        if(rpl.size < 20) break;                              // end of the binlog
+
+        const unsigned char *ev = rpl.buffer + 1;
+        uint32_t ts = le32(ev);
+        uint8_t type = ev[4];
+        uint32_t event_len = le32(ev + 9);
+        uint32_t next_pos = le32(ev + 13);
+        uint64_t start = next_pos >= event_len ? next_pos - event_len : 0;
+        if(ts == 0 || type == EVT_FORMAT_DESCRIPTION) continue;
+        if(type == EVT_ROTATE) break;                         // end of this file
+        events++;
+
+        int is_gtid = type == EVT_GTID || type == EVT_ANONYMOUS_GTID || type == EVT_MARIA_GTID;
+        if(ts >= start_time && (is_gtid || type == EVT_QUERY_EVENT)) {
+            // A BEGIN right after its GTID event starts at the GTID event
+            int after_gtid = prev_type == EVT_GTID || prev_type == EVT_ANONYMOUS_GTID ||
+                             prev_type == EVT_MARIA_GTID;
+            *pos = (type == EVT_QUERY_EVENT && after_gtid) ? prev_start : start;
+            break;
+        }
+        prev_type = type;
+        prev_start = start;
+    }
+    log_debug("start_time seek: %s: %llu event header(s) scanned", file,
+              (unsigned long long)events);
+    seek_close(m, &rpl);
+    return rc;
+}
+
+// Binary search over the binlogs by the timestamp of their first event,
+// then a header scan of the file that can hold the first transaction
+static int seek_in_files(char (*files)[256], const uint64_t *sizes, int n, uint32_t target,
+                         char *file_out, size_t file_size, uint64_t *pos_out, int *probes)
+{
+    uint32_t ts;
+    *probes = 1;
+    if(n == 0 || seek_first_timestamp(files[0], &ts) != 0) return -1;
+
+    int lo = 0;
+    if(ts > target) {
+        log_warn("start_time is older than the oldest binlog %s, starting there", files[0]);
+    } else {
+        // Last file whose first event is not after start_time
+        int hi = n - 1;
+        while(lo < hi) {
+            int mid = (lo + hi + 1) / 2;
+            (*probes)++;
+            if(seek_first_timestamp(files[mid], &ts) != 0) return -1;
+            if(ts <= target) lo = mid;
+            else hi = mid - 1;
+        }
+    }
+
+    // The transaction may also be the first one of a later file
+    for(int i = lo; i < n; i++) {
+        uint64_t pos;
+        if(seek_scan_file(files[i], target, &pos) != 0) return -1;
+        if(pos > 0) {
+            snprintf(file_out, file_size, "%s", files[i]);
+            *pos_out = pos;
+            return 0;
+        }
+    }
+
+    // Nothing that recent yet: start at the end
+    snprintf(file_out, file_size, "%s", files[n - 1]);
+    *pos_out = sizes[n - 1];
+    return 0;
+}
+
+// Binlog coordinates of the first transaction at or after start_time
+static int seek_start_time(MYSQL *mysql, int64_t start_time, char *file_out,
+                           size_t file_size, uint64_t *pos_out)
+{
+    if(mysql_query(mysql, "SHOW BINARY LOGS") != 0) {
+        log_error("start_time seek: SHOW BINARY LOGS: %s", mysql_error(mysql));
+        return -1;
+    }
+    MYSQL_RES *res = mysql_store_result(mysql);
+    if(!res) return -1;
+
+    int count = (int)mysql_num_rows(res);
+    char (*files)[256] = calloc(count ? count : 1, sizeof(*files));
+    uint64_t *sizes = calloc(count ? count : 1, sizeof(uint64_t));
+    int n = 0;
+    MYSQL_ROW row;
+    while(files && sizes && n < count && (row = mysql_fetch_row(res))) {
+        if(!row[0]) continue;
+        snprintf(files[n], sizeof(files[n]), "%s", row[0]);
+        sizes[n] = row[1] ? strtoull(row[1], NULL, 10) : 4;
+        n++;
+    }
+    mysql_free_result(res);
+
+    int probes = 0;
+    uint32_t target = start_time > 0 ? (uint32_t)start_time : 0;
+    int rc = (files && sizes) ?
+             seek_in_files(files, sizes, n, target, file_out, file_size, pos_out, &probes) : -1;
+    if(rc == 0) {
+        log_info("start_time %lld resolved to %s @ %llu (%d of %d binlog(s) probed)",
+                 (long long)start_time, file_out, (unsigned long long)*pos_out, probes, n);
+    }
+    free(files);
+    free(sizes);
+    return rc;
+}
+
+static int mariadb_decompress_rows(const unsigned char *in, size_t in_len,
+                                   unsigned char **out, size_t *out_len)
+{
+    if(in_len < 2) return -1;
+    uint8_t header = in[0];
+    unsigned header_size = header & 0x07;
+    unsigned algo = (header & 0x70) >> 4;
+    if(header_size == 0 || 1 + header_size > in_len || algo != 0) return -1;
+
+    size_t expected = 0;
+    for(unsigned i = 0; i < header_size; ++i){
+        expected |= (size_t)in[1 + i] << (8 * i);
+    }
+
+    *out = (unsigned char*)malloc(expected ? expected : 1);
+    if(!*out) return -1;
 
     uLongf dest_len = (uLongf)expected;
     if(uncompress(*out, &dest_len, in + 1 + header_size,
@@ -845,52 +1891,12 @@ static int load_enum_values_for_column(const char *db,
         return -1;
     }
 
-    const char *col_type = row[0];
-    const char *p = strchr(col_type, '(');
-    const char *end = strrchr(col_type, ')');
-
-    if (!p || !end || end <= p + 1) {
-        mysql_free_result(res);
-        return -1;
-    }
-
-    p++;
-
-    int count = 0;
-    const char *q = p;
-    while (q < end) {
-        const char *s = strchr(q, '\'');
-        if (!s || s >= end) break;
-        const char *e = strchr(s + 1, '\'');
-        if (!e || e >= end) break;
-        count++;
-        q = e + 1;
-    }
-
-    if (count == 0) {
+    cache->count = schema_parse_enum_type(row[0], &cache->values);
+    if (cache->count == 0) {
         mysql_free_result(res);
         return -1;
     }
 
-    cache->values = (char **)calloc(count, sizeof(char *));
-    cache->count = 0;
-
-    q = p;
-    while (q < end && cache->count < count) {
-        const char *s = strchr(q, '\'');
-        if (!s || s >= end) break;
-        const char *e = strchr(s + 1, '\'');
-        if (!e || e >= end) break;
-
-        size_t len = (size_t)(e - (s + 1));
-        char *val = (char *)malloc(len + 1);
-        memcpy(val, s + 1, len);
-        val[len] = '\0';
-
-        cache->values[cache->count++] = val;
-        q = e + 1;
-    }
-
     cache->loaded = 1;
     log_trace("Loaded %d ENUM values for %s.%s.%s",
               cache->count, db, tbl, col_name);
@@ -903,6 +1909,54 @@ static int load_enum_values_for_column(const char *db,
 // COLUMN NAME FETCH
 // ============================================================================
 
+static void free_column_names(void) {
+    if(g_map.column_names) {
+        for(uint32_t i = 0; i < g_map.column_name_count; i++) {
+            free(g_map.column_names[i]);
+        }
+        free(g_map.column_names);
+        g_map.column_names = NULL;
+    }
+    g_map.column_name_count = 0;
+    g_map.column_names_fetched = 0;
+    free(g_map.column_binary);
+    g_map.column_binary = NULL;
+    free(g_map.column_unsigned);
+    g_map.column_unsigned = NULL;
+}
+
+// Install a resolved schema for the current table map (NULL: unresolved).
+// Arrays are sized by the map so row decoding can index them by column.
+static void apply_schema(const schema_info_t *info) {
+    free_column_names();
+    free_enum_cache();
+    if(!info || g_map.ncols == 0) return;
+
+    g_map.column_names = calloc(g_map.ncols, sizeof(char*));
+    g_map.column_binary = calloc(g_map.ncols, 1);
+    g_map.column_unsigned = calloc(g_map.ncols, 1);
+    g_enum_cache = calloc(g_map.ncols, sizeof(enum_cache_t));
+    if(!g_map.column_names || !g_map.column_binary || !g_map.column_unsigned ||
+       !g_enum_cache) return;
+    g_map.column_name_count = g_map.ncols;
+
+    for(uint32_t i = 0; i < g_map.ncols && i < (uint32_t)info->ncols; i++) {
+        g_map.column_names[i] = strdup(info->names[i]);
+        g_map.column_binary[i] = info->binary[i];
+        g_map.column_unsigned[i] = info->is_unsigned[i];
+
+        int count = info->enum_counts[i];
+        if(count > 0 && (g_enum_cache[i].values = calloc(count, sizeof(char*)))) {
+            for(int j = 0; j < count; j++) {
+                g_enum_cache[i].values[j] = strdup(info->enum_values[i][j]);
+            }
+            g_enum_cache[i].count = count;
+            g_enum_cache[i].loaded = 1;
+        }
+    }
+    g_map.column_names_fetched = 1;
+}
+
 static void fetch_column_names(const char *db, const char *tbl) {
     if(!db || !tbl) return;
 
@@ -913,14 +1967,7 @@ static void fetch_column_names(const char *db, const char *tbl) {
         return;
     }
 
-    if(g_map.column_names) {
-        for(uint32_t i = 0; i < g_map.ncols; i++) {
-            free(g_map.column_names[i]);
-        }
-        free(g_map.column_names);
-        g_map.column_names = NULL;
-        g_map.column_names_fetched = 0;
-    }
+    free_column_names();
 
     if(!g_metadata_conn) {
         log_warn("No metadata connection available, cannot fetch column names for %s.%s", db, tbl);
@@ -942,12 +1989,17 @@ static void fetch_column_names(const char *db, const char *tbl) {
     }
 
     int num_fields = mysql_num_fields(res);
-    g_map.column_names = calloc(num_fields, sizeof(char*));
+    g_map.column_names = calloc(num_fields ? num_fields : 1, sizeof(char*));
+    g_map.column_name_count = num_fields;
+    g_map.column_binary = calloc(num_fields ? num_fields : 1, 1);
+    g_map.column_unsigned = calloc(num_fields ? num_fields : 1, 1);
 
-    if(g_map.column_names) {
+    if(g_map.column_names && g_map.column_binary && g_map.column_unsigned) {
         MYSQL_FIELD *fields = mysql_fetch_fields(res);
         for(int i = 0; i < num_fields; i++) {
             g_map.column_names[i] = strdup(fields[i].name);
+            g_map.column_binary[i] = (fields[i].charsetnr == MYSQL_BINARY_CHARSET);
+            g_map.column_unsigned[i] = (fields[i].flags & UNSIGNED_FLAG) != 0;
         }
         g_map.column_names_fetched = 1;
         log_trace("Fetched %d column names for %s.%s", num_fields, db, tbl);
@@ -956,6 +2008,328 @@ static void fetch_column_names(const char *db, const char *tbl) {
     mysql_free_result(res);
 }
 
+// ============================================================================
+// TABLE ID CACHE
+// ============================================================================
+
+// Table ids mapped since the last rotate or DDL. An ignored id costs its
+// TABLE_MAP and rows events only a header read. A captured id keeps a copy
+// of its TABLE_MAP so a rows event for a table mapped before the current
+// one (multi-table statements) can restore the map.
+typedef struct {
+    uint64_t tid;
+    int used;
+    int ignored;
+    unsigned char *map;             // TABLE_MAP payload, captured tables only
+    uint32_t map_len;
+    database_config_t *db_cfg;      // capture config matched once for this id
+    table_config_t *tbl_cfg;
+} table_id_entry_t;
+
+static table_id_entry_t *g_tid_cache = NULL;
+static uint32_t g_tid_cap = 0;      // power of two
+static uint32_t g_tid_count = 0;
+
+static uint32_t tid_slot(uint64_t tid, uint32_t cap) {
+    return (uint32_t)((tid * 0x9E3779B97F4A7C15ULL) >> 32) & (cap - 1);
+}
+
+static table_id_entry_t* tid_cache_find(uint64_t tid) {
+    if (g_tid_count == 0) return NULL;
+    for (uint32_t i = tid_slot(tid, g_tid_cap); g_tid_cache[i].used; i = (i + 1) & (g_tid_cap - 1)) {
+        if (g_tid_cache[i].tid == tid) return &g_tid_cache[i];
+    }
+    return NULL;
+}
+
+static void tid_cache_clear(void) {
+    for (uint32_t i = 0; i < g_tid_cap; i++) free(g_tid_cache[i].map);
+    if (g_tid_cache) memset(g_tid_cache, 0, g_tid_cap * sizeof(table_id_entry_t));
+    g_tid_count = 0;
+}
+
+// Remember tid and its capture config; map == NULL marks it ignored
+static void tid_cache_put(uint64_t tid, const unsigned char *map, uint32_t map_len,
+                          database_config_t *db_cfg, table_config_t *tbl_cfg) {
+    table_id_entry_t *e = tid_cache_find(tid);
+    if (e && map && map == e->map) return;     // restored from this entry
+    if (!e) {
+        if ((g_tid_count + 1) * 4 > g_tid_cap * 3) {
+            uint32_t cap = g_tid_cap ? g_tid_cap * 2 : 256;
+            table_id_entry_t *nc = calloc(cap, sizeof(table_id_entry_t));
+            if (!nc) return;
+            for (uint32_t i = 0; i < g_tid_cap; i++) {
+                if (!g_tid_cache[i].used) continue;
+                uint32_t j = tid_slot(g_tid_cache[i].tid, cap);
+                while (nc[j].used) j = (j + 1) & (cap - 1);
+                nc[j] = g_tid_cache[i];
+            }
+            free(g_tid_cache);
+            g_tid_cache = nc;
+            g_tid_cap = cap;
+        }
+        uint32_t i = tid_slot(tid, g_tid_cap);
+        while (g_tid_cache[i].used) i = (i + 1) & (g_tid_cap - 1);
+        e = &g_tid_cache[i];
+        e->tid = tid;
+        e->used = 1;
+        g_tid_count++;
+    }
+
+    free(e->map);
+    e->map = NULL;
+    e->map_len = 0;
+    e->ignored = (map == NULL);
+    e->db_cfg = db_cfg;
+    e->tbl_cfg = tbl_cfg;
+    if (map) {
+        e->map = malloc(map_len);
+        if (e->map) {
+            memcpy(e->map, map, map_len);
+            e->map_len = map_len;
+        }
+    }
+}
+
+// ============================================================================
+// PARKED ROWS EVENTS
+// ============================================================================
+
+// Rows events of a table whose schema is still being resolved, with the
+// binlog coordinates they were read at. They are replayed in order, per
+// table, before the first event read after the schema arrives; other
+// tables keep streaming meanwhile.
+typedef struct parked_event {
+    uint8_t type;
+    unsigned char *map;             // TABLE_MAP payload of the table
+    uint32_t map_len;
+    unsigned char *rows;            // rows event payload
+    uint32_t rows_len;
+    char txn[TXN_ID_MAX];
+    char binlog[256];
+    uint64_t position;
+    uint64_t event_start;
+    uint64_t txn_start;             // resume point of its transaction
+    uint32_t event_time;
+    uint32_t server_id;
+    int64_t last_committed;
+    int64_t sequence_number;
+    struct parked_event *next;
+} parked_event_t;
+
+typedef struct parked_table {
+    char db[128];
+    char tbl[128];
+    parked_event_t *head;
+    parked_event_t *tail;
+    struct parked_table *next;
+} parked_table_t;
+
+static parked_table_t *g_parked = NULL;
+static int g_parked_count = 0;
+static unsigned g_parked_gen = 0;       // resolver generation last checked
+static int g_replaying = 0;
+
+static parked_table_t* parked_table_find(const char *db, const char *tbl) {
+    for (parked_table_t *t = g_parked; t; t = t->next) {
+        if (strcmp(t->db, db) == 0 && strcmp(t->tbl, tbl) == 0) return t;
+    }
+    return NULL;
+}
+
+static void parse_table_map(const unsigned char *p, uint32_t len);
+static void parse_rows_event(uint8_t event_type, const unsigned char *payload,
+                             uint32_t payload_len);
+static void coalesce_flush_all(void);
+
+static void parked_event_free(parked_event_t *ev) {
+    free(ev->map);
+    free(ev->rows);
+    free(ev);
+}
+
+// Replay the events of every table whose schema is ready
+static void replay_parked(int wait) {
+    if (g_replaying) return;
+    g_replaying = 1;
+    g_parked_gen = schema_resolver_generation();
+
+    // The binlog thread's view of the event being parsed, put back afterwards
+    uint64_t saved_tid = g_map.table_id;
+    char saved_db[128], saved_tbl[128];
+    snprintf(saved_db, sizeof(saved_db), "%s", g_map.db);
+    snprintf(saved_tbl, sizeof(saved_tbl), "%s", g_map.tbl);
+    database_config_t *saved_db_cfg = g_map.db_cfg;
+    char saved_txn[TXN_ID_MAX], saved_binlog[256];
+    snprintf(saved_txn, sizeof(saved_txn), "%s", current_txn_id);
+    snprintf(saved_binlog, sizeof(saved_binlog), "%s", current_binlog);
+    int saved_in_txn = in_transaction;
+    uint64_t saved_position = current_position, saved_start = current_event_start;
+    uint32_t saved_time = current_event_time, saved_server = current_server_id;
+    int64_t saved_lc = txn_last_committed, saved_seq = txn_sequence_number;
+
+    int replayed = 0;
+    parked_table_t **pp = &g_parked;
+    while (*pp) {
+        parked_table_t *t = *pp;
+        if (wait) {
+            while (keep_running && schema_resolver_wait(t->db, t->tbl, 1000) != SCHEMA_READY) {
+                log_warn("Still waiting for the schema of %s.%s", t->db, t->tbl);
+            }
+        }
+        if (schema_resolver_get(t->db, t->tbl, NULL) != SCHEMA_READY) {
+            pp = &t->next;
+            continue;
+        }
+        *pp = t->next;
+
+        coalesce_flush_all();
+        parked_event_t *ev = t->head;
+        while (ev) {
+            parked_event_t *next = ev->next;
+            snprintf(current_txn_id, sizeof(current_txn_id), "%s", ev->txn);
+            snprintf(current_binlog, sizeof(current_binlog), "%s", ev->binlog);
+            in_transaction = 1;
+            current_position = ev->position;
+            current_event_start = ev->event_start;
+            current_event_time = ev->event_time;
+            current_server_id = ev->server_id;
+            txn_last_committed = ev->last_committed;
+            txn_sequence_number = ev->sequence_number;
+
+            parse_table_map(ev->map, ev->map_len);
+            parse_rows_event(ev->type, ev->rows, ev->rows_len);
+            parked_event_free(ev);
+            g_parked_count--;
+            replayed++;
+            ev = next;
+        }
+        coalesce_flush_all();
+        log_debug("Replayed parked rows events of %s.%s", t->db, t->tbl);
+        free(t);
+    }
+
+    snprintf(current_txn_id, sizeof(current_txn_id), "%s", saved_txn);
+    snprintf(current_binlog, sizeof(current_binlog), "%s", saved_binlog);
+    current_position = saved_position;
+    current_event_start = saved_start;
+    current_event_time = saved_time;
+    current_server_id = saved_server;
+    txn_last_committed = saved_lc;
+    txn_sequence_number = saved_seq;
+
+    if (replayed > 0) {
+        // Back to the current table map
+        table_id_entry_t *e = saved_tid ? tid_cache_find(saved_tid) : NULL;
+        if (e && e->map) {
+            in_transaction = 1;
+            parse_table_map(e->map, e->map_len);
+        } else {
+            g_map.table_id = 0;
+            g_map.db_cfg = saved_db_cfg;
+            g_map.tbl_cfg = NULL;
+            snprintf(g_map.db, sizeof(g_map.db), "%s", saved_db);
+            snprintf(g_map.tbl, sizeof(g_map.tbl), "%s", saved_tbl);
+        }
+    }
+    in_transaction = saved_in_txn;
+    g_replaying = 0;
+}
+
+// Drop what is still parked on shutdown
+static void parked_discard(void) {
+    if (g_parked_count > 0) {
+        log_warn("Dropping %d parked rows events, schemas never resolved", g_parked_count);
+    }
+    while (g_parked) {
+        parked_table_t *t = g_parked;
+        g_parked = t->next;
+        while (t->head) {
+            parked_event_t *ev = t->head;
+            t->head = ev->next;
+            parked_event_free(ev);
+        }
+        free(t);
+    }
+    g_parked_count = 0;
+}
+
+// Parked events are not published yet, so neither the checkpoint nor the
+// publishers' delivered watermarks may move past the first of them.
+// g_parked keeps tables in the order they were first parked, so its head
+// event is the earliest.
+static void save_checkpoint(void) {
+    if (g_parked && g_parked->head) {
+        save_position(g_parked->head->binlog, g_parked->head->txn_start);
+    } else {
+        save_position(current_binlog, current_position);
+    }
+}
+
+// Watermark hold for an event dispatched while others are parked, NULL if none
+static publisher_mark_t* parked_hold(void) {
+    if (!g_parked || !g_parked->head) return NULL;
+    parked_event_t *ev = g_parked->head;
+    publisher_mark_t *mark = malloc(sizeof(publisher_mark_t));
+    if (!mark) return NULL;
+    if (publisher_mark_parse(ev->txn, mark) != 0 || !mark->is_gtid) {
+        memset(mark, 0, sizeof(*mark));
+    }
+    snprintf(mark->binlog_file, sizeof(mark->binlog_file), "%s", ev->binlog);
+    mark->position = ev->event_start;
+    return mark;
+}
+
+// Park a rows event of the current (unresolved) table map
+static void park_rows_event(uint8_t type, uint64_t table_id,
+                            const unsigned char *payload, uint32_t payload_len) {
+    table_id_entry_t *e = tid_cache_find(table_id);
+    parked_table_t *t = parked_table_find(g_map.db, g_map.tbl);
+    if (!t) {
+        t = calloc(1, sizeof(parked_table_t));
+        if (!t) return;
+        snprintf(t->db, sizeof(t->db), "%s", g_map.db);
+        snprintf(t->tbl, sizeof(t->tbl), "%s", g_map.tbl);
+
+        // Tables resume in the order they were parked
+        parked_table_t **tail = &g_parked;
+        while (*tail) tail = &(*tail)->next;
+        *tail = t;
+    }
+
+    parked_event_t *ev = calloc(1, sizeof(parked_event_t));
+    if (!ev || !e || !e->map ||
+        !(ev->map = malloc(e->map_len)) || !(ev->rows = malloc(payload_len ? payload_len : 1))) {
+        log_error("Cannot park rows event of %s.%s, dropped", g_map.db, g_map.tbl);
+        if (ev) parked_event_free(ev);
+        return;
+    }
+    memcpy(ev->map, e->map, e->map_len);
+    ev->map_len = e->map_len;
+    memcpy(ev->rows, payload, payload_len);
+    ev->rows_len = payload_len;
+    ev->type = type;
+    snprintf(ev->txn, sizeof(ev->txn), "%s", current_txn_id);
+    snprintf(ev->binlog, sizeof(ev->binlog), "%s", current_binlog);
+    ev->position = current_position;
+    ev->event_start = current_event_start;
+    ev->txn_start = txn_start_position;
+    ev->event_time = current_event_time;
+    ev->server_id = current_server_id;
+    ev->last_committed = txn_last_committed;
+    ev->sequence_number = txn_sequence_number;
+
+    if (t->tail) t->tail->next = ev;
+    else t->head = ev;
+    t->tail = ev;
+    g_parked_count++;
+
+    if (g_parked_count >= g_config.schema_max_parked) {
+        log_warn("%d rows events parked, waiting for pending schemas", g_parked_count);
+        replay_parked(1);
+    }
+}
+
 // ============================================================================
 // TABLE_MAP PARSER
 // ============================================================================
@@ -963,9 +2337,20 @@ static void fetch_column_names(const char *db, const char *tbl) {
 static void parse_table_map(const unsigned char *p, uint32_t len){
     if(len < 8) return;
 
+    const unsigned char *payload = p;
     uint64_t tid = le48(p);  p += 6;
     p += 2;
 
+    // Mapped again (every statement does): nothing to rebuild
+    table_id_entry_t *cached = tid_cache_find(tid);
+    if(cached && !cached->ignored && tid == g_map.table_id && !g_map.schema_pending) {
+        if(!in_transaction) {
+            generate_txn_id(current_txn_id);
+            in_transaction = 1;
+        }
+        return;
+    }
+
     unsigned sch_len = *p++;
     char new_db[128] = "";
     if(sch_len >= sizeof(new_db)) sch_len = sizeof(new_db) - 1;
@@ -983,24 +2368,49 @@ static void parse_table_map(const unsigned char *p, uint32_t len){
     uint64_t ncols64 = *p++;
     uint32_t ncols = (uint32_t)ncols64;
     
+    // Capture config, matched against the (possibly wildcard) capture list
+    // once per table id
+    database_config_t *db_cfg = cached ? cached->db_cfg : find_database_config(new_db);
+    table_config_t *map_cfg = cached ? cached->tbl_cfg : find_table_in(db_cfg, new_tbl);
+
     g_map.table_id = tid;
     snprintf(g_map.db,  sizeof(g_map.db),  "%s", new_db);
     snprintf(g_map.tbl, sizeof(g_map.tbl), "%s", new_tbl);
+    g_map.db_cfg = db_cfg;
+    g_map.tbl_cfg = NULL;
+
+    if(cached && cached->ignored) {
+        g_map.table_id = 0;
+        return;
+    }
+
+    // Lookup tables of enrich rules are decoded even when not captured
+    int lookup_source = is_lookup_source(new_db, new_tbl);
+    int capture_dml = db_cfg && db_cfg->capture_dml;
 
-    if(!should_capture_table(new_db, new_tbl)) {
+    if(!map_cfg && !lookup_source) {
         log_debug("TABLE_MAP tid=%llu db='%s' table='%s' - IGNORED (not in capture list)",
                   (unsigned long long)tid, new_db, new_tbl);
+        tid_cache_put(tid, NULL, 0, db_cfg, NULL);
         g_map.table_id = 0;
         return;
     }
 
-    if(!should_capture_dml(new_db)) {
+    if(!capture_dml && !lookup_source) {
         log_debug("TABLE_MAP tid=%llu db='%s' table='%s' - IGNORED (DML capture disabled)",
                   (unsigned long long)tid, new_db, new_tbl);
+        tid_cache_put(tid, NULL, 0, db_cfg, NULL);
         g_map.table_id = 0;
         return;
     }
 
+    tid_cache_put(tid, payload, len, db_cfg, map_cfg);
+
+    g_map.captured = map_cfg && capture_dml;
+    g_map.tbl_cfg = map_cfg;
+    g_map.priority = map_cfg ? map_cfg->priority : PUBLISHER_PRIORITY_NORMAL;
+    g_map.lookup_source = lookup_source;
+
     int table_changed = (strcmp(g_map.db, new_db) != 0 ||
                          strcmp(g_map.tbl, new_tbl) != 0);
     uint32_t old_ncols = g_map.ncols;
@@ -1063,6 +2473,7 @@ static void parse_table_map(const unsigned char *p, uint32_t len){
             case MT_TIME2:
             case MT_BLOB:
             case MT_GEOMETRY:
+            case MT_JSON:
                 if(p < meta_start + meta_len){
                     g_map.metadata[i] = *p++;
                 }
@@ -1098,33 +2509,77 @@ static void parse_table_map(const unsigned char *p, uint32_t len){
         }
     }
 
-    fetch_column_names(g_map.db, g_map.tbl);
+    // With the resolver the stream never waits on the metadata query; rows
+    // of the table are parked until its schema arrives
+    g_map.schema_pending = 0;
+    if(schema_resolver_enabled()) {
+        const schema_info_t *info = NULL;
+        if(!parked_table_find(g_map.db, g_map.tbl) &&
+           schema_resolver_get(g_map.db, g_map.tbl, &info) == SCHEMA_READY) {
+            apply_schema(info);
+        } else {
+            apply_schema(NULL);
+            g_map.schema_pending = 1;
+        }
+    } else {
+        fetch_column_names(g_map.db, g_map.tbl);
+    }
 
-    table_config_t *tbl_cfg = find_table_config(g_map.db, g_map.tbl);
+    // Resolved into g_map only: tbl_cfg may be a pattern shared by tables
+    // with different columns
+    table_config_t *tbl_cfg = g_map.tbl_cfg;
+    for(int i = 0; i < ENRICH_MAX_RULES; i++) g_map.join_idx[i] = -1;
     if(tbl_cfg && g_map.column_names) {
+        for(int i = 0; i < tbl_cfg->enrich_count; i++) {
+            enrich_rule_t *r = &tbl_cfg->enrich[i];
+            for(uint32_t j = 0; j < g_map.ncols; j++) {
+                if(g_map.column_names[j] && strcmp(r->column, g_map.column_names[j]) == 0) {
+                    g_map.join_idx[i] = j;
+                    break;
+                }
+            }
+            if(g_map.join_idx[i] == -1) {
+                log_warn("Enrich join column %s not found in table %s.%s",
+                         r->column, g_map.db, g_map.tbl);
+            }
+        }
+    }
+
+    // Resolve the captured column name for each column index once per map,
+    // so row decoding does not search the column config per value
+    // BLOB/GEOMETRY output options by column index. Without charset info
+    // a BLOB is treated as binary so it is never mangled as text.
+    free(g_map.binary_opts);
+    g_map.binary_opts = calloc(g_map.ncols ? g_map.ncols : 1, sizeof(binary_column_t*));
+    if(g_map.binary_opts) {
+        for(uint32_t i = 0; i < g_map.ncols; i++) {
+            unsigned char t = g_map.real_types[i];
+            if(t != MT_BLOB && t != MT_GEOMETRY) continue;
+            const binary_column_t *opts = resolve_binary_column(tbl_cfg, i);
+            int is_binary = (t == MT_GEOMETRY) || !g_map.column_binary ||
+                            g_map.column_binary[i];
+            // TEXT columns keep their text form unless configured per column
+            if(is_binary || !opts->is_default) g_map.binary_opts[i] = opts;
+        }
+    }
+
+    free(g_map.include_names);
+    g_map_generation++;
+    g_map.include_names = calloc(g_map.ncols ? g_map.ncols : 1, sizeof(char*));
+    if(tbl_cfg && g_map.include_names) {
         if(tbl_cfg->capture_all_columns) {
-            tbl_cfg->column_count = g_map.ncols;
-            tbl_cfg->columns = calloc(g_map.ncols, sizeof(column_info_t));
             for(uint32_t i = 0; i < g_map.ncols; i++) {
-                if(g_map.column_names[i]) {
-                    strncpy(tbl_cfg->columns[i].name, g_map.column_names[i],
-                            sizeof(tbl_cfg->columns[i].name) - 1);
-                    tbl_cfg->columns[i].index = i;
-                    tbl_cfg->columns[i].position = i;
-                }
+                g_map.include_names[i] = (g_map.column_names && g_map.column_names[i])
+                                         ? g_map.column_names[i] : "unknown";
             }
-        } else {
+        } else if(g_map.column_names) {
             for(int i = 0; i < tbl_cfg->column_count; i++) {
-                tbl_cfg->columns[i].index = -1;
-                for(uint32_t j = 0; j < g_map.ncols; j++) {
-                    if(g_map.column_names[j] &&
-                       strcmp(tbl_cfg->columns[i].name, g_map.column_names[j]) == 0) {
-                        tbl_cfg->columns[i].index = j;
-                        log_trace("Mapped column %s to index %d", tbl_cfg->columns[i].name, j);
-                        break;
-                    }
-                }
-                if(tbl_cfg->columns[i].index == -1) {
+                uint32_t j = 0;
+                while(j < g_map.ncols && !(g_map.column_names[j] &&
+                      strcmp(tbl_cfg->columns[i].name, g_map.column_names[j]) == 0)) j++;
+                if(j < g_map.ncols) {
+                    g_map.include_names[j] = tbl_cfg->columns[i].name;
+                } else {
                     log_warn("Column %s not found in table %s.%s",
                              tbl_cfg->columns[i].name, g_map.db, g_map.tbl);
                 }
@@ -1137,67 +2592,505 @@ static void parse_table_map(const unsigned char *p, uint32_t len){
 }
 
 // ============================================================================
-// COLUMN VALUE PARSER (simplified - full implementation in original file)
+// EVENT BUFFER
 // ============================================================================
 
-static const unsigned char* append_column_value_to_json(
-    char *json_buf, size_t buf_size, size_t *offset,
-    const unsigned char *p,
-    uint32_t col_idx,
-    int is_null,
-    const char *col_name)
-{
-    if(is_null){
-        *offset += snprintf(json_buf + *offset, buf_size - *offset,
-                            "\"%s\":null", col_name);
-        return p;
+// snprintf at *offset into a fixed event buffer. Output that does not fit
+// parks the offset at buf_size - 1, which json_buffer_full() reports; the
+// offset never passes the end, so the remaining size cannot wrap.
+static void json_appendf(char *buf, size_t buf_size, size_t *offset, const char *fmt, ...)
+    __attribute__((format(printf, 4, 5)));
+
+static void json_appendf(char *buf, size_t buf_size, size_t *offset, const char *fmt, ...) {
+    if (*offset + 1 >= buf_size) {
+        *offset = buf_size - 1;
+        return;
     }
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vsnprintf(buf + *offset, buf_size - *offset, fmt, ap);
+    va_end(ap);
+    if (n < 0 || (size_t)n >= buf_size - *offset) *offset = buf_size - 1;
+    else *offset += n;
+}
 
-//    unsigned char type = g_map.types[col_idx];
-    unsigned char real_type = g_map.real_types[col_idx];
-    uint16_t meta = g_map.metadata[col_idx];
+// Did an append run out of space? reserve = bytes still needed after offset
+static int json_buffer_full(size_t buf_size, size_t offset, size_t reserve) {
+    return offset + reserve + 1 >= buf_size;
+}
 
-    *offset += snprintf(json_buf + *offset, buf_size - *offset, "\"%s\":", col_name);
+// Set while a row that did not fit is encoded again: binary and JSON values
+// then go out as references/digests only
+static int g_values_by_ref = 0;
 
-    switch(real_type){
-        case MT_TINY:
-            *offset += snprintf(json_buf + *offset, buf_size - *offset,
-                                "%d", (int8_t)*p);
-            return p + 1;
-        case MT_SHORT:
-        case MT_YEAR:
-            *offset += snprintf(json_buf + *offset, buf_size - *offset,
-                                "%d", (int16_t)le16(p));
-            return p + 2;
-        case MT_INT24: {
-            int32_t v = le24(p);
-            if(v & 0x800000) v |= ~0xFFFFFF;
-            *offset += snprintf(json_buf + *offset, buf_size - *offset, "%d", v);
-            return p + 3;
+// ============================================================================
+// BLOB / GEOMETRY VALUES
+// ============================================================================
+
+// Space kept free after a binary value for the rest of the row and envelope
+#define BINARY_VALUE_RESERVE 256
+
+static size_t json_escaped_len(const unsigned char *s, size_t len) {
+    size_t n = 0;
+    for (size_t i = 0; i < len; i++) {
+        unsigned char c = s[i];
+        if (c == '"' || c == '\\' || c == '\n' || c == '\r' || c == '\t') n += 2;
+        else if (c < 32) n += 6;
+        else n++;
+    }
+    return n;
+}
+
+static size_t json_escape_to(char *dst, const unsigned char *s, size_t len) {
+    char *out = dst;
+    for (size_t i = 0; i < len; i++) {
+        unsigned char c = s[i];
+        switch (c) {
+            case '"':  *out++ = '\\'; *out++ = '"'; break;
+            case '\\': *out++ = '\\'; *out++ = '\\'; break;
+            case '\n': *out++ = '\\'; *out++ = 'n'; break;
+            case '\r': *out++ = '\\'; *out++ = 'r'; break;
+            case '\t': *out++ = '\\'; *out++ = 't'; break;
+            default:
+                if (c < 32) out += sprintf(out, "\\u%04x", c);
+                else *out++ = (char)c;
         }
-        case MT_LONG:
-            *offset += snprintf(json_buf + *offset, buf_size - *offset,
-                                "%u", le32(p));
-            return p + 4;
-        case MT_LONGLONG:
-            *offset += snprintf(json_buf + *offset, buf_size - *offset,
-                                "%llu", (unsigned long long)le64(p));
-            return p + 8;
-        case MT_FLOAT: {
-            float f;
-            memcpy(&f, p, 4);
-            *offset += snprintf(json_buf + *offset, buf_size - *offset, "%f", f);
-            return p + 4;
+    }
+    return out - dst;
+}
+
+// Quoted and escaped string value; one that does not fit fills the buffer
+static void append_json_string(char *json_buf, size_t buf_size, size_t *offset,
+                               const unsigned char *s, size_t len) {
+    size_t need = json_escaped_len(s, len) + 2;
+    if (json_buffer_full(buf_size, *offset, need)) {
+        *offset = buf_size - 1;
+        return;
+    }
+    json_buf[(*offset)++] = '"';
+    *offset += json_escape_to(json_buf + *offset, s, len);
+    json_buf[(*offset)++] = '"';
+    json_buf[*offset] = '\0';
+}
+
+// Size-and-digest stand-in for a value that is not carried inline
+static void append_blob_stub(char *json_buf, size_t buf_size, size_t *offset,
+                             const unsigned char *data, uint32_t len, const char *key) {
+    char hex[SHA256_HEX_LEN + 1];
+    unsigned char digest[SHA256_DIGEST_LEN];
+    sha256(data, len, digest);
+    hex_encode(digest, SHA256_DIGEST_LEN, hex);
+    json_appendf(json_buf, buf_size, offset,
+                 "{\"%s\":\"sha256:%s\",\"size\":%u%s}", key, hex, len,
+                 strcmp(key, "blob_ref") == 0 ? "" : ",\"truncated\":true");
+}
+
+// Write a BLOB/GEOMETRY payload as a JSON value. opts == NULL means a TEXT
+// column written as a plain string. Values are either complete or replaced
+// by an explicit reference/truncation object, never cut silently.
+static void append_blob_value(char *json_buf, size_t buf_size, size_t *offset,
+                              const unsigned char *data, uint32_t len,
+                              const binary_column_t *opts, int is_text)
+{
+    int mode = opts ? opts->mode : -1;
+    size_t room = (!g_values_by_ref && *offset + BINARY_VALUE_RESERVE < buf_size)
+                  ? buf_size - *offset - BINARY_VALUE_RESERVE : 0;
+
+    if (mode == BINARY_MODE_SPILL && len > opts->spill_threshold && g_config.blob_store_dir[0]) {
+        char hex[SHA256_HEX_LEN + 1];
+        if (blob_store_put(g_config.blob_store_dir, data, len, hex) == 0) {
+            json_appendf(json_buf, buf_size, offset,
+                         "{\"blob_ref\":\"sha256:%s\",\"size\":%u}", hex, len);
+            return;
         }
-        case MT_DOUBLE: {
-            double d;
-            memcpy(&d, p, 8);
-            *offset += snprintf(json_buf + *offset, buf_size - *offset, "%f", d);
-            return p + 8;
+        log_error("Cannot spill %u byte value of %s.%s to %s: %s",
+                  len, g_map.db, g_map.tbl, g_config.blob_store_dir, strerror(errno));
+        append_blob_stub(json_buf, buf_size, offset, data, len, "sha256");
+        return;
+    }
+
+    uint32_t n = len;
+    int truncated = 0;
+    if (mode == BINARY_MODE_PREVIEW && len > opts->preview_bytes) {
+        n = opts->preview_bytes;
+        truncated = 1;
+    }
+
+    // TEXT stays text unless a binary encoding was asked for explicitly
+    int as_text = is_text && mode != BINARY_MODE_BASE64 && mode != BINARY_MODE_HEX;
+    if (as_text && truncated) {
+        while (n > 0 && (data[n] & 0xC0) == 0x80) n--;   // keep UTF-8 sequences whole
+    }
+    size_t need = as_text ? json_escaped_len(data, n)
+                : (mode == BINARY_MODE_HEX ? HEX_ENCODED_LEN(n) : BASE64_ENCODED_LEN(n));
+
+    if (need + 64 > room) {
+        if (g_config.blob_store_dir[0] && mode != BINARY_MODE_PREVIEW) {
+            char hex[SHA256_HEX_LEN + 1];
+            if (blob_store_put(g_config.blob_store_dir, data, len, hex) == 0) {
+                json_appendf(json_buf, buf_size, offset,
+                             "{\"blob_ref\":\"sha256:%s\",\"size\":%u}", hex, len);
+                return;
+            }
         }
-        case MT_TIMESTAMP:
-            *offset += snprintf(json_buf + *offset, buf_size - *offset,
-                                "%u", le32(p));
+        log_warn("%u byte value of %s.%s does not fit the event, sending digest only",
+                 len, g_map.db, g_map.tbl);
+        append_blob_stub(json_buf, buf_size, offset, data, len, "sha256");
+        return;
+    }
+
+    if (truncated) {
+        json_appendf(json_buf, buf_size, offset,
+                     "{\"size\":%u,\"truncated\":true,\"preview\":", len);
+    }
+
+    json_buf[(*offset)++] = '"';
+    if (as_text) *offset += json_escape_to(json_buf + *offset, data, n);
+    else if (mode == BINARY_MODE_HEX) *offset += hex_encode(data, n, json_buf + *offset);
+    else *offset += base64_encode(data, n, json_buf + *offset);
+    json_buf[(*offset)++] = '"';
+
+    if (truncated) json_buf[(*offset)++] = '}';
+    json_buf[*offset] = '\0';
+}
+
+// ============================================================================
+// JSON VALUES
+// ============================================================================
+
+#define PARTIAL_JSON_UPDATES 1      // value_options bit of a partial after image
+
+// JSON column of the before image, kept to rebuild a partially updated document
+typedef struct {
+    const unsigned char *data;      // NULL = absent from the image, or NULL
+    uint32_t len;
+} json_before_t;
+
+// Set while the after image of a PARTIAL_UPDATE_ROWS_EVENT row is decoded
+static struct {
+    const unsigned char *bits;      // partial_bits, one per JSON column of the table
+    json_before_t *before;          // by column index
+    uint32_t cap;
+} g_partial = { NULL, NULL, 0 };
+
+// Is the value of col_idx in the after image a diff rather than a document?
+static int partial_json_is_diff(uint32_t col_idx) {
+    if (!g_partial.bits || g_map.real_types[col_idx] != MT_JSON) return 0;
+    int ordinal = 0;
+    for (uint32_t i = 0; i < col_idx; i++) {
+        if (g_map.real_types[i] == MT_JSON) ordinal++;
+    }
+    return bit_get(g_partial.bits, ordinal);
+}
+
+// Text of a partial JSON value: the rebuilt document in "full" mode when the
+// before image has the column, otherwise {"json_patch":[...]}
+static long partial_json_text(const unsigned char *diff, uint32_t len, uint32_t col_idx,
+                              char *out, size_t size) {
+    const json_before_t *before = col_idx < g_partial.cap ? &g_partial.before[col_idx] : NULL;
+    if (g_config.partial_json == PARTIAL_JSON_FULL && before && before->data) {
+        long n = json_diff_apply(before->data, before->len, diff, len, out, size);
+        if (n >= 0) return n;
+        log_warn("JSON diff on %s.%s does not apply to the before image, sending the patch",
+                 g_map.db, g_map.tbl);
+    }
+
+    static const char prefix[] = "{\"json_patch\":";
+    size_t pre = sizeof(prefix) - 1;
+    long n = json_diff_to_patch(diff, len, size > pre ? out + pre : NULL,
+                                size > pre ? size - pre : 0);
+    if (n < 0) return -1;
+
+    size_t total = pre + (size_t)n + 1;
+    if (size > pre) memcpy(out, prefix, pre);
+    else if (size) out[0] = '\0';
+    if (total < size) {
+        out[total - 1] = '}';
+        out[total] = '\0';
+    }
+    return (long)total;
+}
+
+// JSON text of a JSON column value, snprintf style; -1 if malformed
+static long json_column_text(const unsigned char *data, uint32_t len, uint32_t col_idx,
+                             char *out, size_t size) {
+    if (partial_json_is_diff(col_idx)) return partial_json_text(data, len, col_idx, out, size);
+    return json_binary_to_text(data, len, out, size);
+}
+
+// Write a JSON column inline. Like BLOBs, a value that does not fit the
+// event is replaced by its digest rather than cut.
+static void append_json_value(char *json_buf, size_t buf_size, size_t *offset,
+                              const unsigned char *data, uint32_t len, uint32_t col_idx)
+{
+    size_t room = (!g_values_by_ref && *offset + BINARY_VALUE_RESERVE < buf_size)
+                  ? buf_size - *offset - BINARY_VALUE_RESERVE : 0;
+    long n = json_column_text(data, len, col_idx, json_buf + *offset, room);
+    if (n >= 0 && (size_t)n < room) {
+        *offset += n;
+        return;
+    }
+
+    if (n < 0) {
+        log_warn("Malformed JSON value in %s.%s, sending null", g_map.db, g_map.tbl);
+        json_appendf(json_buf, buf_size, offset, "null");
+        return;
+    }
+    log_warn("%ld byte JSON value of %s.%s does not fit the event, sending digest only",
+             n, g_map.db, g_map.tbl);
+    append_blob_stub(json_buf, buf_size, offset, data, len, "sha256");
+}
+
+// ============================================================================
+// DECIMAL / DATE / TIME / BIT / SET VALUES
+// ============================================================================
+
+// Bytes holding 0..9 leftover decimal digits
+static const int decimal_dig2bytes[10] = { 0, 1, 1, 2, 2, 3, 3, 4, 4, 4 };
+
+// Storage size of a NEWDECIMAL(precision, scale)
+static uint32_t decimal_bin_size(int precision, int scale) {
+    int intg = precision - scale;
+    return (intg / 9) * 4 + decimal_dig2bytes[intg % 9] +
+           (scale / 9) * 4 + decimal_dig2bytes[scale % 9];
+}
+
+static uint64_t be_uint(const unsigned char *p, int n) {
+    uint64_t v = 0;
+    for (int i = 0; i < n; i++) v = (v << 8) | p[i];
+    return v;
+}
+
+// Exact text of a NEWDECIMAL: groups of 9 digits in big-endian words, the
+// sign in the top bit and negative values stored inverted
+static void decimal_to_text(const unsigned char *p, int precision, int scale,
+                            char *out, size_t size) {
+    unsigned char buf[40];
+    uint32_t bin_size = decimal_bin_size(precision, scale);
+    if (scale > precision || bin_size == 0 || bin_size > sizeof(buf)) {
+        snprintf(out, size, "0");
+        return;
+    }
+    memcpy(buf, p, bin_size);
+    int negative = !(buf[0] & 0x80);
+    buf[0] ^= 0x80;
+    if (negative) {
+        for (uint32_t i = 0; i < bin_size; i++) buf[i] ^= 0xFF;
+    }
+
+    int intg = precision - scale;
+    int lead = decimal_dig2bytes[intg % 9];
+    const unsigned char *b = buf;
+    char digits[96];
+    size_t n = 0;
+
+    if (lead) {
+        n += sprintf(digits + n, "%0*u", intg % 9, (unsigned)be_uint(b, lead));
+        b += lead;
+    }
+    for (int i = 0; i < intg / 9; i++, b += 4) {
+        n += sprintf(digits + n, "%09u", (unsigned)be_uint(b, 4));
+    }
+    size_t skip = 0;
+    while (skip + 1 < n && digits[skip] == '0') skip++;
+
+    size_t len = snprintf(out, size, "%s%s", negative ? "-" : "", n ? digits + skip : "0");
+    if (scale > 0 && len < size) {
+        n = 0;
+        for (int i = 0; i < scale / 9; i++, b += 4) {
+            n += sprintf(digits + n, "%09u", (unsigned)be_uint(b, 4));
+        }
+        int trail = decimal_dig2bytes[scale % 9];
+        if (trail) n += sprintf(digits + n, "%0*u", scale % 9, (unsigned)be_uint(b, trail));
+        snprintf(out + len, size - len, ".%s", digits);
+    }
+}
+
+// TIME2: 3 byte biased integer part, then 0-3 bytes of fraction
+static void time2_to_text(const unsigned char *p, uint16_t fsp, char *out, size_t size) {
+    int64_t packed;
+    if (fsp >= 5) {
+        packed = (int64_t)be_uint(p, 6) - 0x800000000000LL;
+    } else {
+        int64_t intpart = (int64_t)be_uint(p, 3) - 0x800000;
+        int64_t frac = 0;
+        if (fsp >= 3) {
+            frac = (int64_t)be_uint(p + 3, 2);
+            if (intpart < 0 && frac) { intpart++; frac -= 0x10000; }
+            frac *= 100;
+        } else if (fsp >= 1) {
+            frac = p[3];
+            if (intpart < 0 && frac) { intpart++; frac -= 0x100; }
+            frac *= 10000;
+        }
+        packed = intpart * (1 << 24) + frac;
+    }
+
+    int negative = packed < 0;
+    if (negative) packed = -packed;
+    int64_t hms = packed >> 24;
+    unsigned usec = (unsigned)(packed % (1 << 24));
+    int len = snprintf(out, size, "%s%02d:%02d:%02d", negative ? "-" : "",
+                       (int)((hms >> 12) % (1 << 10)), (int)((hms >> 6) % (1 << 6)),
+                       (int)(hms % (1 << 6)));
+    if (fsp > 0 && len > 0 && (size_t)len < size) {
+        static const unsigned scale[7] = { 1000000, 100000, 10000, 1000, 100, 10, 1 };
+        snprintf(out + len, size - len, ".%0*u", fsp, usec / scale[fsp > 6 ? 6 : fsp]);
+    }
+}
+
+// Names of the members of a SET value, comma separated; -1 without them
+static int set_to_text(uint64_t bits, uint32_t col_idx, char *out, size_t size) {
+    if (!g_enum_cache || col_idx >= g_map.ncols) return -1;
+    enum_cache_t *cache = &g_enum_cache[col_idx];
+    if (!cache->loaded && g_map.column_names && g_map.column_names[col_idx]) {
+        load_enum_values_for_column(g_map.db, g_map.tbl, g_map.column_names[col_idx], cache);
+    }
+    if (!cache->loaded) return -1;
+
+    size_t len = 0;
+    out[0] = '\0';
+    for (int i = 0; i < cache->count && i < 64; i++) {
+        if (!(bits & (1ULL << i))) continue;
+        int n = snprintf(out + len, size - len, "%s%s", len ? "," : "", cache->values[i]);
+        if (n < 0 || (size_t)n >= size - len) return -1;
+        len += n;
+    }
+    return 0;
+}
+
+// Text of the column types without a dedicated encoding: NEWDECIMAL, DATE,
+// TIME, TIME2, DATETIME, BIT and SET. *quoted tells whether it is a JSON
+// string. Returns the advanced pointer, or p for other types.
+static const unsigned char* column_value_text(const unsigned char *p, uint32_t col_idx,
+                                              char *out, size_t size, int *quoted) {
+    uint16_t meta = g_map.metadata[col_idx];
+    *quoted = 1;
+
+    switch (g_map.real_types[col_idx]) {
+        case MT_NEWDECIMAL: {
+            int precision = meta & 0xFF, scale = meta >> 8;
+            decimal_to_text(p, precision, scale, out, size);
+            *quoted = 0;
+            return p + decimal_bin_size(precision, scale);
+        }
+        case MT_DATE:
+        case MT_NEWDATE: {
+            uint32_t v = le24(p);
+            snprintf(out, size, "%04u-%02u-%02u", v >> 9, (v >> 5) & 15, v & 31);
+            return p + 3;
+        }
+        case MT_TIME: {
+            int32_t v = le24(p);
+            if (v & 0x800000) v |= ~0xFFFFFF;
+            uint32_t a = v < 0 ? -v : v;
+            snprintf(out, size, "%s%02u:%02u:%02u", v < 0 ? "-" : "",
+                     a / 10000, (a / 100) % 100, a % 100);
+            return p + 3;
+        }
+        case MT_TIME2:
+            time2_to_text(p, meta, out, size);
+            return p + 3 + (meta + 1) / 2;
+        case MT_DATETIME: {
+            uint64_t v = le64(p);
+            uint64_t d = v / 1000000, t = v % 1000000;
+            snprintf(out, size, "%04u-%02u-%02u %02u:%02u:%02u",
+                     (unsigned)(d / 10000), (unsigned)(d / 100 % 100), (unsigned)(d % 100),
+                     (unsigned)(t / 10000), (unsigned)(t / 100 % 100), (unsigned)(t % 100));
+            return p + 8;
+        }
+        case MT_BIT: {
+            int len = (meta >> 8) + ((meta & 0xFF) ? 1 : 0);
+            snprintf(out, size, "%llu", (unsigned long long)be_uint(p, len > 8 ? 8 : len));
+            *quoted = 0;
+            return p + len;
+        }
+        case MT_SET: {
+            int len = meta >> 8;
+            uint64_t bits = 0;
+            for (int i = len - 1; i >= 0 && i < 8; i--) bits = (bits << 8) | p[i];
+            if (set_to_text(bits, col_idx, out, size) != 0) {
+                snprintf(out, size, "%llu", (unsigned long long)bits);
+                *quoted = 0;
+            }
+            return p + len;
+        }
+        default:
+            return p;
+    }
+}
+
+// ============================================================================
+// COLUMN VALUE PARSER (simplified - full implementation in original file)
+// ============================================================================
+
+// Signedness from the resolved schema; signed when unknown, as in SQL
+static int column_is_unsigned(uint32_t col_idx) {
+    return g_map.column_unsigned && col_idx < g_map.column_name_count &&
+           g_map.column_unsigned[col_idx];
+}
+
+static const unsigned char* append_column_value_to_json(
+    char *json_buf, size_t buf_size, size_t *offset,
+    const unsigned char *p,
+    uint32_t col_idx,
+    int is_null,
+    const char *col_name)
+{
+    // col_name == NULL writes a bare value (array row format)
+    if(col_name) {
+        json_appendf(json_buf, buf_size, offset, "\"%s\":", col_name);
+    }
+
+    if(is_null){
+        json_appendf(json_buf, buf_size, offset, "null");
+        return p;
+    }
+
+//    unsigned char type = g_map.types[col_idx];
+    unsigned char real_type = g_map.real_types[col_idx];
+    uint16_t meta = g_map.metadata[col_idx];
+
+    int is_unsigned = column_is_unsigned(col_idx);
+
+    switch(real_type){
+        case MT_TINY:
+            json_appendf(json_buf, buf_size, offset, "%d", is_unsigned ? *p : (int8_t)*p);
+            return p + 1;
+        case MT_SHORT:
+        case MT_YEAR:
+            json_appendf(json_buf, buf_size, offset, "%d",
+                         is_unsigned ? le16(p) : (int16_t)le16(p));
+            return p + 2;
+        case MT_INT24: {
+            int32_t v = le24(p);
+            if(!is_unsigned && (v & 0x800000)) v |= ~0xFFFFFF;
+            json_appendf(json_buf, buf_size, offset, "%d", v);
+            return p + 3;
+        }
+        case MT_LONG:
+            if(is_unsigned) json_appendf(json_buf, buf_size, offset, "%u", le32(p));
+            else json_appendf(json_buf, buf_size, offset, "%d", (int32_t)le32(p));
+            return p + 4;
+        case MT_LONGLONG:
+            if(is_unsigned) json_appendf(json_buf, buf_size, offset, "%llu",
+                                         (unsigned long long)le64(p));
+            else json_appendf(json_buf, buf_size, offset, "%lld", (long long)(int64_t)le64(p));
+            return p + 8;
+        case MT_FLOAT: {
+            float f;
+            memcpy(&f, p, 4);
+            json_appendf(json_buf, buf_size, offset, "%f", f);
+            return p + 4;
+        }
+        case MT_DOUBLE: {
+            double d;
+            memcpy(&d, p, 8);
+            json_appendf(json_buf, buf_size, offset, "%f", d);
+            return p + 8;
+        }
+        case MT_TIMESTAMP:
+            json_appendf(json_buf, buf_size, offset, "%u", le32(p));
             return p + 4;
         case MT_TIMESTAMP2: {
             uint32_t sec = ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) |
@@ -1211,25 +3104,23 @@ static const unsigned char* append_column_value_to_json(
                 time_t t = (time_t)sec;
                 struct tm *tm = localtime(&t);
                 if(tm){
-                    *offset += snprintf(json_buf + *offset, buf_size - *offset,
-                           "\"%04d-%02d-%02d %02d:%02d:%02d.%0*u\"",
-                           tm->tm_year + 1900, tm->tm_mon + 1, tm->tm_mday,
-                           tm->tm_hour, tm->tm_min, tm->tm_sec, meta, frac);
+                    json_appendf(json_buf, buf_size, offset,
+                                 "\"%04d-%02d-%02d %02d:%02d:%02d.%0*u\"",
+                                 tm->tm_year + 1900, tm->tm_mon + 1, tm->tm_mday,
+                                 tm->tm_hour, tm->tm_min, tm->tm_sec, meta, frac);
                 } else {
-                    *offset += snprintf(json_buf + *offset, buf_size - *offset,
-                                        "\"%u.%0*u\"", sec, meta, frac);
+                    json_appendf(json_buf, buf_size, offset, "\"%u.%0*u\"", sec, meta, frac);
                 }
             } else {
                 time_t t = (time_t)sec;
                 struct tm *tm = localtime(&t);
                 if(tm){
-                    *offset += snprintf(json_buf + *offset, buf_size - *offset,
-                           "\"%04d-%02d-%02d %02d:%02d:%02d\"",
-                           tm->tm_year + 1900, tm->tm_mon + 1, tm->tm_mday,
-                           tm->tm_hour, tm->tm_min, tm->tm_sec);
+                    json_appendf(json_buf, buf_size, offset,
+                                 "\"%04d-%02d-%02d %02d:%02d:%02d\"",
+                                 tm->tm_year + 1900, tm->tm_mon + 1, tm->tm_mday,
+                                 tm->tm_hour, tm->tm_min, tm->tm_sec);
                 } else {
-                    *offset += snprintf(json_buf + *offset, buf_size - *offset,
-                                        "\"%u\"", sec);
+                    json_appendf(json_buf, buf_size, offset, "\"%u\"", sec);
                 }
             }
             return p;
@@ -1249,9 +3140,8 @@ static const unsigned char* append_column_value_to_json(
             int hour = hms >> 12;
             int min = (hms >> 6) & 0x3F;
             int sec = hms & 0x3F;
-            *offset += snprintf(json_buf + *offset, buf_size - *offset,
-                   "\"%04d-%02d-%02d %02d:%02d:%02d\"",
-                   year, mon, day, hour, min, sec);
+            json_appendf(json_buf, buf_size, offset, "\"%04d-%02d-%02d %02d:%02d:%02d\"",
+                         year, mon, day, hour, min, sec);
             if(meta > 0) {
                 int frac_bytes = (meta + 1) / 2;
                 p += frac_bytes;
@@ -1266,19 +3156,7 @@ static const unsigned char* append_column_value_to_json(
                 len = le16(p);
                 p += 2;
             }
-            *offset += snprintf(json_buf + *offset, buf_size - *offset, "\"");
-            for(unsigned i = 0; i < len && *offset < buf_size - 10; i++) {
-                char c = p[i];
-                if(c == '"') *offset += snprintf(json_buf + *offset, buf_size - *offset, "\\\"");
-                else if(c == '\\') *offset += snprintf(json_buf + *offset, buf_size - *offset, "\\\\");
-                else if(c == '\n') *offset += snprintf(json_buf + *offset, buf_size - *offset, "\\n");
-                else if(c == '\r') *offset += snprintf(json_buf + *offset, buf_size - *offset, "\\r");
-                else if(c == '\t') *offset += snprintf(json_buf + *offset, buf_size - *offset, "\\t");
-                else if((unsigned char)c < 32)
-                    *offset += snprintf(json_buf + *offset, buf_size - *offset, "\\u%04x", (unsigned char)c);
-                else json_buf[(*offset)++] = c;
-            }
-            *offset += snprintf(json_buf + *offset, buf_size - *offset, "\"");
+            append_json_string(json_buf, buf_size, offset, p, len);
             return p + len;
         }
         case MT_BLOB: {
@@ -1287,20 +3165,36 @@ static const unsigned char* append_column_value_to_json(
                 len |= (uint32_t)p[i] << (8 * i);
             }
             p += meta;
-            unsigned display_len = len > 200 ? 200 : len;
-            *offset += snprintf(json_buf + *offset, buf_size - *offset, "\"");
-            for(unsigned i = 0; i < display_len && *offset < buf_size - 10; i++) {
-                char c = p[i];
-                if(c == '"') *offset += snprintf(json_buf + *offset, buf_size - *offset, "\\\"");
-                else if(c == '\\') *offset += snprintf(json_buf + *offset, buf_size - *offset, "\\\\");
-                else if(c < 32 || c > 126)
-                    *offset += snprintf(json_buf + *offset, buf_size - *offset, ".");
-                else json_buf[(*offset)++] = c;
+            const binary_column_t *opts = g_map.binary_opts ? g_map.binary_opts[col_idx] : NULL;
+            int is_text = g_map.column_binary ? !g_map.column_binary[col_idx] : 0;
+            append_blob_value(json_buf, buf_size, offset, p, len, opts, is_text);
+            return p + len;
+        }
+        case MT_GEOMETRY: {
+            // Stored like a BLOB: 4 byte SRID (LE) followed by WKB
+            uint32_t len = 0;
+            for(unsigned i = 0; i < meta; i++){
+                len |= (uint32_t)p[i] << (8 * i);
             }
-            if(len > 200) {
-                *offset += snprintf(json_buf + *offset, buf_size - *offset, "...");
+            p += meta;
+            if(len < 4) {
+                json_appendf(json_buf, buf_size, offset, "null");
+                return p + len;
             }
-            *offset += snprintf(json_buf + *offset, buf_size - *offset, "\"");
+            const binary_column_t *opts = g_map.binary_opts ? g_map.binary_opts[col_idx] : NULL;
+            json_appendf(json_buf, buf_size, offset, "{\"srid\":%u,\"wkb\":", le32(p));
+            append_blob_value(json_buf, buf_size, offset, p + 4, len - 4,
+                              opts ? opts : &g_config.binary, 0);
+            json_appendf(json_buf, buf_size, offset, "}");
+            return p + len;
+        }
+        case MT_JSON: {
+            uint32_t len = 0;
+            for(unsigned i = 0; i < meta; i++){
+                len |= (uint32_t)p[i] << (8 * i);
+            }
+            p += meta;
+            append_json_value(json_buf, buf_size, offset, p, len, col_idx);
             return p + len;
         }
         case MT_ENUM: {
@@ -1334,21 +3228,10 @@ static const unsigned char* append_column_value_to_json(
             }
 
             if (enum_str) {
-                *offset += snprintf(json_buf + *offset, buf_size - *offset, "\"");
-                for (const char *s = enum_str; *s && *offset < buf_size - 10; s++) {
-                    char c = *s;
-                    if (c == '"') *offset += snprintf(json_buf + *offset, buf_size - *offset, "\\\"");
-                    else if (c == '\\') *offset += snprintf(json_buf + *offset, buf_size - *offset, "\\\\");
-                    else if (c == '\n') *offset += snprintf(json_buf + *offset, buf_size - *offset, "\\n");
-                    else if (c == '\r') *offset += snprintf(json_buf + *offset, buf_size - *offset, "\\r");
-                    else if (c == '\t') *offset += snprintf(json_buf + *offset, buf_size - *offset, "\\t");
-                    else if ((unsigned char)c < 32)
-                        *offset += snprintf(json_buf + *offset, buf_size - *offset, "\\u%04x", (unsigned char)c);
-                    else json_buf[(*offset)++] = c;
-                }
-                *offset += snprintf(json_buf + *offset, buf_size - *offset, "\"");
+                append_json_string(json_buf, buf_size, offset,
+                                   (const unsigned char *)enum_str, strlen(enum_str));
             } else {
-                *offset += snprintf(json_buf + *offset, buf_size - *offset, "%u", enum_val);
+                json_appendf(json_buf, buf_size, offset, "%u", enum_val);
             }
             return p;
         }
@@ -1361,24 +3244,23 @@ static const unsigned char* append_column_value_to_json(
                 len = le16(p);
                 p += 2;
             }
-            *offset += snprintf(json_buf + *offset, buf_size - *offset, "\"");
-            for(unsigned i = 0; i < len && *offset < buf_size - 10; i++) {
-                char c = p[i];
-                if(c == '"') *offset += snprintf(json_buf + *offset, buf_size - *offset, "\\\"");
-                else if(c == '\\') *offset += snprintf(json_buf + *offset, buf_size - *offset, "\\\\");
-                else if(c == '\n') *offset += snprintf(json_buf + *offset, buf_size - *offset, "\\n");
-                else if(c == '\r') *offset += snprintf(json_buf + *offset, buf_size - *offset, "\\r");
-                else if(c == '\t') *offset += snprintf(json_buf + *offset, buf_size - *offset, "\\t");
-                else if((unsigned char)c < 32)
-                    *offset += snprintf(json_buf + *offset, buf_size - *offset, "\\u%04x", (unsigned char)c);
-                else json_buf[(*offset)++] = c;
-            }
-            *offset += snprintf(json_buf + *offset, buf_size - *offset, "\"");
+            append_json_string(json_buf, buf_size, offset, p, len);
             return p + len;
         }
-        default:
-            *offset += snprintf(json_buf + *offset, buf_size - *offset, "null");
-            return p;
+        default: {
+            char text[1024];
+            int quoted;
+            const unsigned char *next = column_value_text(p, col_idx, text, sizeof(text), &quoted);
+            if (next == p) {
+                json_appendf(json_buf, buf_size, offset, "null");
+            } else if (quoted) {
+                append_json_string(json_buf, buf_size, offset,
+                                   (const unsigned char*)text, strlen(text));
+            } else {
+                json_appendf(json_buf, buf_size, offset, "%s", text);
+            }
+            return next;
+        }
     }
 }
 
@@ -1410,7 +3292,9 @@ static const unsigned char* skip_column_value(const unsigned char *p, uint32_t c
             else { len = le16(p); p += 2; }
             return p + len;
         }
-        case MT_BLOB: {
+        case MT_BLOB:
+        case MT_GEOMETRY:
+        case MT_JSON: {
             uint32_t len = 0;
             for(unsigned i = 0; i < meta; i++)
                 len |= (uint32_t)p[i] << (8 * i);
@@ -1428,13 +3312,457 @@ static const unsigned char* skip_column_value(const unsigned char *p, uint32_t c
             else { len = le16(p); p += 2; }
             return p + len;
         }
+        case MT_NEWDECIMAL: return p + decimal_bin_size(meta & 0xFF, meta >> 8);
+        case MT_DATE:
+        case MT_NEWDATE:
+        case MT_TIME:      return p + 3;
+        case MT_TIME2:     return p + 3 + (meta + 1) / 2;
+        case MT_DATETIME:  return p + 8;
+        case MT_BIT:       return p + (meta >> 8) + ((meta & 0xFF) ? 1 : 0);
+        case MT_SET:       return p + (meta >> 8);
         default:
             return p;
     }
 }
 
+// ============================================================================
+// PARTIAL JSON UPDATES
+// ============================================================================
+
+// Record the JSON values of a before image; the after image that follows
+// may carry diffs against them
+static void partial_json_begin_row(const unsigned char *p, size_t len, uint32_t ncols,
+                                   const unsigned char *present) {
+    if (ncols > g_partial.cap) {
+        json_before_t *before = realloc(g_partial.before, ncols * sizeof(json_before_t));
+        if (before) {
+            g_partial.before = before;
+            g_partial.cap = ncols;
+        }
+    }
+    if (!g_partial.before) return;
+    memset(g_partial.before, 0, g_partial.cap * sizeof(json_before_t));
+
+    const unsigned char *start = p;
+    uint32_t bmp_len = (count_present_columns(present, ncols) + 7) >> 3;
+    if (len < bmp_len) return;
+    const unsigned char *nullmap = p;
+    p += bmp_len;
+
+    int seen = 0;
+    for (uint32_t i = 0; i < ncols && i < g_map.ncols && i < g_partial.cap; i++) {
+        if (!bit_get(present, i)) continue;
+        if (bit_get(nullmap, seen++)) continue;
+
+        if (g_map.real_types[i] == MT_JSON) {
+            uint16_t meta = g_map.metadata[i];
+            if ((size_t)(p - start) + meta > len) return;
+            uint32_t vlen = 0;
+            for (unsigned k = 0; k < meta; k++) vlen |= (uint32_t)p[k] << (8 * k);
+            if ((size_t)(p - start) + meta + vlen > len) return;
+            g_partial.before[i].data = p + meta;
+            g_partial.before[i].len = vlen;
+        }
+        p = skip_column_value(p, i);
+        if ((size_t)(p - start) > len) return;
+    }
+}
+
+// Consume the value_options (and partial_bits) ahead of a partial update
+// after image
+static int partial_json_after_image(const unsigned char **p_ptr, size_t *len_ptr) {
+    const unsigned char *p = *p_ptr;
+    size_t len = *len_ptr;
+
+    // Length-encoded integer
+    if (len < 1) return -1;
+    size_t used = p[0] < 251 ? 1 : p[0] == 252 ? 3 : p[0] == 253 ? 4 : p[0] == 254 ? 9 : 0;
+    if (used == 0 || len < used) return -1;
+    uint64_t options = p[0];
+    if (used > 1) {
+        options = 0;
+        for (size_t i = used - 1; i >= 1; i--) options = (options << 8) | p[i];
+    }
+    p += used;
+    len -= used;
+
+    g_partial.bits = NULL;
+    if (options & PARTIAL_JSON_UPDATES) {
+        uint32_t json_cols = 0;
+        for (uint32_t i = 0; i < g_map.ncols; i++) {
+            if (g_map.real_types[i] == MT_JSON) json_cols++;
+        }
+        uint32_t bits_len = (json_cols + 7) >> 3;
+        if (len < bits_len) return -1;
+        g_partial.bits = p;
+        p += bits_len;
+        len -= bits_len;
+    }
+
+    *p_ptr = p;
+    *len_ptr = len;
+    return 0;
+}
+
+static void partial_json_end_row(void) {
+    g_partial.bits = NULL;
+}
+
+// ============================================================================
+// ROW ENRICHMENT
+// ============================================================================
+
+// Lookup keys are the JSON text of the value without the quotes of strings,
+// so keys read by SELECT and keys decoded from row images compare equal.
+// That needs row images decoded with the column's UNSIGNED flag, as
+// append_column_value_to_json() does: a signed INT -1 is "-1" in both.
+static size_t enrich_key_from_json(const char *json, size_t len, char *key) {
+    if (len >= 2 && json[0] == '"' && json[len - 1] == '"') {
+        json++;
+        len -= 2;
+    }
+    if (len >= ENRICH_KEY_MAX) len = ENRICH_KEY_MAX - 1;
+    memcpy(key, json, len);
+    key[len] = '\0';
+    return len;
+}
+
+// JSON text of a value read by SELECT; out must hold json_escaped_len + 3
+static size_t enrich_json_from_text(const char *v, unsigned long len, int numeric, char *out) {
+    if (!v) return (size_t)sprintf(out, "null");
+    if (numeric) {
+        memcpy(out, v, len);
+        out[len] = '\0';
+        return len;
+    }
+    size_t n = 0;
+    out[n++] = '"';
+    n += json_escape_to(out + n, (const unsigned char*)v, len);
+    out[n++] = '"';
+    out[n] = '\0';
+    return n;
+}
+
+// Fill the cache of one rule with SELECT key, columns... FROM the lookup table
+static int load_enrich_rule(enrich_rule_t *r) {
+    if (!g_metadata_conn) return -1;
+
+    size_t qcap = 256 + strlen(r->key);
+    for (int c = 0; c < r->column_count; c++) qcap += strlen(r->columns[c]) + 4;
+    char *query = malloc(qcap);
+    if (!query) return -1;
+    size_t qoff = snprintf(query, qcap, "SELECT `%s`", r->key);
+    for (int c = 0; c < r->column_count; c++)
+        qoff += snprintf(query + qoff, qcap - qoff, ",`%s`", r->columns[c]);
+    snprintf(query + qoff, qcap - qoff, " FROM `%s`.`%s`", r->src_db, r->src_tbl);
+
+    int rc = mysql_query(g_metadata_conn, query);
+    free(query);
+    if (rc != 0) {
+        log_error("Cannot load enrich table %s.%s: %s", r->src_db, r->src_tbl,
+                  mysql_error(g_metadata_conn));
+        return -1;
+    }
+
+    MYSQL_RES *res = mysql_use_result(g_metadata_conn);
+    if (!res) {
+        log_error("No result loading enrich table %s.%s: %s", r->src_db, r->src_tbl,
+                  mysql_error(g_metadata_conn));
+        return -1;
+    }
+
+    MYSQL_FIELD *fields = mysql_fetch_fields(res);
+    const char *values[ENRICH_MAX_COLUMNS];
+    size_t lens[ENRICH_MAX_COLUMNS];
+    char *bufs[ENRICH_MAX_COLUMNS] = { NULL };
+    size_t caps[ENRICH_MAX_COLUMNS] = { 0 };
+    int ok = 1;
+
+    MYSQL_ROW row;
+    while (ok && (row = mysql_fetch_row(res))) {
+        unsigned long *flens = mysql_fetch_lengths(res);
+        if (!row[0]) continue;
+
+        char key_json[ENRICH_KEY_MAX * 6 + 3];
+        char key[ENRICH_KEY_MAX];
+        unsigned long klen = flens[0] < ENRICH_KEY_MAX ? flens[0] : ENRICH_KEY_MAX - 1;
+        size_t kj = enrich_json_from_text(row[0], klen, IS_NUM(fields[0].type), key_json);
+        size_t key_len = enrich_key_from_json(key_json, kj, key);
+
+        for (int c = 0; c < r->column_count; c++) {
+            size_t need = row[c + 1] ? json_escaped_len((const unsigned char*)row[c + 1],
+                                                        flens[c + 1]) + 3 : 8;
+            if (need > caps[c]) {
+                char *nb = realloc(bufs[c], need);
+                if (!nb) { ok = 0; break; }
+                bufs[c] = nb;
+                caps[c] = need;
+            }
+            lens[c] = enrich_json_from_text(row[c + 1], flens[c + 1],
+                                            IS_NUM(fields[c + 1].type), bufs[c]);
+            values[c] = bufs[c];
+        }
+        if (ok && lookup_cache_put(r->cache, key, key_len, values, lens) != 0) ok = 0;
+    }
+    mysql_free_result(res);
+    for (int c = 0; c < r->column_count; c++) free(bufs[c]);
+
+    if (!ok) {
+        log_error("Out of memory loading enrich table %s.%s", r->src_db, r->src_tbl);
+        return -1;
+    }
+    log_info("Enrich cache %s.%s: loaded %zu row(s) (%zu KB)", r->src_db, r->src_tbl,
+             lookup_cache_count(r->cache), lookup_cache_bytes(r->cache) / 1024);
+    return 0;
+}
+
+static void load_enrich_tables(void) {
+    for (int i = 0; i < g_config.database_count; i++) {
+        database_config_t *db_cfg = &g_config.databases[i];
+        for (int j = 0; j < db_cfg->table_count; j++) {
+            table_config_t *tbl_cfg = &db_cfg->tables[j];
+            for (int k = 0; k < tbl_cfg->enrich_count; k++) {
+                load_enrich_rule(&tbl_cfg->enrich[k]);
+            }
+        }
+    }
+}
+
+// Resolve the lookup table columns of a rule against the current table map
+static int enrich_resolve_source(enrich_rule_t *r) {
+    if (r->src_generation == g_map_generation) return r->src_idx[0] >= 0 ? 0 : -1;
+
+    for (int c = 0; c <= r->column_count; c++) {
+        const char *want = c == 0 ? r->key : r->columns[c - 1];
+        r->src_idx[c] = -1;
+        for (uint32_t i = 0; g_map.column_names && i < g_map.ncols; i++) {
+            if (g_map.column_names[i] && strcmp(g_map.column_names[i], want) == 0) {
+                r->src_idx[c] = i;
+                break;
+            }
+        }
+        if (r->src_idx[c] < 0) {
+            log_warn("Enrich column %s not found in %s.%s", want, r->src_db, r->src_tbl);
+        }
+    }
+    r->src_generation = g_map_generation;
+    return r->src_idx[0] >= 0 ? 0 : -1;
+}
+
+// Decode the columns a rule needs from one row image into buf. starts[c]
+// is (size_t)-1 for columns missing from the image.
+static int enrich_decode_row(const unsigned char **p_ptr, size_t *len_ptr,
+                             uint32_t ncols, const unsigned char *present,
+                             const enrich_rule_t *r, char *buf, size_t buf_size,
+                             size_t *starts, size_t *ends)
+{
+    const unsigned char *p = *p_ptr;
+    const unsigned char *start_p = p;
+    size_t len = *len_ptr;
+    size_t off = 0;
+
+    uint32_t bmp_len = (count_present_columns(present, ncols) + 7) >> 3;
+    if (len < bmp_len) return -1;
+    const unsigned char *nullmap = p;
+    p += bmp_len;
+
+    for (int c = 0; c <= r->column_count; c++) starts[c] = ends[c] = (size_t)-1;
+
+    int seen = 0;
+    for (uint32_t i = 0; i < ncols; i++) {
+        if (!bit_get(present, i)) continue;
+        int is_null = bit_get(nullmap, seen++);
+
+        // The key may also be one of the added columns: decode once
+        int decoded = -1;
+        for (int c = 0; c <= r->column_count && i < g_map.ncols; c++) {
+            if (r->src_idx[c] != (int)i) continue;
+            if (decoded >= 0) {
+                starts[c] = starts[decoded];
+                ends[c] = ends[decoded];
+            } else if (off + 4096 < buf_size) {
+                const unsigned char *old_p = p;
+                starts[c] = off;
+                p = append_column_value_to_json(buf, buf_size, &off, p, i, is_null, NULL);
+                if (p == old_p && !is_null) return -1;
+                ends[c] = off;
+                decoded = c;
+            }
+        }
+        if (decoded < 0 && !is_null) p = skip_column_value(p, i);
+        if ((size_t)(p - start_p) > len) return -1;
+    }
+
+    *p_ptr = p;
+    *len_ptr = len - (p - start_p);
+    return 0;
+}
+
+// Apply one decoded row to a rule's cache; missing columns keep their cached value
+static void enrich_apply_row(enrich_rule_t *r, const char *buf,
+                             const size_t *starts, const size_t *ends,
+                             const char *fallback_key, size_t fallback_len) {
+    char key[ENRICH_KEY_MAX];
+    size_t key_len;
+    if (starts[0] != (size_t)-1) {
+        key_len = enrich_key_from_json(buf + starts[0], ends[0] - starts[0], key);
+    } else if (fallback_key) {
+        memcpy(key, fallback_key, fallback_len + 1);
+        key_len = fallback_len;
+    } else {
+        return;
+    }
+
+    const char *old[ENRICH_MAX_COLUMNS];
+    int have_old = lookup_cache_get(r->cache, key, key_len, old) == 0;
+
+    // Copies, since put replaces the entry old points into
+    char stack_tmp[8192];
+    char *tmp = stack_tmp;
+    size_t need = 0;
+    for (int c = 0; have_old && c < r->column_count; c++) {
+        if (starts[c + 1] == (size_t)-1) need += strlen(old[c]);
+    }
+    if (need > sizeof(stack_tmp) && !(tmp = malloc(need))) {
+        log_error("Out of memory updating enrich cache %s.%s, key %s dropped",
+                  r->src_db, r->src_tbl, key);
+        lookup_cache_remove(r->cache, key, key_len);
+        return;
+    }
+
+    size_t toff = 0;
+    const char *values[ENRICH_MAX_COLUMNS];
+    size_t lens[ENRICH_MAX_COLUMNS];
+    for (int c = 0; c < r->column_count; c++) {
+        const char *v = "null";
+        size_t vlen = 4;
+        if (starts[c + 1] != (size_t)-1) {
+            v = buf + starts[c + 1];
+            vlen = ends[c + 1] - starts[c + 1];
+        } else if (have_old) {
+            vlen = strlen(old[c]);
+            memcpy(tmp + toff, old[c], vlen);
+            v = tmp + toff;
+            toff += vlen;
+        }
+        values[c] = v;
+        lens[c] = vlen;
+    }
+    lookup_cache_put(r->cache, key, key_len, values, lens);
+    if (tmp != stack_tmp) free(tmp);
+}
+
+// Keep the caches of every rule using the current table as lookup table
+// up to date with one of its rows events
+static void enrich_refresh(int is_update, int is_delete,
+                           const unsigned char *row_data, size_t row_len, uint32_t ncols,
+                           const unsigned char *before_present,
+                           const unsigned char *after_present, int partial)
+{
+    static char buf[65536];
+    size_t starts[ENRICH_MAX_COLUMNS + 1], ends[ENRICH_MAX_COLUMNS + 1];
+    size_t bstarts[ENRICH_MAX_COLUMNS + 1], bends[ENRICH_MAX_COLUMNS + 1];
+
+    for (int i = 0; i < g_config.database_count; i++) {
+        database_config_t *db_cfg = &g_config.databases[i];
+        for (int j = 0; j < db_cfg->table_count; j++) {
+            table_config_t *tbl_cfg = &db_cfg->tables[j];
+            for (int k = 0; k < tbl_cfg->enrich_count; k++) {
+                enrich_rule_t *r = &tbl_cfg->enrich[k];
+                if (strcmp(r->src_db, g_map.db) != 0 || strcmp(r->src_tbl, g_map.tbl) != 0) continue;
+                if (enrich_resolve_source(r) != 0) continue;
+
+                const unsigned char *p = row_data;
+                size_t len = row_len;
+                int rows = 0;
+                while (len > 0) {
+                    if (partial) partial_json_begin_row(p, len, ncols, before_present);
+                    if (enrich_decode_row(&p, &len, ncols, before_present, r,
+                                          buf, sizeof(buf) / 2, bstarts, bends) != 0) break;
+                    char before_key[ENRICH_KEY_MAX];
+                    size_t before_len = 0;
+                    if (bstarts[0] != (size_t)-1) {
+                        before_len = enrich_key_from_json(buf + bstarts[0],
+                                                          bends[0] - bstarts[0], before_key);
+                    }
+
+                    if (is_delete) {
+                        if (bstarts[0] != (size_t)-1) lookup_cache_remove(r->cache, before_key, before_len);
+                    } else if (!is_update) {
+                        enrich_apply_row(r, buf, bstarts, bends, NULL, 0);
+                    } else {
+                        // The after image is decoded into the second half of buf
+                        if (partial && partial_json_after_image(&p, &len) != 0) break;
+                        int rc = enrich_decode_row(&p, &len, ncols, after_present, r,
+                                                   buf + sizeof(buf) / 2, sizeof(buf) / 2,
+                                                   starts, ends);
+                        partial_json_end_row();
+                        if (rc != 0) break;
+                        const char *abuf = buf + sizeof(buf) / 2;
+                        if (bstarts[0] != (size_t)-1 && starts[0] != (size_t)-1) {
+                            char after_key[ENRICH_KEY_MAX];
+                            size_t after_len = enrich_key_from_json(abuf + starts[0],
+                                                                    ends[0] - starts[0], after_key);
+                            if (after_len != before_len || memcmp(after_key, before_key, after_len) != 0) {
+                                // Key changed: carry the old values over, then drop the old key
+                                const char *old[ENRICH_MAX_COLUMNS];
+                                if (lookup_cache_get(r->cache, before_key, before_len, old) == 0) {
+                                    size_t lens[ENRICH_MAX_COLUMNS];
+                                    for (int c = 0; c < r->column_count; c++) lens[c] = strlen(old[c]);
+                                    lookup_cache_put(r->cache, after_key, after_len, old, lens);
+                                    lookup_cache_remove(r->cache, before_key, before_len);
+                                }
+                            }
+                        }
+                        enrich_apply_row(r, abuf, starts, ends,
+                                         bstarts[0] != (size_t)-1 ? before_key : NULL, before_len);
+                    }
+                    rows++;
+                }
+                log_trace("Enrich cache %s.%s: %d row(s) applied, %zu entries",
+                          r->src_db, r->src_tbl, rows, lookup_cache_count(r->cache));
+            }
+        }
+    }
+}
+
+// Object rows: append the enrichment columns for the join keys found in the row
+static void enrich_append_columns(table_config_t *tbl_cfg,
+                                  char join_keys[][ENRICH_KEY_MAX], const size_t *join_lens,
+                                  const int *join_found, int *first,
+                                  char *json_buf, size_t buf_size, size_t *json_offset)
+{
+    for (int k = 0; k < tbl_cfg->enrich_count; k++) {
+        enrich_rule_t *r = &tbl_cfg->enrich[k];
+        const char *values[ENRICH_MAX_COLUMNS];
+        int hit = join_found[k] &&
+                  lookup_cache_get(r->cache, join_keys[k], join_lens[k], values) == 0;
+
+        for (int c = 0; c < r->column_count; c++) {
+            // A cached value that does not fit fills the buffer, so the row
+            // moves to a message of its own; there it goes out as null
+            const char *value = hit ? values[c] : "null";
+            size_t need = strlen(value) + strlen(r->prefix) + strlen(r->columns[c]) + 8;
+            if (hit && json_buffer_full(buf_size, *json_offset, need)) {
+                if (!g_values_by_ref) {
+                    *json_offset = buf_size - 1;
+                    return;
+                }
+                log_warn("Enrichment %s%s of %s.%s does not fit the event, sending null",
+                         r->prefix, r->columns[c], g_map.db, g_map.tbl);
+                value = "null";
+            }
+            json_appendf(json_buf, buf_size, json_offset, "%s\"%s%s\":%s",
+                         *first ? "" : ",", r->prefix, r->columns[c], value);
+            *first = 0;
+        }
+    }
+}
+
 static int parse_row_to_json_filtered(const unsigned char **p_ptr, size_t *len_ptr,
                                       uint32_t ncols, const unsigned char *present,
+                                      const char **names, int format,
+                                      table_config_t *enrich,
                                       char *json_buf, size_t buf_size, size_t *json_offset)
 {
     const unsigned char *p   = *p_ptr;
@@ -1450,59 +3778,348 @@ static int parse_row_to_json_filtered(const unsigned char **p_ptr, size_t *len_p
     const unsigned char *nullmap = p;
     p += bmp_len;
 
-    *json_offset += snprintf(json_buf + *json_offset, buf_size - *json_offset, "{");
+    int as_array = (format == PROFILE_FORMAT_ARRAY);
+    json_appendf(json_buf, buf_size, json_offset, as_array ? "[" : "{");
 
     int first = 1;
     int seen  = 0;
 
-    table_config_t *tbl_cfg = find_table_config(g_map.db, g_map.tbl);
+    // Enrichment applies to object rows; join keys are collected on the way
+    int nrules = (enrich && !as_array) ? enrich->enrich_count : 0;
+    char join_keys[ENRICH_MAX_RULES][ENRICH_KEY_MAX];
+    size_t join_lens[ENRICH_MAX_RULES];
+    int join_found[ENRICH_MAX_RULES] = {0};
 
     for (uint32_t i = 0; i < ncols; ++i) {
         if (!bit_get(present, i)) continue;
 
         int is_null = bit_get(nullmap, seen++);
 
-        int should_include = 0;
-        const char *col_name = NULL;
+        const char *col_name = (names && i < g_map.ncols) ? names[i] : NULL;
+        int should_include = (col_name != NULL);
+        if (as_array) col_name = NULL;
 
-        if(tbl_cfg) {
-            if(tbl_cfg->capture_all_columns) {
-                should_include = 1;
-                col_name = (i < g_map.ncols && g_map.column_names && g_map.column_names[i])
-                           ? g_map.column_names[i]
-                           : "unknown";
-            } else {
-                for(int j = 0; j < tbl_cfg->column_count; j++) {
-                    if(tbl_cfg->columns[j].index == (int)i) {
-                        should_include = 1;
-                        col_name = tbl_cfg->columns[j].name;
-                        break;
-                    }
-                }
-            }
+        int is_join = 0;
+        for (int k = 0; k < nrules; k++) {
+            if (g_map.join_idx[k] == (int)i) is_join = 1;
         }
 
+        const char *value_json = NULL;
+        size_t value_len = 0;
+        char scratch[ENRICH_KEY_MAX + 16];
+
         if(!should_include) {
-            if(!is_null) p = skip_column_value(p, i);
-            continue;
+            if(is_join && !is_null) {
+                size_t soff = 0;
+                const unsigned char *old_p = p;
+                p = append_column_value_to_json(scratch, sizeof(scratch), &soff, p, i, 0, NULL);
+                if(p == old_p) return -1;
+                value_json = scratch;
+                value_len = soff < sizeof(scratch) ? soff : sizeof(scratch) - 1;
+            } else if(!is_null) {
+                p = skip_column_value(p, i);
+            }
+        } else {
+            if(!first) {
+                json_appendf(json_buf, buf_size, json_offset, ",");
+            }
+            first = 0;
+
+            const unsigned char *old_p = p;
+            size_t value_start = *json_offset + (col_name ? strlen(col_name) + 3 : 0);
+            p = append_column_value_to_json(json_buf, buf_size, json_offset, p, i, is_null, col_name);
+            if(p == old_p && !is_null) return -1;
+            if(is_join && !is_null && !json_buffer_full(buf_size, *json_offset, 0)) {
+                value_json = json_buf + value_start;
+                value_len = *json_offset - value_start;
+            }
         }
 
-        if(!first) {
-            *json_offset += snprintf(json_buf + *json_offset, buf_size - *json_offset, ",");
+        if(value_json) {
+            for (int k = 0; k < nrules; k++) {
+                if (g_map.join_idx[k] != (int)i) continue;
+                join_lens[k] = enrich_key_from_json(value_json, value_len, join_keys[k]);
+                join_found[k] = 1;
+            }
         }
-        first = 0;
-
-        const unsigned char *old_p = p;
-        p = append_column_value_to_json(json_buf, buf_size, json_offset, p, i, is_null, col_name);
-        if(p == old_p && !is_null) return -1;
 
         size_t consumed = p - start_p;
         if(consumed > len) return -1;
     }
 
-    *json_offset += snprintf(json_buf + *json_offset, buf_size - *json_offset, "}");
+    if (nrules > 0) {
+        enrich_append_columns(enrich, join_keys, join_lens, join_found, &first,
+                              json_buf, buf_size, json_offset);
+    }
+
+    json_appendf(json_buf, buf_size, json_offset, as_array ? "]" : "}");
+
+    size_t consumed = p - start_p;
+    *p_ptr = p;
+    *len_ptr = len - consumed;
+    return 0;
+}
+
+// ============================================================================
+// COLUMNAR ROW DECODER
+// ============================================================================
+
+// Vector type a column decodes to; mirrors append_column_value_to_json
+static int columnar_type(uint32_t col_idx) {
+    switch (g_map.real_types[col_idx]) {
+        case MT_TINY:
+        case MT_SHORT:
+        case MT_YEAR:
+        case MT_INT24:
+        case MT_LONG:
+        case MT_TIMESTAMP:  return CDC_COL_INT64;
+        case MT_LONGLONG:
+            return column_is_unsigned(col_idx) ? CDC_COL_UINT64 : CDC_COL_INT64;
+        case MT_BIT:        return CDC_COL_UINT64;
+        case MT_FLOAT:
+        case MT_DOUBLE:     return CDC_COL_DOUBLE;
+        case MT_TIMESTAMP2: return CDC_COL_TIMESTAMP;
+        case MT_DATETIME2:  return CDC_COL_DATETIME;
+        case MT_BLOB:
+            return (g_map.column_binary && !g_map.column_binary[col_idx]) ?
+                   CDC_COL_STRING : CDC_COL_BINARY;
+        case MT_GEOMETRY:   return CDC_COL_BINARY;
+        default:            return CDC_COL_STRING;     // JSON, DECIMAL, DATE, TIME, SET as text
+    }
+}
+
+// Fractional seconds of TIMESTAMP2/DATETIME2 in microseconds
+static const unsigned char* read_fraction_usec(const unsigned char *p, uint16_t meta,
+                                               int64_t *usec) {
+    static const int64_t scale[4] = { 0, 10000, 100, 1 };
+    *usec = 0;
+    if (meta == 0) return p;
+    int frac_bytes = (meta + 1) / 2;
+    uint32_t frac = 0;
+    for (int i = 0; i < frac_bytes; i++) frac = (frac << 8) | *p++;
+    *usec = (int64_t)frac * scale[frac_bytes];
+    return p;
+}
+
+// Days since 1970-01-01 of a proleptic Gregorian date
+static int64_t days_from_civil(int y, int m, int d) {
+    y -= m <= 2;
+    int64_t era = (y >= 0 ? y : y - 399) / 400;
+    int64_t yoe = y - era * 400;
+    int64_t doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    int64_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + doe - 719468;
+}
+
+// Append one value of column col_idx to column idx of a batch image.
+// Returns the advanced pointer, p for unsupported types, NULL on OOM.
+static const unsigned char* append_column_value_to_batch(
+    column_batch_t *batch, int image, int idx,
+    const unsigned char *p, uint32_t col_idx, int is_null)
+{
+    int rc = 0;
+    if (is_null) {
+        return column_batch_append_null(batch, image, idx) == 0 ? p : NULL;
+    }
+
+    unsigned char real_type = g_map.real_types[col_idx];
+    uint16_t meta = g_map.metadata[col_idx];
+    const unsigned char *next = p;
+
+    int is_unsigned = column_is_unsigned(col_idx);
+
+    switch (real_type) {
+        case MT_TINY:
+            rc = column_batch_append_int(batch, image, idx, is_unsigned ? *p : (int8_t)*p);
+            next = p + 1;
+            break;
+        case MT_SHORT:
+        case MT_YEAR:
+            rc = column_batch_append_int(batch, image, idx,
+                                         is_unsigned ? le16(p) : (int16_t)le16(p));
+            next = p + 2;
+            break;
+        case MT_INT24: {
+            int32_t v = le24(p);
+            if (!is_unsigned && (v & 0x800000)) v |= ~0xFFFFFF;
+            rc = column_batch_append_int(batch, image, idx, v);
+            next = p + 3;
+            break;
+        }
+        case MT_LONG:
+            rc = column_batch_append_int(batch, image, idx,
+                                         is_unsigned ? le32(p) : (int32_t)le32(p));
+            next = p + 4;
+            break;
+        case MT_TIMESTAMP:
+            rc = column_batch_append_int(batch, image, idx, le32(p));
+            next = p + 4;
+            break;
+        case MT_LONGLONG:
+            rc = column_batch_append_int(batch, image, idx, (int64_t)le64(p));
+            next = p + 8;
+            break;
+        case MT_FLOAT: {
+            float f;
+            memcpy(&f, p, 4);
+            rc = column_batch_append_double(batch, image, idx, f);
+            next = p + 4;
+            break;
+        }
+        case MT_DOUBLE: {
+            double d;
+            memcpy(&d, p, 8);
+            rc = column_batch_append_double(batch, image, idx, d);
+            next = p + 8;
+            break;
+        }
+        case MT_TIMESTAMP2: {
+            uint32_t sec = ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) |
+                           ((uint32_t)p[2] << 8) | (uint32_t)p[3];
+            int64_t usec;
+            next = read_fraction_usec(p + 4, meta, &usec);
+            rc = column_batch_append_int(batch, image, idx, (int64_t)sec * 1000000 + usec);
+            break;
+        }
+        case MT_DATETIME2: {
+            uint64_t val = 0;
+            for (int i = 0; i < 5; i++) val = (val << 8) | p[i];
+            val -= 0x8000000000LL;
+            int ymd = val >> 17;
+            int ym = ymd >> 5;
+            int hms = val & 0x1FFFF;
+            int64_t secs = days_from_civil(ym / 13, ym % 13, ymd & 0x1F) * 86400 +
+                           (hms >> 12) * 3600 + ((hms >> 6) & 0x3F) * 60 + (hms & 0x3F);
+            int64_t usec;
+            next = read_fraction_usec(p + 5, meta, &usec);
+            rc = column_batch_append_int(batch, image, idx, secs * 1000000 + usec);
+            break;
+        }
+        case MT_VARCHAR:
+        case MT_STRING: {
+            unsigned len;
+            int one_byte = real_type == MT_VARCHAR ? meta < 256 : (meta >> 8) == 0;
+            if (one_byte) { len = *p++; }
+            else { len = le16(p); p += 2; }
+            rc = column_batch_append_bytes(batch, image, idx, p, len);
+            next = p + len;
+            break;
+        }
+        case MT_BLOB:
+        case MT_GEOMETRY: {
+            // GEOMETRY keeps its 4 byte SRID prefix in front of the WKB
+            uint32_t len = 0;
+            for (unsigned i = 0; i < meta; i++) len |= (uint32_t)p[i] << (8 * i);
+            p += meta;
+            rc = column_batch_append_bytes(batch, image, idx, p, len);
+            next = p + len;
+            break;
+        }
+        case MT_JSON: {
+            uint32_t len = 0;
+            for (unsigned i = 0; i < meta; i++) len |= (uint32_t)p[i] << (8 * i);
+            p += meta;
+            next = p + len;
+
+            char text[1024];
+            long n = json_column_text(p, len, col_idx, text, sizeof(text));
+            if (n < 0) {
+                rc = column_batch_append_null(batch, image, idx);
+            } else if ((size_t)n < sizeof(text)) {
+                rc = column_batch_append_bytes(batch, image, idx, text, (size_t)n);
+            } else {
+                char *big = malloc((size_t)n + 1);
+                if (!big) return NULL;
+                json_column_text(p, len, col_idx, big, (size_t)n + 1);
+                rc = column_batch_append_bytes(batch, image, idx, big, (size_t)n);
+                free(big);
+            }
+            break;
+        }
+        case MT_ENUM: {
+            uint8_t pack_len = (meta >> 8) & 0xFF;
+            uint16_t enum_val = pack_len == 1 ? *p : le16(p);
+            next = p + (pack_len == 1 ? 1 : 2);
+
+            const char *enum_str = NULL;
+            if (g_enum_cache && col_idx < g_map.ncols) {
+                enum_cache_t *cache = &g_enum_cache[col_idx];
+                if (!cache->loaded && g_map.column_names && g_map.column_names[col_idx]) {
+                    load_enum_values_for_column(g_map.db, g_map.tbl,
+                                                g_map.column_names[col_idx], cache);
+                }
+                if (cache->loaded && enum_val >= 1 && enum_val <= (uint16_t)cache->count) {
+                    enum_str = cache->values[enum_val - 1];
+                }
+            }
+            char num[8];
+            if (!enum_str) {
+                snprintf(num, sizeof(num), "%u", enum_val);
+                enum_str = num;
+            }
+            rc = column_batch_append_bytes(batch, image, idx, enum_str, strlen(enum_str));
+            break;
+        }
+        case MT_BIT: {
+            int len = (meta >> 8) + ((meta & 0xFF) ? 1 : 0);
+            rc = column_batch_append_int(batch, image, idx,
+                                         (int64_t)be_uint(p, len > 8 ? 8 : len));
+            next = p + len;
+            break;
+        }
+        default: {
+            // DECIMAL, DATE, TIME, SET: the text the JSON encoding uses
+            char text[1024];
+            int quoted;
+            next = column_value_text(p, col_idx, text, sizeof(text), &quoted);
+            rc = next == p ? column_batch_append_null(batch, image, idx)
+                           : column_batch_append_bytes(batch, image, idx, text, strlen(text));
+            break;
+        }
+    }
+    return rc == 0 ? next : NULL;
+}
+
+// Decode one row image into the next row of a batch image; the projected
+// columns present in the image are batch columns 0..n in column order
+static int parse_row_to_batch(const unsigned char **p_ptr, size_t *len_ptr,
+                              uint32_t ncols, const unsigned char *present,
+                              const char **names, column_batch_t *batch, int image)
+{
+    const unsigned char *p   = *p_ptr;
+    size_t len               = *len_ptr;
+    const unsigned char *start_p = p;
+
+    uint32_t present_count = count_present_columns(present, ncols);
+    uint32_t bmp_len       = (present_count + 7) >> 3;
+
+    if (len < bmp_len) return -1;
+
+    const unsigned char *nullmap = p;
+    p += bmp_len;
+
+    int seen = 0;
+    int idx  = 0;
+
+    for (uint32_t i = 0; i < ncols; ++i) {
+        if (!bit_get(present, i)) continue;
+
+        int is_null = bit_get(nullmap, seen++);
+
+        if (!names || i >= g_map.ncols || !names[i]) {
+            if (!is_null) p = skip_column_value(p, i);
+            continue;
+        }
+
+        const unsigned char *old_p = p;
+        p = append_column_value_to_batch(batch, image, idx++, p, i, is_null);
+        if (!p || (p == old_p && !is_null)) return -1;
+
+        if ((size_t)(p - start_p) > len) return -1;
+    }
 
     size_t consumed = p - start_p;
+    if (consumed > len) return -1;
     *p_ptr = p;
     *len_ptr = len - consumed;
     return 0;
@@ -1566,6 +4183,7 @@ if(len < 13) return;
     int is_commit = 0;
     int is_rollback = 0;
     int is_ddl = 0;
+    int autocommit = 0;
 
     if(strncasecmp(query, "BEGIN", 5) == 0) {
         type = "BEGIN"; is_begin = 1;
@@ -1585,18 +4203,27 @@ if(len < 13) return;
         type = "RENAME"; is_ddl = 1;
     }
     
+    // A table changed by DDL is mapped afresh
+    if(is_ddl) {
+        tid_cache_clear();
+        if(schema_resolver_enabled()) schema_resolver_invalidate_db(NULL);
+    }
+
     if(is_begin) {
         in_transaction = 1;
         generate_txn_id(current_txn_id);
         log_debug("[txn:%s] BEGIN transaction", current_txn_id);
-    } else if(is_ddl && !in_transaction) {
-        generate_txn_id(current_txn_id);
     } else if(!in_transaction) {
+        // Autocommitted statement (DDL): its GTID is used up here
         generate_txn_id(current_txn_id);
+        pending_gtid_txn[0] = '\0';
+        txn_start_pinned = 0;
+        autocommit = 1;
     }
 
     if(is_ddl && db_len > 0 && !should_capture_ddl(db)) {
         log_debug("[txn:%s] DDL/DCL for database %s - IGNORED (capture disabled)",current_txn_id, db);
+        if(autocommit) publish_progress();
         return;
     }
 
@@ -1647,14 +4274,17 @@ if(len < 13) return;
                 type, current_txn_id, db, escaped_query);
         // no table for DDL query event here → pass empty table
         extern void publish_event(const char *db, const char *table, const char *event_json, const char *txn);
+        current_event_type = type;
         publish_event(db, type, event_json, current_txn_id);
+        current_event_type = NULL;
     }
 
     if(is_commit || is_rollback) {
         log_info("[txn:%s] Transaction %s", current_txn_id,
                  is_commit ? "COMMITTED" : "ROLLED BACK");
-        in_transaction = 0;
-        current_txn_id[0] = '\0';
+        end_transaction();
+    } else if(autocommit) {
+        publish_progress();
     }
 }
 
@@ -1662,28 +4292,53 @@ if(len < 13) return;
 // PUBLISH EVENT (USING PLUGIN SYSTEM)
 // ============================================================================
 
-void publish_event(const char *db, const char *table, 
-                  const char *event_json, const char *txn) {
-    if (!g_config.publisher_manager) return;
+// Transaction ends seen; publishers whose boundary_seen lags got no COMMIT
+static uint64_t boundary_seq = 1;
+
+// Dispatch one encoding to the publishers using profile_id (-1 = all).
+// A columnar batch is owned by this call and replaces event->json.
+static void dispatch_cdc_event(const cdc_event_t *event, column_batch_t *batch,
+                               int profile_id, int priority) {
+    if (!g_config.publisher_manager) {
+        column_batch_free(batch);
+        return;
+    }
     
-    // Build CDC event
-    cdc_event_t event = {
-        .db = db,
-        .table = table,
-        .json = event_json,
-        .txn = txn,
-        .position = current_position,
-        .binlog_file = current_binlog
-    };
+    const char *db = event->db;
+    const char *table = event->table;
+
+    // Copied once, shared by every matching queue
+    publisher_event_t *shared = NULL;
+    profile_span_t span;
+    profiler_begin(&span);
 
     // Dispatch to matching publishers
     int dispatched = 0;
     publisher_instance_t *inst = g_config.publisher_manager->instances;
     
     while (inst) {
+        if (profile_id >= 0 && inst->profile_id != profile_id) {
+            inst = inst->next;
+            continue;
+        }
         if (publisher_should_publish(inst, db)) {
-            if (publisher_instance_enqueue(inst, &event) == 0) {
-                log_trace("Dispatching event publisher=%s txn=%s db=%s table=%s binlog_file=%s position=%d : %s", inst->name, txn, db, table, current_binlog, current_position, event_json);
+            if (!shared) {
+                shared = batch ? publisher_event_create_columnar(event, batch)
+                               : publisher_event_create(event);
+                batch = NULL;
+                if (!shared) {
+                    log_error("Failed to allocate event for db=%s table=%s", db, table);
+                    profiler_end(&span, PROFILE_DISPATCH);
+                    return;
+                }
+                shared->priority = priority;
+                shared->hold = parked_hold();
+            }
+            if (publisher_instance_enqueue_event(inst, shared) == 0) {
+                if (event->type && strcmp(event->type, "COMMIT") == 0) {
+                    inst->boundary_seen = boundary_seq;
+                }
+                log_trace("Dispatching event publisher=%s txn=%s db=%s table=%s binlog_file=%s position=%llu : %s", inst->name, event->txn, db, table, event->binlog_file, (unsigned long long)event->position, event->json ? event->json : "(columnar)");
                 dispatched++;
             }
         } else {
@@ -1692,199 +4347,640 @@ void publish_event(const char *db, const char *table,
         inst = inst->next;
     }
     
+    publisher_event_release(shared);
+    column_batch_free(batch);
+    profiler_end(&span, PROFILE_DISPATCH);
+    
     if (dispatched > 0) {
         log_debug("Dispatched to %d publisher(s) for db=%s table=%s",
                  dispatched, db ? db : "", table ? table : "");
     }
 }
 
+// Dispatch an encoding of the event being parsed
+static void publish_event_payload(const char *db, const char *table,
+                                  const char *event_json, column_batch_t *batch,
+                                  const char *txn, int profile_id, int priority) {
+    cdc_event_t event = {
+        .db = db,
+        .table = table,
+        .json = event_json,
+        .txn = txn,
+        .position = current_position,
+        .binlog_file = current_binlog,
+        .last_committed = txn_last_committed,
+        .sequence_number = txn_sequence_number,
+        .timestamp = current_event_time,
+        .type = current_event_type,
+        .key = current_event_key
+    };
+    dispatch_cdc_event(&event, batch, profile_id, priority);
+}
+
+// DDL and COMMIT: never shed, or consumers lose transaction boundaries
+static void publish_event_profile(const char *db, const char *table,
+                                  const char *event_json, const char *txn,
+                                  int profile_id) {
+    publish_event_payload(db, table, event_json, NULL, txn, profile_id,
+                          PUBLISHER_PRIORITY_BOUNDARY);
+}
+
+void publish_event(const char *db, const char *table, 
+                  const char *event_json, const char *txn) {
+    publish_event_profile(db, table, event_json, txn, -1);
+}
+
+// End of the current transaction. Publishers that were not sent its
+// COMMIT (filtered out, capture off, autocommitted DDL) get a progress
+// mark, so their watermark and WAIT_FOR still move past it.
+static void publish_progress(void) {
+    if (!g_config.publisher_manager) return;
+    
+    cdc_event_t event = {
+        .txn = current_txn_id,
+        .position = current_position,
+        .binlog_file = current_binlog,
+        .timestamp = current_event_time
+    };
+    publisher_event_t *shared = NULL;
+    for (publisher_instance_t *inst = g_config.publisher_manager->instances;
+         inst; inst = inst->next) {
+        if (!inst->active || inst->boundary_seen == boundary_seq) continue;
+        if (!shared) {
+            shared = publisher_event_create_progress(&event);
+            if (!shared) break;
+            shared->hold = parked_hold();
+        }
+        publisher_instance_enqueue_event(inst, shared);
+    }
+    publisher_event_release(shared);
+    boundary_seq++;
+}
+
+// Does any publisher using this profile want events for db?
+static int profile_has_subscribers(int profile_id, const char *db) {
+    if (!g_config.publisher_manager) return 0;
+    for (publisher_instance_t *inst = g_config.publisher_manager->instances;
+         inst; inst = inst->next) {
+        if (inst->profile_id == profile_id && publisher_should_publish(inst, db)) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// Does a publisher using this profile and wanting db take the routing key?
+static int profile_wants_key(int profile_id, const char *db) {
+    for (publisher_instance_t *inst = g_config.publisher_manager->instances;
+         inst; inst = inst->next) {
+        if (inst->profile_id == profile_id && inst->routing_key &&
+            publisher_should_publish(inst, db)) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
 // ============================================================================
 // WRITE / UPDATE / DELETE PARSERS
 // ============================================================================
 
 static void append_primary_key_metadata(char *json_buf, size_t buf_size,
                                         size_t *json_offset,
-                                        const char *db, const char *tbl) {
-    table_config_t *tbl_cfg = find_table_config(db, tbl);
+                                        const table_config_t *tbl_cfg) {
     if (!tbl_cfg || tbl_cfg->pk_count <= 0 || !tbl_cfg->primary_keys) {
         return;
     }
 
-    *json_offset += snprintf(json_buf + *json_offset,
-                             buf_size - *json_offset,
-                             ",\"primary_key\":[");
+    json_appendf(json_buf, buf_size, json_offset, ",\"primary_key\":[");
     for (int i = 0; i < tbl_cfg->pk_count; i++) {
         if (i > 0) {
-            *json_offset += snprintf(json_buf + *json_offset,
-                                     buf_size - *json_offset, ",");
+            json_appendf(json_buf, buf_size, json_offset, ",");
         }
         const char *pk_name = tbl_cfg->primary_keys[i] ? tbl_cfg->primary_keys[i] : "";
-        *json_offset += snprintf(json_buf + *json_offset,
-                                 buf_size - *json_offset,
-                                 "\"%s\"", pk_name);
+        json_appendf(json_buf, buf_size, json_offset, "\"%s\"", pk_name);
     }
-    *json_offset += snprintf(json_buf + *json_offset,
-                             buf_size - *json_offset, "]");
+    json_appendf(json_buf, buf_size, json_offset, "]");
 }
 
 
-static void parse_write_rows(const unsigned char *row_data, size_t row_len,
-                            uint32_t ncols, const unsigned char *present)
-{
-    if(g_map.table_id == 0) return;
+#define ROWS_KEY_MAX 8192
 
-    char json_event[32768];
-    size_t json_offset = 0;
-    
-    json_offset += snprintf(json_event, sizeof(json_event),
-    "{\"type\":\"INSERT\",\"txn\":\"%s\",\"db\":\"%s\",\"table\":\"%s\"",
-    current_txn_id, g_map.db, g_map.tbl);
+// Primary key columns of the current table map by column index, rebuilt
+// with the map; NULL if the table has no usable primary_key configured
+static const char **g_key_names = NULL;
+static uint64_t g_key_generation = UINT64_MAX;
 
-    /* add primary_key metadata if configured */
-    append_primary_key_metadata(json_event, sizeof(json_event),
-                                &json_offset, g_map.db, g_map.tbl);
+static const char** primary_key_projection(void) {
+    if (g_key_generation == g_map_generation) return g_key_names;
 
-    /* now start rows array */
-    json_offset += snprintf(json_event + json_offset,
-                            sizeof(json_event) - json_offset,
-                            ",\"rows\":[");
-    
+    free(g_key_names);
+    g_key_names = NULL;
+    g_key_generation = g_map_generation;
+
+    table_config_t *tbl_cfg = g_map.tbl_cfg;
+    if (!tbl_cfg || tbl_cfg->pk_count <= 0 || !g_map.column_names) return NULL;
+
+    g_key_names = calloc(g_map.ncols ? g_map.ncols : 1, sizeof(char*));
+    if (!g_key_names) return NULL;
+
+    int found = 0;
+    for (int k = 0; k < tbl_cfg->pk_count; k++) {
+        const char *pk_name = tbl_cfg->primary_keys[k];
+        for (uint32_t i = 0; pk_name && i < g_map.ncols && i < g_map.column_name_count; i++) {
+            // Large objects would go through the binary output options
+            unsigned char t = g_map.real_types[i];
+            if (t == MT_BLOB || t == MT_GEOMETRY) continue;
+            if (g_map.column_names[i] && strcmp(g_map.column_names[i], pk_name) == 0) {
+                g_key_names[i] = g_map.column_names[i];
+                found++;
+                break;
+            }
+        }
+    }
+    if (!found) {
+        free(g_key_names);
+        g_key_names = NULL;
+    }
+    return g_key_names;
+}
+
+// Routing key of a one row message: the primary key of the row at row_data,
+// from the before image, as a JSON array in column order ("[42]")
+static const char* rows_event_key(const unsigned char *row_data, size_t row_len,
+                                  uint32_t ncols, const unsigned char *present,
+                                  char *key, size_t key_size) {
+    const char **names = primary_key_projection();
+    if (!names || row_len < ((ncols + 7) >> 3)) return NULL;
 
-    int row_num = 0;
     const unsigned char *p = row_data;
     size_t len = row_len;
+    size_t off = 0;
+    if (parse_row_to_json_filtered(&p, &len, ncols, present, names, PROFILE_FORMAT_ARRAY,
+                                   NULL, key, key_size, &off) != 0 ||
+        off >= key_size - 1) {
+        return NULL;
+    }
+    return key;
+}
 
-    uint32_t min_row_size = (ncols + 7) >> 3;
+typedef enum { ROWS_INSERT, ROWS_UPDATE, ROWS_DELETE } rows_kind_t;
 
-    while(len >= min_row_size && json_offset < sizeof(json_event) - 2000){
-        row_num++;
-        if(row_num > 1)
-            json_offset += snprintf(json_event + json_offset,
-                                   sizeof(json_event) - json_offset, ",");
+static const char *rows_kind_names[] = { "INSERT", "UPDATE", "DELETE" };
 
-        if(parse_row_to_json_filtered(&p, &len, ncols, present,
-                                     json_event, sizeof(json_event), &json_offset) != 0) {
-            break;
-        }
+// Array format: list the names of the projected columns present in an image
+static void append_column_list(char *json_buf, size_t buf_size, size_t *json_offset,
+                               const char *key, const unsigned char *present,
+                               uint32_t ncols, const char **names) {
+    json_appendf(json_buf, buf_size, json_offset, ",\"%s\":[", key);
+    int first = 1;
+    for (uint32_t i = 0; i < ncols && i < g_map.ncols; i++) {
+        if (!bit_get(present, i) || !names || !names[i]) continue;
+        json_appendf(json_buf, buf_size, json_offset, "%s\"%s\"", first ? "" : ",", names[i]);
+        first = 0;
     }
+    json_appendf(json_buf, buf_size, json_offset, "]");
+}
 
-    json_offset += snprintf(json_event + json_offset,
-                           sizeof(json_event) - json_offset, "]}");
+// Encode one row (before/after pair for updates) at json_offset; -1 if malformed
+static int encode_row(rows_kind_t kind, output_profile_t *prof, const char **names,
+                      table_config_t *enrich, const unsigned char **p, size_t *len,
+                      uint32_t ncols, const unsigned char *before_present,
+                      const unsigned char *after_present, int partial,
+                      char *json_event, size_t buf_size, size_t *json_offset)
+{
+    if (kind != ROWS_UPDATE) {
+        return parse_row_to_json_filtered(p, len, ncols, before_present, names,
+                                          prof->format, enrich, json_event, buf_size, json_offset);
+    }
 
-    if(row_num > 0) {
-        publish_event(g_map.db, g_map.tbl, json_event, current_txn_id);
-        log_debug("INSERT %s.%s: %d row(s) captured", g_map.db, g_map.tbl, row_num);
+    json_appendf(json_event, buf_size, json_offset, "{\"before\":");
+    if (partial) partial_json_begin_row(*p, *len, ncols, before_present);
+    if (parse_row_to_json_filtered(p, len, ncols, before_present, names,
+                                   prof->format, enrich, json_event, buf_size, json_offset) != 0) {
+        return -1;
+    }
+
+    json_appendf(json_event, buf_size, json_offset, ",\"after\":");
+    int rc = -1;
+    if (!partial || partial_json_after_image(p, len) == 0) {
+        rc = parse_row_to_json_filtered(p, len, ncols, after_present, names,
+                                        prof->format, enrich, json_event, buf_size, json_offset);
     }
+    partial_json_end_row();
+    if (rc != 0) return -1;
+
+    json_appendf(json_event, buf_size, json_offset, "}");
+    return 0;
 }
 
-static void parse_update_rows(const unsigned char *row_data, size_t row_len,
+// Room kept after the rows for the closing "]}"
+#define ROWS_TAIL_RESERVE 2
+
+// Encode a rows event through one output profile; returns the row count.
+// Rows are consumed from *row_data / *row_len. A row that does not fit after
+// others ends the message and is left there for the next one (*row_len > 0);
+// a row that does not fit on its own is encoded again with binary and JSON
+// values by reference, and skipped if it still does not fit. The first row
+// encoded is left at *first_row / *first_len.
+static int encode_rows_event(rows_kind_t kind, output_profile_t *prof,
+                             const unsigned char **row_data, size_t *row_len,
                              uint32_t ncols,
                              const unsigned char *before_present,
-                             const unsigned char *after_present)
+                             const unsigned char *after_present, int partial,
+                             char *json_event, size_t buf_size, size_t *rows_at,
+                             const unsigned char **first_row, size_t *first_len)
 {
-    if(g_map.table_id == 0) return;
-
-    char json_event[32768];
     size_t json_offset = 0;
+    const char **names = profile_projection(prof);
+    table_config_t *enrich = g_map.tbl_cfg;
+    if (enrich && enrich->enrich_count == 0) enrich = NULL;
+
+    if (prof->envelope == PROFILE_ENVELOPE_MINIMAL) {
+        json_appendf(json_event, buf_size, &json_offset,
+                     "{\"type\":\"%s\",\"db\":\"%s\",\"table\":\"%s\"",
+                     rows_kind_names[kind], g_map.db, g_map.tbl);
+    } else {
+        json_appendf(json_event, buf_size, &json_offset,
+                     "{\"type\":\"%s\",\"txn\":\"%s\",\"db\":\"%s\",\"table\":\"%s\"",
+                     rows_kind_names[kind], current_txn_id, g_map.db, g_map.tbl);
 
-    json_offset += snprintf(json_event, sizeof(json_event),
-    "{\"type\":\"UPDATE\",\"txn\":\"%s\",\"db\":\"%s\",\"table\":\"%s\"",
-    current_txn_id, g_map.db, g_map.tbl);
+        /* add primary_key metadata if configured */
+        append_primary_key_metadata(json_event, buf_size,
+                                    &json_offset, g_map.tbl_cfg);
+    }
 
-    append_primary_key_metadata(json_event, sizeof(json_event),
-                                &json_offset, g_map.db, g_map.tbl);
+    if (prof->format == PROFILE_FORMAT_ARRAY) {
+        if (kind == ROWS_UPDATE) {
+            append_column_list(json_event, buf_size, &json_offset, "before_columns",
+                               before_present, ncols, names);
+            append_column_list(json_event, buf_size, &json_offset, "columns",
+                               after_present, ncols, names);
+        } else {
+            append_column_list(json_event, buf_size, &json_offset, "columns",
+                               before_present, ncols, names);
+        }
+    }
 
-    json_offset += snprintf(json_event + json_offset,
-                            sizeof(json_event) - json_offset,
-                            ",\"rows\":[");
+    /* now start rows array */
+    json_appendf(json_event, buf_size, &json_offset, ",\"rows\":[");
+    *rows_at = json_offset;
 
+    if (json_buffer_full(buf_size, json_offset, ROWS_TAIL_RESERVE)) {
+        log_error("%s event header of %s.%s does not fit the %zu byte event buffer",
+                  rows_kind_names[kind], g_map.db, g_map.tbl, buf_size);
+        *row_len = 0;
+        return 0;
+    }
 
     int row_num = 0;
-    const unsigned char *p = row_data;
-    size_t len = row_len;
+    int more = 0;
+    const unsigned char *p = *row_data;
+    size_t len = *row_len;
 
-    uint32_t min_row_size = 2 * ((ncols + 7) >> 3);
-    uint32_t conservative_min = min_row_size + ncols * 2;
+    // Updates carry two images per row
+    uint32_t min_row_size = (ncols + 7) >> 3;
+    if (kind == ROWS_UPDATE) min_row_size = 2 * min_row_size + ncols * 2;
 
-    while(len >= conservative_min && json_offset < sizeof(json_event) - 4000){
-        row_num++;
-        if(row_num > 1)
-            json_offset += snprintf(json_event + json_offset,
-                                   sizeof(json_event) - json_offset, ",");
+    while (len >= min_row_size) {
+        const unsigned char *row_p = p;
+        size_t row_left = len;
+        size_t row_at = json_offset;
 
-        json_offset += snprintf(json_event + json_offset,
-                               sizeof(json_event) - json_offset, "{\"before\":");
+        if (row_num > 0) json_appendf(json_event, buf_size, &json_offset, ",");
+        if (encode_row(kind, prof, names, enrich, &p, &len, ncols, before_present,
+                       after_present, partial, json_event, buf_size, &json_offset) != 0) {
+            json_offset = row_at;
+            break;
+        }
+        if (!json_buffer_full(buf_size, json_offset, ROWS_TAIL_RESERVE)) {
+            if (row_num == 0) {
+                *first_row = row_p;
+                *first_len = row_left;
+            }
+            row_num++;
+            g_values_by_ref = 0;
+            continue;
+        }
 
-        if(parse_row_to_json_filtered(&p, &len, ncols, before_present,
-                                     json_event, sizeof(json_event), &json_offset) != 0) {
+        json_offset = row_at;
+        if (row_num > 0) {
+            p = row_p;
+            len = row_left;
+            more = 1;
             break;
         }
+        if (!g_values_by_ref) {
+            g_values_by_ref = 1;
+            p = row_p;
+            len = row_left;
+            continue;
+        }
+        log_error("%s row of %s.%s does not fit the %zu byte event buffer, skipped",
+                  rows_kind_names[kind], g_map.db, g_map.tbl, buf_size);
+        g_values_by_ref = 0;
+    }
+    g_values_by_ref = 0;
+
+    json_appendf(json_event, buf_size, &json_offset, "]}");
+
+    *row_data = p;
+    *row_len = more ? len : 0;
+    return row_num;
+}
+
+// Declare the projected columns present in an image as batch columns
+static int declare_batch_columns(column_batch_t *batch, int image, uint32_t ncols,
+                                 const unsigned char *present, const char **names) {
+    int idx = 0;
+    for (uint32_t i = 0; i < ncols && i < g_map.ncols; i++) {
+        if (!bit_get(present, i) || !names || !names[i]) continue;
+        if (batch) {
+            column_batch_set_column(batch, image, idx, names[i],
+                                    columnar_type(i), g_map.real_types[i]);
+        }
+        idx++;
+    }
+    return idx;
+}
 
-        json_offset += snprintf(json_event + json_offset,
-                               sizeof(json_event) - json_offset, ",\"after\":");
+// Decode a rows event into column vectors; NULL if nothing was decoded
+static column_batch_t* encode_rows_columnar(rows_kind_t kind, output_profile_t *prof,
+                                            const unsigned char *row_data, size_t row_len,
+                                            uint32_t ncols,
+                                            const unsigned char *before_present,
+                                            const unsigned char *after_present, int partial)
+{
+    static const int batch_kinds[] = { CDC_ROWS_INSERT, CDC_ROWS_UPDATE, CDC_ROWS_DELETE };
+    const char **names = profile_projection(prof);
+
+    // INSERT and DELETE carry a single image, described by before_present
+    int is_update = (kind == ROWS_UPDATE);
+    const unsigned char *main_present = is_update ? after_present : before_present;
+    int main_count = declare_batch_columns(NULL, 0, ncols, main_present, names);
+    int before_count = is_update ?
+                       declare_batch_columns(NULL, 0, ncols, before_present, names) : 0;
+
+    column_batch_t *batch = column_batch_create(batch_kinds[kind], main_count, before_count);
+    if (!batch) {
+        log_error("Failed to allocate columnar batch for %s.%s", g_map.db, g_map.tbl);
+        return NULL;
+    }
+    declare_batch_columns(batch, COLUMN_BATCH_AFTER, ncols, main_present, names);
+    if (is_update) {
+        declare_batch_columns(batch, COLUMN_BATCH_BEFORE, ncols, before_present, names);
+    }
 
-        if(parse_row_to_json_filtered(&p, &len, ncols, after_present,
-                                     json_event, sizeof(json_event), &json_offset) != 0) {
+    const unsigned char *p = row_data;
+    size_t len = row_len;
+    uint32_t min_row_size = (is_update ? 2 : 1) * ((ncols + 7) >> 3);
+
+    while (len >= min_row_size && len > 0) {
+        int rc;
+        if (is_update) {
+            if (partial) partial_json_begin_row(p, len, ncols, before_present);
+            rc = parse_row_to_batch(&p, &len, ncols, before_present, names,
+                                    batch, COLUMN_BATCH_BEFORE);
+            if (rc == 0 && partial) rc = partial_json_after_image(&p, &len);
+            if (rc == 0) {
+                rc = parse_row_to_batch(&p, &len, ncols, after_present, names,
+                                        batch, COLUMN_BATCH_AFTER);
+            }
+            partial_json_end_row();
+        } else {
+            rc = parse_row_to_batch(&p, &len, ncols, before_present, names,
+                                    batch, COLUMN_BATCH_AFTER);
+        }
+        if (rc != 0) {
+            column_batch_abort_row(batch);
             break;
         }
+        column_batch_end_row(batch);
+    }
 
-        json_offset += snprintf(json_event + json_offset,
-                               sizeof(json_event) - json_offset, "}");
+    if (column_batch_rows(batch) == 0) {
+        column_batch_free(batch);
+        return NULL;
     }
+    return batch;
+}
 
-    json_offset += snprintf(json_event + json_offset,
-                           sizeof(json_event) - json_offset, "]}");
+// ============================================================================
+// ROWS COALESCING
+// ============================================================================
 
-    if(row_num > 0) {
-        publish_event(g_map.db, g_map.tbl, json_event, current_txn_id);
-        log_debug("UPDATE %s.%s: %d row(s) captured", g_map.db, g_map.tbl, row_num);
+// Consecutive rows events of one transaction whose envelope (type, txn,
+// table, key and column lists) is identical are merged into one message per
+// output profile, up to coalesce_max_rows rows or coalesce_max_bytes. The
+// merged message carries the position of the last event it contains.
+typedef struct {
+    char *buf;                      // envelope and rows so far, without "]}"
+    size_t len;
+    size_t envelope_len;            // bytes before the first row
+    int rows;
+    int events;
+    int priority;
+    char db[128];
+    char tbl[128];
+    char txn[TXN_ID_MAX];
+    const char *type;
+    char key[ROWS_KEY_MAX];         // key of the first row, sent only if it stays alone
+    cdc_event_t meta;               // position of the last merged event
+} coalesce_buf_t;
+
+static coalesce_buf_t *g_coalesce = NULL;     // one per output profile
+static int coalesce_pending = 0;              // buffers holding rows
+
+static void coalesce_flush_profile(int pi) {
+    coalesce_buf_t *c = &g_coalesce[pi];
+    if (c->rows == 0) return;
+
+    memcpy(c->buf + c->len, "]}", 3);
+    c->meta.db = c->db;
+    c->meta.table = c->tbl;
+    c->meta.txn = c->txn;
+    c->meta.json = c->buf;
+    c->meta.type = c->type;
+    c->meta.key = (c->rows == 1 && c->key[0]) ? c->key : NULL;
+    dispatch_cdc_event(&c->meta, NULL, pi, c->priority);
+
+    if (c->events > 1) {
+        metrics_add("binlog_coalesced_events_total", NULL, c->events);
+        metrics_add("binlog_coalesced_messages_total", NULL, 1);
     }
+    c->rows = 0;
+    c->events = 0;
+    c->len = 0;
+    coalesce_pending--;
 }
 
-static void parse_delete_rows(const unsigned char *row_data, size_t row_len,
-                             uint32_t ncols, const unsigned char *present)
-{
-    if(g_map.table_id == 0) return;
+static void coalesce_flush_all(void) {
+    for (int pi = 0; coalesce_pending > 0 && pi < g_config.profile_count; pi++) {
+        coalesce_flush_profile(pi);
+    }
+}
 
-    char json_event[32768];
-    size_t json_offset = 0;
-    
-    json_offset += snprintf(json_event, sizeof(json_event),
-    "{\"type\":\"DELETE\",\"txn\":\"%s\",\"db\":\"%s\",\"table\":\"%s\"",
-    current_txn_id, g_map.db, g_map.tbl);
+// Add one encoded rows event of the current table map to profile pi
+static void coalesce_rows(int pi, const char *json, size_t rows_at, int rows) {
+    if (!g_coalesce) {
+        g_coalesce = calloc(g_config.profile_count, sizeof(coalesce_buf_t));
+        if (!g_coalesce) {
+            publish_event_payload(g_map.db, g_map.tbl, json, NULL, current_txn_id, pi,
+                                  g_map.priority);
+            return;
+        }
+        metrics_describe("binlog_coalesced_events_total", METRICS_COUNTER,
+                         "Rows events merged into multi-event messages");
+        metrics_describe("binlog_coalesced_messages_total", METRICS_COUNTER,
+                         "Messages built from more than one rows event");
+    }
 
-    append_primary_key_metadata(json_event, sizeof(json_event),
-                                &json_offset, g_map.db, g_map.tbl);
+    coalesce_buf_t *c = &g_coalesce[pi];
+    size_t len = strlen(json) - 2;                  // without "]}"
+    size_t body = len - rows_at;
 
-    json_offset += snprintf(json_event + json_offset,
-                            sizeof(json_event) - json_offset,
-                            ",\"rows\":[");
+    if (c->rows > 0 &&
+        (c->envelope_len != rows_at || memcmp(c->buf, json, rows_at) != 0 ||
+         c->rows + rows > g_config.coalesce_max_rows ||
+         c->len + 1 + body + 3 > g_config.coalesce_max_bytes)) {
+        coalesce_flush_profile(pi);
+    }
 
+    if (!c->buf) {
+        c->buf = malloc(g_config.coalesce_max_bytes);
+        if (!c->buf) {
+            publish_event_payload(g_map.db, g_map.tbl, json, NULL, current_txn_id, pi,
+                                  g_map.priority);
+            return;
+        }
+    }
 
-    int row_num = 0;
-    const unsigned char *p = row_data;
-    size_t len = row_len;
+    if (c->rows == 0) {
+        memcpy(c->buf, json, len);
+        c->len = len;
+        c->envelope_len = rows_at;
+        c->priority = g_map.priority;
+        snprintf(c->db, sizeof(c->db), "%s", g_map.db);
+        snprintf(c->tbl, sizeof(c->tbl), "%s", g_map.tbl);
+        snprintf(c->txn, sizeof(c->txn), "%s", current_txn_id);
+        snprintf(c->key, sizeof(c->key), "%s", current_event_key ? current_event_key : "");
+        c->type = current_event_type;
+        coalesce_pending++;
+    } else {
+        c->buf[c->len++] = ',';
+        memcpy(c->buf + c->len, json + rows_at, body);
+        c->len += body;
+    }
+    c->rows += rows;
+    c->events++;
 
-    uint32_t min_row_size = (ncols + 7) >> 3;
+    c->meta = (cdc_event_t){
+        .position = current_position,
+        .binlog_file = current_binlog,
+        .last_committed = txn_last_committed,
+        .sequence_number = txn_sequence_number,
+        .timestamp = current_event_time
+    };
 
-    while(len >= min_row_size && json_offset < sizeof(json_event) - 2000){
-        row_num++;
-        if(row_num > 1)
-            json_offset += snprintf(json_event + json_offset,
-                                   sizeof(json_event) - json_offset, ",");
+    if (c->rows >= g_config.coalesce_max_rows) coalesce_flush_profile(pi);
+}
 
-        if(parse_row_to_json_filtered(&p, &len, ncols, present,
-                                     json_event, sizeof(json_event), &json_offset) != 0) {
-            break;
-        }
+// Transaction boundaries and binlog changes end every merged message
+static int ends_coalescing(uint8_t type) {
+    switch (type) {
+        case EVT_QUERY_EVENT:
+        case EVT_XID:
+        case EVT_GTID:
+        case EVT_ANONYMOUS_GTID:
+        case EVT_MARIA_GTID:
+        case EVT_FORMAT_DESCRIPTION:
+        case EVT_ROTATE:
+            return 1;
+    }
+    return 0;
+}
+
+// Encode the rows event once per distinct output profile in use and share
+// each encoding among the publishers of that profile
+static void dispatch_rows_event(rows_kind_t kind,
+                                const unsigned char *row_data, size_t row_len,
+                                uint32_t ncols,
+                                const unsigned char *before_present,
+                                const unsigned char *after_present, int partial)
+{
+    if(g_map.table_id == 0) return;
+
+    if(g_map.lookup_source) {
+        enrich_refresh(kind == ROWS_UPDATE, kind == ROWS_DELETE, row_data, row_len,
+                       ncols, before_present, after_present, partial);
     }
+    if(!g_map.captured) return;
+
+    char json_event[32768];
+    char key[ROWS_KEY_MAX];
+    int row_num = 0;
+    profile_span_t span;
+
+    current_event_type = rows_kind_names[kind];
+
+    for (int pi = 0; pi < g_config.profile_count; pi++) {
+        if (!profile_has_subscribers(pi, g_map.db)) continue;
+        int want_key = profile_wants_key(pi, g_map.db);
+
+        if (g_config.profiles[pi].format == PROFILE_FORMAT_COLUMNAR) {
+            profiler_begin(&span);
+            column_batch_t *batch = encode_rows_columnar(kind, &g_config.profiles[pi],
+                                                         row_data, row_len, ncols,
+                                                         before_present, after_present,
+                                                         partial);
+            profiler_end(&span, PROFILE_ENCODE);
+            row_num = column_batch_rows(batch);
+            if (want_key && row_num == 1) {
+                current_event_key = rows_event_key(row_data, row_len, ncols, before_present,
+                                                   key, sizeof(key));
+            }
+            if (batch) {
+                publish_event_payload(g_map.db, g_map.tbl, NULL, batch, current_txn_id, pi,
+                                      g_map.priority);
+            }
+            current_event_key = NULL;
+            continue;
+        }
 
-    json_offset += snprintf(json_event + json_offset,
-                           sizeof(json_event) - json_offset, "]}");
+        // Rows beyond one event buffer continue in further messages
+        const unsigned char *rows = row_data;
+        size_t rows_len = row_len;
+        row_num = 0;
+        do {
+            const unsigned char *first_row = NULL;
+            size_t first_len = 0;
+            size_t rows_at = 0;
+            profiler_begin(&span);
+            int n = encode_rows_event(kind, &g_config.profiles[pi], &rows, &rows_len,
+                                      ncols, before_present, after_present, partial,
+                                      json_event, sizeof(json_event), &rows_at,
+                                      &first_row, &first_len);
+            profiler_end(&span, PROFILE_ENCODE);
+            if (want_key && n == 1) {
+                current_event_key = rows_event_key(first_row, first_len, ncols, before_present,
+                                                   key, sizeof(key));
+            }
+            if (n > 0 && g_config.coalesce_max_rows > 0) {
+                coalesce_rows(pi, json_event, rows_at, n);
+            } else if (n > 0) {
+                publish_event_payload(g_map.db, g_map.tbl, json_event, NULL, current_txn_id, pi,
+                                      g_map.priority);
+            }
+            current_event_key = NULL;
+            row_num += n;
+        } while (rows_len > 0);
+    }
+    current_event_type = NULL;
+    current_event_key = NULL;
 
     if(row_num > 0) {
-        publish_event(g_map.db, g_map.tbl, json_event, current_txn_id);
-        log_debug("DELETE %s.%s: %d row(s) captured", g_map.db, g_map.tbl, row_num);
+        log_debug("%s %s.%s: %d row(s) captured", rows_kind_names[kind],
+                  g_map.db, g_map.tbl, row_num);
     }
 }
 
@@ -1899,9 +4995,23 @@ static void parse_rows_event(uint8_t event_type, const unsigned char *payload,
     if(payload_len < 8) return;
 
     uint64_t table_id = le48(p); p += 6;
-    (void)table_id;
     p += 2;
 
+    // Ignored tables stop here, before bitmaps and decompression
+    if(table_id != g_map.table_id || g_map.table_id == 0) {
+        table_id_entry_t *e = tid_cache_find(table_id);
+        if(!e || e->ignored || !e->map) return;
+
+        // Multi-table statement: rows of a table mapped before the current one
+        parse_table_map(e->map, e->map_len);
+        if(table_id != g_map.table_id) return;
+    }
+
+    if(g_map.schema_pending) {
+        park_rows_event(event_type, table_id, payload, payload_len);
+        return;
+    }
+
 //    if(event_type == EVT_WRITE_ROWSv2 || event_type == EVT_UPDATE_ROWSv2 ||
 //       event_type == EVT_DELETE_ROWSv2){
 //        if(payload_len < (uint32_t)(p - payload + 2)) return;
@@ -1911,7 +5021,8 @@ static void parse_rows_event(uint8_t event_type, const unsigned char *payload,
 //    }
     if (event_type == EVT_WRITE_ROWSv2 ||
         event_type == EVT_UPDATE_ROWSv2 ||
-        event_type == EVT_DELETE_ROWSv2) {
+        event_type == EVT_DELETE_ROWSv2 ||
+        event_type == EVT_PARTIAL_UPDATE_ROWS) {
 
         /* extra_data_len (2 bytes) includes its own length */
         if (payload_len < (uint32_t)(p - payload + 2)) return;
@@ -1935,8 +5046,9 @@ static void parse_rows_event(uint8_t event_type, const unsigned char *payload,
     const unsigned char *before_present = NULL;
     const unsigned char *after_present = NULL;
 
+    int partial = (event_type == EVT_PARTIAL_UPDATE_ROWS);
     if(event_type == EVT_UPDATE_ROWSv1 || event_type == EVT_UPDATE_ROWSv2 ||
-       event_type == EVT_MARIA_UPDATE_ROWS_COMPRESSED){
+       event_type == EVT_MARIA_UPDATE_ROWS_COMPRESSED || partial){
         if(payload_len < (uint32_t)(p - payload + bmp_len * 2)) return;
         before_present = p;
         p += bmp_len;
@@ -1955,8 +5067,12 @@ static void parse_rows_event(uint8_t event_type, const unsigned char *payload,
     if(event_type == EVT_MARIA_WRITE_ROWS_COMPRESSED ||
        event_type == EVT_MARIA_UPDATE_ROWS_COMPRESSED ||
        event_type == EVT_MARIA_DELETE_ROWS_COMPRESSED){
-        if(mariadb_decompress_rows(p, payload_len - (uint32_t)(p - payload),
-                                   &dec, &row_len) != 0){
+        profile_span_t span;
+        profiler_begin(&span);
+        int rc = mariadb_decompress_rows(p, payload_len - (uint32_t)(p - payload),
+                                         &dec, &row_len);
+        profiler_end(&span, PROFILE_DECOMPRESS);
+        if(rc != 0){
             log_error("Failed to decompress rows");
             return;
         }
@@ -1968,23 +5084,116 @@ static void parse_rows_event(uint8_t event_type, const unsigned char *payload,
 
     if(event_type == EVT_WRITE_ROWSv1 || event_type == EVT_WRITE_ROWSv2 ||
        event_type == EVT_MARIA_WRITE_ROWS_COMPRESSED){
-        parse_write_rows(row_data, row_len, ncols, before_present);
+        dispatch_rows_event(ROWS_INSERT, row_data, row_len, ncols, before_present, NULL, 0);
     } else if(event_type == EVT_UPDATE_ROWSv1 || event_type == EVT_UPDATE_ROWSv2 ||
-              event_type == EVT_MARIA_UPDATE_ROWS_COMPRESSED){
-        parse_update_rows(row_data, row_len, ncols,
-                         before_present, after_present);
+              event_type == EVT_MARIA_UPDATE_ROWS_COMPRESSED || partial){
+        dispatch_rows_event(ROWS_UPDATE, row_data, row_len, ncols,
+                            before_present, after_present, partial);
     } else {
-        parse_delete_rows(row_data, row_len, ncols, before_present);
+        dispatch_rows_event(ROWS_DELETE, row_data, row_len, ncols, before_present, NULL, 0);
     }
 
     if(dec) free(dec);
 }
 
+// ============================================================================
+// WATERMARK EVENTS
+// ============================================================================
+
+// A WATERMARK tells opted-in publishers that every change up to
+// binlog_file:position (and timestamp) has been handed to them. Sent only
+// between transactions with nothing parked or coalesced, at most once per
+// interval, and on every HEARTBEAT while the primary is idle.
+//
+// The timestamp is the newest binlog event time. MySQL heartbeats carry
+// timestamp 0, so while the primary is idle it is that time plus the
+// seconds elapsed (on our monotonic clock) since the event was read: the
+// watermark keeps moving, and never goes backwards. Consumers that need
+// to tell an idle primary apart use the idle flag.
+
+static uint32_t wm_event_time = 0;          // newest header timestamp seen
+static struct timespec wm_event_seen;       // when wm_event_time was read
+static uint32_t wm_last_ts = 0;             // timestamp of the last WATERMARK
+static struct timespec wm_last_emit;
+
+static void publish_watermark(int idle, uint32_t ts) {
+    if (ts < wm_last_ts) ts = wm_last_ts;
+    wm_last_ts = ts;
+
+    char json[512];
+    snprintf(json, sizeof(json),
+             "{\"type\":\"WATERMARK\",\"binlog_file\":\"%s\",\"position\":%llu,"
+             "\"timestamp\":%u,\"idle\":%s}",
+             current_binlog, (unsigned long long)current_position, ts,
+             idle ? "true" : "false");
+
+    cdc_event_t event = {
+        .db = "",
+        .table = "WATERMARK",
+        .json = json,
+        .txn = "",
+        .position = current_position,
+        .binlog_file = current_binlog,
+        .timestamp = ts,
+        .type = "WATERMARK",
+        .key = NULL
+    };
+
+    publisher_event_t *shared = NULL;
+    int sent = 0;
+    for (publisher_instance_t *inst = g_config.publisher_manager->instances;
+         inst; inst = inst->next) {
+        if (!inst->watermarks) continue;
+        if (!shared) {
+            shared = publisher_event_create(&event);
+            if (!shared) return;
+            shared->priority = PUBLISHER_PRIORITY_LOW;
+        }
+        if (publisher_instance_enqueue_event(inst, shared) == 0) sent++;
+    }
+    publisher_event_release(shared);
+
+    if (sent > 0) {
+        metrics_add("binlog_watermark_events_total", NULL, 1);
+        log_trace("WATERMARK %s @ %llu ts=%u to %d publisher(s)%s", current_binlog,
+                  (unsigned long long)current_position, ts, sent, idle ? " (idle)" : "");
+    }
+}
+
+// Called after each event with its header time, and with heartbeat set
+// for each HEARTBEAT with the heartbeat's header time (0 = none)
+static void watermark_tick(int heartbeat, uint32_t event_time) {
+    if (g_config.watermark_interval_ms <= 0 || !g_config.publisher_manager) return;
+    if (event_time > wm_event_time) {
+        wm_event_time = event_time;
+        clock_gettime(CLOCK_MONOTONIC, &wm_event_seen);
+    }
+    if (in_transaction || g_parked || coalesce_pending) return;
+
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    int64_t elapsed_ms = (int64_t)(now.tv_sec - wm_last_emit.tv_sec) * 1000 +
+                         (now.tv_nsec - wm_last_emit.tv_nsec) / 1000000;
+    // Heartbeats are already paced by the primary
+    if (!heartbeat && elapsed_ms < g_config.watermark_interval_ms) return;
+
+    // Idle: extend the last event time, unless the heartbeat had its own
+    uint32_t ts = wm_event_time;
+    if (heartbeat && event_time < wm_event_time && wm_event_time > 0 &&
+        now.tv_sec > wm_event_seen.tv_sec) {
+        ts += (uint32_t)(now.tv_sec - wm_event_seen.tv_sec);
+    }
+
+    wm_last_emit = now;
+    publish_watermark(heartbeat, ts);
+}
+
 // ============================================================================
 // EVENT DISPATCH
 // ============================================================================
 
 static void parse_format(const unsigned char *p, uint32_t len){
+    tid_cache_clear();
     if(len < 2) return;
     uint16_t v = le16(p);
     log_info("FORMAT_DESCRIPTION ver=%u", v);
@@ -2012,17 +5221,21 @@ static void parse_rotate(const unsigned char *p, uint32_t len){
         strcpy(current_binlog, "<unknown>");
     }
     current_position = pos;
+    tid_cache_clear();
 
     log_info("ROTATE to '%s' @ %llu", current_binlog, (unsigned long long)pos);
 
     if(g_config.save_last_position) {
-        save_position(current_binlog, current_position);
+        save_checkpoint();
         events_since_save = 0;
     }
 }
 
 static int parse_event(const unsigned char *buf, uint32_t size){
     if(size < 1 || buf[0] != 0x00) return -1;
+
+    // Schemas that arrived while the last event was parsed
+    if(g_parked && schema_resolver_generation() != g_parked_gen) replay_parked(0);
     buf++; size--;
 
     if(size < 19) return -1;
@@ -2032,13 +5245,37 @@ static int parse_event(const unsigned char *buf, uint32_t size){
     uint32_t next_pos = le32(buf + 13);
 
     if(event_len > size) event_len = size;
+
+    // Keepalive from an idle primary: no position of its own, and its time
+    // only feeds the watermark
+    if(type == EVT_HEARTBEAT || type == EVT_HEARTBEAT_V2) {
+        metrics_add("binlog_heartbeats_total", NULL, 1);
+        log_trace("HEARTBEAT @ %s:%llu", current_binlog, (unsigned long long)current_position);
+        watermark_tick(1, le32(buf));
+        return 0;
+    }
+
     if(next_pos > 0) current_position = next_pos;
+    current_server_id = le32(buf + 5);
+    current_event_time = le32(buf);
+    current_event_start = next_pos >= event_len ? next_pos - event_len : 0;
 
     uint32_t payload_len = event_len - 19;
     const unsigned char *payload = buf + 19;
 
     if(has_checksum && payload_len >= 4) payload_len -= 4;
 
+    if(coalesce_pending && ends_coalescing(type)) coalesce_flush_all();
+
+    if(!in_transaction) {
+        if(type == EVT_GTID || type == EVT_ANONYMOUS_GTID || type == EVT_MARIA_GTID) {
+            txn_start_position = current_event_start;
+            txn_start_pinned = 1;
+        } else if(!txn_start_pinned) {
+            txn_start_position = current_event_start;
+        }
+    }
+
     switch(type){
         case EVT_QUERY_EVENT:
             parse_query(payload, payload_len);
@@ -2052,21 +5289,31 @@ static int parse_event(const unsigned char *buf, uint32_t size){
                 char event_json[256];
                 /* Use last known table-map DB for routing (if any) */
                 const char *db = (g_map.db[0] != '\0') ? g_map.db : "";
-                if(should_capture_ddl(db)){
+                if(g_map.db_cfg && g_map.db_cfg->capture_ddl){
                     snprintf(event_json, sizeof(event_json),
                              "{\"type\":\"COMMIT\",\"txn\":\"%s\",\"db\":\"%s\",\"xid\":%llu}"
                              ,current_txn_id, db, (unsigned long long)xid);
                     /* No specific table for a COMMIT boundary */
+                    current_event_type = "COMMIT";
                     publish_event(db, "COMMIT", event_json, current_txn_id);
+                    current_event_type = NULL;
                 } else {
                     log_debug("[txn:%s] DDL/DCL for database %s - IGNORED (capture disabled)", current_txn_id, db);
                 }
             } else {
                 log_debug("XID COMMIT (server_xid=%llu)", (unsigned long long)xid);
             }
-            in_transaction = 0;
-            current_txn_id[0] = '\0';
+            end_transaction();
+            break;
+        case EVT_GTID:
+            parse_gtid(payload, payload_len);
             break;
+        case EVT_ANONYMOUS_GTID:
+            pending_gtid_txn[0] = '\0';   // no GTID, use coordinates
+            parse_logical_clock(payload, payload_len);
+            break;
+        case EVT_MARIA_GTID:
+            parse_maria_gtid(payload, payload_len);
             break;
         case EVT_FORMAT_DESCRIPTION:
             parse_format(payload, payload_len);
@@ -2083,6 +5330,7 @@ static int parse_event(const unsigned char *buf, uint32_t size){
         case EVT_UPDATE_ROWSv2:
         case EVT_DELETE_ROWSv1:
         case EVT_DELETE_ROWSv2:
+        case EVT_PARTIAL_UPDATE_ROWS:
         case EVT_MARIA_WRITE_ROWS_COMPRESSED:
         case EVT_MARIA_UPDATE_ROWS_COMPRESSED:
         case EVT_MARIA_DELETE_ROWS_COMPRESSED:
@@ -2090,15 +5338,17 @@ static int parse_event(const unsigned char *buf, uint32_t size){
             break;
     }
 
+    watermark_tick(0, current_event_time);
+
     events_since_save++;
     if(g_config.save_last_position) {
         if(g_config.save_position_event_count > 0) {
             if(events_since_save >= g_config.save_position_event_count) {
-                save_position(current_binlog, current_position);
+                save_checkpoint();
                 events_since_save = 0;
             }
         } else {
-            save_position(current_binlog, current_position);
+            save_checkpoint();
             events_since_save = 0;
         }
     }
@@ -2115,8 +5365,11 @@ static int stream_binlog(MYSQL *m, MYSQL_RPL *rpl){
             (unsigned long long)rpl->start_position);
     log_info("Waiting for events (Ctrl+C to stop)...");
 
+    profile_span_t span;
     while(keep_running){
+        profiler_begin(&span);
         int ret = mysql_binlog_fetch(m, rpl);
+        profiler_end(&span, PROFILE_FETCH);
         if(ret != 0){
             if(!keep_running) {
                 log_info("Shutting down gracefully...");
@@ -2133,7 +5386,9 @@ static int stream_binlog(MYSQL *m, MYSQL_RPL *rpl){
             continue;
         }
         events_received++;
+        profiler_begin(&span);
         parse_event(rpl->buffer, (uint32_t)rpl->size);
+        profiler_end(&span, PROFILE_DECODE);
     }
     return 0;
 }
@@ -2145,9 +5400,17 @@ static int stream_binlog(MYSQL *m, MYSQL_RPL *rpl){
 static log_file_t main_log;
 
 int main(int argc, char **argv){
+    // Re-executed as the host process of an isolated publisher
+    if(argc >= 2 && strcmp(argv[1], PLUGIN_HOST_ARG) == 0) {
+        return plugin_host_main(argc, argv);
+    }
+
     signal(SIGINT,  signal_handler);
     signal(SIGTERM, signal_handler);
 
+    struct timespec startup_t0;
+    clock_gettime(CLOCK_MONOTONIC, &startup_t0);
+
     if(argc < 2){
         fprintf(stderr, "Usage: %s config.json\n", argv[0]);
         return 1;
@@ -2171,19 +5434,22 @@ int main(int argc, char **argv){
         log_warn("Failed to print Database configurations");
     }
 
-    // Start all publishers
+    metrics_init(g_config.metrics_file, g_config.metrics_interval);
+    metrics_describe("binlog_startup_seconds", METRICS_GAUGE,
+                     "Time from process start until streaming began");
+    metrics_describe("binlog_startup_publishers_pending", METRICS_GAUGE,
+                     "Non-critical publishers still starting when streaming began");
+    metrics_describe("binlog_heartbeats_total", METRICS_COUNTER,
+                     "HEARTBEAT events received from the primary");
+    metrics_describe("binlog_watermark_events_total", METRICS_COUNTER,
+                     "WATERMARK events sent to publishers");
+
+    // Load and start publishers in the background while we connect to
+    // MySQL; streaming begins once the critical ones are ready
     if (g_config.publisher_manager) {
-        publisher_instance_t *inst = g_config.publisher_manager->instances;
-        while (inst) {
-            if (inst->active) {
-                if (publisher_instance_start(inst) == 0) {
-                    log_info("Started publisher: %s", inst->name);
-                } else {
-                    log_error("Failed to start publisher: %s", inst->name);
-                }
-            }
-            inst = inst->next;
-        }
+        publisher_manager_start_all(g_config.publisher_manager, g_config.startup_threads);
+        control_server_start(g_config.control_socket, g_config.control_max_clients,
+                             g_config.control_mode, g_config.publisher_manager);
     }
 
     MYSQL *m = mysql_init(NULL);
@@ -2216,14 +5482,34 @@ int main(int argc, char **argv){
         }
     }
 
+    if(g_config.schema_threads > 0 &&
+       schema_resolver_start(g_config.host, g_config.port, g_config.username,
+                             g_config.password, g_config.schema_threads) != 0) {
+        log_warn("Schema resolver unavailable, column names are fetched inline");
+    }
+
     g_socket_fd = get_mysql_socket_fd(m);
     detect_checksum(m);
     announce_checksum(m);
+    announce_heartbeat(m, g_config.watermark_interval_ms);
 
     char start_file[256] = "";
     uint64_t start_pos = 4;
 
-    if(restore_position(start_file, &start_pos) != 0) {
+    if(restore_position(start_file, &start_pos) == 0) {
+        if(g_config.start_time) {
+            log_info("Resuming from checkpoint %s @ %llu, start_time ignored",
+                     start_file, (unsigned long long)start_pos);
+        }
+    } else if(g_config.start_time) {
+        if(seek_start_time(m, g_config.start_time, start_file, sizeof(start_file), &start_pos) != 0) {
+            log_error("Cannot find a binlog position for start_time %lld",
+                      (long long)g_config.start_time);
+            mysql_close(m);
+            if(g_metadata_conn) mysql_close(g_metadata_conn);
+            return 1;
+        }
+    } else {
         if(g_config.binlog_file[0]) {
             //strncpy(start_file, g_config.binlog_file, sizeof(start_file) - 1);
             snprintf(start_file, sizeof(start_file), "%s", g_config.binlog_file);
@@ -2238,6 +5524,34 @@ int main(int argc, char **argv){
         }
     }
 
+    // Snapshot the enrichment lookup tables; changes from start_pos on are
+    // replayed from the stream, so the cache converges on the source
+    load_enrich_tables();
+
+    if (g_config.publisher_manager) {
+        int waiting = publisher_manager_wait_ready(g_config.publisher_manager,
+                                                   g_config.startup_timeout_ms);
+        if (waiting > 0) {
+            log_warn("%d critical publisher(s) not ready after %d ms, streaming anyway",
+                     waiting, g_config.startup_timeout_ms);
+        }
+    }
+
+    struct timespec startup_t1;
+    clock_gettime(CLOCK_MONOTONIC, &startup_t1);
+    double startup_sec = (startup_t1.tv_sec - startup_t0.tv_sec) +
+                         (startup_t1.tv_nsec - startup_t0.tv_nsec) / 1e9;
+    int pending = 0;
+    if (g_config.publisher_manager) {
+        pthread_mutex_lock(&g_config.publisher_manager->startup_mutex);
+        pending = g_config.publisher_manager->startup_pending;
+        pthread_mutex_unlock(&g_config.publisher_manager->startup_mutex);
+    }
+    metrics_set("binlog_startup_seconds", NULL, startup_sec);
+    metrics_set("binlog_startup_publishers_pending", NULL, pending);
+    if (g_config.metrics_file[0]) metrics_write(g_config.metrics_file);
+    log_info("Startup completed in %.3f s (%d publisher(s) still starting)", startup_sec, pending);
+
     MYSQL_RPL rpl;
     memset(&rpl, 0, sizeof(rpl));
     rpl.file_name_length = strlen(start_file);
@@ -2253,14 +5567,20 @@ int main(int argc, char **argv){
         return 1;
     }
 
+    profiler_register_thread("stream");
     int ret = stream_binlog(m, &rpl);
+    if(g_parked) replay_parked(1);
+    parked_discard();
+    coalesce_flush_all();
+    profiler_unregister_thread();
 
     if(g_config.save_last_position) {
-        save_position(current_binlog, current_position);
+        save_checkpoint();
     }
 
     mysql_binlog_close(m, &rpl);
     mysql_close(m);
+    schema_resolver_stop();
     if(g_metadata_conn) {
         mysql_close(g_metadata_conn);
         g_metadata_conn = NULL;
@@ -2269,14 +5589,9 @@ int main(int argc, char **argv){
 
     // Stop and cleanup publishers
     if (g_config.publisher_manager) {
-        publisher_instance_t *inst = g_config.publisher_manager->instances;
-        while (inst) {
-            if (inst->started) {
-                publisher_instance_stop(inst);
-            }
-            inst = inst->next;
-        }
-        
+        publisher_manager_join_startup(g_config.publisher_manager);
+        control_server_stop();
+        publisher_manager_stop_all(g_config.publisher_manager);
         publisher_manager_destroy(g_config.publisher_manager);
         g_config.publisher_manager = NULL;
     }
@@ -2285,14 +5600,27 @@ int main(int argc, char **argv){
     free(g_map.metadata);
     free(g_map.real_types);
 
-    if(g_map.column_names) {
-        for(uint32_t i = 0; i < g_map.ncols; i++) {
-            free(g_map.column_names[i]);
-        }
-        free(g_map.column_names);
-    }
+    free_column_names();
 
     free_enum_cache();
+    free(g_map.include_names);
+    free(g_map.binary_opts);
+    free(g_map.column_binary);
+    free(g_partial.before);
+    tid_cache_clear();
+    free(g_tid_cache);
+    if(g_coalesce) {
+        for (int i = 0; i < g_config.profile_count; i++) free(g_coalesce[i].buf);
+        free(g_coalesce);
+    }
+
+    for (int i = 0; i < g_config.profile_count; i++) {
+        free_output_profile(&g_config.profiles[i]);
+    }
+    free(g_config.profiles);
+
+    profiler_shutdown();
+    metrics_shutdown();
 
     for (int i = 0; i < g_config.database_count; i++) {
         for (int j = 0; j < g_config.databases[i].table_count; j++) {
@@ -2300,6 +5628,9 @@ int main(int argc, char **argv){
 
             /* free columns array (if allocated) */
             free(tbl->columns);
+            free(tbl->binary_columns);
+            free_enrich_rules(tbl);
+            free_name_pattern(&tbl->match);
 
             /* free primary key strings */
             if (tbl->primary_keys) {
@@ -2310,6 +5641,7 @@ int main(int argc, char **argv){
             }
         }
         free(g_config.databases[i].tables);
+        free_name_pattern(&g_config.databases[i].match);
     }
     free(g_config.databases);
 
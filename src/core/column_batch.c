@@ -0,0 +1,216 @@
+// column_batch.c
+// Builder for columnar rows batches
+
+#include "column_batch.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define COLUMN_BATCH_INITIAL_ROWS 64
+
+typedef struct {
+    char *name;
+    uint8_t *validity;
+    uint64_t *values;           // fixed width types
+    uint32_t *offsets;          // string types, rows + 1 entries
+    char *data;
+    size_t data_len, data_cap;
+    int rows, capacity;
+    int var_width;
+} column_builder_t;
+
+struct column_batch {
+    cdc_column_batch_t view;
+    column_builder_t *builders[2];
+    cdc_column_t *columns[2];
+    int counts[2];
+    int rows;
+};
+
+static int is_var_width(int type) {
+    return type == CDC_COL_STRING || type == CDC_COL_BINARY;
+}
+
+column_batch_t* column_batch_create(int kind, int column_count, int before_count) {
+    column_batch_t *b = calloc(1, sizeof(column_batch_t));
+    if (!b) return NULL;
+
+    b->view.kind = kind;
+    b->counts[COLUMN_BATCH_AFTER] = column_count;
+    b->counts[COLUMN_BATCH_BEFORE] = before_count;
+
+    for (int img = 0; img < 2; img++) {
+        int n = b->counts[img] ? b->counts[img] : 1;
+        b->builders[img] = calloc(n, sizeof(column_builder_t));
+        b->columns[img] = calloc(n, sizeof(cdc_column_t));
+        if (!b->builders[img] || !b->columns[img]) {
+            column_batch_free(b);
+            return NULL;
+        }
+    }
+    return b;
+}
+
+void column_batch_free(column_batch_t *b) {
+    if (!b) return;
+    for (int img = 0; img < 2; img++) {
+        if (b->builders[img]) {
+            for (int i = 0; i < b->counts[img]; i++) {
+                column_builder_t *cb = &b->builders[img][i];
+                free(cb->name);
+                free(cb->validity);
+                free(cb->values);
+                free(cb->offsets);
+                free(cb->data);
+            }
+        }
+        free(b->builders[img]);
+        free(b->columns[img]);
+    }
+    free(b);
+}
+
+void column_batch_set_column(column_batch_t *b, int image, int idx,
+                             const char *name, int type, int mysql_type) {
+    if (!b || image < 0 || image > 1 || idx < 0 || idx >= b->counts[image]) return;
+    column_builder_t *cb = &b->builders[image][idx];
+    cdc_column_t *col = &b->columns[image][idx];
+    free(cb->name);
+    cb->name = strdup(name ? name : "");
+    col->name = cb->name ? cb->name : "";
+    col->type = type;
+    col->mysql_type = mysql_type;
+    cb->var_width = is_var_width(type);
+}
+
+// Make room for one more row in a column
+static column_builder_t* builder_reserve(column_batch_t *b, int image, int idx) {
+    if (!b || image < 0 || image > 1 || idx < 0 || idx >= b->counts[image]) return NULL;
+    column_builder_t *cb = &b->builders[image][idx];
+    if (cb->rows < cb->capacity) return cb;
+
+    int cap = cb->capacity ? cb->capacity * 2 : COLUMN_BATCH_INITIAL_ROWS;
+    size_t old_bytes = (cb->capacity + 7) / 8;
+    size_t new_bytes = (cap + 7) / 8;
+
+    uint8_t *validity = realloc(cb->validity, new_bytes);
+    if (!validity) return NULL;
+    memset(validity + old_bytes, 0, new_bytes - old_bytes);
+    cb->validity = validity;
+
+    if (cb->var_width) {
+        uint32_t *offsets = realloc(cb->offsets, (cap + 1) * sizeof(uint32_t));
+        if (!offsets) return NULL;
+        if (!cb->capacity) offsets[0] = 0;
+        cb->offsets = offsets;
+    } else {
+        uint64_t *values = realloc(cb->values, cap * sizeof(uint64_t));
+        if (!values) return NULL;
+        cb->values = values;
+    }
+    cb->capacity = cap;
+    return cb;
+}
+
+static void builder_set_valid(column_builder_t *cb, int valid) {
+    if (valid) cb->validity[cb->rows >> 3] |= (uint8_t)(1u << (cb->rows & 7));
+    else cb->validity[cb->rows >> 3] &= (uint8_t)~(1u << (cb->rows & 7));
+}
+
+int column_batch_append_null(column_batch_t *b, int image, int idx) {
+    column_builder_t *cb = builder_reserve(b, image, idx);
+    if (!cb) return -1;
+    builder_set_valid(cb, 0);
+    if (cb->var_width) cb->offsets[cb->rows + 1] = (uint32_t)cb->data_len;
+    else cb->values[cb->rows] = 0;
+    cb->rows++;
+    return 0;
+}
+
+int column_batch_append_int(column_batch_t *b, int image, int idx, int64_t v) {
+    column_builder_t *cb = builder_reserve(b, image, idx);
+    if (!cb || cb->var_width) return -1;
+    builder_set_valid(cb, 1);
+    memcpy(&cb->values[cb->rows], &v, sizeof(v));
+    cb->rows++;
+    return 0;
+}
+
+int column_batch_append_double(column_batch_t *b, int image, int idx, double v) {
+    column_builder_t *cb = builder_reserve(b, image, idx);
+    if (!cb || cb->var_width) return -1;
+    builder_set_valid(cb, 1);
+    memcpy(&cb->values[cb->rows], &v, sizeof(v));
+    cb->rows++;
+    return 0;
+}
+
+int column_batch_append_bytes(column_batch_t *b, int image, int idx,
+                              const void *data, size_t len) {
+    column_builder_t *cb = builder_reserve(b, image, idx);
+    if (!cb || !cb->var_width) return -1;
+    if (cb->data_len + len > UINT32_MAX) return -1;
+
+    if (cb->data_len + len > cb->data_cap) {
+        size_t cap = cb->data_cap ? cb->data_cap : 1024;
+        while (cap < cb->data_len + len) cap *= 2;
+        char *nd = realloc(cb->data, cap);
+        if (!nd) return -1;
+        cb->data = nd;
+        cb->data_cap = cap;
+    }
+    if (len) memcpy(cb->data + cb->data_len, data, len);
+    cb->data_len += len;
+
+    builder_set_valid(cb, 1);
+    cb->offsets[cb->rows + 1] = (uint32_t)cb->data_len;
+    cb->rows++;
+    return 0;
+}
+
+void column_batch_end_row(column_batch_t *b) {
+    if (b) b->rows++;
+}
+
+void column_batch_abort_row(column_batch_t *b) {
+    if (!b) return;
+    for (int img = 0; img < 2; img++) {
+        for (int i = 0; i < b->counts[img]; i++) {
+            column_builder_t *cb = &b->builders[img][i];
+            if (cb->rows <= b->rows) continue;
+            cb->rows = b->rows;
+            if (cb->var_width) cb->data_len = cb->offsets[cb->rows];
+        }
+    }
+}
+
+int column_batch_rows(const column_batch_t *b) {
+    return b ? b->rows : 0;
+}
+
+cdc_column_batch_t* column_batch_finish(column_batch_t *b) {
+    if (!b) return NULL;
+
+    static const uint32_t empty_offsets[1] = { 0 };
+    for (int img = 0; img < 2; img++) {
+        for (int i = 0; i < b->counts[img]; i++) {
+            column_builder_t *cb = &b->builders[img][i];
+            cdc_column_t *col = &b->columns[img][i];
+            col->validity = cb->validity;
+            col->values = cb->var_width ? NULL : cb->values;
+            col->offsets = cb->var_width ? (cb->offsets ? cb->offsets : empty_offsets) : NULL;
+            col->data = cb->var_width ? (cb->data ? cb->data : "") : NULL;
+        }
+    }
+
+    b->view.row_count = b->rows;
+    b->view.column_count = b->counts[COLUMN_BATCH_AFTER];
+    b->view.columns = b->columns[COLUMN_BATCH_AFTER];
+    b->view.before_column_count = b->counts[COLUMN_BATCH_BEFORE];
+    b->view.before_columns = b->counts[COLUMN_BATCH_BEFORE] ?
+                             b->columns[COLUMN_BATCH_BEFORE] : NULL;
+    return &b->view;
+}
+
+const cdc_column_batch_t* column_batch_view(const column_batch_t *b) {
+    return b ? &b->view : NULL;
+}
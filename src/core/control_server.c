@@ -0,0 +1,312 @@
+// control_server.c
+// Local control socket: delivered watermarks, read-your-writes waits and
+// publisher counters
+
+#include "control_server.h"
+#include "logger.h"
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <errno.h>
+#include <poll.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+#define CONTROL_LINE_MAX        1024
+#define CONTROL_REPLY_MAX       65536
+#define CONTROL_POLL_MS         200
+#define CONTROL_MAX_WAIT_MS     3600000
+
+static publisher_manager_t *control_manager = NULL;
+static char control_path[108];
+static int listen_fd = -1;
+static pthread_t accept_thread;
+static int accept_started = 0;
+
+// Client connections, so stop can shut them down
+static pthread_mutex_t control_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t control_cond = PTHREAD_COND_INITIALIZER;
+static int *client_fds = NULL;
+static int max_clients = 0;
+static int client_count = 0;
+static int control_stop = 0;
+
+static publisher_instance_t* find_publisher(const char *name) {
+    for (publisher_instance_t *inst = control_manager->instances; inst; inst = inst->next) {
+        if (strcmp(inst->name, name) == 0) return inst;
+    }
+    return NULL;
+}
+
+static int send_all(int fd, const char *buf, size_t len) {
+    while (len > 0) {
+        ssize_t n = send(fd, buf, len, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        buf += n;
+        len -= (size_t)n;
+    }
+    return 0;
+}
+
+// {"<key>":[<one object per publisher, or only name>]}
+static void cmd_list(const char *key, int (*format)(publisher_instance_t*, char*, size_t),
+                     const char *name, char *reply, size_t size) {
+    int len = snprintf(reply, size, "{\"%s\":[", key);
+    int first = 1;
+    for (publisher_instance_t *inst = control_manager->instances; inst; inst = inst->next) {
+        if (name && strcmp(inst->name, name) != 0) continue;
+        if (!first && len < (int)size) len += snprintf(reply + len, size - len, ",");
+        int n = len < (int)size ? format(inst, reply + len, size - len) : -1;
+        if (n < 0) {
+            snprintf(reply, size, "ERR reply too large");
+            return;
+        }
+        len += n;
+        first = 0;
+    }
+    if (name && first) {
+        snprintf(reply, size, "ERR unknown publisher %s", name);
+        return;
+    }
+    if (len < (int)size) snprintf(reply + len, size - len, "]}");
+}
+
+static void cmd_wait_for(const char *mark_text, const char *name, const char *timeout_text,
+                         char *reply, size_t size) {
+    publisher_mark_t mark;
+    if (!mark_text || !name || !timeout_text) {
+        snprintf(reply, size, "ERR usage: WAIT_FOR <gtid|binlog_file:position> <publisher> <timeout_ms>");
+        return;
+    }
+    if (publisher_mark_parse(mark_text, &mark) != 0) {
+        snprintf(reply, size, "ERR invalid GTID or position %s", mark_text);
+        return;
+    }
+    publisher_instance_t *inst = find_publisher(name);
+    if (!inst) {
+        snprintf(reply, size, "ERR unknown publisher %s", name);
+        return;
+    }
+    int timeout_ms = atoi(timeout_text);
+    if (timeout_ms < 0) timeout_ms = 0;
+    if (timeout_ms > CONTROL_MAX_WAIT_MS) timeout_ms = CONTROL_MAX_WAIT_MS;
+
+    int rc = publisher_watermark_wait(inst, &mark, timeout_ms);
+    snprintf(reply, size, "%s", rc == 0 ? "OK" : rc > 0 ? "TIMEOUT" : "ERR shutting down");
+}
+
+static void handle_line(char *line, char *reply, size_t size) {
+    char *save = NULL;
+    char *cmd = strtok_r(line, " \t\r", &save);
+    if (!cmd) {
+        snprintf(reply, size, "ERR empty command");
+        return;
+    }
+    char *a1 = strtok_r(NULL, " \t\r", &save);
+    char *a2 = strtok_r(NULL, " \t\r", &save);
+    char *a3 = strtok_r(NULL, " \t\r", &save);
+
+    if (strcasecmp(cmd, "WATERMARK") == 0) {
+        cmd_list("watermarks", publisher_watermark_format, a1, reply, size);
+    } else if (strcasecmp(cmd, "STATS") == 0) {
+        cmd_list("stats", publisher_stats_format, a1, reply, size);
+    } else if (strcasecmp(cmd, "WAIT_FOR") == 0) {
+        cmd_wait_for(a1, a2, a3, reply, size);
+    } else {
+        snprintf(reply, size, "ERR unknown command %s", cmd);
+    }
+}
+
+static void* client_thread(void *arg) {
+    int fd = (int)(intptr_t)arg;
+    char line[CONTROL_LINE_MAX];
+    size_t used = 0;
+    char *reply = malloc(CONTROL_REPLY_MAX);
+
+    while (reply) {
+        ssize_t n = recv(fd, line + used, sizeof(line) - 1 - used, 0);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        used += (size_t)n;
+        line[used] = '\0';
+
+        // Answer every complete line in the buffer
+        char *start = line;
+        char *nl;
+        int failed = 0;
+        while (!failed && (nl = strchr(start, '\n')) != NULL) {
+            *nl = '\0';
+            handle_line(start, reply, CONTROL_REPLY_MAX - 1);
+            size_t len = strlen(reply);
+            reply[len++] = '\n';
+            failed = send_all(fd, reply, len) != 0;
+            start = nl + 1;
+        }
+        if (failed) break;
+        used -= (size_t)(start - line);
+        memmove(line, start, used);
+        if (used == sizeof(line) - 1) {
+            send_all(fd, "ERR line too long\n", 18);
+            break;
+        }
+    }
+    free(reply);
+
+    pthread_mutex_lock(&control_mutex);
+    for (int i = 0; i < max_clients; i++) {
+        if (client_fds[i] == fd) client_fds[i] = -1;
+    }
+    client_count--;
+    pthread_cond_broadcast(&control_cond);
+    pthread_mutex_unlock(&control_mutex);
+    close(fd);
+    return NULL;
+}
+
+static void* accept_loop(void *arg) {
+    (void)arg;
+    struct pollfd pfd = { .fd = listen_fd, .events = POLLIN };
+
+    while (1) {
+        pthread_mutex_lock(&control_mutex);
+        int stop = control_stop;
+        pthread_mutex_unlock(&control_mutex);
+        if (stop) break;
+
+        if (poll(&pfd, 1, CONTROL_POLL_MS) <= 0) continue;
+        int fd = accept(listen_fd, NULL, NULL);
+        if (fd < 0) continue;
+
+        pthread_mutex_lock(&control_mutex);
+        int slot = -1;
+        for (int i = 0; i < max_clients && !control_stop; i++) {
+            if (client_fds[i] < 0) {
+                slot = i;
+                break;
+            }
+        }
+        if (slot >= 0) {
+            client_fds[slot] = fd;
+            client_count++;
+        }
+        pthread_mutex_unlock(&control_mutex);
+
+        if (slot < 0) {
+            send_all(fd, "ERR too many clients\n", 21);
+            close(fd);
+            continue;
+        }
+
+        pthread_t tid;
+        pthread_attr_t attr;
+        pthread_attr_init(&attr);
+        pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+        if (pthread_create(&tid, &attr, client_thread, (void*)(intptr_t)fd) != 0) {
+            log_warn("Control: cannot start client thread");
+            pthread_mutex_lock(&control_mutex);
+            client_fds[slot] = -1;
+            client_count--;
+            pthread_mutex_unlock(&control_mutex);
+            close(fd);
+        }
+        pthread_attr_destroy(&attr);
+    }
+    return NULL;
+}
+
+int control_server_start(const char *path, int clients, int mode, publisher_manager_t *manager) {
+    if (!path || !path[0] || !manager) return 0;
+
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        log_error("Control socket path too long: %s", path);
+        return -1;
+    }
+    snprintf(addr.sun_path, sizeof(addr.sun_path), "%s", path);
+
+    // Only ever replace a stale socket, never a file that happens to be there
+    struct stat st;
+    if (lstat(path, &st) == 0 && !S_ISSOCK(st.st_mode)) {
+        log_error("Control socket %s: exists and is not a socket", path);
+        return -1;
+    }
+
+    max_clients = clients > 0 ? clients : 64;
+    client_fds = malloc(max_clients * sizeof(int));
+    if (!client_fds) return -1;
+    for (int i = 0; i < max_clients; i++) client_fds[i] = -1;
+
+    listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listen_fd < 0) {
+        log_error("Control socket: %s", strerror(errno));
+        return -1;
+    }
+    unlink(path);
+    // chmod before listen: nobody can connect in between
+    int bound = bind(listen_fd, (struct sockaddr*)&addr, sizeof(addr)) == 0;
+    if (!bound || chmod(path, mode > 0 ? (mode_t)mode : 0600) != 0 ||
+        listen(listen_fd, 16) != 0) {
+        log_error("Control socket %s: %s", path, strerror(errno));
+        close(listen_fd);
+        listen_fd = -1;
+        if (bound) unlink(path);
+        return -1;
+    }
+
+    control_manager = manager;
+    snprintf(control_path, sizeof(control_path), "%s", path);
+    control_stop = 0;
+
+    if (pthread_create(&accept_thread, NULL, accept_loop, NULL) != 0) {
+        log_error("Failed to start control thread");
+        close(listen_fd);
+        listen_fd = -1;
+        unlink(path);
+        return -1;
+    }
+    accept_started = 1;
+
+    log_info("Control socket listening on %s (mode %04o)", path, mode > 0 ? mode : 0600);
+    return 0;
+}
+
+void control_server_stop(void) {
+    if (!accept_started) return;
+
+    pthread_mutex_lock(&control_mutex);
+    control_stop = 1;
+    pthread_mutex_unlock(&control_mutex);
+    pthread_join(accept_thread, NULL);
+    accept_started = 0;
+
+    close(listen_fd);
+    listen_fd = -1;
+    unlink(control_path);
+
+    // Wake WAIT_FOR callers, then disconnect everyone
+    for (publisher_instance_t *inst = control_manager->instances; inst; inst = inst->next) {
+        publisher_watermark_close(inst);
+    }
+    pthread_mutex_lock(&control_mutex);
+    for (int i = 0; i < max_clients; i++) {
+        if (client_fds[i] >= 0) shutdown(client_fds[i], SHUT_RDWR);
+    }
+    while (client_count > 0) {
+        pthread_cond_wait(&control_cond, &control_mutex);
+    }
+    pthread_mutex_unlock(&control_mutex);
+
+    free(client_fds);
+    client_fds = NULL;
+    control_manager = NULL;
+}
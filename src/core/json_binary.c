@@ -0,0 +1,752 @@
+// json_binary.c
+// MySQL binary JSON decoder and partial JSON diff support
+
+#include "json_binary.h"
+#include "binary_codec.h"
+#include <json-c/json.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Value types of the binary format
+#define JSONB_SMALL_OBJECT  0x00
+#define JSONB_LARGE_OBJECT  0x01
+#define JSONB_SMALL_ARRAY   0x02
+#define JSONB_LARGE_ARRAY   0x03
+#define JSONB_LITERAL       0x04
+#define JSONB_INT16         0x05
+#define JSONB_UINT16        0x06
+#define JSONB_INT32         0x07
+#define JSONB_UINT32        0x08
+#define JSONB_INT64         0x09
+#define JSONB_UINT64        0x0a
+#define JSONB_DOUBLE        0x0b
+#define JSONB_STRING        0x0c
+#define JSONB_OPAQUE        0x0f
+
+#define JSONB_LITERAL_NULL  0x00
+#define JSONB_LITERAL_TRUE  0x01
+#define JSONB_LITERAL_FALSE 0x02
+
+// Diff operations
+#define JSON_DIFF_REPLACE   0
+#define JSON_DIFF_INSERT    1
+#define JSON_DIFF_REMOVE    2
+
+// MySQL column types that appear as opaque values
+#define OPAQUE_TIMESTAMP    7
+#define OPAQUE_DATE        10
+#define OPAQUE_TIME        11
+#define OPAQUE_DATETIME    12
+#define OPAQUE_NEWDECIMAL 246
+
+#define JSON_MAX_DEPTH     100      // same nesting limit as the server
+#define JSON_PATH_MAX_LEGS 100
+
+// ============================================================================
+// OUTPUT
+// ============================================================================
+
+// snprintf style writer: counts everything, stores what fits
+typedef struct {
+    char *buf;
+    size_t size;
+    size_t len;
+} json_out_t;
+
+static void out_put(json_out_t *o, const char *s, size_t n) {
+    if (o->len < o->size) {
+        size_t room = o->size - o->len;
+        memcpy(o->buf + o->len, s, n < room ? n : room);
+    }
+    o->len += n;
+}
+
+static void out_printf(json_out_t *o, const char *fmt, ...) {
+    char tmp[64];
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vsnprintf(tmp, sizeof(tmp), fmt, ap);
+    va_end(ap);
+    if (n > 0) out_put(o, tmp, (size_t)n < sizeof(tmp) ? (size_t)n : sizeof(tmp) - 1);
+}
+
+static long out_finish(json_out_t *o) {
+    if (o->size) o->buf[o->len < o->size ? o->len : o->size - 1] = '\0';
+    return (long)o->len;
+}
+
+static void out_escaped(json_out_t *o, const char *s, size_t n) {
+    size_t run = 0;
+    for (size_t i = 0; i < n; i++) {
+        unsigned char c = (unsigned char)s[i];
+        const char *esc = NULL;
+        switch (c) {
+            case '"':  esc = "\\\""; break;
+            case '\\': esc = "\\\\"; break;
+            case '\n': esc = "\\n"; break;
+            case '\r': esc = "\\r"; break;
+            case '\t': esc = "\\t"; break;
+            case '\b': esc = "\\b"; break;
+            case '\f': esc = "\\f"; break;
+            default:
+                if (c >= 32) continue;
+        }
+        out_put(o, s + run, i - run);
+        if (esc) out_put(o, esc, 2);
+        else out_printf(o, "\\u%04x", c);
+        run = i + 1;
+    }
+    out_put(o, s + run, n - run);
+}
+
+static void out_string(json_out_t *o, const char *s, size_t n) {
+    out_put(o, "\"", 1);
+    out_escaped(o, s, n);
+    out_put(o, "\"", 1);
+}
+
+// ============================================================================
+// BINARY JSON DECODER
+// ============================================================================
+
+static uint32_t read_uint(const unsigned char *p, int size) {
+    uint32_t v = 0;
+    for (int i = 0; i < size; i++) v |= (uint32_t)p[i] << (8 * i);
+    return v;
+}
+
+// Variable length string size: 7 bits per byte, high bit = more bytes
+static int read_varlen(const unsigned char *p, size_t len, uint32_t *value, size_t *used) {
+    uint64_t v = 0;
+    for (size_t i = 0; i < len && i < 5; i++) {
+        v |= (uint64_t)(p[i] & 0x7f) << (7 * i);
+        if (!(p[i] & 0x80)) {
+            if (v > UINT32_MAX) return -1;
+            *value = (uint32_t)v;
+            *used = i + 1;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+static void out_double(json_out_t *o, double d) {
+    char tmp[40];
+    snprintf(tmp, sizeof(tmp), "%.15g", d);
+    if (strtod(tmp, NULL) != d) snprintf(tmp, sizeof(tmp), "%.17g", d);
+    out_put(o, tmp, strlen(tmp));
+    if (!strpbrk(tmp, ".eEn")) out_put(o, ".0", 2);   // keep it a double
+}
+
+// Binary DECIMAL: groups of 9 digits in 4 big-endian bytes, sign in the top bit
+static int out_decimal(json_out_t *o, const unsigned char *p, size_t len) {
+    static const int dig2bytes[10] = { 0, 1, 1, 2, 2, 3, 3, 4, 4, 4 };
+    if (len < 2) return -1;
+    int precision = p[0], scale = p[1];
+    if (precision < 1 || precision > 65 || scale > 30 || scale > precision) return -1;
+
+    int intg = precision - scale;
+    int intg0 = intg / 9, intg0x = intg % 9;
+    int frac0 = scale / 9, frac0x = scale % 9;
+    size_t size = intg0 * 4 + dig2bytes[intg0x] + frac0 * 4 + dig2bytes[frac0x];
+    if (len < 2 + size) return -1;
+
+    unsigned char buf[40];
+    memcpy(buf, p + 2, size);
+    int negative = !(buf[0] & 0x80);
+    buf[0] ^= 0x80;
+    if (negative) {
+        for (size_t i = 0; i < size; i++) buf[i] = (unsigned char)~buf[i];
+    }
+
+    const unsigned char *b = buf;
+    int started = 0;
+    if (negative) out_put(o, "-", 1);
+    if (intg0x) {
+        uint32_t v = 0;
+        for (int i = 0; i < dig2bytes[intg0x]; i++) v = (v << 8) | *b++;
+        if (v) {
+            out_printf(o, "%u", v);
+            started = 1;
+        }
+    }
+    for (int g = 0; g < intg0; g++, b += 4) {
+        uint32_t v = ((uint32_t)b[0] << 24) | ((uint32_t)b[1] << 16) | ((uint32_t)b[2] << 8) | b[3];
+        if (started) {
+            out_printf(o, "%09u", v);
+        } else if (v) {
+            out_printf(o, "%u", v);
+            started = 1;
+        }
+    }
+    if (!started) out_put(o, "0", 1);
+
+    if (scale) {
+        out_put(o, ".", 1);
+        for (int g = 0; g < frac0; g++, b += 4) {
+            uint32_t v = ((uint32_t)b[0] << 24) | ((uint32_t)b[1] << 16) | ((uint32_t)b[2] << 8) | b[3];
+            out_printf(o, "%09u", v);
+        }
+        if (frac0x) {
+            uint32_t v = 0;
+            for (int i = 0; i < dig2bytes[frac0x]; i++) v = (v << 8) | *b++;
+            out_printf(o, "%0*u", frac0x, v);
+        }
+    }
+    return 0;
+}
+
+// Temporal values are stored as the server's packed 8 byte integers
+static int out_temporal(json_out_t *o, int type, const unsigned char *p, size_t len) {
+    if (len < 8) return -1;
+    int64_t packed = 0;
+    for (int i = 7; i >= 0; i--) packed = (packed << 8) | p[i];
+    int negative = packed < 0;
+    uint64_t v = negative ? (uint64_t)-packed : (uint64_t)packed;
+    unsigned frac = (unsigned)(v % (1ULL << 24));
+    uint64_t intpart = v >> 24;
+
+    if (type == OPAQUE_TIME) {
+        out_printf(o, "\"%s%02u:%02u:%02u.%06u\"", negative ? "-" : "",
+                   (unsigned)((intpart >> 12) % (1 << 10)), (unsigned)((intpart >> 6) % 64),
+                   (unsigned)(intpart % 64), frac);
+        return 0;
+    }
+
+    uint64_t ymd = intpart >> 17, ym = ymd >> 5, hms = intpart % (1 << 17);
+    if (type == OPAQUE_DATE) {
+        out_printf(o, "\"%04u-%02u-%02u\"", (unsigned)(ym / 13), (unsigned)(ym % 13),
+                   (unsigned)(ymd % 32));
+    } else {
+        out_printf(o, "\"%04u-%02u-%02u %02u:%02u:%02u.%06u\"",
+                   (unsigned)(ym / 13), (unsigned)(ym % 13), (unsigned)(ymd % 32),
+                   (unsigned)(hms >> 12), (unsigned)((hms >> 6) % 64), (unsigned)(hms % 64), frac);
+    }
+    return 0;
+}
+
+static int out_opaque(json_out_t *o, const unsigned char *p, size_t len) {
+    if (len < 1) return -1;
+    int type = p[0];
+    uint32_t n;
+    size_t used;
+    if (read_varlen(p + 1, len - 1, &n, &used) != 0 || n > len - 1 - used) return -1;
+    const unsigned char *data = p + 1 + used;
+
+    switch (type) {
+        case OPAQUE_NEWDECIMAL:
+            return out_decimal(o, data, n);
+        case OPAQUE_DATE:
+        case OPAQUE_TIME:
+        case OPAQUE_DATETIME:
+        case OPAQUE_TIMESTAMP:
+            return out_temporal(o, type, data, n);
+        default: {
+            // Same text the server uses for other opaque values
+            char *b64 = malloc(BASE64_ENCODED_LEN(n) + 1);
+            if (!b64) return -1;
+            base64_encode(data, n, b64);
+            out_printf(o, "\"base64:type%d:", type);
+            out_put(o, b64, BASE64_ENCODED_LEN(n));
+            out_put(o, "\"", 1);
+            free(b64);
+            return 0;
+        }
+    }
+}
+
+static int decode_value(json_out_t *o, int type, const unsigned char *p, size_t len, int depth);
+
+// Object or array; offsets inside are relative to p
+static int decode_container(json_out_t *o, int type, const unsigned char *p, size_t len, int depth) {
+    int large = (type == JSONB_LARGE_OBJECT || type == JSONB_LARGE_ARRAY);
+    int is_object = (type == JSONB_SMALL_OBJECT || type == JSONB_LARGE_OBJECT);
+    int os = large ? 4 : 2;
+    if (depth > JSON_MAX_DEPTH || len < (size_t)(2 * os)) return -1;
+
+    uint32_t count = read_uint(p, os);
+    uint32_t bytes = read_uint(p + os, os);
+    if (bytes > len) return -1;
+
+    size_t key_entry = os + 2;
+    size_t value_entry = 1 + os;
+    size_t header = 2 * os + (is_object ? (size_t)count * key_entry : 0);
+    if (header + (size_t)count * value_entry > bytes) return -1;
+
+    out_put(o, is_object ? "{" : "[", 1);
+    for (uint32_t i = 0; i < count; i++) {
+        if (i) out_put(o, ",", 1);
+
+        if (is_object) {
+            const unsigned char *ke = p + 2 * os + (size_t)i * key_entry;
+            uint32_t key_off = read_uint(ke, os);
+            uint32_t key_len = read_uint(ke + os, 2);
+            if ((size_t)key_off + key_len > bytes) return -1;
+            out_string(o, (const char *)p + key_off, key_len);
+            out_put(o, ":", 1);
+        }
+
+        const unsigned char *ve = p + header + (size_t)i * value_entry;
+        int vt = ve[0];
+        int inlined = vt == JSONB_LITERAL || vt == JSONB_INT16 || vt == JSONB_UINT16 ||
+                      (large && (vt == JSONB_INT32 || vt == JSONB_UINT32));
+        if (inlined) {
+            if (decode_value(o, vt, ve + 1, os, depth + 1) != 0) return -1;
+        } else {
+            uint32_t off = read_uint(ve + 1, os);
+            if (off >= bytes) return -1;
+            if (decode_value(o, vt, p + off, bytes - off, depth + 1) != 0) return -1;
+        }
+    }
+    out_put(o, is_object ? "}" : "]", 1);
+    return 0;
+}
+
+static int decode_value(json_out_t *o, int type, const unsigned char *p, size_t len, int depth) {
+    switch (type) {
+        case JSONB_SMALL_OBJECT:
+        case JSONB_LARGE_OBJECT:
+        case JSONB_SMALL_ARRAY:
+        case JSONB_LARGE_ARRAY:
+            return decode_container(o, type, p, len, depth);
+        case JSONB_LITERAL:
+            if (len < 1) return -1;
+            if (p[0] == JSONB_LITERAL_NULL) out_put(o, "null", 4);
+            else if (p[0] == JSONB_LITERAL_TRUE) out_put(o, "true", 4);
+            else if (p[0] == JSONB_LITERAL_FALSE) out_put(o, "false", 5);
+            else return -1;
+            return 0;
+        case JSONB_INT16:
+            if (len < 2) return -1;
+            out_printf(o, "%d", (int16_t)read_uint(p, 2));
+            return 0;
+        case JSONB_UINT16:
+            if (len < 2) return -1;
+            out_printf(o, "%u", read_uint(p, 2));
+            return 0;
+        case JSONB_INT32:
+            if (len < 4) return -1;
+            out_printf(o, "%d", (int32_t)read_uint(p, 4));
+            return 0;
+        case JSONB_UINT32:
+            if (len < 4) return -1;
+            out_printf(o, "%u", read_uint(p, 4));
+            return 0;
+        case JSONB_INT64:
+        case JSONB_UINT64: {
+            if (len < 8) return -1;
+            uint64_t v = (uint64_t)read_uint(p, 4) | ((uint64_t)read_uint(p + 4, 4) << 32);
+            if (type == JSONB_INT64) out_printf(o, "%lld", (long long)(int64_t)v);
+            else out_printf(o, "%llu", (unsigned long long)v);
+            return 0;
+        }
+        case JSONB_DOUBLE: {
+            if (len < 8) return -1;
+            double d;
+            memcpy(&d, p, 8);
+            out_double(o, d);
+            return 0;
+        }
+        case JSONB_STRING: {
+            uint32_t n;
+            size_t used;
+            if (read_varlen(p, len, &n, &used) != 0 || n > len - used) return -1;
+            out_string(o, (const char *)p + used, n);
+            return 0;
+        }
+        case JSONB_OPAQUE:
+            return out_opaque(o, p, len);
+        default:
+            return -1;
+    }
+}
+
+// A complete binary JSON document: type byte followed by the value
+static int decode_document(json_out_t *o, const unsigned char *data, size_t len) {
+    if (len == 0) {
+        out_put(o, "null", 4);
+        return 0;
+    }
+    return decode_value(o, data[0], data + 1, len - 1, 0);
+}
+
+long json_binary_to_text(const unsigned char *data, size_t len, char *out, size_t size) {
+    json_out_t o = { out, size, 0 };
+    if (decode_document(&o, data, len) != 0) {
+        out_finish(&o);
+        return -1;
+    }
+    return out_finish(&o);
+}
+
+// Decode into a heap string sized to fit
+static char* binary_to_text_alloc(const unsigned char *data, size_t len) {
+    size_t size = len * 2 + 64;
+    for (;;) {
+        char *text = malloc(size);
+        if (!text) return NULL;
+        long n = json_binary_to_text(data, len, text, size);
+        if (n < 0) {
+            free(text);
+            return NULL;
+        }
+        if ((size_t)n < size) return text;
+        free(text);
+        size = (size_t)n + 1;
+    }
+}
+
+// ============================================================================
+// DIFFS
+// ============================================================================
+
+// One diff of a partial JSON value: op, path, and (not for remove) a value
+typedef struct {
+    int op;
+    const char *path;
+    size_t path_len;
+    const unsigned char *value;
+    size_t value_len;
+} json_diff_t;
+
+// Length-encoded integer of the client/server protocol
+static int read_packed(const unsigned char *p, size_t len, uint64_t *value, size_t *used) {
+    if (len < 1) return -1;
+    size_t n = p[0] < 251 ? 0 : p[0] == 252 ? 2 : p[0] == 253 ? 3 : p[0] == 254 ? 8 : (size_t)-1;
+    if (n == (size_t)-1 || len < 1 + n) return -1;
+    if (n == 0) {
+        *value = p[0];
+    } else {
+        uint64_t v = 0;
+        for (size_t i = 0; i < n; i++) v |= (uint64_t)p[1 + i] << (8 * i);
+        *value = v;
+    }
+    *used = 1 + n;
+    return 0;
+}
+
+// Read the diff at *pos; returns 1 when one was read, 0 at the end, -1 on error
+static int next_diff(const unsigned char *data, size_t len, size_t *pos, json_diff_t *d) {
+    if (*pos >= len) return 0;
+    const unsigned char *p = data + *pos;
+    size_t left = len - *pos;
+    uint64_t n;
+    size_t used;
+
+    d->op = p[0];
+    if (d->op > JSON_DIFF_REMOVE) return -1;
+    p++; left--;
+
+    if (read_packed(p, left, &n, &used) != 0 || n > left - used) return -1;
+    d->path = (const char *)p + used;
+    d->path_len = (size_t)n;
+    p += used + n; left -= used + n;
+
+    d->value = NULL;
+    d->value_len = 0;
+    if (d->op != JSON_DIFF_REMOVE) {
+        if (read_packed(p, left, &n, &used) != 0 || n > left - used) return -1;
+        d->value = p + used;
+        d->value_len = (size_t)n;
+        p += used + n; left -= used + n;
+    }
+
+    *pos = len - left;
+    return 1;
+}
+
+// Path leg: member name or array index
+typedef struct {
+    int is_index;
+    size_t index;
+    const char *key;            // NUL terminated, inside the caller's buffer
+    size_t key_len;
+} path_leg_t;
+
+static int hex_value(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+// Decode a quoted member name at s (after the opening quote) into dst
+static int unquote_key(const char *s, const char *end, char *dst, size_t *dst_len, const char **next) {
+    size_t n = 0;
+    while (s < end && *s != '"') {
+        char c = *s++;
+        if (c != '\\') {
+            dst[n++] = c;
+            continue;
+        }
+        if (s >= end) return -1;
+        c = *s++;
+        switch (c) {
+            case 'b': dst[n++] = '\b'; break;
+            case 'f': dst[n++] = '\f'; break;
+            case 'n': dst[n++] = '\n'; break;
+            case 'r': dst[n++] = '\r'; break;
+            case 't': dst[n++] = '\t'; break;
+            case 'u': {
+                if (end - s < 4) return -1;
+                unsigned cp = 0;
+                for (int i = 0; i < 4; i++) {
+                    int h = hex_value(s[i]);
+                    if (h < 0) return -1;
+                    cp = (cp << 4) | (unsigned)h;
+                }
+                s += 4;
+                if (cp < 0x80) {
+                    dst[n++] = (char)cp;
+                } else if (cp < 0x800) {
+                    dst[n++] = (char)(0xC0 | (cp >> 6));
+                    dst[n++] = (char)(0x80 | (cp & 0x3F));
+                } else {
+                    dst[n++] = (char)(0xE0 | (cp >> 12));
+                    dst[n++] = (char)(0x80 | ((cp >> 6) & 0x3F));
+                    dst[n++] = (char)(0x80 | (cp & 0x3F));
+                }
+                break;
+            }
+            default: dst[n++] = c; break;
+        }
+    }
+    if (s >= end) return -1;
+    *dst_len = n;
+    *next = s + 1;
+    return 0;
+}
+
+// Parse a server path such as $.a."b c"[2]. Member names are unescaped into
+// keys, which must hold len + max_legs bytes. Returns the number of legs.
+static int parse_path(const char *path, size_t len, path_leg_t *legs, int max_legs, char *keys) {
+    const char *s = path, *end = path + len;
+    while (s < end && *s == ' ') s++;
+    if (s >= end || *s != '$') return -1;
+    s++;
+
+    int n = 0;
+    while (s < end) {
+        if (*s == ' ') {
+            s++;
+            continue;
+        }
+        if (n >= max_legs) return -1;
+        path_leg_t *leg = &legs[n];
+        memset(leg, 0, sizeof(*leg));
+
+        if (*s == '[') {
+            s++;
+            size_t idx = 0;
+            int digits = 0;
+            while (s < end && *s >= '0' && *s <= '9') {
+                idx = idx * 10 + (size_t)(*s++ - '0');
+                digits++;
+            }
+            while (s < end && *s == ' ') s++;
+            if (!digits || s >= end || *s != ']') return -1;
+            s++;
+            leg->is_index = 1;
+            leg->index = idx;
+        } else if (*s == '.') {
+            s++;
+            while (s < end && *s == ' ') s++;
+            if (s >= end) return -1;
+            size_t klen;
+            if (*s == '"') {
+                if (unquote_key(s + 1, end, keys, &klen, &s) != 0) return -1;
+            } else {
+                const char *start = s;
+                while (s < end && *s != '.' && *s != '[' && *s != ' ') s++;
+                klen = (size_t)(s - start);
+                if (!klen || memchr(start, '*', klen)) return -1;
+                memcpy(keys, start, klen);
+            }
+            keys[klen] = '\0';
+            leg->key = keys;
+            leg->key_len = klen;
+            keys += klen + 1;
+        } else {
+            return -1;
+        }
+        n++;
+    }
+    return n;
+}
+
+// JSON Pointer (RFC 6901) of a parsed path, as a JSON string
+static void out_pointer(json_out_t *o, const path_leg_t *legs, int n) {
+    out_put(o, "\"", 1);
+    for (int i = 0; i < n; i++) {
+        out_put(o, "/", 1);
+        if (legs[i].is_index) {
+            out_printf(o, "%zu", legs[i].index);
+            continue;
+        }
+        const char *k = legs[i].key;
+        size_t run = 0;
+        for (size_t j = 0; j < legs[i].key_len; j++) {
+            if (k[j] != '~' && k[j] != '/') continue;
+            out_escaped(o, k + run, j - run);
+            out_put(o, k[j] == '~' ? "~0" : "~1", 2);
+            run = j + 1;
+        }
+        out_escaped(o, k + run, legs[i].key_len - run);
+    }
+    out_put(o, "\"", 1);
+}
+
+long json_diff_to_patch(const unsigned char *diff, size_t len, char *out, size_t size) {
+    static const char *ops[] = { "replace", "add", "remove" };
+    json_out_t o = { out, size, 0 };
+    path_leg_t legs[JSON_PATH_MAX_LEGS];
+    size_t pos = 0;
+    json_diff_t d;
+    int rc, first = 1;
+
+    out_put(&o, "[", 1);
+    while ((rc = next_diff(diff, len, &pos, &d)) == 1) {
+        char *keys = malloc(d.path_len + JSON_PATH_MAX_LEGS + 1);
+        int n = keys ? parse_path(d.path, d.path_len, legs, JSON_PATH_MAX_LEGS, keys) : -1;
+        if (n < 0) {
+            free(keys);
+            rc = -1;
+            break;
+        }
+
+        out_printf(&o, "%s{\"op\":\"%s\",\"path\":", first ? "" : ",", ops[d.op]);
+        out_pointer(&o, legs, n);
+        free(keys);
+        first = 0;
+
+        if (d.op != JSON_DIFF_REMOVE) {
+            out_put(&o, ",\"value\":", 9);
+            if (decode_document(&o, d.value, d.value_len) != 0) {
+                rc = -1;
+                break;
+            }
+        }
+        out_put(&o, "}", 1);
+    }
+    out_put(&o, "]", 1);
+
+    long n = out_finish(&o);
+    return rc < 0 ? -1 : n;
+}
+
+// Child of a container along one leg, NULL if absent
+static json_object* leg_child(json_object *parent, const path_leg_t *leg) {
+    json_object *child = NULL;
+    if (leg->is_index) {
+        if (!json_object_is_type(parent, json_type_array) ||
+            leg->index >= json_object_array_length(parent)) return NULL;
+        return json_object_array_get_idx(parent, leg->index);
+    }
+    if (!json_object_is_type(parent, json_type_object)) return NULL;
+    json_object_object_get_ex(parent, leg->key, &child);
+    return child;
+}
+
+// Apply one diff to *root; takes ownership of value
+static int apply_diff(json_object **root, int op, const path_leg_t *legs, int n,
+                      json_object *value) {
+    if (n == 0) {
+        if (op != JSON_DIFF_REPLACE) {
+            json_object_put(value);
+            return -1;
+        }
+        json_object_put(*root);
+        *root = value;
+        return 0;
+    }
+
+    json_object *parent = *root;
+    for (int i = 0; i < n - 1 && parent; i++) parent = leg_child(parent, &legs[i]);
+
+    const path_leg_t *leg = &legs[n - 1];
+    json_type want = leg->is_index ? json_type_array : json_type_object;
+    if (!parent || !json_object_is_type(parent, want)) {
+        json_object_put(value);
+        return -1;
+    }
+
+    if (!leg->is_index) {
+        if (op == JSON_DIFF_REMOVE) json_object_object_del(parent, leg->key);
+        else json_object_object_add(parent, leg->key, value);
+        return 0;
+    }
+
+    size_t count = json_object_array_length(parent);
+    if (op != JSON_DIFF_INSERT && leg->index >= count) {
+        json_object_put(value);
+        return -1;
+    }
+    switch (op) {
+        case JSON_DIFF_REPLACE:
+            return json_object_array_put_idx(parent, leg->index, value);
+        case JSON_DIFF_REMOVE:
+            return json_object_array_del_idx(parent, leg->index, 1);
+        default:
+            if (leg->index >= count) return json_object_array_add(parent, value);
+            // Shift the tail up one slot, then store the new element
+            json_object_array_add(parent, json_object_get(json_object_array_get_idx(parent, count - 1)));
+            for (size_t i = count - 1; i > leg->index; i--) {
+                json_object_array_put_idx(parent, i,
+                                          json_object_get(json_object_array_get_idx(parent, i - 1)));
+            }
+            return json_object_array_put_idx(parent, leg->index, value);
+    }
+}
+
+// Binary JSON value as a json-c object; JSON null is a NULL object
+static int binary_to_object(const unsigned char *data, size_t len, json_object **obj) {
+    char *text = binary_to_text_alloc(data, len);
+    if (!text) return -1;
+    *obj = json_tokener_parse(text);
+    int rc = (*obj || strcmp(text, "null") == 0) ? 0 : -1;
+    free(text);
+    return rc;
+}
+
+long json_diff_apply(const unsigned char *before, size_t before_len,
+                     const unsigned char *diff, size_t len, char *out, size_t size) {
+    json_object *root = NULL;
+    if (binary_to_object(before, before_len, &root) != 0) return -1;
+
+    path_leg_t legs[JSON_PATH_MAX_LEGS];
+    size_t pos = 0;
+    json_diff_t d;
+    int rc;
+
+    while ((rc = next_diff(diff, len, &pos, &d)) == 1) {
+        char *keys = malloc(d.path_len + JSON_PATH_MAX_LEGS + 1);
+        int n = keys ? parse_path(d.path, d.path_len, legs, JSON_PATH_MAX_LEGS, keys) : -1;
+
+        json_object *value = NULL;
+        if (n >= 0 && d.op != JSON_DIFF_REMOVE &&
+            binary_to_object(d.value, d.value_len, &value) != 0) n = -1;
+
+        if (n < 0 || apply_diff(&root, d.op, legs, n, value) != 0) {
+            free(keys);
+            rc = -1;
+            break;
+        }
+        free(keys);
+    }
+
+    if (rc < 0) {
+        json_object_put(root);
+        return -1;
+    }
+
+    const char *text = root ? json_object_to_json_string_ext(root,
+                                  JSON_C_TO_STRING_PLAIN | JSON_C_TO_STRING_NOSLASHESCAPE)
+                            : "null";
+    json_out_t o = { out, size, 0 };
+    out_put(&o, text, strlen(text));
+    json_object_put(root);
+    return out_finish(&o);
+}
@@ -86,6 +86,10 @@ void log_set_level(int level) {
   L.level = level;
 }
 
+int log_get_level(void) {
+  return L.level;
+}
+
 void log_set_quiet(bool enable) {
   L.quiet = enable;
 }
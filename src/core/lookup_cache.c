@@ -0,0 +1,194 @@
+// lookup_cache.c
+// Compact in-memory hash index for row enrichment
+
+#include "lookup_cache.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define LOOKUP_INITIAL_SLOTS 64
+
+// Entry layout: key_len bytes of key, then each value NUL terminated
+typedef struct {
+    uint32_t key_len;
+    uint32_t size;
+    char data[];
+} lookup_entry_t;
+
+typedef struct {
+    uint64_t hash;              // 0 = empty slot
+    lookup_entry_t *entry;
+} lookup_slot_t;
+
+struct lookup_cache {
+    lookup_slot_t *slots;
+    size_t capacity;            // power of two
+    size_t count;
+    size_t bytes;
+    int value_count;
+};
+
+// FNV-1a, never 0 so 0 can mark empty slots
+static uint64_t lookup_hash(const char *key, size_t len) {
+    uint64_t h = 1469598103934665603ULL;
+    for (size_t i = 0; i < len; i++) {
+        h ^= (unsigned char)key[i];
+        h *= 1099511628211ULL;
+    }
+    return h ? h : 1;
+}
+
+lookup_cache_t* lookup_cache_create(int value_count) {
+    lookup_cache_t *c = calloc(1, sizeof(lookup_cache_t));
+    if (!c) return NULL;
+    c->slots = calloc(LOOKUP_INITIAL_SLOTS, sizeof(lookup_slot_t));
+    if (!c->slots) {
+        free(c);
+        return NULL;
+    }
+    c->capacity = LOOKUP_INITIAL_SLOTS;
+    c->value_count = value_count;
+    return c;
+}
+
+void lookup_cache_clear(lookup_cache_t *c) {
+    if (!c) return;
+    for (size_t i = 0; i < c->capacity; i++) {
+        free(c->slots[i].entry);
+        c->slots[i].entry = NULL;
+        c->slots[i].hash = 0;
+    }
+    c->count = 0;
+    c->bytes = 0;
+}
+
+void lookup_cache_destroy(lookup_cache_t *c) {
+    if (!c) return;
+    lookup_cache_clear(c);
+    free(c->slots);
+    free(c);
+}
+
+// Slot holding key, or the empty slot where it would go
+static size_t lookup_find(const lookup_cache_t *c, uint64_t hash,
+                          const char *key, size_t key_len) {
+    size_t mask = c->capacity - 1;
+    size_t i = hash & mask;
+    while (c->slots[i].hash) {
+        const lookup_entry_t *e = c->slots[i].entry;
+        if (c->slots[i].hash == hash && e->key_len == key_len &&
+            memcmp(e->data, key, key_len) == 0) {
+            break;
+        }
+        i = (i + 1) & mask;
+    }
+    return i;
+}
+
+static int lookup_grow(lookup_cache_t *c) {
+    size_t cap = c->capacity * 2;
+    lookup_slot_t *slots = calloc(cap, sizeof(lookup_slot_t));
+    if (!slots) return -1;
+
+    for (size_t i = 0; i < c->capacity; i++) {
+        if (!c->slots[i].hash) continue;
+        size_t j = c->slots[i].hash & (cap - 1);
+        while (slots[j].hash) j = (j + 1) & (cap - 1);
+        slots[j] = c->slots[i];
+    }
+    free(c->slots);
+    c->slots = slots;
+    c->capacity = cap;
+    return 0;
+}
+
+int lookup_cache_put(lookup_cache_t *c, const char *key, size_t key_len,
+                     const char *const *values, const size_t *value_lens) {
+    if (!c || !key || key_len > UINT32_MAX) return -1;
+
+    // Keep the load factor under 3/4
+    if ((c->count + 1) * 4 > c->capacity * 3 && lookup_grow(c) != 0) return -1;
+
+    size_t size = key_len;
+    for (int v = 0; v < c->value_count; v++) size += value_lens[v] + 1;
+
+    lookup_entry_t *e = malloc(sizeof(lookup_entry_t) + size);
+    if (!e) return -1;
+    e->key_len = (uint32_t)key_len;
+    e->size = (uint32_t)size;
+
+    char *dst = e->data;
+    memcpy(dst, key, key_len);
+    dst += key_len;
+    for (int v = 0; v < c->value_count; v++) {
+        if (value_lens[v]) memcpy(dst, values[v], value_lens[v]);
+        dst += value_lens[v];
+        *dst++ = '\0';
+    }
+
+    uint64_t hash = lookup_hash(key, key_len);
+    size_t i = lookup_find(c, hash, key, key_len);
+    if (c->slots[i].hash) {
+        c->bytes -= c->slots[i].entry->size;
+        free(c->slots[i].entry);
+    } else {
+        c->count++;
+    }
+    c->slots[i].hash = hash;
+    c->slots[i].entry = e;
+    c->bytes += size;
+    return 0;
+}
+
+int lookup_cache_get(const lookup_cache_t *c, const char *key, size_t key_len,
+                     const char **values) {
+    if (!c || !key) return -1;
+
+    size_t i = lookup_find(c, lookup_hash(key, key_len), key, key_len);
+    if (!c->slots[i].hash) return -1;
+
+    const lookup_entry_t *e = c->slots[i].entry;
+    const char *p = e->data + e->key_len;
+    for (int v = 0; v < c->value_count; v++) {
+        values[v] = p;
+        p += strlen(p) + 1;
+    }
+    return 0;
+}
+
+void lookup_cache_remove(lookup_cache_t *c, const char *key, size_t key_len) {
+    if (!c || !key) return;
+
+    size_t mask = c->capacity - 1;
+    size_t i = lookup_find(c, lookup_hash(key, key_len), key, key_len);
+    if (!c->slots[i].hash) return;
+
+    c->bytes -= c->slots[i].entry->size;
+    free(c->slots[i].entry);
+    c->slots[i].hash = 0;
+    c->slots[i].entry = NULL;
+    c->count--;
+
+    // Backward shift: move later members of the probe run into the hole
+    size_t hole = i;
+    size_t j = (i + 1) & mask;
+    while (c->slots[j].hash) {
+        size_t home = c->slots[j].hash & mask;
+        if (((j - home) & mask) >= ((j - hole) & mask)) {
+            c->slots[hole] = c->slots[j];
+            c->slots[j].hash = 0;
+            c->slots[j].entry = NULL;
+            hole = j;
+        }
+        j = (j + 1) & mask;
+    }
+}
+
+size_t lookup_cache_count(const lookup_cache_t *c) {
+    return c ? c->count : 0;
+}
+
+size_t lookup_cache_bytes(const lookup_cache_t *c) {
+    if (!c) return 0;
+    return c->bytes + c->count * sizeof(lookup_entry_t) +
+           c->capacity * sizeof(lookup_slot_t);
+}
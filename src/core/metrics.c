@@ -0,0 +1,224 @@
+// metrics.c
+// Prometheus text format metrics registry and file writer
+
+#include "metrics.h"
+#include "logger.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <time.h>
+#include <errno.h>
+
+typedef struct {
+    char *name;
+    char *labels;
+    double value;
+} metric_t;
+
+typedef struct {
+    char *name;
+    char *help;
+    int type;
+} metric_family_t;
+
+static pthread_mutex_t metrics_mutex = PTHREAD_MUTEX_INITIALIZER;
+static metric_t *metrics = NULL;
+static int metric_count = 0;
+static int metric_capacity = 0;
+static metric_family_t *families = NULL;
+static int family_count = 0;
+
+static char metrics_path[512] = "";
+static int metrics_interval = 0;
+static pthread_t metrics_thread;
+static int metrics_thread_started = 0;
+static int metrics_stop = 0;
+static pthread_cond_t metrics_cond = PTHREAD_COND_INITIALIZER;
+
+// Find or create a series; caller holds metrics_mutex
+static metric_t* metric_lookup(const char *name, const char *labels) {
+    if (!labels) labels = "";
+
+    for (int i = 0; i < metric_count; i++) {
+        if (strcmp(metrics[i].name, name) == 0 && strcmp(metrics[i].labels, labels) == 0) {
+            return &metrics[i];
+        }
+    }
+
+    if (metric_count == metric_capacity) {
+        int cap = metric_capacity ? metric_capacity * 2 : 32;
+        metric_t *nm = realloc(metrics, cap * sizeof(metric_t));
+        if (!nm) return NULL;
+        metrics = nm;
+        metric_capacity = cap;
+    }
+
+    metric_t *m = &metrics[metric_count];
+    m->name = strdup(name);
+    m->labels = strdup(labels);
+    m->value = 0;
+    if (!m->name || !m->labels) {
+        free(m->name);
+        free(m->labels);
+        return NULL;
+    }
+    metric_count++;
+    return m;
+}
+
+void metrics_describe(const char *name, int type, const char *help) {
+    if (!name) return;
+
+    pthread_mutex_lock(&metrics_mutex);
+    for (int i = 0; i < family_count; i++) {
+        if (strcmp(families[i].name, name) == 0) {
+            pthread_mutex_unlock(&metrics_mutex);
+            return;
+        }
+    }
+    metric_family_t *nf = realloc(families, (family_count + 1) * sizeof(metric_family_t));
+    if (nf) {
+        families = nf;
+        families[family_count].name = strdup(name);
+        families[family_count].help = strdup(help ? help : "");
+        families[family_count].type = type;
+        family_count++;
+    }
+    pthread_mutex_unlock(&metrics_mutex);
+}
+
+void metrics_set(const char *name, const char *labels, double value) {
+    if (!name) return;
+    pthread_mutex_lock(&metrics_mutex);
+    metric_t *m = metric_lookup(name, labels);
+    if (m) m->value = value;
+    pthread_mutex_unlock(&metrics_mutex);
+}
+
+void metrics_add(const char *name, const char *labels, double delta) {
+    if (!name) return;
+    pthread_mutex_lock(&metrics_mutex);
+    metric_t *m = metric_lookup(name, labels);
+    if (m) m->value += delta;
+    pthread_mutex_unlock(&metrics_mutex);
+}
+
+static const metric_family_t* family_for(const char *name) {
+    for (int i = 0; i < family_count; i++) {
+        if (strcmp(families[i].name, name) == 0) return &families[i];
+    }
+    return NULL;
+}
+
+int metrics_write(const char *path) {
+    if (!path || !path[0]) return -1;
+
+    char tmp[600];
+    snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+
+    FILE *fp = fopen(tmp, "w");
+    if (!fp) {
+        log_warn("Cannot write metrics to %s: %s", tmp, strerror(errno));
+        return -1;
+    }
+
+    pthread_mutex_lock(&metrics_mutex);
+    for (int i = 0; i < metric_count; i++) {
+        // Families must be contiguous: emit each name once, with all its series
+        int seen = 0;
+        for (int j = 0; j < i; j++) {
+            if (strcmp(metrics[j].name, metrics[i].name) == 0) { seen = 1; break; }
+        }
+        if (seen) continue;
+
+        const metric_family_t *f = family_for(metrics[i].name);
+        if (f) {
+            fprintf(fp, "# HELP %s %s\n# TYPE %s %s\n", f->name, f->help, f->name,
+                    f->type == METRICS_COUNTER ? "counter" : "gauge");
+        }
+
+        for (int j = i; j < metric_count; j++) {
+            metric_t *m = &metrics[j];
+            if (strcmp(m->name, metrics[i].name) != 0) continue;
+            if (m->labels[0]) fprintf(fp, "%s{%s} %.17g\n", m->name, m->labels, m->value);
+            else fprintf(fp, "%s %.17g\n", m->name, m->value);
+        }
+    }
+    pthread_mutex_unlock(&metrics_mutex);
+
+    if (fclose(fp) != 0 || rename(tmp, path) != 0) {
+        log_warn("Cannot write metrics to %s: %s", path, strerror(errno));
+        remove(tmp);
+        return -1;
+    }
+    return 0;
+}
+
+static void* metrics_writer_thread(void *arg) {
+    (void)arg;
+
+    pthread_mutex_lock(&metrics_mutex);
+    while (!metrics_stop) {
+        struct timespec ts;
+        clock_gettime(CLOCK_REALTIME, &ts);
+        ts.tv_sec += metrics_interval;
+        pthread_cond_timedwait(&metrics_cond, &metrics_mutex, &ts);
+        if (metrics_stop) break;
+
+        pthread_mutex_unlock(&metrics_mutex);
+        metrics_write(metrics_path);
+        pthread_mutex_lock(&metrics_mutex);
+    }
+    pthread_mutex_unlock(&metrics_mutex);
+    return NULL;
+}
+
+int metrics_init(const char *path, int interval_sec) {
+    if (!path || !path[0]) return 0;
+
+    snprintf(metrics_path, sizeof(metrics_path), "%s", path);
+    metrics_interval = interval_sec;
+
+    if (interval_sec > 0) {
+        if (pthread_create(&metrics_thread, NULL, metrics_writer_thread, NULL) != 0) {
+            log_error("Failed to start metrics writer thread");
+            return -1;
+        }
+        metrics_thread_started = 1;
+    }
+
+    log_info("Metrics file: %s (every %d s)", metrics_path, interval_sec);
+    return 0;
+}
+
+void metrics_shutdown(void) {
+    if (metrics_thread_started) {
+        pthread_mutex_lock(&metrics_mutex);
+        metrics_stop = 1;
+        pthread_cond_signal(&metrics_cond);
+        pthread_mutex_unlock(&metrics_mutex);
+        pthread_join(metrics_thread, NULL);
+        metrics_thread_started = 0;
+    }
+
+    if (metrics_path[0]) metrics_write(metrics_path);
+
+    pthread_mutex_lock(&metrics_mutex);
+    for (int i = 0; i < metric_count; i++) {
+        free(metrics[i].name);
+        free(metrics[i].labels);
+    }
+    free(metrics);
+    metrics = NULL;
+    metric_count = metric_capacity = 0;
+
+    for (int i = 0; i < family_count; i++) {
+        free(families[i].name);
+        free(families[i].help);
+    }
+    free(families);
+    families = NULL;
+    family_count = 0;
+    pthread_mutex_unlock(&metrics_mutex);
+}
@@ -0,0 +1,860 @@
+// plugin_host.c
+// Out-of-process publisher host: shared memory rings, proxy plugin and supervisor
+
+#define _GNU_SOURCE
+#include "plugin_host.h"
+#include "logger.h"
+#include "metrics.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+
+#define HOST_MAGIC                 0x50485342u
+#define HOST_CONFIG_SIZE           65536
+#define HOST_ACK_CAPACITY          4096
+#define HOST_RECORD_WRAP           0xFFFFFFFFu
+#define HOST_DEFAULT_RING_SIZE     (4u << 20)
+#define HOST_MIN_RING_SIZE         (64u << 10)
+#define HOST_START_TIMEOUT_MS      30000
+#define HOST_STOP_TIMEOUT_MS       10000
+#define HOST_RESTART_MIN_DELAY_MS  100
+#define HOST_RESTART_MAX_DELAY_MS  30000
+#define HOST_POLL_MS               100
+
+// Host lifecycle, written by the host under the shm mutex
+enum {
+    HOST_STARTING,
+    HOST_INITIALIZED,
+    HOST_RUNNING,
+    HOST_FAILED,
+    HOST_STOPPED
+};
+
+typedef struct {
+    uint64_t seq;
+    int32_t status;                 // publish() return value
+    int32_t pad;
+} host_ack_t;
+
+// Event record in the data ring, followed by its strings. size covers the
+// header and strings rounded up to 8 bytes; HOST_RECORD_WRAP means the rest
+// of the ring is unused and the next record starts at offset 0.
+typedef struct {
+    uint32_t size;
+    uint32_t str_len[7];            // db, table, json, txn, binlog_file, type, key:
+                                    // strlen + 1, 0 = NULL
+    uint64_t seq;
+    uint64_t position;
+    int64_t last_committed;
+    int64_t sequence_number;
+    uint32_t timestamp;
+    uint32_t pad;
+} host_record_t;
+
+typedef struct {
+    uint32_t magic;
+    int log_level;
+    pid_t parent;
+    pthread_mutex_t mutex;          // robust and process shared
+    sem_t data_sem;                 // core -> host: records or a request
+    sem_t ack_sem;                  // host -> core: acks or a state change
+    int state;
+    int start_requested;
+    int stop_requested;
+    uint64_t ring_size;
+    uint64_t head;                  // end of the records written by the core
+    uint64_t read;                  // next record for the host
+    uint64_t tail;                  // start of the oldest record not yet released
+    uint64_t ack_head, ack_tail;
+    host_ack_t acks[HOST_ACK_CAPACITY];
+    uint32_t config_len;
+    char config[HOST_CONFIG_SIZE];  // name, library, databases, key/values
+} host_shm_t;
+
+#define HOST_RING_OFFSET ((sizeof(host_shm_t) + 63) & ~(size_t)63)
+
+// Core side of one host process
+typedef struct plugin_host {
+    publisher_instance_t *inst;
+    int fd;
+    host_shm_t *shm;
+    unsigned char *ring;
+    size_t map_size;
+    pid_t pid;
+    uint64_t next_seq;
+    uint64_t acked_seq;             // seq of the last ack taken, supervisor thread only
+    uint64_t acked;
+    uint64_t failed;
+    int restarts;
+    int stopping;
+    pthread_t supervisor;
+    int supervisor_started;
+    pthread_mutex_t mutex;          // guards pid/stopping, pairs with cond
+    pthread_cond_t cond;            // ring space freed or host state changed
+} plugin_host_t;
+
+// ============================================================================
+// SHARED HELPERS
+// ============================================================================
+
+// A host that died holding the mutex leaves it EOWNERDEAD; the ring
+// positions are only updated in single stores, so it can be reused as is
+static void shm_lock(host_shm_t *shm) {
+    if (pthread_mutex_lock(&shm->mutex) == EOWNERDEAD) {
+        pthread_mutex_consistent(&shm->mutex);
+    }
+}
+
+static void shm_unlock(host_shm_t *shm) {
+    pthread_mutex_unlock(&shm->mutex);
+}
+
+static int shm_get_state(host_shm_t *shm) {
+    shm_lock(shm);
+    int state = shm->state;
+    shm_unlock(shm);
+    return state;
+}
+
+static void deadline_after(struct timespec *ts, int ms) {
+    clock_gettime(CLOCK_REALTIME, ts);
+    ts->tv_sec += ms / 1000;
+    ts->tv_nsec += (long)(ms % 1000) * 1000000L;
+    if (ts->tv_nsec >= 1000000000L) {
+        ts->tv_sec++;
+        ts->tv_nsec -= 1000000000L;
+    }
+}
+
+// Semaphores count every post; one wake handles all pending work
+static void sem_wait_ms(sem_t *sem, int ms) {
+    struct timespec ts;
+    deadline_after(&ts, ms);
+    while (sem_timedwait(sem, &ts) != 0 && errno == EINTR) { }
+}
+
+static int config_put(host_shm_t *shm, const char *s) {
+    size_t n = strlen(s ? s : "") + 1;
+    if (shm->config_len + n > HOST_CONFIG_SIZE) return -1;
+    memcpy(shm->config + shm->config_len, s ? s : "", n);
+    shm->config_len += n;
+    return 0;
+}
+
+static const char* config_next(const host_shm_t *shm, uint32_t *off) {
+    if (*off >= shm->config_len) return "";
+    const char *s = shm->config + *off;
+    *off += strlen(s) + 1;
+    return s;
+}
+
+// ============================================================================
+// CORE SIDE
+// ============================================================================
+
+static int host_spawn(plugin_host_t *h) {
+    char fdarg[16];
+    char title[160];
+    snprintf(fdarg, sizeof(fdarg), "%d", h->fd);
+    snprintf(title, sizeof(title), "binlog_stream[%s]", h->inst->name);
+    char *const argv[] = { title, (char*)PLUGIN_HOST_ARG, fdarg, NULL };
+
+    pid_t pid = fork();
+    if (pid < 0) {
+        log_error("Plugin host %s: fork failed: %s", h->inst->name, strerror(errno));
+        return -1;
+    }
+    if (pid == 0) {
+        // Only async-signal-safe calls between fork and exec
+        int flags = fcntl(h->fd, F_GETFD);
+        if (flags >= 0) fcntl(h->fd, F_SETFD, flags & ~FD_CLOEXEC);
+        execv("/proc/self/exe", argv);
+        _exit(127);
+    }
+
+    pthread_mutex_lock(&h->mutex);
+    h->pid = pid;
+    pthread_mutex_unlock(&h->mutex);
+    log_info("Plugin host for %s started (pid %d)", h->inst->name, (int)pid);
+    return 0;
+}
+
+// Collect acks and free the ring space of the records they cover. Acks
+// arrive in publish order; each completes the instance's oldest event in
+// flight, so its counters and watermark move only once the host delivered.
+// A host whose acks are out of order or whose read position is outside
+// [tail, head] is killed without taking any of them: the restarted host
+// replays from tail.
+static void host_drain_acks(plugin_host_t *h) {
+    host_shm_t *shm = h->shm;
+    uint64_t acked = 0, failed = 0;
+    int32_t status[HOST_ACK_CAPACITY];
+    int bad = 0;
+
+    shm_lock(shm);
+    uint64_t read = shm->read, tail = shm->tail, head = shm->head;
+    uint64_t ack_tail = shm->ack_tail, ack_head = shm->ack_head;
+    if (read < tail || read > head || ack_head - ack_tail > HOST_ACK_CAPACITY) bad = 1;
+    for (; !bad && ack_tail < ack_head; ack_tail++) {
+        host_ack_t *a = &shm->acks[ack_tail % HOST_ACK_CAPACITY];
+        if (a->seq != h->acked_seq + acked + 1) {
+            bad = 1;
+            break;
+        }
+        status[acked++] = a->status;
+        if (a->status != 0) failed++;
+    }
+    if (bad) {
+        shm->ack_tail = shm->ack_head;
+    } else {
+        shm->ack_tail = ack_tail;
+        // The host moves read together with each ack, so all before it is done
+        shm->tail = read;
+        h->acked_seq += acked;
+    }
+    shm_unlock(shm);
+
+    if (bad) {
+        pthread_mutex_lock(&h->mutex);
+        pid_t pid = h->pid;
+        pthread_mutex_unlock(&h->mutex);
+        log_error("Plugin host %s: invalid ack (read %llu outside [%llu, %llu] or "
+                  "not seq %llu), restarting the host", h->inst->name,
+                  (unsigned long long)read, (unsigned long long)tail,
+                  (unsigned long long)head, (unsigned long long)(h->acked_seq + 1));
+        if (pid > 0) kill(pid, SIGKILL);
+        return;
+    }
+
+    for (uint64_t i = 0; i < acked; i++) publisher_instance_ack(h->inst, status[i]);
+
+    pthread_mutex_lock(&h->mutex);
+    h->acked += acked;
+    h->failed += failed;
+    pthread_cond_broadcast(&h->cond);
+    pthread_mutex_unlock(&h->mutex);
+
+    if (failed) {
+        char labels[192];
+        snprintf(labels, sizeof(labels), "publisher=\"%s\"", h->inst->name);
+        metrics_add("binlog_plugin_host_publish_errors_total", labels, failed);
+        log_warn("Plugin host %s: %llu event(s) failed to publish",
+                 h->inst->name, (unsigned long long)failed);
+    }
+}
+
+// Prepare the rings for a new host: replay from the oldest unacked record
+static void host_reset(plugin_host_t *h) {
+    host_shm_t *shm = h->shm;
+    shm_lock(shm);
+    shm->state = HOST_STARTING;
+    shm->read = shm->tail;
+    shm->ack_head = shm->ack_tail = 0;
+    shm_unlock(shm);
+}
+
+static void host_set_up(plugin_host_t *h, int up) {
+    char labels[192];
+    snprintf(labels, sizeof(labels), "publisher=\"%s\"", h->inst->name);
+    metrics_set("binlog_plugin_host_up", labels, up);
+}
+
+static void* host_supervisor_thread(void *arg) {
+    plugin_host_t *h = (plugin_host_t*)arg;
+    host_shm_t *shm = h->shm;
+    int was_running = 0;
+    int up = 0;
+    int delay_ms = HOST_RESTART_MIN_DELAY_MS;
+    int stop_ms = 0;
+
+    if (host_spawn(h) != 0) {
+        shm_lock(shm);
+        shm->state = HOST_FAILED;
+        shm_unlock(shm);
+    }
+
+    while (1) {
+        sem_wait_ms(&shm->ack_sem, HOST_POLL_MS);
+        host_drain_acks(h);
+
+        pthread_mutex_lock(&h->mutex);
+        int stopping = h->stopping;
+        pid_t pid = h->pid;
+        pthread_mutex_unlock(&h->mutex);
+
+        if (!up && shm_get_state(shm) == HOST_RUNNING) {
+            up = was_running = 1;
+            delay_ms = HOST_RESTART_MIN_DELAY_MS;
+            host_set_up(h, 1);
+        }
+
+        if (pid > 0) {
+            int status = 0;
+            if (waitpid(pid, &status, WNOHANG) != pid) {
+                // Still running; a stopping host gets a bounded time to drain
+                if (stopping && (stop_ms += HOST_POLL_MS) >= HOST_STOP_TIMEOUT_MS) {
+                    log_warn("Plugin host %s did not stop in %d ms, killing it",
+                             h->inst->name, HOST_STOP_TIMEOUT_MS);
+                    kill(pid, SIGKILL);
+                    stop_ms = 0;
+                }
+                continue;
+            }
+
+            pthread_mutex_lock(&h->mutex);
+            h->pid = -1;
+            pthread_mutex_unlock(&h->mutex);
+            host_drain_acks(h);
+            host_set_up(h, 0);
+            up = 0;
+
+            if (stopping) break;
+
+            if (WIFSIGNALED(status)) {
+                log_error("Plugin host %s killed by signal %d", h->inst->name, WTERMSIG(status));
+            } else {
+                log_error("Plugin host %s exited with status %d", h->inst->name, WEXITSTATUS(status));
+            }
+
+            // Never came up: report the failure to init/start instead of retrying
+            if (!was_running) {
+                shm_lock(shm);
+                if (shm->state != HOST_FAILED) shm->state = HOST_FAILED;
+                shm_unlock(shm);
+                break;
+            }
+        } else if (stopping || !was_running) {
+            break;
+        }
+
+        // Restart with backoff, replaying unacked events
+        pthread_mutex_lock(&h->mutex);
+        struct timespec ts;
+        deadline_after(&ts, delay_ms);
+        while (!h->stopping &&
+               pthread_cond_timedwait(&h->cond, &h->mutex, &ts) != ETIMEDOUT) { }
+        stopping = h->stopping;
+        if (!stopping) h->restarts++;
+        pthread_mutex_unlock(&h->mutex);
+        if (stopping) break;
+
+        delay_ms = delay_ms * 2 > HOST_RESTART_MAX_DELAY_MS ? HOST_RESTART_MAX_DELAY_MS : delay_ms * 2;
+
+        char labels[192];
+        snprintf(labels, sizeof(labels), "publisher=\"%s\"", h->inst->name);
+        metrics_add("binlog_plugin_host_restarts_total", labels, 1);
+
+        host_reset(h);
+        host_spawn(h);
+    }
+
+    pthread_mutex_lock(&h->mutex);
+    pthread_cond_broadcast(&h->cond);
+    pthread_mutex_unlock(&h->mutex);
+    return NULL;
+}
+
+// Wait until the host reaches want; -1 on failure or timeout
+static int host_wait_state(plugin_host_t *h, int want, int timeout_ms) {
+    struct timespec ts;
+    deadline_after(&ts, timeout_ms);
+
+    int state;
+    pthread_mutex_lock(&h->mutex);
+    while ((state = shm_get_state(h->shm)) < want) {
+        if (pthread_cond_timedwait(&h->cond, &h->mutex, &ts) == ETIMEDOUT) {
+            state = shm_get_state(h->shm);
+            break;
+        }
+    }
+    pthread_mutex_unlock(&h->mutex);
+    return state == want ? 0 : -1;
+}
+
+static void host_stop_supervisor(plugin_host_t *h) {
+    if (!h->supervisor_started) return;
+
+    // Mark it first so the host's exit is not taken for a crash
+    pthread_mutex_lock(&h->mutex);
+    h->stopping = 1;
+    pthread_cond_broadcast(&h->cond);
+    pthread_mutex_unlock(&h->mutex);
+
+    shm_lock(h->shm);
+    h->shm->stop_requested = 1;
+    shm_unlock(h->shm);
+    sem_post(&h->shm->data_sem);
+
+    pthread_join(h->supervisor, NULL);
+    h->supervisor_started = 0;
+}
+
+static int host_create_shm(plugin_host_t *h, size_t ring_size) {
+    h->map_size = HOST_RING_OFFSET + ring_size;
+    h->fd = memfd_create("binlog-plugin-host", MFD_CLOEXEC);
+    if (h->fd < 0 || ftruncate(h->fd, h->map_size) != 0) {
+        log_error("Plugin host %s: cannot create shared memory: %s",
+                  h->inst->name, strerror(errno));
+        return -1;
+    }
+    void *map = mmap(NULL, h->map_size, PROT_READ | PROT_WRITE, MAP_SHARED, h->fd, 0);
+    if (map == MAP_FAILED) {
+        log_error("Plugin host %s: mmap failed: %s", h->inst->name, strerror(errno));
+        return -1;
+    }
+    h->shm = (host_shm_t*)map;
+    h->ring = (unsigned char*)map + HOST_RING_OFFSET;
+
+    host_shm_t *shm = h->shm;
+    shm->magic = HOST_MAGIC;
+    shm->log_level = log_get_level();
+    shm->parent = getpid();
+    shm->ring_size = ring_size;
+
+    pthread_mutexattr_t ma;
+    pthread_mutexattr_init(&ma);
+    pthread_mutexattr_setpshared(&ma, PTHREAD_PROCESS_SHARED);
+    pthread_mutexattr_setrobust(&ma, PTHREAD_MUTEX_ROBUST);
+    pthread_mutex_init(&shm->mutex, &ma);
+    pthread_mutexattr_destroy(&ma);
+    sem_init(&shm->data_sem, 1, 0);
+    sem_init(&shm->ack_sem, 1, 0);
+
+    const publisher_config_t *cfg = &h->inst->config;
+    char num[16];
+    int rc = config_put(shm, h->inst->name) | config_put(shm, h->inst->library_path);
+    snprintf(num, sizeof(num), "%d", cfg->db_count);
+    rc |= config_put(shm, num);
+    for (int i = 0; i < cfg->db_count; i++) rc |= config_put(shm, cfg->databases[i]);
+    snprintf(num, sizeof(num), "%d", cfg->config_count);
+    rc |= config_put(shm, num);
+    for (int i = 0; i < cfg->config_count; i++) {
+        rc |= config_put(shm, cfg->config_keys[i]);
+        rc |= config_put(shm, cfg->config_values[i]);
+    }
+    if (rc != 0) {
+        log_error("Plugin host %s: configuration larger than %d bytes", h->inst->name, HOST_CONFIG_SIZE);
+        return -1;
+    }
+    return 0;
+}
+
+static void host_free(plugin_host_t *h) {
+    if (!h) return;
+    if (h->shm) {
+        sem_destroy(&h->shm->data_sem);
+        sem_destroy(&h->shm->ack_sem);
+        pthread_mutex_destroy(&h->shm->mutex);
+        munmap(h->shm, h->map_size);
+    }
+    if (h->fd >= 0) close(h->fd);
+    pthread_mutex_destroy(&h->mutex);
+    pthread_cond_destroy(&h->cond);
+    free(h);
+}
+
+// ============================================================================
+// PROXY PLUGIN
+// ============================================================================
+
+static const char* proxy_get_name(void) {
+    return "plugin_host";
+}
+
+static const char* proxy_get_version(void) {
+    return "1.0.0";
+}
+
+static int proxy_get_api_version(void) {
+    return PUBLISHER_API_VERSION;
+}
+
+// plugin_data already points at the host set up by plugin_host_attach()
+static int proxy_init(const publisher_config_t *config, void **plugin_data) {
+    (void)config;
+    plugin_host_t *h = (plugin_host_t*)*plugin_data;
+
+    size_t ring_size = h->inst->host_ring_size ? h->inst->host_ring_size : HOST_DEFAULT_RING_SIZE;
+    if (ring_size < HOST_MIN_RING_SIZE) ring_size = HOST_MIN_RING_SIZE;
+    ring_size = (ring_size + 63) & ~(size_t)63;
+
+    if (host_create_shm(h, ring_size) != 0) return -1;
+
+    if (pthread_create(&h->supervisor, NULL, host_supervisor_thread, h) != 0) {
+        log_error("Plugin host %s: cannot start supervisor thread", h->inst->name);
+        return -1;
+    }
+    h->supervisor_started = 1;
+
+    if (host_wait_state(h, HOST_INITIALIZED, HOST_START_TIMEOUT_MS) != 0) {
+        log_error("Plugin host %s failed to initialize %s", h->inst->name, h->inst->library_path);
+        host_stop_supervisor(h);
+        return -1;
+    }
+    return 0;
+}
+
+static int proxy_start(void *plugin_data) {
+    plugin_host_t *h = (plugin_host_t*)plugin_data;
+
+    shm_lock(h->shm);
+    h->shm->start_requested = 1;
+    shm_unlock(h->shm);
+    sem_post(&h->shm->data_sem);
+
+    if (host_wait_state(h, HOST_RUNNING, HOST_START_TIMEOUT_MS) != 0) {
+        log_error("Plugin host %s failed to start", h->inst->name);
+        return -1;
+    }
+    log_info("Plugin host %s running, ring %llu KB", h->inst->name,
+             (unsigned long long)(h->shm->ring_size >> 10));
+    return 0;
+}
+
+static int proxy_publish(void *plugin_data, const cdc_event_t *event) {
+    plugin_host_t *h = (plugin_host_t*)plugin_data;
+    host_shm_t *shm = h->shm;
+
+    const char *strs[7] = { event->db, event->table, event->json, event->txn, event->binlog_file,
+                            event->type, event->key };
+    uint32_t lens[7];
+    size_t need = sizeof(host_record_t);
+    for (int i = 0; i < 7; i++) {
+        lens[i] = strs[i] ? (uint32_t)strlen(strs[i]) + 1 : 0;
+        need += lens[i];
+    }
+    need = (need + 7) & ~(size_t)7;
+    if (need > shm->ring_size / 2) {
+        log_error("Plugin host %s: event of %zu bytes does not fit the ring", h->inst->name, need);
+        return -1;
+    }
+
+    // Only this thread moves head, so space can only grow while we wait
+    uint64_t head, off, skip;
+    int stalled_ms = 0;
+    pthread_mutex_lock(&h->mutex);
+    while (1) {
+        shm_lock(shm);
+        head = shm->head;
+        uint64_t used = head - shm->tail;
+        shm_unlock(shm);
+
+        off = head % shm->ring_size;
+        skip = off + need > shm->ring_size ? shm->ring_size - off : 0;
+        if (shm->ring_size - used >= need + skip) break;
+
+        // Shutting down and the host does not come back: stop holding up the drain
+        pthread_mutex_lock(&h->inst->q_mutex);
+        int draining = h->inst->q_stop;
+        pthread_mutex_unlock(&h->inst->q_mutex);
+        if ((h->stopping || draining) && shm_get_state(shm) != HOST_RUNNING &&
+            (stalled_ms += HOST_POLL_MS) > HOST_STOP_TIMEOUT_MS) {
+            pthread_mutex_unlock(&h->mutex);
+            return -1;
+        }
+        struct timespec ts;
+        deadline_after(&ts, HOST_POLL_MS);
+        pthread_cond_timedwait(&h->cond, &h->mutex, &ts);
+    }
+    uint64_t seq = ++h->next_seq;
+    pthread_mutex_unlock(&h->mutex);
+
+    if (skip) {
+        ((host_record_t*)(h->ring + off))->size = HOST_RECORD_WRAP;
+        head += skip;
+        off = 0;
+    }
+
+    host_record_t *r = (host_record_t*)(h->ring + off);
+    r->size = (uint32_t)need;
+    r->seq = seq;
+    r->position = event->position;
+    r->last_committed = event->last_committed;
+    r->sequence_number = event->sequence_number;
+    r->timestamp = event->timestamp;
+    unsigned char *dst = (unsigned char*)(r + 1);
+    for (int i = 0; i < 7; i++) {
+        r->str_len[i] = lens[i];
+        if (lens[i]) {
+            memcpy(dst, strs[i], lens[i]);
+            dst += lens[i];
+        }
+    }
+
+    shm_lock(shm);
+    shm->head = head + need;
+    shm_unlock(shm);
+    sem_post(&shm->data_sem);
+    return 0;
+}
+
+static int proxy_stop(void *plugin_data) {
+    plugin_host_t *h = (plugin_host_t*)plugin_data;
+
+    host_stop_supervisor(h);
+
+    shm_lock(h->shm);
+    uint64_t pending = h->shm->head - h->shm->tail;
+    shm_unlock(h->shm);
+    if (pending) {
+        log_warn("Plugin host %s stopped with %llu bytes of unacknowledged events",
+                 h->inst->name, (unsigned long long)pending);
+    }
+    log_info("Plugin host %s stopped (acked=%llu, failed=%llu, restarts=%d)",
+             h->inst->name, (unsigned long long)h->acked,
+             (unsigned long long)h->failed, h->restarts);
+    return 0;
+}
+
+static void proxy_cleanup(void *plugin_data) {
+    plugin_host_t *h = (plugin_host_t*)plugin_data;
+    if (!h) return;
+    host_stop_supervisor(h);
+    host_free(h);
+}
+
+static int proxy_health_check(void *plugin_data) {
+    plugin_host_t *h = (plugin_host_t*)plugin_data;
+    return shm_get_state(h->shm) == HOST_RUNNING ? 0 : -1;
+}
+
+static const publisher_callbacks_t proxy_callbacks = {
+    .get_name = proxy_get_name,
+    .get_version = proxy_get_version,
+    .get_api_version = proxy_get_api_version,
+    .init = proxy_init,
+    .start = proxy_start,
+    .stop = proxy_stop,
+    .cleanup = proxy_cleanup,
+    .publish = proxy_publish,
+    .publish_batch = NULL,
+    .health_check = proxy_health_check,
+};
+
+int plugin_host_attach(publisher_instance_t *inst) {
+    plugin_host_t *h = calloc(1, sizeof(plugin_host_t));
+    publisher_plugin_t *p = malloc(sizeof(publisher_plugin_t));
+    if (!h || !p) {
+        free(h);
+        free(p);
+        return -1;
+    }
+
+    h->inst = inst;
+    inst->deferred_ack = 1;
+    h->fd = -1;
+    h->pid = -1;
+    pthread_mutex_init(&h->mutex, NULL);
+    pthread_cond_init(&h->cond, NULL);
+
+    p->callbacks = &proxy_callbacks;
+    p->plugin_data = h;
+    inst->plugin = p;
+
+    metrics_describe("binlog_plugin_host_up", METRICS_GAUGE,
+                     "Out-of-process publisher host is running");
+    metrics_describe("binlog_plugin_host_restarts_total", METRICS_COUNTER,
+                     "Times the publisher host process was restarted");
+    metrics_describe("binlog_plugin_host_publish_errors_total", METRICS_COUNTER,
+                     "Events the plugin in the host failed to publish");
+    return 0;
+}
+
+// ============================================================================
+// HOST PROCESS
+// ============================================================================
+
+static void host_set_state(host_shm_t *shm, int state) {
+    shm_lock(shm);
+    shm->state = state;
+    shm_unlock(shm);
+    sem_post(&shm->ack_sem);
+}
+
+// Wait for the core; exit when it is gone
+static void host_wait(host_shm_t *shm) {
+    sem_wait_ms(&shm->data_sem, HOST_POLL_MS);
+    if (getppid() != shm->parent) {
+        log_error("Plugin host: streamer process %d is gone, exiting", (int)shm->parent);
+        _exit(1);
+    }
+}
+
+static void host_ack(host_shm_t *shm, uint64_t seq, int status, uint64_t next_read) {
+    while (1) {
+        shm_lock(shm);
+        if (shm->ack_head - shm->ack_tail < HOST_ACK_CAPACITY) {
+            host_ack_t *a = &shm->acks[shm->ack_head % HOST_ACK_CAPACITY];
+            a->seq = seq;
+            a->status = status;
+            shm->ack_head++;
+            shm->read = next_read;
+            shm_unlock(shm);
+            break;
+        }
+        shm_unlock(shm);
+        struct timespec ts = {0, 1000000L};
+        nanosleep(&ts, NULL);
+    }
+    sem_post(&shm->ack_sem);
+}
+
+static void host_run(host_shm_t *shm, unsigned char *ring, publisher_instance_t *inst) {
+    const publisher_callbacks_t *cb = inst->plugin->callbacks;
+
+    while (1) {
+        shm_lock(shm);
+        uint64_t head = shm->head;
+        uint64_t read = shm->read;
+        int stop = shm->stop_requested;
+        shm_unlock(shm);
+
+        if (read == head) {
+            if (stop) break;
+            host_wait(shm);
+            continue;
+        }
+
+        uint64_t off = read % shm->ring_size;
+        host_record_t *r = (host_record_t*)(ring + off);
+        if (r->size == HOST_RECORD_WRAP) {
+            shm_lock(shm);
+            shm->read = read + (shm->ring_size - off);
+            shm_unlock(shm);
+            continue;
+        }
+
+        // Strings are used in place; the core keeps them until acked
+        const char *strs[7];
+        const char *p = (const char*)(r + 1);
+        for (int i = 0; i < 7; i++) {
+            strs[i] = r->str_len[i] ? p : NULL;
+            p += r->str_len[i];
+        }
+        cdc_event_t event = {
+            .db = strs[0],
+            .table = strs[1],
+            .json = strs[2],
+            .txn = strs[3],
+            .position = r->position,
+            .binlog_file = strs[4],
+            .last_committed = r->last_committed,
+            .sequence_number = r->sequence_number,
+            .timestamp = r->timestamp,
+            .type = strs[5],
+            .key = strs[6]
+        };
+
+        int rc = cb->publish(inst->plugin->plugin_data, &event);
+        host_ack(shm, r->seq, rc, read + r->size);
+    }
+}
+
+int plugin_host_main(int argc, char **argv) {
+    if (argc < 3) {
+        fprintf(stderr, "Usage: %s %s <fd>\n", argv[0], PLUGIN_HOST_ARG);
+        return 1;
+    }
+
+    // The core stops us through the ring; ^C to the process group must not
+    // kill the host before it has drained
+    signal(SIGINT, SIG_IGN);
+    signal(SIGTERM, SIG_IGN);
+
+    int fd = atoi(argv[2]);
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < HOST_RING_OFFSET) {
+        fprintf(stderr, "Plugin host: invalid shared memory fd %d\n", fd);
+        return 1;
+    }
+    void *map = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (map == MAP_FAILED) {
+        fprintf(stderr, "Plugin host: mmap failed: %s\n", strerror(errno));
+        return 1;
+    }
+    close(fd);
+
+    host_shm_t *shm = (host_shm_t*)map;
+    unsigned char *ring = (unsigned char*)map + HOST_RING_OFFSET;
+    if (shm->magic != HOST_MAGIC) {
+        fprintf(stderr, "Plugin host: bad shared memory header\n");
+        return 1;
+    }
+    log_set_level(shm->log_level);
+
+    // Rebuild the publisher config; strings stay in the mapping
+    uint32_t off = 0;
+    const char *name = config_next(shm, &off);
+    const char *library = config_next(shm, &off);
+    publisher_config_t config = {0};
+    config.name = name;
+    config.active = 1;
+    config.db_count = atoi(config_next(shm, &off));
+    config.databases = calloc(config.db_count + 1, sizeof(char*));
+    for (int i = 0; config.databases && i < config.db_count; i++) {
+        config.databases[i] = (char*)config_next(shm, &off);
+    }
+    config.config_count = atoi(config_next(shm, &off));
+    config.config_keys = calloc(config.config_count + 1, sizeof(char*));
+    config.config_values = calloc(config.config_count + 1, sizeof(char*));
+    for (int i = 0; config.config_keys && config.config_values && i < config.config_count; i++) {
+        config.config_keys[i] = (char*)config_next(shm, &off);
+        config.config_values[i] = (char*)config_next(shm, &off);
+    }
+
+    publisher_manager_t *mgr = NULL;
+    publisher_instance_t *inst = NULL;
+    if (publisher_manager_init(&mgr) != 0 ||
+        publisher_manager_load_plugin(mgr, name, library, &config, &inst) != 0) {
+        log_error("Plugin host: cannot load %s from %s", name, library);
+        host_set_state(shm, HOST_FAILED);
+        return 1;
+    }
+    free(config.databases);
+    free(config.config_keys);
+    free(config.config_values);
+
+    host_set_state(shm, HOST_INITIALIZED);
+    log_info("Plugin host %s initialized (pid %d)", name, (int)getpid());
+
+    while (1) {
+        shm_lock(shm);
+        int start = shm->start_requested;
+        int stop = shm->stop_requested;
+        shm_unlock(shm);
+        if (start) break;
+        if (stop) {
+            publisher_manager_destroy(mgr);
+            host_set_state(shm, HOST_STOPPED);
+            return 0;
+        }
+        host_wait(shm);
+    }
+
+    const publisher_callbacks_t *cb = inst->plugin->callbacks;
+    if (cb->start && cb->start(inst->plugin->plugin_data) != 0) {
+        log_error("Plugin host: %s start callback failed", name);
+        host_set_state(shm, HOST_FAILED);
+        publisher_manager_destroy(mgr);
+        return 1;
+    }
+    host_set_state(shm, HOST_RUNNING);
+
+    host_run(shm, ring, inst);
+
+    if (cb->stop) cb->stop(inst->plugin->plugin_data);
+    publisher_manager_destroy(mgr);
+    host_set_state(shm, HOST_STOPPED);
+    log_info("Plugin host %s exiting", name);
+    return 0;
+}
@@ -3,13 +3,21 @@
 
 #include "publisher_loader.h"
 #include "logger.h"
+#include "metrics.h"
+#include "txn_scheduler.h"
+#include "plugin_host.h"
+#include "column_batch.h"
+#include "stage_profiler.h"
+#include "static_plugins.h"
 #include <stdlib.h>
 #include <string.h>
 #include <dlfcn.h>
 #include <errno.h>
 #include <stdarg.h>
+#include <time.h>
 
 #define PUBLISHER_QUEUE_CAPACITY 1024
+#define PUBLISHER_STARTUP_MAX_THREADS 16
 
 // Global helpers instance
 const publisher_api_helpers_t *publisher_helpers = NULL;
@@ -108,6 +116,41 @@ static int plugin_get_config_bool(const publisher_config_t *config,
     return default_val;
 }
 
+// Manager whose publishers emit_event() can reach
+static publisher_manager_t *emit_manager = NULL;
+
+static int name_in_list(const char *name, const char *list) {
+    size_t n = strlen(name);
+    for (const char *p = list; *p; ) {
+        while (*p == ',' || *p == ' ') p++;
+        const char *end = p;
+        while (*end && *end != ',') end++;
+        const char *last = end;
+        while (last > p && last[-1] == ' ') last--;
+        if ((size_t)(last - p) == n && strncmp(p, name, n) == 0) return 1;
+        p = end;
+    }
+    return 0;
+}
+
+static int plugin_emit_event(const cdc_event_t *event, const char *publishers) {
+    publisher_manager_t *mgr = __atomic_load_n(&emit_manager, __ATOMIC_ACQUIRE);
+    if (!mgr || !event || !publishers || !publishers[0]) return -1;
+
+    publisher_event_t *shared = NULL;
+    int queued = 0;
+    for (publisher_instance_t *inst = mgr->instances; inst; inst = inst->next) {
+        if (!name_in_list(inst->name, publishers)) continue;
+        if (!shared) {
+            shared = publisher_event_create(event);
+            if (!shared) return -1;
+        }
+        if (publisher_instance_enqueue_event(inst, shared) == 0) queued++;
+    }
+    publisher_event_release(shared);
+    return queued > 0 ? queued : -1;
+}
+
 
 // Initialize publisher manager
 int publisher_manager_init(publisher_manager_t **manager) {
@@ -125,57 +168,125 @@ int publisher_manager_init(publisher_manager_t **manager) {
     mgr->helpers.get_config = plugin_get_config;
     mgr->helpers.get_config_int = plugin_get_config_int;
     mgr->helpers.get_config_bool = plugin_get_config_bool;
+    mgr->helpers.txn_scheduler_create = txn_scheduler_create;
+    mgr->helpers.txn_scheduler_destroy = txn_scheduler_destroy;
+    mgr->helpers.txn_scheduler_wait_ready = txn_scheduler_wait_ready;
+    mgr->helpers.txn_scheduler_dispatched = txn_scheduler_dispatched;
+    mgr->helpers.txn_scheduler_complete = txn_scheduler_complete;
+    mgr->helpers.txn_scheduler_drain = txn_scheduler_drain;
+    mgr->helpers.txn_scheduler_shutdown = txn_scheduler_shutdown;
+    mgr->helpers.emit_event = plugin_emit_event;
     
     // Set global helpers for plugins
     publisher_helpers = &mgr->helpers;
     
+    pthread_mutex_init(&mgr->startup_mutex, NULL);
+    pthread_cond_init(&mgr->startup_cond, NULL);
+    
+    metrics_describe("binlog_publisher_startup_seconds", METRICS_GAUGE,
+                     "Time to load and start a publisher plugin");
+    metrics_describe("binlog_publisher_ready", METRICS_GAUGE,
+                     "1 once the publisher is started, 0 if it failed");
+    metrics_describe("binlog_publisher_shed_level", METRICS_GAUGE,
+                     "Load shedding level: 0 none, 1 sampling low, 2 shedding low");
+    metrics_describe("binlog_publisher_shed_events_total", METRICS_COUNTER,
+                     "Events not delivered because of load shedding");
+    
     *manager = mgr;
+    __atomic_store_n(&emit_manager, mgr, __ATOMIC_RELEASE);
     return 0;
 }
 
-//// Deep copy CDC event
-//static cdc_event_t* cdc_event_copy(const cdc_event_t *src) {
-//    if (!src) return NULL;
-//    
-//    cdc_event_t *dst = malloc(sizeof(cdc_event_t));
-//    if (!dst) return NULL;
-//    
-//    // Copy pointers (shallow - strings should be static or managed by caller)
-//    memcpy(dst, src, sizeof(cdc_event_t));
-//    return dst;
-//}
-
-// Deep copy CDC event (owns all strings in the copy)
-static cdc_event_t* cdc_event_copy(const cdc_event_t *src) {
+// Build a shared event: one allocation holds the struct and all strings
+publisher_event_t* publisher_event_create(const cdc_event_t *src) {
     if (!src) return NULL;
 
-    cdc_event_t *dst = calloc(1, sizeof(*dst));
-    if (!dst) return NULL;
+    const char *strs[7] = { src->db, src->table, src->json, src->txn, src->binlog_file,
+                            src->type, src->key };
+    size_t lens[7];
+    size_t total = 0;
+    for (int i = 0; i < 7; i++) {
+        lens[i] = strs[i] ? strlen(strs[i]) + 1 : 0;
+        total += lens[i];
+    }
+
+    publisher_event_t *pe = malloc(sizeof(*pe) + total);
+    if (!pe) return NULL;
 
-    // Copy scalars
-    dst->position = src->position;
+    pe->refs = 1;
+    pe->event = *src;
+    pe->batch = NULL;
+    pe->priority = PUBLISHER_PRIORITY_NORMAL;
+    pe->size = sizeof(*pe) + total;
+    pe->hold = NULL;
+    pe->progress = 0;
 
-    // Deep copy strings (it's fine to assign char* to const char*)
-    if (src->db)          dst->db          = strdup(src->db);
-    if (src->table)       dst->table       = strdup(src->table);
-    if (src->json)        dst->json        = strdup(src->json);
-    if (src->txn)         dst->txn         = strdup(src->txn);
-    if (src->binlog_file) dst->binlog_file = strdup(src->binlog_file);
+    char *dst = pe->data;
+    const char **fields[7] = { &pe->event.db, &pe->event.table, &pe->event.json,
+                               &pe->event.txn, &pe->event.binlog_file,
+                               &pe->event.type, &pe->event.key };
+    for (int i = 0; i < 7; i++) {
+        if (strs[i]) {
+            memcpy(dst, strs[i], lens[i]);
+            *fields[i] = dst;
+            dst += lens[i];
+        } else {
+            *fields[i] = NULL;
+        }
+    }
 
-    return dst;
+    return pe;
 }
 
-static void cdc_event_free(cdc_event_t *e) {
-    if (!e) return;
+publisher_event_t* publisher_event_create_progress(const cdc_event_t *src) {
+    cdc_event_t mark = {
+        .db = "",
+        .table = "",
+        .txn = src->txn,
+        .position = src->position,
+        .binlog_file = src->binlog_file,
+        .timestamp = src->timestamp,
+        .type = "COMMIT"
+    };
+    publisher_event_t *pe = publisher_event_create(&mark);
+    if (pe) pe->progress = 1;
+    return pe;
+}
 
-    // cast away const only for freeing our own strdup'ed copies
-    free((char*)e->db);
-    free((char*)e->table);
-    free((char*)e->json);
-    free((char*)e->txn);
-    free((char*)e->binlog_file);
+publisher_event_t* publisher_event_create_columnar(const cdc_event_t *src,
+                                                   column_batch_t *batch) {
+    publisher_event_t *pe = publisher_event_create(src);
+    if (!pe) {
+        column_batch_free(batch);
+        return NULL;
+    }
 
-    free(e);
+    // The batch header points at the event's own copies of the strings
+    cdc_column_batch_t *view = column_batch_finish(batch);
+    if (view) {
+        view->db = pe->event.db;
+        view->table = pe->event.table;
+        view->txn = pe->event.txn;
+        view->position = pe->event.position;
+        view->binlog_file = pe->event.binlog_file;
+        view->last_committed = pe->event.last_committed;
+        view->sequence_number = pe->event.sequence_number;
+    }
+    pe->batch = batch;
+    return pe;
+}
+
+static void publisher_event_retain(publisher_event_t *pe) {
+    __atomic_add_fetch(&pe->refs, 1, __ATOMIC_RELAXED);
+}
+
+void publisher_event_release(publisher_event_t *pe) {
+    if (!pe) return;
+    if (__atomic_sub_fetch(&pe->refs, 1, __ATOMIC_ACQ_REL) == 0) {
+        column_batch_free(pe->batch);
+        free(pe->hold);
+        free(pe);
+    }
 }
 
 
@@ -183,10 +294,10 @@ static void cdc_event_free(cdc_event_t *e) {
 static int queue_init(publisher_instance_t *inst) {
     log_trace("Initializing queue for %s",inst->name);
     if(inst->q_capacity > 0){
-        inst->queue = calloc(inst->q_capacity, sizeof(cdc_event_t*));
+        inst->queue = calloc(inst->q_capacity, sizeof(publisher_event_t*));
         inst->q_capacity = inst->q_capacity;
     } else {
-        inst->queue = calloc(PUBLISHER_QUEUE_CAPACITY, sizeof(cdc_event_t*));
+        inst->queue = calloc(PUBLISHER_QUEUE_CAPACITY, sizeof(publisher_event_t*));
         inst->q_capacity = PUBLISHER_QUEUE_CAPACITY;
     }
     log_trace("Queue depth set for %s is %d", inst->name, inst->q_capacity);
@@ -198,6 +309,10 @@ static int queue_init(publisher_instance_t *inst) {
     
     pthread_mutex_init(&inst->q_mutex, NULL);
     pthread_cond_init(&inst->q_cond, NULL);
+    pthread_mutex_init(&inst->wm.mutex, NULL);
+    pthread_cond_init(&inst->wm.cond, NULL);
+    pthread_mutex_init(&inst->inflight_mutex, NULL);
+    pthread_mutex_init(&inst->shed.spill_mutex, NULL);
     
     return 0;
 }
@@ -208,69 +323,467 @@ static void queue_destroy(publisher_instance_t *inst) {
     pthread_mutex_lock(&inst->q_mutex);
     for (int i = 0; i < inst->q_count; i++) {
         int idx = (inst->q_head + i) % inst->q_capacity;
-        cdc_event_free(inst->queue[idx]);
+        publisher_event_release(inst->queue[idx]);
     }
     pthread_mutex_unlock(&inst->q_mutex);
     
     free(inst->queue);
     inst->queue = NULL;
     
+    int unacked = 0;
+    for (int i = 0; i < inst->inflight_count; i++) {
+        publisher_event_t *event = inst->inflight[(inst->inflight_head + i) % inst->inflight_cap];
+        if (!event->progress) unacked++;
+        publisher_event_release(event);
+    }
+    if (unacked > 0) {
+        log_warn("Publisher %s: %d event(s) never acknowledged by the host process",
+                 inst->name, unacked);
+        stat_counters_add(inst->stats, PUBLISHER_STAT_DROPPED, unacked);
+    }
+    free(inst->inflight);
+    inst->inflight = NULL;
+    inst->inflight_count = 0;
+    pthread_mutex_destroy(&inst->inflight_mutex);
+    pthread_mutex_destroy(&inst->shed.spill_mutex);
+    
     pthread_mutex_destroy(&inst->q_mutex);
     pthread_cond_destroy(&inst->q_cond);
+    pthread_mutex_destroy(&inst->wm.mutex);
+    pthread_cond_destroy(&inst->wm.cond);
+}
+
+// ============================================================================
+// DELIVERED WATERMARK
+// ============================================================================
+
+uint64_t publisher_binlog_file_index(const char *name) {
+    const char *dot = strrchr(name, '.');
+    uint64_t idx = 0;
+    if (!dot) return 0;
+    for (const char *p = dot + 1; *p >= '0' && *p <= '9'; p++) {
+        idx = idx * 10 + (uint64_t)(*p - '0');
+    }
+    return idx;
+}
+
+static int parse_u64(const char *p, const char *end, uint64_t *out) {
+    if (p >= end) return -1;
+    uint64_t v = 0;
+    for (; p < end; p++) {
+        if (*p < '0' || *p > '9') return -1;
+        v = v * 10 + (uint64_t)(*p - '0');
+    }
+    *out = v;
+    return 0;
+}
+
+// GTID part of a mark; -1 for anything else, including the transaction ids
+// the core derives from binlog coordinates
+static int mark_parse_gtid(const char *text, publisher_mark_t *mark) {
+    const char *colon = strrchr(text, ':');
+    const char *end = text + strlen(text);
+
+    if (colon) {
+        // MySQL: 36 character server uuid
+        if (colon - text != 36 || parse_u64(colon + 1, end, &mark->seq) != 0) return -1;
+        snprintf(mark->source, sizeof(mark->source), "%.*s", (int)(colon - text), text);
+    } else {
+        // MariaDB: domain-server-seq, all decimal
+        const char *d1 = strchr(text, '-');
+        const char *d2 = d1 ? strchr(d1 + 1, '-') : NULL;
+        uint64_t domain, server;
+        if (!d2 || strchr(d2 + 1, '-') ||
+            parse_u64(text, d1, &domain) != 0 || parse_u64(d1 + 1, d2, &server) != 0 ||
+            parse_u64(d2 + 1, end, &mark->seq) != 0) {
+            return -1;
+        }
+        snprintf(mark->source, sizeof(mark->source), "%llu", (unsigned long long)domain);
+    }
+    mark->is_gtid = 1;
+    return 0;
+}
+
+int publisher_mark_parse(const char *text, publisher_mark_t *mark) {
+    memset(mark, 0, sizeof(*mark));
+    if (!text || !*text) return -1;
+    if (mark_parse_gtid(text, mark) == 0) return 0;
+
+    const char *colon = strrchr(text, ':');
+    if (!colon || colon == text || (size_t)(colon - text) >= sizeof(mark->binlog_file) ||
+        parse_u64(colon + 1, text + strlen(text), &mark->position) != 0) {
+        return -1;
+    }
+    snprintf(mark->binlog_file, sizeof(mark->binlog_file), "%.*s", (int)(colon - text), text);
+    return 0;
+}
+
+// Record a delivered event. A GTID's transaction counts as delivered with
+// its COMMIT event, or once an event of a later transaction was delivered.
+// Neither passes the event's hold, which the core has not dispatched yet.
+static void watermark_advance(publisher_instance_t *inst, const publisher_event_t *pe) {
+    publisher_watermark_t *wm = &inst->wm;
+    const cdc_event_t *ev = &pe->event;
+    const publisher_mark_t *hold = pe->hold;
+    publisher_mark_t txn;
+    int has_gtid = ev->txn && mark_parse_gtid(ev->txn, &txn) == 0;
+
+    const char *file = ev->binlog_file;
+    uint64_t position = ev->position;
+    if (hold && hold->binlog_file[0] && file && file[0]) {
+        uint64_t idx = publisher_binlog_file_index(file);
+        uint64_t held = publisher_binlog_file_index(hold->binlog_file);
+        if (held < idx || (held == idx && hold->position < position)) {
+            file = hold->binlog_file;
+            position = hold->position;
+        }
+    }
+
+    pthread_mutex_lock(&wm->mutex);
+
+    if (file && file[0]) {
+        uint64_t idx = publisher_binlog_file_index(file);
+        uint64_t cur = publisher_binlog_file_index(wm->binlog_file);
+        if (!wm->binlog_file[0] || idx > cur || (idx == cur && position > wm->position)) {
+            snprintf(wm->binlog_file, sizeof(wm->binlog_file), "%s", file);
+            wm->position = position;
+        }
+    }
+
+    if (has_gtid) {
+        uint64_t done = (ev->type && strcmp(ev->type, "COMMIT") == 0) ? txn.seq : txn.seq - 1;
+        if (hold && hold->is_gtid && strcmp(hold->source, txn.source) == 0 &&
+            done >= hold->seq) {
+            done = hold->seq - 1;
+        }
+        int i = 0;
+        while (i < wm->source_count && strcmp(wm->source[i], txn.source) != 0) i++;
+        if (i == wm->source_count && i < PUBLISHER_WM_SOURCES) {
+            snprintf(wm->source[i], sizeof(wm->source[i]), "%s", txn.source);
+            wm->seq[i] = 0;
+            wm->source_count++;
+        }
+        if (i < wm->source_count && done > wm->seq[i]) wm->seq[i] = done;
+    }
+
+    if (wm->waiters) pthread_cond_broadcast(&wm->cond);
+    pthread_mutex_unlock(&wm->mutex);
+}
+
+// Caller holds wm->mutex
+static int watermark_reached(const publisher_watermark_t *wm, const publisher_mark_t *mark) {
+    if (mark->is_gtid) {
+        for (int i = 0; i < wm->source_count; i++) {
+            if (strcmp(wm->source[i], mark->source) == 0) return wm->seq[i] >= mark->seq;
+        }
+        return 0;
+    }
+    if (!wm->binlog_file[0]) return 0;
+    uint64_t idx = publisher_binlog_file_index(mark->binlog_file);
+    uint64_t cur = publisher_binlog_file_index(wm->binlog_file);
+    return cur > idx || (cur == idx && wm->position >= mark->position);
+}
+
+int publisher_watermark_wait(publisher_instance_t *inst, const publisher_mark_t *mark,
+                             int timeout_ms) {
+    publisher_watermark_t *wm = &inst->wm;
+    struct timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += timeout_ms / 1000;
+    deadline.tv_nsec += (long)(timeout_ms % 1000) * 1000000L;
+    if (deadline.tv_nsec >= 1000000000L) {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000L;
+    }
+
+    pthread_mutex_lock(&wm->mutex);
+    wm->waiters++;
+    int rc = 1;
+    while (1) {
+        if (watermark_reached(wm, mark)) {
+            rc = 0;
+            break;
+        }
+        if (wm->closed) {
+            rc = -1;
+            break;
+        }
+        if (pthread_cond_timedwait(&wm->cond, &wm->mutex, &deadline) == ETIMEDOUT) {
+            rc = watermark_reached(wm, mark) ? 0 : 1;
+            break;
+        }
+    }
+    wm->waiters--;
+    pthread_mutex_unlock(&wm->mutex);
+    return rc;
+}
+
+int publisher_watermark_format(publisher_instance_t *inst, char *buf, size_t size) {
+    publisher_watermark_t *wm = &inst->wm;
+
+    pthread_mutex_lock(&wm->mutex);
+    int len = snprintf(buf, size,
+                       "{\"publisher\":\"%s\",\"binlog_file\":\"%s\",\"position\":%llu,\"gtid\":[",
+                       inst->name, wm->binlog_file, (unsigned long long)wm->position);
+    for (int i = 0; i < wm->source_count && len < (int)size; i++) {
+        len += snprintf(buf + len, size - len, "%s{\"source\":\"%s\",\"seq\":%llu}",
+                        i ? "," : "", wm->source[i], (unsigned long long)wm->seq[i]);
+    }
+    if (len < (int)size) len += snprintf(buf + len, size - len, "]}");
+    pthread_mutex_unlock(&wm->mutex);
+    return len < (int)size ? len : -1;
+}
+
+void publisher_watermark_close(publisher_instance_t *inst) {
+    pthread_mutex_lock(&inst->wm.mutex);
+    inst->wm.closed = 1;
+    pthread_cond_broadcast(&inst->wm.cond);
+    pthread_mutex_unlock(&inst->wm.mutex);
+}
+
+// Caller holds inflight_mutex
+static int inflight_push_locked(publisher_instance_t *inst, publisher_event_t *event) {
+    if (inst->inflight_count == inst->inflight_cap) {
+        int cap = inst->inflight_cap ? inst->inflight_cap * 2 : 256;
+        publisher_event_t **n = malloc(cap * sizeof(publisher_event_t*));
+        if (!n) return -1;
+        for (int i = 0; i < inst->inflight_count; i++) {
+            n[i] = inst->inflight[(inst->inflight_head + i) % inst->inflight_cap];
+        }
+        free(inst->inflight);
+        inst->inflight = n;
+        inst->inflight_head = 0;
+        inst->inflight_cap = cap;
+    }
+    publisher_event_retain(event);
+    inst->inflight[(inst->inflight_head + inst->inflight_count) % inst->inflight_cap] = event;
+    inst->inflight_count++;
+    return 0;
 }
 
+// Track an event handed to a host process until it is acked
+static int inflight_push(publisher_instance_t *inst, publisher_event_t *event) {
+    pthread_mutex_lock(&inst->inflight_mutex);
+    int ret = inflight_push_locked(inst, event);
+    pthread_mutex_unlock(&inst->inflight_mutex);
+    return ret;
+}
+
+// Oldest event in flight, if it is a progress mark
+static publisher_event_t* inflight_pop_progress(publisher_instance_t *inst) {
+    publisher_event_t *event = NULL;
+    pthread_mutex_lock(&inst->inflight_mutex);
+    if (inst->inflight_count > 0 && inst->inflight[inst->inflight_head]->progress) {
+        event = inst->inflight[inst->inflight_head];
+        inst->inflight_head = (inst->inflight_head + 1) % inst->inflight_cap;
+        inst->inflight_count--;
+    }
+    pthread_mutex_unlock(&inst->inflight_mutex);
+    return event;
+}
+
+// The event just pushed never reached the host
+static void inflight_drop_last(publisher_instance_t *inst) {
+    publisher_event_t *event = NULL;
+    pthread_mutex_lock(&inst->inflight_mutex);
+    if (inst->inflight_count > 0) {
+        inst->inflight_count--;
+        event = inst->inflight[(inst->inflight_head + inst->inflight_count) % inst->inflight_cap];
+    }
+    pthread_mutex_unlock(&inst->inflight_mutex);
+    publisher_event_release(event);
+}
+
+void publisher_instance_ack(publisher_instance_t *inst, int status) {
+    publisher_event_t *event = NULL;
+    pthread_mutex_lock(&inst->inflight_mutex);
+    if (inst->inflight_count > 0) {
+        event = inst->inflight[inst->inflight_head];
+        inst->inflight_head = (inst->inflight_head + 1) % inst->inflight_cap;
+        inst->inflight_count--;
+    }
+    pthread_mutex_unlock(&inst->inflight_mutex);
+    if (!event) return;
+
+    if (status == 0) {
+        stat_counters_add(inst->stats, PUBLISHER_STAT_PUBLISHED, 1);
+        watermark_advance(inst, event);
+    } else {
+        stat_counters_add(inst->stats, PUBLISHER_STAT_ERRORS, 1);
+    }
+    publisher_event_release(event);
+    
+    // Progress marks queued behind it are reached now
+    while ((event = inflight_pop_progress(inst))) {
+        watermark_advance(inst, event);
+        publisher_event_release(event);
+    }
+}
+
+// A progress mark passes the watermark once everything before it was
+// delivered: at once, or with the ack of the last event in flight
+static void progress_deliver(publisher_instance_t *inst, publisher_event_t *event) {
+    if (inst->deferred_ack) {
+        pthread_mutex_lock(&inst->inflight_mutex);
+        int queued = inst->inflight_count > 0 && inflight_push_locked(inst, event) == 0;
+        pthread_mutex_unlock(&inst->inflight_mutex);
+        if (queued) return;
+    }
+    watermark_advance(inst, event);
+}
+
+// Hand one event to the plugin and drop the queue's reference
+static void publisher_deliver(publisher_instance_t *inst, publisher_event_t *event) {
+    if (event && event->progress) {
+        progress_deliver(inst, event);
+    } else if (event && event->batch && inst->plugin) {
+        int (*publish_columnar)(void *, const cdc_column_batch_t *) =
+            PUBLISHER_CALLBACK_V2(inst, publish_columnar);
+        if (!publish_columnar) {
+            stat_counters_add(inst->stats, PUBLISHER_STAT_ERRORS, 1);
+            if (!inst->columnar_warned) {
+                log_warn("Publisher %s has a columnar output profile but no publish_columnar callback",
+                         inst->name);
+                inst->columnar_warned = 1;
+            }
+        } else {
+            profile_span_t span;
+            profiler_begin(&span);
+            int ret = publish_columnar(inst->plugin->plugin_data,
+                                       column_batch_view(event->batch));
+            profiler_end(&span, PROFILE_PUBLISH);
+            if (ret == 0) {
+                stat_counters_add(inst->stats, PUBLISHER_STAT_PUBLISHED, 1);
+                watermark_advance(inst, event);
+            } else {
+                stat_counters_add(inst->stats, PUBLISHER_STAT_ERRORS, 1);
+                log_warn("Publisher %s failed to publish columnar batch: ret=%d",
+                        inst->name, ret);
+            }
+        }
+    } else if (event && inst->deferred_ack && inflight_push(inst, event) != 0) {
+        stat_counters_add(inst->stats, PUBLISHER_STAT_ERRORS, 1);
+        log_warn("Publisher %s: cannot track event for the host process, dropped", inst->name);
+    } else if (event && inst->plugin && inst->plugin->callbacks->publish) {
+        profile_span_t span;
+        profiler_begin(&span);
+        int ret = inst->plugin->callbacks->publish(
+            inst->plugin->plugin_data,
+            &event->event
+        );
+        profiler_end(&span, PROFILE_PUBLISH);
+        
+        // Deferred: counted once the host acks, see publisher_instance_ack()
+        if (ret == 0 && !inst->deferred_ack) {
+            stat_counters_add(inst->stats, PUBLISHER_STAT_PUBLISHED, 1);
+            watermark_advance(inst, event);
+        } else if (ret != 0) {
+            if (inst->deferred_ack) inflight_drop_last(inst);
+            stat_counters_add(inst->stats, PUBLISHER_STAT_ERRORS, 1);
+            log_warn("Publisher %s failed to publish event: ret=%d",
+                    inst->name, ret);
+        }
+    }
+    
+    publisher_event_release(event);
+}
+
+// Pop the next event; caller holds q_mutex and has checked q_count
+static publisher_event_t* queue_pop_locked(publisher_instance_t *inst) {
+    int idx = inst->q_head;
+    publisher_event_t *event = inst->queue[idx];
+    inst->queue[idx] = NULL;
+    inst->q_head = (inst->q_head + 1) % inst->q_capacity;
+    inst->q_count--;
+    inst->q_bytes -= event->size;
+    if (inst->q_waiters) pthread_cond_broadcast(&inst->q_cond);
+    return event;
+}
+
+static void shed_report(publisher_instance_t *inst);
+
 // Worker thread for async event processing
 static void* publisher_worker_thread(void *arg) {
     publisher_instance_t *inst = (publisher_instance_t*)arg;
     
     log_info("Publisher worker started: %s", inst->name);
     
+    char thread_name[160];
+    snprintf(thread_name, sizeof(thread_name), "publisher:%s", inst->name);
+    profiler_register_thread(thread_name);
+    
+    profile_span_t span;
     while (1) {
         pthread_mutex_lock(&inst->q_mutex);
         
+        profiler_begin(&span);
         while (inst->q_count == 0 && !inst->q_stop) {
             pthread_cond_wait(&inst->q_cond, &inst->q_mutex);
         }
+        profiler_end(&span, PROFILE_QUEUE_WAIT);
         
         if (inst->q_stop && inst->q_count == 0) {
             pthread_mutex_unlock(&inst->q_mutex);
             break;
         }
         
-        int idx = inst->q_head;
-        cdc_event_t *event = inst->queue[idx];
-        inst->queue[idx] = NULL;
-        inst->q_head = (inst->q_head + 1) % inst->q_capacity;
-        inst->q_count--;
+        publisher_event_t *event = queue_pop_locked(inst);
         
         pthread_cond_signal(&inst->q_cond);
         pthread_mutex_unlock(&inst->q_mutex);
         
         // Process event
-        if (event && inst->plugin && inst->plugin->callbacks->publish) {
-            int ret = inst->plugin->callbacks->publish(
-                inst->plugin->plugin_data,
-                event
-            );
-            
-            if (ret == 0) {
-                inst->events_published++;
-            } else {
-                inst->errors++;
-                log_warn("Publisher %s failed to publish event: ret=%d",
-                        inst->name, ret);
-            }
-        }
-        
-        cdc_event_free(event);
+        publisher_deliver(inst, event);
+        if (inst->shed.enabled) shed_report(inst);
     }
     
+    profiler_unregister_thread();
     log_info("Publisher worker exiting: %s", inst->name);
     return NULL;
 }
 
-// Load plugin from shared library
-int publisher_manager_load_plugin(
+// One pool turn for a publisher. Only the worker holding the SCHEDULED
+// instance gets here, so events are still delivered in order.
+int publisher_instance_run(publisher_instance_t *inst, int quantum) {
+    for (int n = 0; ; n++) {
+        pthread_mutex_lock(&inst->q_mutex);
+        
+        if (inst->q_count == 0) {
+            inst->sched_state = PUBLISHER_IDLE;
+            pthread_cond_broadcast(&inst->q_cond);
+            pthread_mutex_unlock(&inst->q_mutex);
+            return 0;
+        }
+        
+        if (n >= quantum) {
+            pthread_mutex_unlock(&inst->q_mutex);
+            return 1;
+        }
+        
+        publisher_event_t *event = queue_pop_locked(inst);
+        pthread_mutex_unlock(&inst->q_mutex);
+        
+        publisher_deliver(inst, event);
+        if (inst->shed.enabled) shed_report(inst);
+    }
+}
+
+// Create the shared pool
+int publisher_manager_enable_pool(publisher_manager_t *manager, int threads, int quantum) {
+    if (!manager) return -1;
+    if (manager->pool) return 0;
+    
+    manager->pool = publisher_pool_create(threads, quantum);
+    if (!manager->pool) {
+        log_error("Failed to create publisher pool, using dedicated threads");
+        return -1;
+    }
+    return 0;
+}
+
+// Register a plugin instance: copy its configuration and create its queue.
+// The library is not loaded yet, but events can already be queued.
+int publisher_manager_add_plugin(
     publisher_manager_t *manager,
     const char *name,
     const char *library_path,
@@ -278,7 +791,7 @@ int publisher_manager_load_plugin(
     publisher_instance_t **out_instance)
 {
     if (!manager || !name || !library_path || !config) {
-        log_error("Invalid parameters to publisher_manager_load_plugin");
+        log_error("Invalid parameters to publisher_manager_add_plugin");
         return -1;
     }
     
@@ -287,7 +800,7 @@ int publisher_manager_load_plugin(
         return -1;
     }
     
-    log_info("Loading publisher plugin: %s from %s %d", name, library_path);
+    log_info("Registering publisher plugin: %s from %s", name, library_path);
     
     // Allocate instance
     publisher_instance_t *inst = calloc(1, sizeof(publisher_instance_t));
@@ -367,11 +880,57 @@ int publisher_manager_load_plugin(
         inst->config.config_count = config->config_count;
     }
     
+    // Initialize queue and counters
+    inst->stats = stat_counters_create(PUBLISHER_STAT_COUNT);
+    if (!inst->stats || queue_init(inst) != 0) {
+        log_error("Failed to initialize queue for publisher %s", name);
+        publisher_instance_destroy(inst);
+        return -1;
+    }
+    
+    inst->active = config->active;
+    inst->load_state = PUBLISHER_LOADING;
+    
+    // Add to manager
+    inst->next = manager->instances;
+    manager->instances = inst;
+    manager->instance_count++;
+    
+    *out_instance = inst;
+    return 0;
+}
+
+// Built-in plugin whose name is the file name of library_path, minus extension
+static const static_plugin_t* static_plugin_find(const char *library_path) {
+    const char *base = strrchr(library_path, '/');
+    base = base ? base + 1 : library_path;
+
+    for (const static_plugin_t *sp = static_plugins; sp->name; sp++) {
+        size_t n = strlen(sp->name);
+        if (strncmp(base, sp->name, n) == 0 && (base[n] == '\0' || base[n] == '.')) {
+            return sp;
+        }
+    }
+    return NULL;
+}
+
+// Load the shared library and get its plugin descriptor
+static int publisher_instance_dlopen(publisher_instance_t *inst) {
+    // Plugins linked into the binary take precedence over the library file
+    const static_plugin_t *builtin = static_plugin_find(inst->library_path);
+    if (builtin) {
+        log_info("Plugin %s is built in, %s not loaded", builtin->name, inst->library_path);
+        if (builtin->init(&inst->plugin) != 0 || !inst->plugin) {
+            log_error("Plugin %s init failed", builtin->name);
+            return -1;
+        }
+        return 0;
+    }
+
     // Load shared library
-    inst->dl_handle = dlopen(library_path, RTLD_NOW | RTLD_LOCAL);
+    inst->dl_handle = dlopen(inst->library_path, RTLD_NOW | RTLD_LOCAL);
     if (!inst->dl_handle) {
-        log_error("Failed to load plugin %s: %s", library_path, dlerror());
-        publisher_instance_destroy(inst);
+        log_error("Failed to load plugin %s: %s", inst->library_path, dlerror());
         return -1;
     }
     
@@ -381,15 +940,30 @@ int publisher_manager_load_plugin(
     
     if (!init_fn) {
         log_error("Plugin %s missing publisher_plugin_init symbol: %s",
-                 library_path, dlerror());
-        publisher_instance_destroy(inst);
+                 inst->library_path, dlerror());
         return -1;
     }
     
     // Initialize plugin
     if (init_fn(&inst->plugin) != 0 || !inst->plugin) {
-        log_error("Plugin %s init failed", library_path);
-        publisher_instance_destroy(inst);
+        log_error("Plugin %s init failed", inst->library_path);
+        return -1;
+    }
+    
+    return 0;
+}
+
+// dlopen the plugin library (or attach its host process) and run its init callback
+static int publisher_instance_load(publisher_instance_t *inst) {
+    log_info("Loading publisher plugin: %s from %s%s", inst->name, inst->library_path,
+             inst->out_of_process ? " (host process)" : "");
+    
+    if (inst->out_of_process) {
+        if (plugin_host_attach(inst) != 0) {
+            log_error("Failed to set up plugin host for %s", inst->name);
+            return -1;
+        }
+    } else if (publisher_instance_dlopen(inst) != 0) {
         return -1;
     }
     
@@ -398,20 +972,21 @@ int publisher_manager_load_plugin(
         !inst->plugin->callbacks->get_name ||
         !inst->plugin->callbacks->init ||
         !inst->plugin->callbacks->publish) {
-        log_error("Plugin %s missing required callbacks", library_path);
-        publisher_instance_destroy(inst);
+        log_error("Plugin %s missing required callbacks", inst->library_path);
         return -1;
     }
     
-    // Check API version
+    // Check API version; without get_api_version it is the first one
+    inst->api_version = PUBLISHER_API_VERSION_MIN;
     if (inst->plugin->callbacks->get_api_version) {
         int api_ver = inst->plugin->callbacks->get_api_version();
-        if (api_ver != PUBLISHER_API_VERSION) {
-            log_error("Plugin %s API version mismatch: expected %d, got %d",
-                     library_path, PUBLISHER_API_VERSION, api_ver);
-            publisher_instance_destroy(inst);
+        if (api_ver < PUBLISHER_API_VERSION_MIN || api_ver > PUBLISHER_API_VERSION) {
+            log_error("Plugin %s API version mismatch: expected %d to %d, got %d",
+                     inst->library_path, PUBLISHER_API_VERSION_MIN, PUBLISHER_API_VERSION,
+                     api_ver);
             return -1;
         }
+        inst->api_version = api_ver;
     }
     
     // Get plugin info
@@ -424,32 +999,193 @@ int publisher_manager_load_plugin(
     // Call plugin init
     if (inst->plugin->callbacks->init(&inst->config, &inst->plugin->plugin_data) != 0) {
         log_error("Plugin %s init callback failed", plugin_name);
-        publisher_instance_destroy(inst);
         return -1;
     }
     
-    // Initialize queue
-    if (queue_init(inst) != 0) {
-        log_error("Failed to initialize queue for publisher %s", name);
+    log_info("Publisher %s loaded successfully (active=%d, databases=%d)",
+            inst->name, inst->active, inst->config.db_count);
+    
+    return 0;
+}
+
+// Unlink an instance that was just added at the head of the list
+static void publisher_manager_remove_head(publisher_manager_t *manager, publisher_instance_t *inst) {
+    if (manager->instances == inst) {
+        manager->instances = inst->next;
+        manager->instance_count--;
+    }
+}
+
+// Load plugin from shared library (synchronously)
+int publisher_manager_load_plugin(
+    publisher_manager_t *manager,
+    const char *name,
+    const char *library_path,
+    const publisher_config_t *config,
+    publisher_instance_t **out_instance)
+{
+    publisher_instance_t *inst = NULL;
+    if (publisher_manager_add_plugin(manager, name, library_path, config, &inst) != 0) {
+        return -1;
+    }
+    
+    if (publisher_instance_load(inst) != 0) {
+        publisher_manager_remove_head(manager, inst);
         publisher_instance_destroy(inst);
         return -1;
     }
     
-    inst->active = config->active;
+    inst->load_state = PUBLISHER_READY;
+    *out_instance = inst;
+    return 0;
+}
+
+static double elapsed_ms(const struct timespec *t0) {
+    struct timespec t1;
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    return (t1.tv_sec - t0->tv_sec) * 1000.0 + (t1.tv_nsec - t0->tv_nsec) / 1e6;
+}
+
+// Publisher could not be loaded: stop dispatching to it and drop its backlog
+static void publisher_instance_fail(publisher_instance_t *inst) {
+    pthread_mutex_lock(&inst->q_mutex);
+    inst->active = 0;
+    for (int i = 0; i < inst->q_count; i++) {
+        int idx = (inst->q_head + i) % inst->q_capacity;
+        publisher_event_release(inst->queue[idx]);
+        inst->queue[idx] = NULL;
+    }
+    stat_counters_add(inst->stats, PUBLISHER_STAT_DROPPED, (uint64_t)inst->q_count);
+    inst->q_head = inst->q_tail = inst->q_count = 0;
+    pthread_mutex_unlock(&inst->q_mutex);
+}
+
+static void* publisher_startup_thread(void *arg) {
+    publisher_manager_t *mgr = (publisher_manager_t*)arg;
     
-    // Add to manager
-    inst->next = manager->instances;
-    manager->instances = inst;
-    manager->instance_count++;
+    while (1) {
+        pthread_mutex_lock(&mgr->startup_mutex);
+        publisher_instance_t *inst = mgr->startup_next;
+        while (inst && (!inst->active || inst->started)) inst = inst->next;
+        mgr->startup_next = inst ? inst->next : NULL;
+        pthread_mutex_unlock(&mgr->startup_mutex);
+        
+        if (!inst) break;
+        
+        struct timespec t0;
+        clock_gettime(CLOCK_MONOTONIC, &t0);
+        
+        int ok = (inst->load_state == PUBLISHER_READY || publisher_instance_load(inst) == 0) &&
+                 publisher_instance_start(inst) == 0;
+        if (!ok) {
+            log_error("Failed to start publisher: %s", inst->name);
+            publisher_instance_fail(inst);
+        }
+        
+        double ms = elapsed_ms(&t0);
+        char labels[192];
+        snprintf(labels, sizeof(labels), "publisher=\"%s\"", inst->name);
+        metrics_set("binlog_publisher_startup_seconds", labels, ms / 1000.0);
+        metrics_set("binlog_publisher_ready", labels, ok ? 1 : 0);
+        
+        pthread_mutex_lock(&mgr->startup_mutex);
+        inst->startup_ms = ms;
+        inst->load_state = ok ? PUBLISHER_READY : PUBLISHER_FAILED;
+        mgr->startup_pending--;
+        if (inst->critical) mgr->startup_pending_critical--;
+        pthread_cond_broadcast(&mgr->startup_cond);
+        pthread_mutex_unlock(&mgr->startup_mutex);
+        
+        if (ok) {
+            log_info("Started publisher: %s in %.1f ms%s", inst->name, ms,
+                     inst->critical ? "" : " (non-critical)");
+        }
+    }
     
-    *out_instance = inst;
+    return NULL;
+}
+
+// Load and start publishers in parallel
+int publisher_manager_start_all(publisher_manager_t *manager, int threads) {
+    if (!manager) return -1;
+    
+    int pending = 0, critical = 0;
+    for (publisher_instance_t *inst = manager->instances; inst; inst = inst->next) {
+        if (!inst->active || inst->started) continue;
+        pending++;
+        if (inst->critical) critical++;
+    }
+    if (pending == 0) return 0;
     
-    log_info("Publisher %s loaded successfully (active=%d, databases=%d)",
-            name, inst->active, inst->config.db_count);
+    if (threads <= 0 || threads > pending) threads = pending;
+    if (threads > PUBLISHER_STARTUP_MAX_THREADS) threads = PUBLISHER_STARTUP_MAX_THREADS;
+    
+    manager->startup_threads = calloc(threads, sizeof(pthread_t));
+    if (!manager->startup_threads) return -1;
+    
+    pthread_mutex_lock(&manager->startup_mutex);
+    manager->startup_next = manager->instances;
+    manager->startup_pending = pending;
+    manager->startup_pending_critical = critical;
+    pthread_mutex_unlock(&manager->startup_mutex);
+    
+    log_info("Starting %d publisher(s) (%d critical) on %d thread(s)", pending, critical, threads);
+    
+    for (int i = 0; i < threads; i++) {
+        if (pthread_create(&manager->startup_threads[i], NULL,
+                           publisher_startup_thread, manager) != 0) {
+            log_error("Failed to create publisher startup thread");
+            break;
+        }
+        manager->startup_thread_count++;
+    }
+    
+    // No thread at all: fall back to starting them here
+    if (manager->startup_thread_count == 0) {
+        publisher_startup_thread(manager);
+    }
     
     return 0;
 }
 
+int publisher_manager_wait_ready(publisher_manager_t *manager, int timeout_ms) {
+    if (!manager) return 0;
+    
+    struct timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += timeout_ms / 1000;
+    deadline.tv_nsec += (long)(timeout_ms % 1000) * 1000000L;
+    if (deadline.tv_nsec >= 1000000000L) {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000L;
+    }
+    
+    pthread_mutex_lock(&manager->startup_mutex);
+    while (manager->startup_pending_critical > 0) {
+        if (timeout_ms <= 0) {
+            pthread_cond_wait(&manager->startup_cond, &manager->startup_mutex);
+        } else if (pthread_cond_timedwait(&manager->startup_cond, &manager->startup_mutex,
+                                          &deadline) == ETIMEDOUT) {
+            break;
+        }
+    }
+    int remaining = manager->startup_pending_critical;
+    pthread_mutex_unlock(&manager->startup_mutex);
+    
+    return remaining;
+}
+
+void publisher_manager_join_startup(publisher_manager_t *manager) {
+    if (!manager || !manager->startup_threads) return;
+    
+    for (int i = 0; i < manager->startup_thread_count; i++) {
+        pthread_join(manager->startup_threads[i], NULL);
+    }
+    free(manager->startup_threads);
+    manager->startup_threads = NULL;
+    manager->startup_thread_count = 0;
+}
+
 // Start publisher
 int publisher_instance_start(publisher_instance_t *inst) {
     if (!inst || !inst->active) return -1;
@@ -465,6 +1201,23 @@ int publisher_instance_start(publisher_instance_t *inst) {
         }
     }
     
+    // Pool mode: no thread of its own, schedule anything queued so far
+    if (inst->pool) {
+        int schedule = 0;
+        pthread_mutex_lock(&inst->q_mutex);
+        __atomic_store_n(&inst->started, 1, __ATOMIC_RELEASE);
+        if (inst->q_count > 0 && inst->sched_state == PUBLISHER_IDLE) {
+            inst->sched_state = PUBLISHER_SCHEDULED;
+            schedule = 1;
+        }
+        pthread_mutex_unlock(&inst->q_mutex);
+        
+        if (schedule) publisher_pool_schedule(inst->pool, inst);
+        
+        log_info("Publisher %s started (shared pool)", inst->name);
+        return 0;
+    }
+    
     // Start worker thread
     if (pthread_create(&inst->thread, NULL, publisher_worker_thread, inst) != 0) {
         log_error("Failed to start worker thread for publisher %s", inst->name);
@@ -472,7 +1225,7 @@ int publisher_instance_start(publisher_instance_t *inst) {
     }
     
     inst->thread_started = 1;
-    inst->started = 1;
+    __atomic_store_n(&inst->started, 1, __ATOMIC_RELEASE);
     
     log_info("Publisher %s started", inst->name);
     return 0;
@@ -488,6 +1241,11 @@ int publisher_instance_stop(publisher_instance_t *inst) {
     pthread_mutex_lock(&inst->q_mutex);
     inst->q_stop = 1;
     pthread_cond_broadcast(&inst->q_cond);
+    
+    // Pool mode: wait until the pool has drained the queue
+    while (inst->pool && (inst->q_count > 0 || inst->sched_state != PUBLISHER_IDLE)) {
+        pthread_cond_wait(&inst->q_cond, &inst->q_mutex);
+    }
     pthread_mutex_unlock(&inst->q_mutex);
     
     // Wait for worker thread
@@ -501,43 +1259,315 @@ int publisher_instance_stop(publisher_instance_t *inst) {
         inst->plugin->callbacks->stop(inst->plugin->plugin_data);
     }
     
-    inst->started = 0;
+    __atomic_store_n(&inst->started, 0, __ATOMIC_RELEASE);
     
+    publisher_stats_t stats;
+    publisher_stats_snapshot(inst, &stats);
     log_info("Publisher %s stopped (published=%llu, dropped=%llu, errors=%llu)",
-            inst->name, inst->events_published, inst->events_dropped, inst->errors);
+            inst->name, (unsigned long long)stats.events_published,
+            (unsigned long long)stats.events_dropped, (unsigned long long)stats.errors);
     
     return 0;
 }
 
+void publisher_manager_stop_all(publisher_manager_t *manager) {
+    if (!manager) return;
+    for (int emitters = 1; emitters >= 0; emitters--) {
+        for (publisher_instance_t *inst = manager->instances; inst; inst = inst->next) {
+            int emits = plugin_get_config(&inst->config, "emit_to") != NULL;
+            if (emits == emitters && __atomic_load_n(&inst->started, __ATOMIC_ACQUIRE))
+                publisher_instance_stop(inst);
+        }
+    }
+}
+
+// ============================================================================
+// STATISTICS
+// ============================================================================
+
+void publisher_stats_snapshot(publisher_instance_t *inst, publisher_stats_t *out) {
+    uint64_t v[PUBLISHER_STAT_COUNT] = {0};
+    memset(out, 0, sizeof(*out));
+    stat_counters_snapshot(inst->stats, v);
+    out->events_published = v[PUBLISHER_STAT_PUBLISHED];
+    out->events_dropped = v[PUBLISHER_STAT_DROPPED];
+    out->errors = v[PUBLISHER_STAT_ERRORS];
+
+    // Plugin data exists between start and cleanup only
+    int (*get_stats)(void *, publisher_stat_t *, int) =
+        inst->plugin ? PUBLISHER_CALLBACK_V2(inst, get_stats) : NULL;
+    if (__atomic_load_n(&inst->started, __ATOMIC_ACQUIRE) && get_stats) {
+        int n = get_stats(inst->plugin->plugin_data, out->plugin, PUBLISHER_PLUGIN_STATS_MAX);
+        out->plugin_count = n < 0 ? 0 : n > PUBLISHER_PLUGIN_STATS_MAX ? PUBLISHER_PLUGIN_STATS_MAX : n;
+    }
+}
+
+int publisher_stats_format(publisher_instance_t *inst, char *buf, size_t size) {
+    publisher_stats_t st;
+    publisher_stats_snapshot(inst, &st);
+
+    int len = snprintf(buf, size,
+                       "{\"publisher\":\"%s\",\"published\":%llu,\"dropped\":%llu,"
+                       "\"errors\":%llu,\"plugin\":{",
+                       inst->name, (unsigned long long)st.events_published,
+                       (unsigned long long)st.events_dropped, (unsigned long long)st.errors);
+    for (int i = 0; i < st.plugin_count && len < (int)size; i++) {
+        len += snprintf(buf + len, size - len, "%s\"%s\":%llu", i ? "," : "",
+                        st.plugin[i].name ? st.plugin[i].name : "",
+                        (unsigned long long)st.plugin[i].value);
+    }
+    if (len < (int)size) len += snprintf(buf + len, size - len, "}}");
+    return len < (int)size ? len : -1;
+}
+
+// ============================================================================
+// LOAD SHEDDING
+// ============================================================================
+
+#define SHED_KEEP    0
+#define SHED_SAMPLE  1              // dropped by sampling
+#define SHED_DROP    2
+#define SHED_SPILL   3              // written to the spill file instead
+
+static const char *priority_names[PUBLISHER_PRIORITY_COUNT] = { "critical", "normal", "low" };
+static const char *shed_level_names[] = { "none", "sample", "drop" };
+static const char *shed_action_names[] = { "kept", "sampled", "dropped", "spilled" };
+
+int publisher_priority_parse(const char *name) {
+    if (!name) return -1;
+    for (int i = 0; i < PUBLISHER_PRIORITY_COUNT; i++) {
+        if (strcasecmp(name, priority_names[i]) == 0) return i;
+    }
+    return -1;
+}
+
+// The publisher's own rules win over the table's class
+static int shed_priority(const publisher_instance_t *inst, const publisher_event_t *event) {
+    if (event->priority == PUBLISHER_PRIORITY_BOUNDARY) return PUBLISHER_PRIORITY_CRITICAL;
+    
+    const char *db = event->event.db;
+    const char *table = event->event.table;
+    
+    for (int i = 0; db && i < inst->shed.rule_count; i++) {
+        const publisher_priority_rule_t *r = &inst->shed.rules[i];
+        if (strcmp(r->db, db) != 0) continue;
+        if (strcmp(r->table, "*") == 0 || (table && strcmp(r->table, table) == 0)) {
+            return r->priority;
+        }
+    }
+    return event->priority;
+}
+
+// Caller holds q_mutex
+static double shed_pressure(const publisher_instance_t *inst, const publisher_event_t *event) {
+    const publisher_shedding_t *s = &inst->shed;
+    double pressure = (double)inst->q_count / inst->q_capacity;
+    
+    if (s->max_bytes) {
+        double bytes = (double)inst->q_bytes / s->max_bytes;
+        if (bytes > pressure) pressure = bytes;
+    }
+    
+    // How far the sink is behind in binlog time
+    if (s->max_lag_sec && inst->q_count > 0) {
+        uint32_t head = inst->queue[inst->q_head]->event.timestamp;
+        uint32_t now = event->event.timestamp;
+        if (head && now > head) {
+            double lag = (double)(now - head) / s->max_lag_sec;
+            if (lag > pressure) pressure = lag;
+        }
+    }
+    return pressure;
+}
+
+// A level is left only once pressure is 20% below its threshold, so the
+// publisher does not flap around it. Caller holds q_mutex.
+static void shed_update_level(publisher_instance_t *inst, double pressure) {
+    publisher_shedding_t *s = &inst->shed;
+    int level = pressure >= s->drop_at ? PUBLISHER_SHED_DROP :
+                pressure >= s->sample_at ? PUBLISHER_SHED_SAMPLE : PUBLISHER_SHED_NONE;
+    
+    if (level == s->level) return;
+    if (level < s->level) {
+        double threshold = s->level == PUBLISHER_SHED_DROP ? s->drop_at : s->sample_at;
+        if (pressure > threshold * 0.8) return;
+    }
+    
+    if (level > s->level) {
+        log_warn("Publisher %s overloaded (queue %d/%d, %zu bytes): shedding %s -> %s",
+                 inst->name, inst->q_count, inst->q_capacity, inst->q_bytes,
+                 shed_level_names[s->level], shed_level_names[level]);
+    } else {
+        log_info("Publisher %s recovering (queue %d/%d, %zu bytes): shedding %s -> %s",
+                 inst->name, inst->q_count, inst->q_capacity, inst->q_bytes,
+                 shed_level_names[s->level], shed_level_names[level]);
+    }
+    s->level = level;
+    
+    char labels[160];
+    snprintf(labels, sizeof(labels), "publisher=\"%s\"", inst->name);
+    metrics_set("binlog_publisher_shed_level", labels, level);
+}
+
+// Normal tables trail low ones by one level; critical ones are never shed
+static int shed_action(publisher_instance_t *inst, int priority) {
+    publisher_shedding_t *s = &inst->shed;
+    if (priority == PUBLISHER_PRIORITY_CRITICAL) return SHED_KEEP;
+    
+    int level = priority == PUBLISHER_PRIORITY_NORMAL ? s->level - 1 : s->level;
+    if (level <= PUBLISHER_SHED_NONE) return SHED_KEEP;
+    if (level == PUBLISHER_SHED_SAMPLE) {
+        return s->seen[priority]++ % s->sample_rate == 0 ? SHED_KEEP : SHED_SAMPLE;
+    }
+    return SHED_DROP;
+}
+
+// Append a shed event to the spill file; caller does not hold q_mutex
+static int shed_spill(publisher_instance_t *inst, const publisher_event_t *event) {
+    publisher_shedding_t *s = &inst->shed;
+    if (!event->event.json) return -1;
+    
+    int ret = 0;
+    pthread_mutex_lock(&s->spill_mutex);
+    if (!s->spill_path[0]) {
+        ret = -1;
+    } else if (!s->spill_fp && !(s->spill_fp = fopen(s->spill_path, "a"))) {
+        log_error("Publisher %s cannot open spill file %s: %s",
+                  inst->name, s->spill_path, strerror(errno));
+        s->spill_path[0] = '\0';
+        ret = -1;
+    } else if (fputs(event->event.json, s->spill_fp) == EOF ||
+               fputc('\n', s->spill_fp) == EOF) {
+        ret = -1;
+    }
+    pthread_mutex_unlock(&s->spill_mutex);
+    return ret;
+}
+
+// Add the shed counts to the metrics and flush spilled events. Runs on the
+// publisher's worker, so the enqueue path only bumps a counter.
+static void shed_report(publisher_instance_t *inst) {
+    publisher_shedding_t *s = &inst->shed;
+    int spilled = 0;
+    
+    for (int p = 0; p < PUBLISHER_PRIORITY_COUNT; p++) {
+        for (int a = SHED_SAMPLE; a <= SHED_SPILL; a++) {
+            if (!__atomic_load_n(&s->unreported[p][a], __ATOMIC_RELAXED)) continue;
+            uint64_t n = __atomic_exchange_n(&s->unreported[p][a], 0, __ATOMIC_RELAXED);
+            if (!n) continue;
+            
+            char labels[256];
+            snprintf(labels, sizeof(labels), "publisher=\"%s\",priority=\"%s\",action=\"%s\"",
+                     inst->name, priority_names[p], shed_action_names[a]);
+            metrics_add("binlog_publisher_shed_events_total", labels, (double)n);
+            if (a == SHED_SPILL) spilled = 1;
+        }
+    }
+    
+    if (spilled) {
+        pthread_mutex_lock(&s->spill_mutex);
+        if (s->spill_fp) fflush(s->spill_fp);
+        pthread_mutex_unlock(&s->spill_mutex);
+    }
+}
+
 // Enqueue event for publishing
 int publisher_instance_enqueue(publisher_instance_t *inst, const cdc_event_t *event) {
     if (!inst || !inst->active || !event) return -1;
     
-    cdc_event_t *event_copy = cdc_event_copy(event);
-    if (!event_copy) {
-        inst->events_dropped++;
+    publisher_event_t *shared = publisher_event_create(event);
+    if (!shared) {
+        stat_counters_add(inst->stats, PUBLISHER_STAT_DROPPED, 1);
         return -1;
     }
     
+    int ret = publisher_instance_enqueue_event(inst, shared);
+    publisher_event_release(shared);
+    return ret;
+}
+
+// Enqueue a shared event; the queue holds its own reference
+int publisher_instance_enqueue_event(publisher_instance_t *inst, publisher_event_t *event) {
+    if (!inst || !inst->active || !event) return -1;
+    
     pthread_mutex_lock(&inst->q_mutex);
     
+    // Failed while loading in the background
+    if (!inst->active) {
+        pthread_mutex_unlock(&inst->q_mutex);
+        return -1;
+    }
+    
+    // Only the newest progress mark matters: replace a queued one, and
+    // never shed or count one; the next transaction end catches up
+    if (event->progress) {
+        int last = (inst->q_tail + inst->q_capacity - 1) % inst->q_capacity;
+        if (inst->q_count > 0 && inst->queue[last]->progress) {
+            publisher_event_t *old = inst->queue[last];
+            publisher_event_retain(event);
+            inst->queue[last] = event;
+            inst->q_bytes += event->size - old->size;
+            pthread_mutex_unlock(&inst->q_mutex);
+            publisher_event_release(old);
+            return 0;
+        }
+        if (inst->q_count >= inst->q_capacity) {
+            pthread_mutex_unlock(&inst->q_mutex);
+            return -1;
+        }
+    } else if (inst->shed.enabled) {
+        int priority = shed_priority(inst, event);
+        shed_update_level(inst, shed_pressure(inst, event));
+        
+        // Critical tables wait for the worker instead of losing events
+        while (priority == PUBLISHER_PRIORITY_CRITICAL && inst->started &&
+               inst->q_count >= inst->q_capacity && !inst->q_stop) {
+            inst->q_waiters++;
+            pthread_cond_wait(&inst->q_cond, &inst->q_mutex);
+            inst->q_waiters--;
+        }
+        
+        int action = shed_action(inst, priority);
+        if (action == SHED_KEEP && inst->q_count >= inst->q_capacity) action = SHED_DROP;
+        if (action != SHED_KEEP) {
+            pthread_mutex_unlock(&inst->q_mutex);
+            
+            // The caller's reference keeps event alive for the spill
+            if (action == SHED_DROP && shed_spill(inst, event) == 0) action = SHED_SPILL;
+            if (action != SHED_SPILL) stat_counters_add(inst->stats, PUBLISHER_STAT_DROPPED, 1);
+            __atomic_add_fetch(&inst->shed.unreported[priority][action], 1, __ATOMIC_RELAXED);
+            return action == SHED_SPILL ? 0 : -1;
+        }
+    }
+    
     // Check if queue is full
     if (inst->q_count >= inst->q_capacity) {
         pthread_mutex_unlock(&inst->q_mutex);
-        cdc_event_free(event_copy);
-        inst->events_dropped++;
+        stat_counters_add(inst->stats, PUBLISHER_STAT_DROPPED, 1);
         log_warn("Publisher %s queue full, dropping event", inst->name);
         return -1;
     }
     
+    publisher_event_retain(event);
     int idx = inst->q_tail;
-    inst->queue[idx] = event_copy;
+    inst->queue[idx] = event;
     inst->q_tail = (inst->q_tail + 1) % inst->q_capacity;
     inst->q_count++;
+    inst->q_bytes += event->size;
     
-    pthread_cond_signal(&inst->q_cond);
+    int schedule = 0;
+    if (inst->pool) {
+        if (inst->started && inst->sched_state == PUBLISHER_IDLE) {
+            inst->sched_state = PUBLISHER_SCHEDULED;
+            schedule = 1;
+        }
+    } else {
+        pthread_cond_signal(&inst->q_cond);
+    }
     pthread_mutex_unlock(&inst->q_mutex);
     
+    if (schedule) publisher_pool_schedule(inst->pool, inst);
+    
     return 0;
 }
 
@@ -584,6 +1614,10 @@ void publisher_instance_destroy(publisher_instance_t *inst) {
     
     // Cleanup queue
     queue_destroy(inst);
+    stat_counters_destroy(inst->stats);
+    
+    if (inst->shed.spill_fp) fclose(inst->shed.spill_fp);
+    free(inst->shed.rules);
     
     // Free config - only if arrays were allocated and contain our own strings
     if (inst->config.name) {
@@ -624,6 +1658,14 @@ void publisher_instance_destroy(publisher_instance_t *inst) {
 void publisher_manager_destroy(publisher_manager_t *manager) {
     if (!manager) return;
     
+    publisher_manager_join_startup(manager);
+    publisher_manager_stop_all(manager);
+    
+    // Nothing may emit into instances that are being freed
+    publisher_manager_t *expected = manager;
+    __atomic_compare_exchange_n(&emit_manager, &expected, NULL, 0,
+                                __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+    
     publisher_instance_t *inst = manager->instances;
     while (inst) {
         publisher_instance_t *next = inst->next;
@@ -631,6 +1673,11 @@ void publisher_manager_destroy(publisher_manager_t *manager) {
         inst = next;
     }
     
+    // All publishers are stopped, nothing can be scheduled any more
+    publisher_pool_destroy(manager->pool);
+    
+    pthread_mutex_destroy(&manager->startup_mutex);
+    pthread_cond_destroy(&manager->startup_cond);
     free(manager);
     publisher_helpers = NULL;
 }
\ No newline at end of file
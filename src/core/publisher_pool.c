@@ -0,0 +1,254 @@
+// publisher_pool.c
+// Work-stealing worker pool shared by publisher queues
+
+#include "publisher_pool.h"
+#include "publisher_loader.h"
+#include "logger.h"
+#include "stage_profiler.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#define POOL_DEQUE_INITIAL 16
+
+// Per-worker ring of ready publishers. The owner takes from the head and
+// requeues at the tail; thieves take from the tail.
+typedef struct {
+    publisher_instance_t **items;
+    int head, count, capacity;
+    pthread_mutex_t mutex;
+} pool_deque_t;
+
+typedef struct {
+    publisher_pool_t *pool;
+    int index;
+    pthread_t thread;
+    int thread_started;
+    pool_deque_t deque;
+} pool_worker_t;
+
+struct publisher_pool {
+    pool_worker_t *workers;
+    int worker_count;
+    int quantum;
+
+    // Ready publishers across all deques; workers sleep while it is zero
+    int ready;
+    int stop;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+
+    unsigned int next_worker;
+};
+
+// Worker owning the calling thread, so rescheduling stays local
+static __thread pool_worker_t *tls_worker = NULL;
+
+static int deque_push(pool_deque_t *dq, publisher_instance_t *inst) {
+    pthread_mutex_lock(&dq->mutex);
+
+    if (dq->count == dq->capacity) {
+        int cap = dq->capacity ? dq->capacity * 2 : POOL_DEQUE_INITIAL;
+        publisher_instance_t **items = malloc(cap * sizeof(*items));
+        if (!items) {
+            pthread_mutex_unlock(&dq->mutex);
+            return -1;
+        }
+        for (int i = 0; i < dq->count; i++) {
+            items[i] = dq->items[(dq->head + i) % dq->capacity];
+        }
+        free(dq->items);
+        dq->items = items;
+        dq->head = 0;
+        dq->capacity = cap;
+    }
+
+    dq->items[(dq->head + dq->count) % dq->capacity] = inst;
+    dq->count++;
+
+    pthread_mutex_unlock(&dq->mutex);
+    return 0;
+}
+
+static publisher_instance_t* deque_pop_head(pool_deque_t *dq) {
+    publisher_instance_t *inst = NULL;
+
+    pthread_mutex_lock(&dq->mutex);
+    if (dq->count > 0) {
+        inst = dq->items[dq->head];
+        dq->head = (dq->head + 1) % dq->capacity;
+        dq->count--;
+    }
+    pthread_mutex_unlock(&dq->mutex);
+
+    return inst;
+}
+
+static publisher_instance_t* deque_steal_tail(pool_deque_t *dq) {
+    publisher_instance_t *inst = NULL;
+
+    // Never block on a busy victim, just try the next one
+    if (pthread_mutex_trylock(&dq->mutex) != 0) return NULL;
+    if (dq->count > 0) {
+        dq->count--;
+        inst = dq->items[(dq->head + dq->count) % dq->capacity];
+    }
+    pthread_mutex_unlock(&dq->mutex);
+
+    return inst;
+}
+
+static void pool_push(publisher_pool_t *pool, pool_worker_t *w, publisher_instance_t *inst) {
+    // Any deque will do when w's cannot grow
+    for (int i = 0; i < pool->worker_count; i++) {
+        pool_worker_t *t = &pool->workers[(w->index + i) % pool->worker_count];
+        if (deque_push(&t->deque, inst) == 0) {
+            pthread_mutex_lock(&pool->mutex);
+            pool->ready++;
+            pthread_cond_signal(&pool->cond);
+            pthread_mutex_unlock(&pool->mutex);
+            return;
+        }
+    }
+
+    // Nowhere to queue it: still SCHEDULED, so no one else would ever run
+    // it. Deliver its backlog here until it goes idle.
+    log_error("Publisher pool: cannot queue %s, out of memory; delivering inline", inst->name);
+    while (publisher_instance_run(inst, pool->quantum)) { }
+}
+
+void publisher_pool_schedule(publisher_pool_t *pool, publisher_instance_t *inst) {
+    if (!pool || !inst) return;
+
+    pool_worker_t *w = tls_worker;
+    if (!w || w->pool != pool) {
+        unsigned int n = __atomic_fetch_add(&pool->next_worker, 1, __ATOMIC_RELAXED);
+        w = &pool->workers[n % pool->worker_count];
+    }
+    pool_push(pool, w, inst);
+}
+
+static publisher_instance_t* pool_take(pool_worker_t *w) {
+    publisher_pool_t *pool = w->pool;
+
+    publisher_instance_t *inst = deque_pop_head(&w->deque);
+    for (int i = 1; !inst && i < pool->worker_count; i++) {
+        inst = deque_steal_tail(&pool->workers[(w->index + i) % pool->worker_count].deque);
+    }
+
+    if (inst) {
+        pthread_mutex_lock(&pool->mutex);
+        pool->ready--;
+        pthread_mutex_unlock(&pool->mutex);
+    }
+    return inst;
+}
+
+static void* pool_worker_thread(void *arg) {
+    pool_worker_t *w = (pool_worker_t*)arg;
+    publisher_pool_t *pool = w->pool;
+
+    tls_worker = w;
+    log_debug("Publisher pool worker %d started", w->index);
+
+    char thread_name[32];
+    snprintf(thread_name, sizeof(thread_name), "pool:%d", w->index);
+    profiler_register_thread(thread_name);
+
+    profile_span_t span;
+    while (1) {
+        publisher_instance_t *inst = pool_take(w);
+
+        if (!inst) {
+            pthread_mutex_lock(&pool->mutex);
+            profiler_begin(&span);
+            while (pool->ready == 0 && !pool->stop) {
+                pthread_cond_wait(&pool->cond, &pool->mutex);
+            }
+            profiler_end(&span, PROFILE_QUEUE_WAIT);
+            int done = pool->stop && pool->ready == 0;
+            pthread_mutex_unlock(&pool->mutex);
+            if (done) break;
+            continue;
+        }
+
+        // Still has events after its quantum: requeue behind the others
+        if (publisher_instance_run(inst, pool->quantum)) {
+            pool_push(pool, w, inst);
+        }
+    }
+
+    profiler_unregister_thread();
+    log_debug("Publisher pool worker %d exiting", w->index);
+    return NULL;
+}
+
+publisher_pool_t* publisher_pool_create(int threads, int quantum) {
+    if (threads <= 0) {
+        long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = ncpu > 0 ? (int)ncpu : 1;
+    }
+    if (quantum <= 0) quantum = PUBLISHER_POOL_DEFAULT_QUANTUM;
+
+    publisher_pool_t *pool = calloc(1, sizeof(publisher_pool_t));
+    if (!pool) return NULL;
+
+    pool->workers = calloc(threads, sizeof(pool_worker_t));
+    if (!pool->workers) {
+        free(pool);
+        return NULL;
+    }
+    pool->worker_count = threads;
+    pool->quantum = quantum;
+    pthread_mutex_init(&pool->mutex, NULL);
+    pthread_cond_init(&pool->cond, NULL);
+
+    for (int i = 0; i < threads; i++) {
+        pool_worker_t *w = &pool->workers[i];
+        w->pool = pool;
+        w->index = i;
+        pthread_mutex_init(&w->deque.mutex, NULL);
+    }
+
+    for (int i = 0; i < threads; i++) {
+        pool_worker_t *w = &pool->workers[i];
+        if (pthread_create(&w->thread, NULL, pool_worker_thread, w) != 0) {
+            log_error("Failed to start publisher pool worker %d", i);
+            publisher_pool_destroy(pool);
+            return NULL;
+        }
+        w->thread_started = 1;
+    }
+
+    log_info("Publisher pool started: %d worker(s), quantum %d events", threads, quantum);
+    return pool;
+}
+
+void publisher_pool_destroy(publisher_pool_t *pool) {
+    if (!pool) return;
+
+    pthread_mutex_lock(&pool->mutex);
+    pool->stop = 1;
+    pthread_cond_broadcast(&pool->cond);
+    pthread_mutex_unlock(&pool->mutex);
+
+    for (int i = 0; i < pool->worker_count; i++) {
+        pool_worker_t *w = &pool->workers[i];
+        if (w->thread_started) {
+            pthread_join(w->thread, NULL);
+        }
+        free(w->deque.items);
+        pthread_mutex_destroy(&w->deque.mutex);
+    }
+
+    pthread_mutex_destroy(&pool->mutex);
+    pthread_cond_destroy(&pool->cond);
+    free(pool->workers);
+    free(pool);
+}
+
+int publisher_pool_thread_count(const publisher_pool_t *pool) {
+    return pool ? pool->worker_count : 0;
+}
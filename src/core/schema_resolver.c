@@ -0,0 +1,432 @@
+// schema_resolver.c
+// Column metadata lookups off the binlog thread
+
+#include "schema_resolver.h"
+#include "logger.h"
+#include <mysql/mysql.h>
+#include <mysql/mysqld_error.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <time.h>
+
+#define SCHEMA_BUCKETS  256
+#define SCHEMA_RETRY_MIN_MS   250   // first retry of a failed lookup
+#define SCHEMA_RETRY_MAX_MS   30000
+
+typedef struct schema_entry {
+    char db[128];
+    char tbl[128];
+    int state;                      // SCHEMA_PENDING / SCHEMA_READY
+    schema_info_t info;
+    int attempts;                   // failed lookups so far
+    uint64_t retry_at;              // monotonic ms, 0 = now
+    struct schema_entry *next;      // bucket chain
+    struct schema_entry *queue_next;
+} schema_entry_t;
+
+typedef struct {
+    pthread_t thread;
+    MYSQL *conn;
+    int index;
+} resolver_worker_t;
+
+static schema_entry_t *buckets[SCHEMA_BUCKETS];
+static schema_entry_t *queue_head = NULL;
+static schema_entry_t *queue_tail = NULL;
+static pthread_mutex_t resolver_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t resolver_cond = PTHREAD_COND_INITIALIZER;     // work queued
+static pthread_cond_t resolved_cond = PTHREAD_COND_INITIALIZER;     // lookup done
+static resolver_worker_t *workers = NULL;
+static int worker_count = 0;
+static int resolver_stop = 0;
+static unsigned resolver_gen = 0;
+
+static char conn_host[256];
+static int conn_port;
+static char conn_user[128];
+static char conn_password[128];
+
+static uint64_t now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000 + (uint64_t)ts.tv_nsec / 1000000;
+}
+
+static unsigned bucket_of(const char *db, const char *tbl) {
+    unsigned h = 2166136261u;
+    for (const char *p = db; *p; p++) h = (h ^ (unsigned char)*p) * 16777619u;
+    h = (h ^ '.') * 16777619u;
+    for (const char *p = tbl; *p; p++) h = (h ^ (unsigned char)*p) * 16777619u;
+    return h % SCHEMA_BUCKETS;
+}
+
+// Caller holds resolver_mutex
+static schema_entry_t* entry_find(const char *db, const char *tbl) {
+    for (schema_entry_t *e = buckets[bucket_of(db, tbl)]; e; e = e->next) {
+        if (strcmp(e->db, db) == 0 && strcmp(e->tbl, tbl) == 0) return e;
+    }
+    return NULL;
+}
+
+static void info_free(schema_info_t *info) {
+    for (int i = 0; i < info->ncols; i++) {
+        free(info->names[i]);
+        if (info->enum_values && info->enum_values[i]) {
+            for (int j = 0; j < info->enum_counts[i]; j++) free(info->enum_values[i][j]);
+            free(info->enum_values[i]);
+        }
+    }
+    free(info->names);
+    free(info->binary);
+    free(info->is_unsigned);
+    free(info->enum_values);
+    free(info->enum_counts);
+    memset(info, 0, sizeof(*info));
+}
+
+int schema_parse_enum_type(const char *column_type, char ***values) {
+    *values = NULL;
+    const char *p = column_type ? strchr(column_type, '(') : NULL;
+    const char *end = column_type ? strrchr(column_type, ')') : NULL;
+    if (!p || !end || end <= p + 1) return 0;
+    p++;
+
+    int count = 0;
+    for (const char *q = p; q < end; ) {
+        const char *s = strchr(q, '\'');
+        if (!s || s >= end) break;
+        const char *e = strchr(s + 1, '\'');
+        if (!e || e >= end) break;
+        count++;
+        q = e + 1;
+    }
+    if (count == 0) return 0;
+
+    char **out = calloc(count, sizeof(char*));
+    if (!out) return 0;
+
+    int n = 0;
+    for (const char *q = p; q < end && n < count; ) {
+        const char *s = strchr(q, '\'');
+        if (!s || s >= end) break;
+        const char *e = strchr(s + 1, '\'');
+        if (!e || e >= end) break;
+        out[n] = strndup(s + 1, (size_t)(e - (s + 1)));
+        if (!out[n]) break;
+        n++;
+        q = e + 1;
+    }
+    *values = out;
+    return n;
+}
+
+static MYSQL* worker_connect(resolver_worker_t *w) {
+    if (w->conn && mysql_ping(w->conn) == 0) return w->conn;
+    if (w->conn) mysql_close(w->conn);
+
+    w->conn = mysql_init(NULL);
+    if (!w->conn) return NULL;
+    if (!mysql_real_connect(w->conn, conn_host, conn_user, conn_password,
+                            NULL, conn_port, NULL, 0)) {
+        log_warn("Schema resolver %d: connect failed: %s", w->index, mysql_error(w->conn));
+        mysql_close(w->conn);
+        w->conn = NULL;
+    }
+    return w->conn;
+}
+
+// Names, binary and signedness flags in table order, then ENUM/SET values.
+// Returns 0 on success, -1 if the lookup should be retried and 1 if the
+// table no longer exists (info left empty).
+static int resolve_table(MYSQL *conn, const char *db, const char *tbl, schema_info_t *info) {
+    char query[1024];
+    snprintf(query, sizeof(query), "SELECT * FROM `%s`.`%s` LIMIT 0", db, tbl);
+    if (mysql_query(conn, query) != 0) {
+        unsigned err = mysql_errno(conn);
+        log_warn("Cannot get column names for %s.%s: %s", db, tbl, mysql_error(conn));
+        return (err == ER_NO_SUCH_TABLE || err == ER_BAD_DB_ERROR) ? 1 : -1;
+    }
+    MYSQL_RES *res = mysql_store_result(conn);
+    if (!res) return -1;
+
+    int n = (int)mysql_num_fields(res);
+    info->names = calloc(n ? n : 1, sizeof(char*));
+    info->binary = calloc(n ? n : 1, 1);
+    info->is_unsigned = calloc(n ? n : 1, 1);
+    info->enum_values = calloc(n ? n : 1, sizeof(char**));
+    info->enum_counts = calloc(n ? n : 1, sizeof(int));
+    if (!info->names || !info->binary || !info->is_unsigned ||
+        !info->enum_values || !info->enum_counts) {
+        mysql_free_result(res);
+        info_free(info);
+        return -1;
+    }
+
+    MYSQL_FIELD *fields = mysql_fetch_fields(res);
+    for (int i = 0; i < n; i++) {
+        info->names[i] = strdup(fields[i].name);
+        info->binary[i] = (fields[i].charsetnr == 63);
+        info->is_unsigned[i] = (fields[i].flags & UNSIGNED_FLAG) != 0;
+    }
+    info->ncols = n;
+    mysql_free_result(res);
+
+    char edb[257], etbl[257];
+    mysql_real_escape_string(conn, edb, db, strlen(db));
+    mysql_real_escape_string(conn, etbl, tbl, strlen(tbl));
+    snprintf(query, sizeof(query),
+             "SELECT COLUMN_NAME, COLUMN_TYPE FROM INFORMATION_SCHEMA.COLUMNS "
+             "WHERE TABLE_SCHEMA='%s' AND TABLE_NAME='%s' AND DATA_TYPE IN ('enum','set')",
+             edb, etbl);
+    if (mysql_query(conn, query) != 0) {
+        log_warn("Failed to get ENUM definitions for %s.%s: %s", db, tbl, mysql_error(conn));
+        info_free(info);
+        return -1;
+    }
+    res = mysql_store_result(conn);
+    if (!res) {
+        info_free(info);
+        return -1;
+    }
+
+    MYSQL_ROW row;
+    while ((row = mysql_fetch_row(res))) {
+        if (!row[0] || !row[1]) continue;
+        for (int i = 0; i < n; i++) {
+            if (info->names[i] && strcmp(info->names[i], row[0]) == 0 && !info->enum_values[i]) {
+                info->enum_counts[i] = schema_parse_enum_type(row[1], &info->enum_values[i]);
+                break;
+            }
+        }
+    }
+    mysql_free_result(res);
+    return 0;
+}
+
+// Caller holds resolver_mutex. Unlinks the first queued entry that is due;
+// otherwise sets *wait_ms to the time until the next one (-1 = queue empty).
+static schema_entry_t* queue_take(uint64_t now, int64_t *wait_ms) {
+    *wait_ms = -1;
+    schema_entry_t *prev = NULL;
+    for (schema_entry_t *e = queue_head; e; prev = e, e = e->queue_next) {
+        if (e->retry_at <= now) {
+            if (prev) prev->queue_next = e->queue_next;
+            else queue_head = e->queue_next;
+            if (queue_tail == e) queue_tail = prev;
+            e->queue_next = NULL;
+            return e;
+        }
+        int64_t left = (int64_t)(e->retry_at - now);
+        if (*wait_ms < 0 || left < *wait_ms) *wait_ms = left;
+    }
+    return NULL;
+}
+
+// Caller holds resolver_mutex
+static void queue_push(schema_entry_t *e) {
+    e->queue_next = NULL;
+    if (queue_tail) queue_tail->queue_next = e;
+    else queue_head = e;
+    queue_tail = e;
+}
+
+static void* resolver_thread(void *arg) {
+    resolver_worker_t *w = (resolver_worker_t*)arg;
+    mysql_thread_init();
+
+    pthread_mutex_lock(&resolver_mutex);
+    while (1) {
+        schema_entry_t *e = NULL;
+        while (!resolver_stop) {
+            int64_t wait_ms;
+            if ((e = queue_take(now_ms(), &wait_ms))) break;
+            if (wait_ms < 0) {
+                pthread_cond_wait(&resolver_cond, &resolver_mutex);
+            } else {
+                // Only failed lookups are waiting for their retry time
+                struct timespec deadline;
+                clock_gettime(CLOCK_REALTIME, &deadline);
+                deadline.tv_sec += wait_ms / 1000;
+                deadline.tv_nsec += (long)(wait_ms % 1000) * 1000000L;
+                if (deadline.tv_nsec >= 1000000000L) {
+                    deadline.tv_sec++;
+                    deadline.tv_nsec -= 1000000000L;
+                }
+                pthread_cond_timedwait(&resolver_cond, &resolver_mutex, &deadline);
+            }
+        }
+        if (resolver_stop) break;
+        pthread_mutex_unlock(&resolver_mutex);
+
+        // Entries are only freed by stop/invalidate, never while PENDING
+        schema_info_t info = {0};
+        struct timespec t0, t1;
+        clock_gettime(CLOCK_MONOTONIC, &t0);
+        MYSQL *conn = worker_connect(w);
+        int rc = conn ? resolve_table(conn, e->db, e->tbl, &info) : -1;
+        clock_gettime(CLOCK_MONOTONIC, &t1);
+        double ms = (t1.tv_sec - t0.tv_sec) * 1e3 + (t1.tv_nsec - t0.tv_nsec) / 1e6;
+
+        pthread_mutex_lock(&resolver_mutex);
+        if (rc < 0) {
+            // Rows of the table stay parked; never publish them without a schema
+            int delay = SCHEMA_RETRY_MIN_MS;
+            for (int i = 0; i < e->attempts && delay < SCHEMA_RETRY_MAX_MS; i++) delay *= 2;
+            if (delay > SCHEMA_RETRY_MAX_MS) delay = SCHEMA_RETRY_MAX_MS;
+            e->attempts++;
+            e->retry_at = now_ms() + (uint64_t)delay;
+            log_warn("Schema lookup of %s.%s failed (attempt %d), retrying in %d ms",
+                     e->db, e->tbl, e->attempts, delay);
+            queue_push(e);
+            continue;
+        }
+        if (rc > 0) {
+            // Dropped since the event was written: nothing left to wait for
+            log_warn("Table %s.%s no longer exists, its rows are published without column names",
+                     e->db, e->tbl);
+        }
+        log_debug("Resolved schema of %s.%s: %d column(s) in %.1f ms", e->db, e->tbl, info.ncols, ms);
+        e->info = info;
+        e->state = SCHEMA_READY;
+        __atomic_add_fetch(&resolver_gen, 1, __ATOMIC_RELEASE);
+        pthread_cond_broadcast(&resolved_cond);
+    }
+    pthread_mutex_unlock(&resolver_mutex);
+
+    if (w->conn) mysql_close(w->conn);
+    w->conn = NULL;
+    mysql_thread_end();
+    return NULL;
+}
+
+int schema_resolver_start(const char *host, int port, const char *user,
+                          const char *password, int threads) {
+    if (threads <= 0) return 0;
+
+    snprintf(conn_host, sizeof(conn_host), "%s", host);
+    snprintf(conn_user, sizeof(conn_user), "%s", user);
+    snprintf(conn_password, sizeof(conn_password), "%s", password);
+    conn_port = port;
+
+    workers = calloc(threads, sizeof(resolver_worker_t));
+    if (!workers) return -1;
+
+    for (int i = 0; i < threads; i++) {
+        workers[i].index = i;
+        if (pthread_create(&workers[i].thread, NULL, resolver_thread, &workers[i]) != 0) {
+            log_error("Failed to start schema resolver thread %d", i);
+            break;
+        }
+        worker_count++;
+    }
+    if (worker_count == 0) {
+        free(workers);
+        workers = NULL;
+        return -1;
+    }
+
+    log_info("Schema resolver started with %d thread(s)", worker_count);
+    return 0;
+}
+
+int schema_resolver_enabled(void) {
+    return worker_count > 0;
+}
+
+int schema_resolver_get(const char *db, const char *tbl, const schema_info_t **info) {
+    pthread_mutex_lock(&resolver_mutex);
+    schema_entry_t *e = entry_find(db, tbl);
+    if (!e) {
+        e = calloc(1, sizeof(schema_entry_t));
+        if (!e) {
+            pthread_mutex_unlock(&resolver_mutex);
+            return SCHEMA_PENDING;
+        }
+        snprintf(e->db, sizeof(e->db), "%s", db);
+        snprintf(e->tbl, sizeof(e->tbl), "%s", tbl);
+        e->state = SCHEMA_PENDING;
+
+        unsigned b = bucket_of(db, tbl);
+        e->next = buckets[b];
+        buckets[b] = e;
+
+        queue_push(e);
+        pthread_cond_signal(&resolver_cond);
+    }
+    int state = e->state;
+    if (state == SCHEMA_READY && info) *info = &e->info;
+    pthread_mutex_unlock(&resolver_mutex);
+    return state;
+}
+
+int schema_resolver_wait(const char *db, const char *tbl, int timeout_ms) {
+    struct timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += timeout_ms / 1000;
+    deadline.tv_nsec += (long)(timeout_ms % 1000) * 1000000L;
+    if (deadline.tv_nsec >= 1000000000L) {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000L;
+    }
+
+    pthread_mutex_lock(&resolver_mutex);
+    schema_entry_t *e = entry_find(db, tbl);
+    while (e && e->state == SCHEMA_PENDING && !resolver_stop) {
+        if (pthread_cond_timedwait(&resolved_cond, &resolver_mutex, &deadline) != 0) break;
+    }
+    int state = e ? e->state : SCHEMA_PENDING;
+    pthread_mutex_unlock(&resolver_mutex);
+    return state;
+}
+
+void schema_resolver_invalidate_db(const char *db) {
+    pthread_mutex_lock(&resolver_mutex);
+    for (int b = 0; b < SCHEMA_BUCKETS; b++) {
+        schema_entry_t **pp = &buckets[b];
+        while (*pp) {
+            schema_entry_t *e = *pp;
+            if (e->state == SCHEMA_READY && (!db || strcmp(e->db, db) == 0)) {
+                *pp = e->next;
+                info_free(&e->info);
+                free(e);
+            } else {
+                pp = &e->next;
+            }
+        }
+    }
+    pthread_mutex_unlock(&resolver_mutex);
+}
+
+unsigned schema_resolver_generation(void) {
+    return __atomic_load_n(&resolver_gen, __ATOMIC_ACQUIRE);
+}
+
+void schema_resolver_stop(void) {
+    if (worker_count == 0) return;
+
+    pthread_mutex_lock(&resolver_mutex);
+    resolver_stop = 1;
+    pthread_cond_broadcast(&resolver_cond);
+    pthread_cond_broadcast(&resolved_cond);
+    pthread_mutex_unlock(&resolver_mutex);
+
+    for (int i = 0; i < worker_count; i++) pthread_join(workers[i].thread, NULL);
+    free(workers);
+    workers = NULL;
+    worker_count = 0;
+
+    for (int b = 0; b < SCHEMA_BUCKETS; b++) {
+        schema_entry_t *e = buckets[b];
+        while (e) {
+            schema_entry_t *next = e->next;
+            info_free(&e->info);
+            free(e);
+            e = next;
+        }
+        buckets[b] = NULL;
+    }
+    queue_head = queue_tail = NULL;
+}
@@ -0,0 +1,263 @@
+// stage_profiler.c
+// Per-stage wall time and per-thread CPU accounting
+
+#include "stage_profiler.h"
+#include "metrics.h"
+#include "logger.h"
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+#include <time.h>
+
+#define PROFILER_MAX_THREADS 64
+
+static const char *stage_names[PROFILE_STAGE_COUNT] = {
+    "fetch", "decompress", "decode", "encode", "dispatch", "queue_wait", "publish"
+};
+
+// Counters are written only by the owning thread, so a relaxed store is
+// enough; one cache line per thread keeps the writers apart
+typedef struct {
+    uint64_t ns[PROFILE_STAGE_COUNT];
+    uint64_t calls[PROFILE_STAGE_COUNT];
+    char name[64];
+    clockid_t cpu_clock;
+    int alive;
+    double cpu_sec;         // last reading of the current thread
+    double cpu_base;        // earlier threads that had the same name
+    double cpu_prev;        // total at the previous summary
+} __attribute__((aligned(64))) profile_thread_t;
+
+static profile_thread_t threads[PROFILER_MAX_THREADS];
+static int thread_count = 0;
+
+// Unregistered threads share this one and add atomically
+static profile_thread_t shared_slot;
+
+static __thread profile_thread_t *tls_thread = NULL;
+static __thread uint64_t tls_child = 0;
+
+static int profiler_enabled = 0;
+static int profiler_interval = 0;
+static uint64_t stage_prev_ns[PROFILE_STAGE_COUNT];
+static uint64_t stage_prev_calls[PROFILE_STAGE_COUNT];
+static struct timespec report_prev;
+
+static pthread_mutex_t profiler_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t profiler_cond = PTHREAD_COND_INITIALIZER;
+static pthread_t profiler_thread;
+static int profiler_thread_started = 0;
+static int profiler_stop = 0;
+
+static inline uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC_RAW, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static double clock_seconds(clockid_t clock) {
+    struct timespec ts;
+    if (clock_gettime(clock, &ts) != 0) return -1;
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+void profiler_begin(profile_span_t *span) {
+    if (!profiler_enabled) {
+        span->start = 0;
+        return;
+    }
+    span->child = tls_child;
+    tls_child = 0;
+    span->start = now_ns();
+}
+
+void profiler_end(profile_span_t *span, profile_stage_t stage) {
+    if (!span->start) return;
+
+    uint64_t elapsed = now_ns() - span->start;
+    uint64_t self = elapsed > tls_child ? elapsed - tls_child : 0;
+    tls_child = span->child + elapsed;
+
+    profile_thread_t *t = tls_thread;
+    if (t) {
+        __atomic_store_n(&t->ns[stage], t->ns[stage] + self, __ATOMIC_RELAXED);
+        __atomic_store_n(&t->calls[stage], t->calls[stage] + 1, __ATOMIC_RELAXED);
+    } else {
+        __atomic_fetch_add(&shared_slot.ns[stage], self, __ATOMIC_RELAXED);
+        __atomic_fetch_add(&shared_slot.calls[stage], 1, __ATOMIC_RELAXED);
+    }
+}
+
+void profiler_register_thread(const char *name) {
+    if (!profiler_enabled || !name) return;
+
+    clockid_t clock;
+    if (pthread_getcpuclockid(pthread_self(), &clock) != 0) return;
+
+    pthread_mutex_lock(&profiler_mutex);
+
+    // A restarted thread continues the series of its predecessor
+    profile_thread_t *t = NULL;
+    for (int i = 0; i < thread_count; i++) {
+        if (!threads[i].alive && strcmp(threads[i].name, name) == 0) {
+            t = &threads[i];
+            t->cpu_base += t->cpu_sec;
+            t->cpu_sec = 0;
+            break;
+        }
+    }
+    if (!t && thread_count < PROFILER_MAX_THREADS) {
+        t = &threads[thread_count++];
+        snprintf(t->name, sizeof(t->name), "%s", name);
+    }
+    if (t) {
+        t->cpu_clock = clock;
+        t->alive = 1;
+        tls_thread = t;
+    } else {
+        log_warn("Profiler: too many threads, %s is not tracked", name);
+    }
+
+    pthread_mutex_unlock(&profiler_mutex);
+}
+
+void profiler_unregister_thread(void) {
+    profile_thread_t *t = tls_thread;
+    if (!t) return;
+
+    // Last reading while the clock is still valid
+    double cpu = clock_seconds(CLOCK_THREAD_CPUTIME_ID);
+
+    pthread_mutex_lock(&profiler_mutex);
+    if (cpu >= 0) t->cpu_sec = cpu;
+    t->alive = 0;
+    pthread_mutex_unlock(&profiler_mutex);
+
+    tls_thread = NULL;
+}
+
+// Export the counters and log what changed since the previous call
+static void profiler_report(void) {
+    uint64_t ns[PROFILE_STAGE_COUNT];
+    uint64_t calls[PROFILE_STAGE_COUNT];
+    char line[2048];
+    int len = 0;
+
+    pthread_mutex_lock(&profiler_mutex);
+
+    for (int s = 0; s < PROFILE_STAGE_COUNT; s++) {
+        ns[s] = __atomic_load_n(&shared_slot.ns[s], __ATOMIC_RELAXED);
+        calls[s] = __atomic_load_n(&shared_slot.calls[s], __ATOMIC_RELAXED);
+        for (int i = 0; i < thread_count; i++) {
+            ns[s] += __atomic_load_n(&threads[i].ns[s], __ATOMIC_RELAXED);
+            calls[s] += __atomic_load_n(&threads[i].calls[s], __ATOMIC_RELAXED);
+        }
+    }
+
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    double period = (now.tv_sec - report_prev.tv_sec) +
+                    (now.tv_nsec - report_prev.tv_nsec) / 1e9;
+    report_prev = now;
+
+    len += snprintf(line + len, sizeof(line) - len, "Profile %.0fs:", period);
+    for (int s = 0; s < PROFILE_STAGE_COUNT; s++) {
+        char labels[64];
+        snprintf(labels, sizeof(labels), "stage=\"%s\"", stage_names[s]);
+        metrics_set("binlog_stage_seconds_total", labels, ns[s] / 1e9);
+        metrics_set("binlog_stage_calls_total", labels, (double)calls[s]);
+
+        if (len < (int)sizeof(line)) {
+            len += snprintf(line + len, sizeof(line) - len, " %s=%.3fs/%llu",
+                            stage_names[s], (ns[s] - stage_prev_ns[s]) / 1e9,
+                            (unsigned long long)(calls[s] - stage_prev_calls[s]));
+        }
+        stage_prev_ns[s] = ns[s];
+        stage_prev_calls[s] = calls[s];
+    }
+
+    if (len < (int)sizeof(line)) len += snprintf(line + len, sizeof(line) - len, " | cpu");
+    for (int i = 0; i < thread_count; i++) {
+        profile_thread_t *t = &threads[i];
+        if (t->alive) {
+            double cpu = clock_seconds(t->cpu_clock);
+            if (cpu >= 0) t->cpu_sec = cpu;
+        }
+        double total = t->cpu_base + t->cpu_sec;
+
+        char labels[128];
+        snprintf(labels, sizeof(labels), "thread=\"%s\"", t->name);
+        metrics_set("binlog_thread_cpu_seconds_total", labels, total);
+
+        if (len < (int)sizeof(line)) {
+            len += snprintf(line + len, sizeof(line) - len, " %s=%.3fs",
+                            t->name, total - t->cpu_prev);
+        }
+        t->cpu_prev = total;
+    }
+
+    pthread_mutex_unlock(&profiler_mutex);
+
+    log_info("%s", line);
+}
+
+static void* profiler_reporter_thread(void *arg) {
+    (void)arg;
+
+    pthread_mutex_lock(&profiler_mutex);
+    while (!profiler_stop) {
+        struct timespec ts;
+        clock_gettime(CLOCK_REALTIME, &ts);
+        ts.tv_sec += profiler_interval;
+        pthread_cond_timedwait(&profiler_cond, &profiler_mutex, &ts);
+        if (profiler_stop) break;
+
+        pthread_mutex_unlock(&profiler_mutex);
+        profiler_report();
+        pthread_mutex_lock(&profiler_mutex);
+    }
+    pthread_mutex_unlock(&profiler_mutex);
+    return NULL;
+}
+
+int profiler_init(int enabled, int interval_sec) {
+    if (!enabled) return 0;
+
+    profiler_enabled = 1;
+    profiler_interval = interval_sec;
+    clock_gettime(CLOCK_MONOTONIC, &report_prev);
+
+    metrics_describe("binlog_stage_seconds_total", METRICS_COUNTER,
+                     "Wall time spent in each pipeline stage, nested stages excluded");
+    metrics_describe("binlog_stage_calls_total", METRICS_COUNTER,
+                     "Number of timed spans per pipeline stage");
+    metrics_describe("binlog_thread_cpu_seconds_total", METRICS_COUNTER,
+                     "CPU time consumed by each stream and publisher thread");
+
+    if (interval_sec > 0) {
+        if (pthread_create(&profiler_thread, NULL, profiler_reporter_thread, NULL) != 0) {
+            log_error("Failed to start profiler thread");
+            return -1;
+        }
+        profiler_thread_started = 1;
+    }
+
+    log_info("Stage profiling enabled (summary every %d s)", interval_sec);
+    return 0;
+}
+
+void profiler_shutdown(void) {
+    if (!profiler_enabled) return;
+
+    if (profiler_thread_started) {
+        pthread_mutex_lock(&profiler_mutex);
+        profiler_stop = 1;
+        pthread_cond_signal(&profiler_cond);
+        pthread_mutex_unlock(&profiler_mutex);
+        pthread_join(profiler_thread, NULL);
+        profiler_thread_started = 0;
+    }
+
+    profiler_report();
+    profiler_enabled = 0;
+}
@@ -0,0 +1,112 @@
+// stat_counters.c
+// Per-thread statistics counters with consistent snapshots
+
+#include "stat_counters.h"
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+
+#define STAT_SLOTS 64               // threads with a slot of their own
+
+// Written only by the thread owning the slot: plain stores between two
+// bumps of seq (odd while writing)
+typedef struct {
+    uint64_t seq;
+    uint64_t value[STAT_COUNTERS_MAX];
+} __attribute__((aligned(64))) stat_slot_t;
+
+struct stat_counters {
+    int count;
+    stat_slot_t slots[STAT_SLOTS];
+    stat_slot_t shared;             // threads beyond STAT_SLOTS add atomically
+};
+
+// Slot index of the calling thread, the same in every counter set; freed
+// when the thread exits
+static uint64_t slots_used = 0;
+static pthread_key_t slot_key;
+static pthread_once_t slot_once = PTHREAD_ONCE_INIT;
+static __thread int tls_slot = -1;
+
+static void slot_release(void *arg) {
+    int slot = (int)(intptr_t)arg - 1;
+    __atomic_fetch_and(&slots_used, ~(1ULL << slot), __ATOMIC_RELEASE);
+}
+
+static void slot_key_create(void) {
+    pthread_key_create(&slot_key, slot_release);
+}
+
+static int slot_claim(void) {
+    pthread_once(&slot_once, slot_key_create);
+    uint64_t used = __atomic_load_n(&slots_used, __ATOMIC_RELAXED);
+    while (~used) {
+        int slot = __builtin_ctzll(~used);
+        if (__atomic_compare_exchange_n(&slots_used, &used, used | (1ULL << slot), 0,
+                                        __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+            pthread_setspecific(slot_key, (void*)(intptr_t)(slot + 1));
+            return slot;
+        }
+    }
+    return STAT_SLOTS;
+}
+
+stat_counters_t* stat_counters_create(int count) {
+    if (count < 1 || count > STAT_COUNTERS_MAX) return NULL;
+    stat_counters_t *c = NULL;
+    if (posix_memalign((void**)&c, 64, sizeof(stat_counters_t)) != 0) return NULL;
+    memset(c, 0, sizeof(*c));
+    c->count = count;
+    return c;
+}
+
+void stat_counters_destroy(stat_counters_t *c) {
+    free(c);
+}
+
+void stat_counters_add(stat_counters_t *c, int counter, uint64_t delta) {
+    if (!c || counter < 0 || counter >= c->count) return;
+    if (tls_slot < 0) tls_slot = slot_claim();
+
+    if (tls_slot == STAT_SLOTS) {
+        __atomic_fetch_add(&c->shared.value[counter], delta, __ATOMIC_RELAXED);
+        return;
+    }
+
+    stat_slot_t *s = &c->slots[tls_slot];
+    uint64_t seq = s->seq;
+    __atomic_store_n(&s->seq, seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    __atomic_store_n(&s->value[counter], s->value[counter] + delta, __ATOMIC_RELAXED);
+    __atomic_store_n(&s->seq, seq + 2, __ATOMIC_RELEASE);
+}
+
+void stat_counters_snapshot(const stat_counters_t *c, uint64_t *out) {
+    if (!c) return;
+    uint64_t v[STAT_COUNTERS_MAX];
+
+    for (int k = 0; k < c->count; k++) {
+        out[k] = __atomic_load_n(&c->shared.value[k], __ATOMIC_RELAXED);
+    }
+    for (int i = 0; i < STAT_SLOTS; i++) {
+        const stat_slot_t *s = &c->slots[i];
+        uint64_t seq;
+        int spins = 0;
+        while (1) {
+            seq = __atomic_load_n(&s->seq, __ATOMIC_ACQUIRE);
+            if (seq == 0) break;            // never written
+            if (!(seq & 1)) {
+                for (int k = 0; k < c->count; k++) {
+                    v[k] = __atomic_load_n(&s->value[k], __ATOMIC_RELAXED);
+                }
+                __atomic_thread_fence(__ATOMIC_ACQUIRE);
+                if (__atomic_load_n(&s->seq, __ATOMIC_RELAXED) == seq) break;
+            }
+            // Owner is mid-update; let it finish
+            if (++spins > 64) sched_yield();
+        }
+        if (seq == 0) continue;
+        for (int k = 0; k < c->count; k++) out[k] += v[k];
+    }
+}
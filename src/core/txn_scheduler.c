@@ -0,0 +1,136 @@
+// txn_scheduler.c
+// Logical-clock transaction scheduler for parallel sinks
+
+#include "txn_scheduler.h"
+#include <stdlib.h>
+#include <pthread.h>
+
+typedef struct {
+    int64_t seq;
+    int done;
+} txn_slot_t;
+
+// In-flight transactions in dispatch (= sequence) order. Completed entries
+// stay in place until everything before them has completed too, so the head
+// is always the oldest transaction still running.
+struct txn_scheduler {
+    txn_slot_t *ring;
+    int head, count, capacity;
+    int64_t last_dispatched;
+    int stop;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+};
+
+txn_scheduler_t* txn_scheduler_create(int window) {
+    if (window <= 0) window = TXN_SCHEDULER_DEFAULT_WINDOW;
+
+    txn_scheduler_t *s = calloc(1, sizeof(txn_scheduler_t));
+    if (!s) return NULL;
+
+    s->ring = calloc(window, sizeof(txn_slot_t));
+    if (!s->ring) {
+        free(s);
+        return NULL;
+    }
+    s->capacity = window;
+    pthread_mutex_init(&s->mutex, NULL);
+    pthread_cond_init(&s->cond, NULL);
+    return s;
+}
+
+void txn_scheduler_destroy(txn_scheduler_t *s) {
+    if (!s) return;
+    pthread_mutex_destroy(&s->mutex);
+    pthread_cond_destroy(&s->cond);
+    free(s->ring);
+    free(s);
+}
+
+// Oldest in-flight sequence number, 0 when nothing is running; caller holds mutex
+static int64_t oldest_in_flight(const txn_scheduler_t *s) {
+    return s->count > 0 ? s->ring[s->head].seq : 0;
+}
+
+int txn_scheduler_wait_ready(txn_scheduler_t *s, int64_t last_committed) {
+    if (!s) return -1;
+
+    pthread_mutex_lock(&s->mutex);
+    while (!s->stop) {
+        int64_t oldest = oldest_in_flight(s);
+        if ((oldest == 0 || oldest > last_committed) && s->count < s->capacity) break;
+        pthread_cond_wait(&s->cond, &s->mutex);
+    }
+    int rc = s->stop ? -1 : 0;
+    pthread_mutex_unlock(&s->mutex);
+    return rc;
+}
+
+int txn_scheduler_dispatched(txn_scheduler_t *s, int64_t sequence_number) {
+    if (!s) return -1;
+
+    pthread_mutex_lock(&s->mutex);
+    if (sequence_number <= s->last_dispatched) {
+        pthread_mutex_unlock(&s->mutex);
+        return -1;
+    }
+    // Normally wait_ready() made room already; never drop a transaction
+    while (s->count >= s->capacity && !s->stop) {
+        pthread_cond_wait(&s->cond, &s->mutex);
+    }
+    if (s->stop) {
+        pthread_mutex_unlock(&s->mutex);
+        return -1;
+    }
+    txn_slot_t *slot = &s->ring[(s->head + s->count) % s->capacity];
+    slot->seq = sequence_number;
+    slot->done = 0;
+    s->count++;
+    s->last_dispatched = sequence_number;
+    pthread_mutex_unlock(&s->mutex);
+    return 0;
+}
+
+void txn_scheduler_complete(txn_scheduler_t *s, int64_t sequence_number) {
+    if (!s) return;
+
+    pthread_mutex_lock(&s->mutex);
+    for (int i = 0; i < s->count; i++) {
+        txn_slot_t *slot = &s->ring[(s->head + i) % s->capacity];
+        if (slot->seq == sequence_number) {
+            slot->done = 1;
+            break;
+        }
+    }
+
+    int advanced = 0;
+    while (s->count > 0 && s->ring[s->head].done) {
+        s->head = (s->head + 1) % s->capacity;
+        s->count--;
+        advanced = 1;
+    }
+    if (advanced) pthread_cond_broadcast(&s->cond);
+    pthread_mutex_unlock(&s->mutex);
+}
+
+void txn_scheduler_drain(txn_scheduler_t *s) {
+    if (!s) return;
+
+    pthread_mutex_lock(&s->mutex);
+    while (s->count > 0 && !s->stop) {
+        pthread_cond_wait(&s->cond, &s->mutex);
+    }
+    s->head = 0;
+    s->count = 0;
+    s->last_dispatched = 0;
+    pthread_mutex_unlock(&s->mutex);
+}
+
+void txn_scheduler_shutdown(txn_scheduler_t *s) {
+    if (!s) return;
+
+    pthread_mutex_lock(&s->mutex);
+    s->stop = 1;
+    pthread_cond_broadcast(&s->cond);
+    pthread_mutex_unlock(&s->mutex);
+}
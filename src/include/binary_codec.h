@@ -0,0 +1,38 @@
+// binary_codec.h
+// Binary column encoders (base64, hex), SHA-256 and a content-addressed
+// blob store used to keep large BLOB/GEOMETRY values out of event payloads
+
+#ifndef BINARY_CODEC_H
+#define BINARY_CODEC_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define SHA256_DIGEST_LEN   32
+#define SHA256_HEX_LEN      64
+
+// Encoded sizes (without terminating NUL)
+#define BASE64_ENCODED_LEN(n)   ((((n) + 2) / 3) * 4)
+#define HEX_ENCODED_LEN(n)      ((n) * 2)
+
+// Encode len bytes of src as standard padded base64 into dst. dst must hold
+// BASE64_ENCODED_LEN(len) + 1 bytes. Uses SSSE3 when the CPU supports it.
+// Returns the number of characters written.
+size_t base64_encode(const unsigned char *src, size_t len, char *dst);
+
+// Encode len bytes of src as lowercase hex into dst (HEX_ENCODED_LEN + 1)
+size_t hex_encode(const unsigned char *src, size_t len, char *dst);
+
+// SHA-256 of len bytes of data
+void sha256(const void *data, size_t len, unsigned char out[SHA256_DIGEST_LEN]);
+
+// Store data under <dir>/<h0h1>/<sha256 hex> unless it already exists.
+// Writes the hex digest to hex_out (SHA256_HEX_LEN + 1 bytes).
+// Returns 0 on success, -1 on error.
+int blob_store_put(const char *dir, const unsigned char *data, size_t len,
+                   char hex_out[SHA256_HEX_LEN + 1]);
+
+// Name of the base64 implementation selected at runtime ("ssse3"/"scalar")
+const char* base64_impl_name(void);
+
+#endif
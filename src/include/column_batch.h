@@ -0,0 +1,54 @@
+// column_batch.h
+// Builder for columnar rows batches (cdc_column_batch_t)
+//
+// The rows decoder appends values column by column, row by row, straight
+// from the binlog row image; nothing is formatted as text. Each column grows
+// its own validity bitmap, 8 byte value vector or offsets + data buffers.
+// column_batch_finish() exposes the buffers through the plugin API structs
+// without copying them.
+
+#ifndef COLUMN_BATCH_H
+#define COLUMN_BATCH_H
+
+#include "publisher_api.h"
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct column_batch column_batch_t;
+
+#define COLUMN_BATCH_AFTER   0      // columns: the row, or the after image
+#define COLUMN_BATCH_BEFORE  1      // before_columns, UPDATE only
+
+// Columns of both images are declared up front; before_count is 0 unless
+// kind is CDC_ROWS_UPDATE
+column_batch_t* column_batch_create(int kind, int column_count, int before_count);
+void column_batch_free(column_batch_t *b);
+
+// Declare column idx of an image (name is copied)
+void column_batch_set_column(column_batch_t *b, int image, int idx,
+                             const char *name, int type, int mysql_type);
+
+// Append the next value of a column. Each returns -1 on allocation failure.
+int column_batch_append_null(column_batch_t *b, int image, int idx);
+int column_batch_append_int(column_batch_t *b, int image, int idx, int64_t v);
+int column_batch_append_double(column_batch_t *b, int image, int idx, double v);
+int column_batch_append_bytes(column_batch_t *b, int image, int idx,
+                              const void *data, size_t len);
+
+// Close the current row: every column must have received exactly one value
+void column_batch_end_row(column_batch_t *b);
+
+// Drop the values appended since the last end_row (row failed to decode)
+void column_batch_abort_row(column_batch_t *b);
+
+int column_batch_rows(const column_batch_t *b);
+
+// Publish view of the batch; the caller fills in db, table, txn and position.
+// Valid until column_batch_free().
+cdc_column_batch_t* column_batch_finish(column_batch_t *b);
+
+// The finished view; the batch is read-only from here on and may be shared
+// by several publisher threads
+const cdc_column_batch_t* column_batch_view(const column_batch_t *b);
+
+#endif // COLUMN_BATCH_H
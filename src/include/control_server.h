@@ -0,0 +1,29 @@
+// control_server.h
+// Local control socket: delivered watermarks, read-your-writes waits and
+// publisher counters
+//
+// Line protocol on a unix stream socket, one reply line per command:
+//   WATERMARK [publisher]
+//       {"watermarks":[{"publisher":...,"binlog_file":...,"position":N,
+//                       "gtid":[{"source":...,"seq":N}]}]}
+//   WAIT_FOR <gtid|binlog_file:position> <publisher> <timeout_ms>
+//       OK | TIMEOUT | ERR <reason>
+//   STATS [publisher]
+//       {"stats":[{"publisher":...,"published":N,"dropped":N,"errors":N,
+//                  "plugin":{<get_stats counters>}}]}
+// WAIT_FOR returns as soon as the publisher has acknowledged the point, so
+// a service can wait for its own write instead of sleeping.
+
+#ifndef CONTROL_SERVER_H
+#define CONTROL_SERVER_H
+
+#include "publisher_loader.h"
+
+// Listen on path with the given permissions (<= 0: 0600). An existing
+// socket file is replaced; any other file there is an error.
+int control_server_start(const char *path, int max_clients, int mode, publisher_manager_t *manager);
+
+// Release waiting clients and stop; call before the publishers are destroyed
+void control_server_stop(void);
+
+#endif // CONTROL_SERVER_H
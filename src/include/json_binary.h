@@ -0,0 +1,25 @@
+// json_binary.h
+// Decoder for MySQL's binary JSON column format and for the JSON diffs
+// logged by PARTIAL_UPDATE_ROWS_EVENT (binlog_row_value_options=PARTIAL_JSON)
+//
+// All writers follow snprintf: at most size bytes are written, the output is
+// NUL terminated, and the return value is the full length the text needs so
+// the caller can retry with a larger buffer. -1 means the input is malformed.
+
+#ifndef JSON_BINARY_H
+#define JSON_BINARY_H
+
+#include <stddef.h>
+
+// JSON text of a binary JSON value (an empty value is JSON null)
+long json_binary_to_text(const unsigned char *data, size_t len, char *out, size_t size);
+
+// The diffs of a partial JSON value as a JSON Patch (RFC 6902) array
+long json_diff_to_patch(const unsigned char *diff, size_t len, char *out, size_t size);
+
+// Apply the diffs to the binary JSON value of the before image and write
+// the resulting document
+long json_diff_apply(const unsigned char *before, size_t before_len,
+                     const unsigned char *diff, size_t len, char *out, size_t size);
+
+#endif // JSON_BINARY_H
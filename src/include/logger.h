@@ -43,6 +43,7 @@ enum { LOG_TRACE, LOG_DEBUG, LOG_INFO, LOG_WARN, LOG_ERROR, LOG_FATAL };
 const char* log_level_string(int level);
 void log_set_lock(log_LockFn fn, void *udata);
 void log_set_level(int level);
+int  log_get_level(void);
 void log_set_quiet(bool enable);
 int  log_add_callback(log_LogFn fn, void *udata, int level);
 int  log_add_fp(FILE *fp, int level);
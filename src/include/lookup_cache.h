@@ -0,0 +1,35 @@
+// lookup_cache.h
+// Compact in-memory hash index for row enrichment
+//
+// Maps a key string to a fixed number of value strings. Each entry is a
+// single allocation holding the key and its values back to back, indexed
+// by an open addressing table with linear probing. Used from the binlog
+// thread only, so there is no locking.
+
+#ifndef LOOKUP_CACHE_H
+#define LOOKUP_CACHE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct lookup_cache lookup_cache_t;
+
+lookup_cache_t* lookup_cache_create(int value_count);
+void lookup_cache_destroy(lookup_cache_t *c);
+
+// Insert or replace the values of key. Returns -1 on allocation failure.
+int lookup_cache_put(lookup_cache_t *c, const char *key, size_t key_len,
+                     const char *const *values, const size_t *value_lens);
+
+// Fill values[0..value_count) with pointers into the entry. Returns 0 when
+// found, -1 otherwise. Pointers are valid until the next put/remove/clear.
+int lookup_cache_get(const lookup_cache_t *c, const char *key, size_t key_len,
+                     const char **values);
+
+void lookup_cache_remove(lookup_cache_t *c, const char *key, size_t key_len);
+void lookup_cache_clear(lookup_cache_t *c);
+
+size_t lookup_cache_count(const lookup_cache_t *c);
+size_t lookup_cache_bytes(const lookup_cache_t *c);   // approximate footprint
+
+#endif // LOOKUP_CACHE_H
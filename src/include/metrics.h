@@ -0,0 +1,30 @@
+// metrics.h
+// Process metrics exported in Prometheus text format
+//
+// Values are kept in a small in-process registry and written periodically
+// to a file (for the node_exporter textfile collector or a sidecar).
+
+#ifndef METRICS_H
+#define METRICS_H
+
+#define METRICS_GAUGE    0
+#define METRICS_COUNTER  1
+
+// Start the registry; path == NULL or "" keeps metrics in memory only.
+// interval_sec <= 0 disables the periodic writer.
+int metrics_init(const char *path, int interval_sec);
+
+// Declare HELP/TYPE for a metric family (optional)
+void metrics_describe(const char *name, int type, const char *help);
+
+// labels is the inside of {...}, e.g. "publisher=\"kafka\"", or NULL
+void metrics_set(const char *name, const char *labels, double value);
+void metrics_add(const char *name, const char *labels, double delta);
+
+// Write all metrics to path now (atomically via rename)
+int metrics_write(const char *path);
+
+// Stop the writer, write a final snapshot and free the registry
+void metrics_shutdown(void);
+
+#endif // METRICS_H
@@ -0,0 +1,30 @@
+// plugin_host.h
+// Out-of-process publisher host
+//
+// A publisher configured with "isolation": "process" is not loaded into the
+// streamer. The core re-executes itself as "<exe> --plugin-host <fd>"; that
+// host process loads the plugin through the normal plugin API and receives
+// events through a shared memory ring. Acks come back on a second ring and
+// free the space of the events they cover.
+//
+// A supervisor thread in the core restarts a host that dies and replays the
+// events it had not acknowledged, so delivery is at-least-once. GC pauses,
+// crashes and memory growth of the plugin stay in the host process.
+
+#ifndef PLUGIN_HOST_H
+#define PLUGIN_HOST_H
+
+#include "publisher_loader.h"
+
+#define PLUGIN_HOST_ARG "--plugin-host"
+
+// Install the proxy plugin on inst instead of dlopen'ing its library. The
+// regular init/start/publish/stop callbacks then drive the host process;
+// events count as published once the host acks them. Columnar output
+// profiles are refused when the config is loaded.
+int plugin_host_attach(publisher_instance_t *inst);
+
+// Entry point of the host process (argv[1] == PLUGIN_HOST_ARG)
+int plugin_host_main(int argc, char **argv);
+
+#endif // PLUGIN_HOST_H
@@ -12,13 +12,17 @@
 #include <stddef.h>
 #include <stdint.h>
 
-// API version for compatibility checking
-#define PUBLISHER_API_VERSION 1
+// API version for compatibility checking. Version 2 appended
+// publish_columnar and get_stats to publisher_callbacks_t; the core reads
+// them only from plugins that report version 2 or later.
+#define PUBLISHER_API_VERSION 2
+#define PUBLISHER_API_VERSION_MIN 1     // oldest version the core still loads
 
 // Forward declarations
 typedef struct publisher_plugin publisher_plugin_t;
 typedef struct cdc_event cdc_event_t;
 typedef struct publisher_config publisher_config_t;
+struct txn_scheduler;
 
 // CDC Event structure passed to publishers
 struct cdc_event {
@@ -28,8 +32,63 @@ struct cdc_event {
     const char *txn;          // Transaction ID
     uint64_t position;        // Binlog position
     const char *binlog_file;  // Binlog file name
+    // MySQL logical clock of the transaction (0 = unknown, e.g. MariaDB or
+    // no GTID). sequence_number restarts with each binlog file.
+    int64_t last_committed;
+    int64_t sequence_number;
+    uint32_t timestamp;       // binlog event time, seconds since the epoch (0 = unknown)
+    // Routing metadata, also found in the JSON body. Transports may carry it
+    // out of band so consumers can route without parsing the payload.
+    const char *type;         // "INSERT", "UPDATE", "DELETE", "COMMIT", DDL kind; NULL = unknown
+    const char *key;          // primary key as a JSON array, only for one row messages
+                              // to publishers with "routing_key" set; NULL = none
 };
 
+// Columnar rows delivery
+//
+// Publishers whose output profile uses "format": "columnar" receive each
+// rows event as a batch of typed column vectors instead of a JSON string.
+// Only captured (projected) columns present in the row image are included.
+// Buffers follow the Arrow layout and are valid for the duration of the
+// publish_columnar call only.
+#define CDC_COL_INT64      0    // int64_t values
+#define CDC_COL_UINT64     1    // uint64_t values (BIGINT UNSIGNED, BIT)
+#define CDC_COL_DOUBLE     2    // double values (FLOAT, DOUBLE)
+#define CDC_COL_STRING     3    // offsets + data, text (also DECIMAL, DATE, TIME, SET)
+#define CDC_COL_BINARY     4    // offsets + data, raw bytes (BLOB, GEOMETRY: SRID + WKB)
+#define CDC_COL_TIMESTAMP  5    // int64_t microseconds since the epoch, UTC
+#define CDC_COL_DATETIME   6    // int64_t microseconds since the epoch, wall clock without zone
+
+#define CDC_ROWS_INSERT    0
+#define CDC_ROWS_UPDATE    1
+#define CDC_ROWS_DELETE    2
+
+typedef struct cdc_column {
+    const char *name;
+    int type;                   // CDC_COL_*
+    int mysql_type;             // binlog column type
+    const uint8_t *validity;    // bit i (LSB first) set = row i is not NULL
+    const void *values;         // fixed width types: one 8 byte value per row
+    const uint32_t *offsets;    // string types: row i is data[offsets[i], offsets[i+1])
+    const char *data;
+} cdc_column_t;
+
+typedef struct cdc_column_batch {
+    const char *db;
+    const char *table;
+    const char *txn;
+    uint64_t position;
+    const char *binlog_file;
+    int64_t last_committed;
+    int64_t sequence_number;
+    int kind;                           // CDC_ROWS_*
+    int row_count;
+    int column_count;
+    const cdc_column_t *columns;        // after image; the deleted row for DELETE
+    int before_column_count;
+    const cdc_column_t *before_columns; // UPDATE only, NULL otherwise
+} cdc_column_batch_t;
+
 // Publisher configuration from JSON
 struct publisher_config {
     const char *name;         // Publisher name
@@ -45,6 +104,12 @@ struct publisher_config {
     int config_count;         // Number of config items
 };
 
+// Plugin counter reported by get_stats; name must outlive the plugin data
+typedef struct publisher_stat {
+    const char *name;
+    uint64_t value;
+} publisher_stat_t;
+
 // Publisher plugin callbacks
 typedef struct publisher_callbacks {
     // Get plugin metadata
@@ -67,6 +132,15 @@ typedef struct publisher_callbacks {
     // Optional: health check
     int (*health_check)(void *plugin_data);
     
+    // Added in API version 2; plugins reporting version 1 end here
+    
+    // Optional: columnar rows delivery, required for columnar output profiles
+    int (*publish_columnar)(void *plugin_data, const cdc_column_batch_t *batch);
+    
+    // Optional: fill up to max counters, return how many. Runs on a stats
+    // thread while events are published, so read counters without locking.
+    int (*get_stats)(void *plugin_data, publisher_stat_t *stats, int max);
+    
 } publisher_callbacks_t;
 
 // Plugin descriptor - must be exported by each plugin
@@ -101,6 +175,23 @@ typedef struct publisher_api_helpers {
     int (*get_config_int)(const publisher_config_t *config, const char *key, int default_val);
     int (*get_config_bool)(const publisher_config_t *, const char *key, int default_val);
     
+    // Logical-clock transaction scheduler (see txn_scheduler.h); NULL on
+    // cores that predate it
+    struct txn_scheduler* (*txn_scheduler_create)(int window);
+    void (*txn_scheduler_destroy)(struct txn_scheduler *s);
+    int (*txn_scheduler_wait_ready)(struct txn_scheduler *s, int64_t last_committed);
+    int (*txn_scheduler_dispatched)(struct txn_scheduler *s, int64_t sequence_number);
+    void (*txn_scheduler_complete)(struct txn_scheduler *s, int64_t sequence_number);
+    void (*txn_scheduler_drain)(struct txn_scheduler *s);
+    void (*txn_scheduler_shutdown)(struct txn_scheduler *s);
+    
+    // Hand an event produced by a plugin to other publishers, by name
+    // (comma separated). The event is copied. Returns the number of
+    // publishers it was queued to, -1 if none; NULL on older cores.
+    // Plugins that emit name their targets in an "emit_to" setting; the
+    // core stops them before other publishers, so they may emit on stop.
+    int (*emit_event)(const cdc_event_t *event, const char *publishers);
+    
 } publisher_api_helpers_t;
 
 // Global helpers instance (set by core before init)
@@ -120,6 +211,10 @@ extern const publisher_api_helpers_t *publisher_helpers;
 #define PLUGIN_GET_CONFIG_INT(cfg, key, def) \
     (publisher_helpers ? publisher_helpers->get_config_int(cfg, key, def) : (def))
 
+// Counters read by get_stats on another thread
+#define PLUGIN_STAT_ADD(counter, n)  __atomic_fetch_add(&(counter), (n), __ATOMIC_RELAXED)
+#define PLUGIN_STAT_GET(counter)     __atomic_load_n(&(counter), __ATOMIC_RELAXED)
+
 #define PLUGIN_GET_CONFIG_BOOL(cfg, key, def) \
     (publisher_helpers->get_config_bool ? \
         publisher_helpers->get_config_bool((cfg), (key), (def)) : (def))
@@ -7,7 +7,114 @@
 #define PUBLISHER_LOADER_H
 
 #include "publisher_api.h"
+#include "publisher_pool.h"
+#include "stat_counters.h"
 #include <pthread.h>
+#include <stdio.h>
+
+struct column_batch;
+
+// Priority classes for load shedding (per table, overridable per publisher)
+#define PUBLISHER_PRIORITY_CRITICAL  0  // never shed; enqueue waits for room
+#define PUBLISHER_PRIORITY_NORMAL    1
+#define PUBLISHER_PRIORITY_LOW       2
+#define PUBLISHER_PRIORITY_COUNT     3
+#define PUBLISHER_PRIORITY_BOUNDARY  (-1) // DDL and transaction boundaries: never shed,
+                                          // whatever the publisher's rules
+
+#define PUBLISHER_SHED_NONE    0
+#define PUBLISHER_SHED_SAMPLE  1        // low priority sampled
+#define PUBLISHER_SHED_DROP    2        // low priority shed, normal sampled
+
+// Core counters of a publisher
+#define PUBLISHER_STAT_PUBLISHED  0
+#define PUBLISHER_STAT_DROPPED    1     // queue full, shed or failed to load
+#define PUBLISHER_STAT_ERRORS     2     // publish callback failed
+#define PUBLISHER_STAT_COUNT      3
+
+#define PUBLISHER_PLUGIN_STATS_MAX 16
+
+// Snapshot of a publisher's counters
+typedef struct {
+    uint64_t events_published;
+    uint64_t events_dropped;
+    uint64_t errors;
+    publisher_stat_t plugin[PUBLISHER_PLUGIN_STATS_MAX];   // from get_stats
+    int plugin_count;
+} publisher_stats_t;
+
+// A point in the stream: a GTID (source + transaction number) or binlog
+// coordinates. MySQL "uuid:N" has source uuid; MariaDB "D-S-N" source D.
+#define PUBLISHER_MARK_SOURCE_MAX  48
+#define PUBLISHER_WM_SOURCES       8
+
+typedef struct {
+    int is_gtid;
+    char source[PUBLISHER_MARK_SOURCE_MAX];
+    uint64_t seq;
+    char binlog_file[256];
+    uint64_t position;
+} publisher_mark_t;
+
+// Immutable, reference counted copy of a CDC event. One copy is built per
+// encoded payload and shared by every publisher queue it is dispatched to.
+typedef struct publisher_event {
+    int refs;
+    cdc_event_t event;
+    struct column_batch *batch;     // columnar payload (event.json is NULL), owned
+    int priority;                   // PUBLISHER_PRIORITY_* of the source table, or BOUNDARY
+    size_t size;                    // bytes counted against max_queue_bytes
+    publisher_mark_t *hold;         // earliest event not yet dispatched (parked), owned;
+                                    // delivering this one advances watermarks short of it
+    int progress;                   // no payload: only advances the watermark, see
+                                    // publisher_event_create_progress()
+    char data[];            // backing storage for all strings in event
+} publisher_event_t;
+
+// Publisher override of a table's priority class
+typedef struct {
+    char db[128];
+    char table[128];                // "*" = every table of db
+    int priority;
+} publisher_priority_rule_t;
+
+// Load shedding under sustained overload. Pressure is the highest of the
+// queue fill, queued bytes / max_bytes and head lag / max_lag_sec.
+typedef struct {
+    int enabled;
+    double sample_at;                   // pressure where PUBLISHER_SHED_SAMPLE starts
+    double drop_at;                     // pressure where PUBLISHER_SHED_DROP starts
+    int sample_rate;                    // keep one event in sample_rate while sampling
+    size_t max_bytes;                   // 0 = queue bytes not considered
+    uint32_t max_lag_sec;               // 0 = lag not considered
+    char spill_path[512];               // shed events appended as JSON lines, "" = drop
+    FILE *spill_fp;                     // opened on first spill, under spill_mutex
+    pthread_mutex_t spill_mutex;        // spill file I/O stays off q_mutex
+    publisher_priority_rule_t *rules;
+    int rule_count;
+    
+    // Runtime state, under q_mutex
+    int level;                          // PUBLISHER_SHED_*
+    uint64_t seen[PUBLISHER_PRIORITY_COUNT];
+    
+    // Shed events not yet added to the metrics, by priority and action;
+    // atomic, reported by the publisher's worker
+    uint64_t unreported[PUBLISHER_PRIORITY_COUNT][4];
+} publisher_shedding_t;
+
+// What a publisher has delivered: the furthest binlog position and, per
+// GTID source, the last transaction delivered in full
+typedef struct {
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    int waiters;
+    int closed;                         // shutting down, waits return
+    char binlog_file[256];
+    uint64_t position;
+    char source[PUBLISHER_WM_SOURCES][PUBLISHER_MARK_SOURCE_MAX];
+    uint64_t seq[PUBLISHER_WM_SOURCES];
+    int source_count;
+} publisher_watermark_t;
 
 // Publisher instance (combines plugin with runtime state)
 typedef struct publisher_instance {
@@ -17,36 +124,92 @@ typedef struct publisher_instance {
     // Plugin handle
     void *dl_handle;                    // dlopen handle
     publisher_plugin_t *plugin;         // Plugin descriptor
+    int api_version;                    // reported by the plugin, see PUBLISHER_CALLBACK_V2
     
     // Configuration
     publisher_config_t config;
     
     // Runtime state
     int active;
-    int started;
+    int started;                        // other threads read it with __atomic_load_n
+    
+    // Output profile (index into the core's profile registry, 0 = default)
+    int profile_id;
+    
+    // Startup: PUBLISHER_LOADING until the library is loaded and started
+    int load_state;
+    int critical;                       // stream waits for this one to be ready
+    double startup_ms;
+    
+    // Run the plugin in a supervised host process (see plugin_host.h)
+    int out_of_process;
+    size_t host_ring_size;              // bytes, 0 = default
+    
+    // Set by the host proxy: publish() only queues to the host, which acks
+    // later. Events handed over and not yet acked, oldest first.
+    int deferred_ack;
+    publisher_event_t **inflight;
+    int inflight_head, inflight_count, inflight_cap;
+    pthread_mutex_t inflight_mutex;
     
     // Async queue for event processing
-    cdc_event_t **queue;
+    publisher_event_t **queue;
     int q_head, q_tail, q_count, q_capacity;
     pthread_mutex_t q_mutex;
     pthread_cond_t q_cond;
     int q_stop;
+    size_t q_bytes;                     // sum of queued event sizes
+    int q_waiters;                      // critical enqueues waiting for room
+    publisher_shedding_t shed;
     pthread_t thread;
     int thread_started;
     
-    // Statistics
-    uint64_t events_published;
-    uint64_t events_dropped;
-    uint64_t errors;
+    // Shared pool scheduling (pool == NULL: dedicated worker thread)
+    publisher_pool_t *pool;
+    int dedicated_thread;               // keep own thread even with a pool
+    int watermarks;                     // also receives WATERMARK events
+    int routing_key;                    // uses cdc_event_t.key, computed only then
+    int sched_state;                    // PUBLISHER_IDLE / PUBLISHER_SCHEDULED, under q_mutex
+    int columnar_warned;                // columnar event without publish_columnar logged
+    publisher_watermark_t wm;           // advanced after each successful publish
+    uint64_t boundary_seen;             // core: last transaction end dispatched to it,
+                                        // binlog thread only
+    
+    // Statistics, PUBLISHER_STAT_* counters; read with publisher_stats_snapshot()
+    stat_counters_t *stats;
     
     struct publisher_instance *next;
 } publisher_instance_t;
 
+// Callback appended in API version 2, NULL for plugins built against version 1
+// (their callbacks struct ends before it)
+#define PUBLISHER_CALLBACK_V2(inst, cb) \
+    ((inst)->api_version >= 2 ? (inst)->plugin->callbacks->cb : NULL)
+
+#define PUBLISHER_IDLE       0
+#define PUBLISHER_SCHEDULED  1
+
+#define PUBLISHER_LOADING    0
+#define PUBLISHER_READY      1
+#define PUBLISHER_FAILED     2
+
 // Publisher manager
 typedef struct publisher_manager {
     publisher_instance_t *instances;
     int instance_count;
     
+    // Optional shared worker pool for non-dedicated publishers
+    publisher_pool_t *pool;
+    
+    // Parallel startup
+    pthread_mutex_t startup_mutex;
+    pthread_cond_t startup_cond;
+    pthread_t *startup_threads;
+    int startup_thread_count;
+    publisher_instance_t *startup_next;
+    int startup_pending;
+    int startup_pending_critical;
+    
     // Global helpers for plugins
     publisher_api_helpers_t helpers;
     
@@ -55,7 +218,28 @@ typedef struct publisher_manager {
 // Initialize publisher manager
 int publisher_manager_init(publisher_manager_t **manager);
 
-// Load a publisher plugin from shared library
+// Register a publisher without loading it; publisher_manager_start_all()
+// loads and starts it later. Events may be queued in the meantime.
+int publisher_manager_add_plugin(
+    publisher_manager_t *manager,
+    const char *name,
+    const char *library_path,
+    const publisher_config_t *config,
+    publisher_instance_t **instance
+);
+
+// Load and start all registered publishers on threads startup threads
+// (<= 0: one per publisher). Returns immediately.
+int publisher_manager_start_all(publisher_manager_t *manager, int threads);
+
+// Wait until every critical publisher is ready or failed, at most
+// timeout_ms (<= 0: no limit). Returns the number still loading.
+int publisher_manager_wait_ready(publisher_manager_t *manager, int timeout_ms);
+
+// Wait for the startup threads to finish
+void publisher_manager_join_startup(publisher_manager_t *manager);
+
+// Load a publisher plugin from shared library (synchronously)
 int publisher_manager_load_plugin(
     publisher_manager_t *manager,
     const char *name,
@@ -64,18 +248,73 @@ int publisher_manager_load_plugin(
     publisher_instance_t **instance
 );
 
+// Create the shared worker pool; publishers loaded afterwards use it
+// unless they ask for a dedicated thread
+int publisher_manager_enable_pool(publisher_manager_t *manager, int threads, int quantum);
+
 // Start/stop publishers
 int publisher_instance_start(publisher_instance_t *instance);
 int publisher_instance_stop(publisher_instance_t *instance);
 
+// Stop every started publisher; those with an "emit_to" setting first, so
+// events they emit while stopping reach publishers that are still running
+void publisher_manager_stop_all(publisher_manager_t *manager);
+
+// Pool mode: deliver up to quantum queued events. Returns 1 if events
+// remain and the instance must be rescheduled, 0 once it went idle.
+int publisher_instance_run(publisher_instance_t *instance, int quantum);
+
+// Deferred ack: the oldest event in flight was delivered (status 0) or
+// failed; counts it and advances the watermark
+void publisher_instance_ack(publisher_instance_t *instance, int status);
+
 // Queue management
 int publisher_instance_enqueue(publisher_instance_t *instance, const cdc_event_t *event);
 
+// Shared events: create once, enqueue to many instances, release the
+// creator's reference when done. Enqueue takes its own reference.
+publisher_event_t* publisher_event_create(const cdc_event_t *event);
+// Columnar variant: takes ownership of batch, also on failure
+publisher_event_t* publisher_event_create_columnar(const cdc_event_t *event,
+                                                   struct column_batch *batch);
+// Progress mark for the end of a transaction a publisher did not get the
+// COMMIT of (filtered out, or not captured). Never handed to the plugin;
+// only the newest one waits in a queue.
+publisher_event_t* publisher_event_create_progress(const cdc_event_t *event);
+void publisher_event_release(publisher_event_t *event);
+int publisher_instance_enqueue_event(publisher_instance_t *instance, publisher_event_t *event);
+
 // Cleanup
 void publisher_instance_destroy(publisher_instance_t *instance);
 void publisher_manager_destroy(publisher_manager_t *manager);
 
+// Parse "critical" / "normal" / "low"; -1 if unknown
+int publisher_priority_parse(const char *name);
+
 // Database filter check
 int publisher_should_publish(publisher_instance_t *instance, const char *db);
 
+// Numeric suffix of a binlog file name ("mysql-bin.000042" -> 42)
+uint64_t publisher_binlog_file_index(const char *name);
+
+// Parse a GTID or "binlog_file:position"; -1 if neither
+int publisher_mark_parse(const char *text, publisher_mark_t *mark);
+
+// Wait until the publisher has delivered mark. Returns 0 once reached,
+// 1 on timeout, -1 if the watermark was closed.
+int publisher_watermark_wait(publisher_instance_t *instance, const publisher_mark_t *mark,
+                             int timeout_ms);
+
+// Watermark as a JSON object
+int publisher_watermark_format(publisher_instance_t *instance, char *buf, size_t size);
+
+// Release every waiter, for shutdown
+void publisher_watermark_close(publisher_instance_t *instance);
+
+// Core and plugin counters; takes no lock the publish path uses
+void publisher_stats_snapshot(publisher_instance_t *instance, publisher_stats_t *stats);
+
+// Snapshot as a JSON object
+int publisher_stats_format(publisher_instance_t *instance, char *buf, size_t size);
+
 #endif // PUBLISHER_LOADER_H
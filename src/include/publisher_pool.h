@@ -0,0 +1,32 @@
+// publisher_pool.h
+// Shared work-stealing worker pool for publisher queues
+//
+// Instead of one thread per publisher, ready publishers are placed on the
+// deque of a pool worker. A publisher is owned by at most one worker at a
+// time (so its events stay ordered) and runs for a bounded quantum before
+// being requeued, so a busy sink cannot starve the others. Idle workers
+// steal ready publishers from the other workers' deques.
+
+#ifndef PUBLISHER_POOL_H
+#define PUBLISHER_POOL_H
+
+struct publisher_instance;
+
+typedef struct publisher_pool publisher_pool_t;
+
+#define PUBLISHER_POOL_DEFAULT_QUANTUM 64
+
+// Create a pool with threads workers (<= 0: one per online CPU) that
+// deliver up to quantum events per publisher turn
+publisher_pool_t* publisher_pool_create(int threads, int quantum);
+
+// Queue a publisher that just became ready. The caller must have moved the
+// instance from IDLE to SCHEDULED under its q_mutex.
+void publisher_pool_schedule(publisher_pool_t *pool, struct publisher_instance *inst);
+
+// Stop and join all workers. Publishers must be stopped first.
+void publisher_pool_destroy(publisher_pool_t *pool);
+
+int publisher_pool_thread_count(const publisher_pool_t *pool);
+
+#endif // PUBLISHER_POOL_H
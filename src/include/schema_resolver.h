@@ -0,0 +1,53 @@
+// schema_resolver.h
+// Column metadata lookups off the binlog thread
+//
+// Resolver threads, each with its own MySQL connection, fetch the column
+// names, binary and signedness flags and ENUM/SET values of a table. The
+// binlog thread never waits: schema_resolver_get() answers from the cache or
+// queues the table and returns SCHEMA_PENDING, and
+// schema_resolver_generation() tells it when to look again. Failed lookups
+// stay pending and are retried with backoff.
+
+#ifndef SCHEMA_RESOLVER_H
+#define SCHEMA_RESOLVER_H
+
+#define SCHEMA_PENDING  0
+#define SCHEMA_READY    1
+
+// Result for one table; immutable once READY
+typedef struct {
+    int ncols;                      // 0 if the table no longer exists
+    char **names;
+    unsigned char *binary;          // 1 = binary charset
+    unsigned char *is_unsigned;     // 1 = UNSIGNED numeric column
+    char ***enum_values;            // per column, NULL unless ENUM/SET
+    int *enum_counts;
+} schema_info_t;
+
+// Start threads resolver threads (<= 0: none, schema_resolver_get() is
+// then unavailable)
+int schema_resolver_start(const char *host, int port, const char *user,
+                          const char *password, int threads);
+
+// Binlog thread only. READY fills *info, valid until the table is
+// invalidated or the resolver stops.
+int schema_resolver_get(const char *db, const char *tbl, const schema_info_t **info);
+
+// Wait up to timeout_ms for a queued table. Returns SCHEMA_READY or SCHEMA_PENDING.
+int schema_resolver_wait(const char *db, const char *tbl, int timeout_ms);
+
+// Forget the resolved tables of db (NULL = all) after DDL; queued lookups
+// are kept
+void schema_resolver_invalidate_db(const char *db);
+
+// Bumped each time a lookup completes
+unsigned schema_resolver_generation(void);
+
+int schema_resolver_enabled(void);
+void schema_resolver_stop(void);
+
+// Values of an "enum('a','b')" / "set(...)" column type. Returns the
+// count (0 if none) and a malloc'ed array of malloc'ed strings in *values.
+int schema_parse_enum_type(const char *column_type, char ***values);
+
+#endif // SCHEMA_RESOLVER_H
@@ -0,0 +1,44 @@
+// stage_profiler.h
+// Per-stage wall time and per-thread CPU accounting
+//
+// Each thread accumulates exclusive time per pipeline stage (time spent in
+// nested spans is charged to the inner stage only). A reporter thread sums
+// the counters, reads each registered thread's CPU clock, exports both as
+// metrics and logs a one-line summary every interval.
+
+#ifndef STAGE_PROFILER_H
+#define STAGE_PROFILER_H
+
+#include <stdint.h>
+
+typedef enum {
+    PROFILE_FETCH = 0,      // waiting in mysql_binlog_fetch
+    PROFILE_DECOMPRESS,     // compressed rows / transaction payloads
+    PROFILE_DECODE,         // event parsing not covered by another stage
+    PROFILE_ENCODE,         // row image to JSON / columnar batch
+    PROFILE_DISPATCH,       // copying and enqueueing to publishers
+    PROFILE_QUEUE_WAIT,     // publisher workers idle on an empty queue
+    PROFILE_PUBLISH,        // plugin publish callbacks
+    PROFILE_STAGE_COUNT
+} profile_stage_t;
+
+typedef struct {
+    uint64_t start;         // 0 when profiling is off
+    uint64_t child;         // caller's nested time, restored on end
+} profile_span_t;
+
+// interval_sec <= 0 reports only once, at shutdown.
+// Nothing is measured unless enabled is set.
+int profiler_init(int enabled, int interval_sec);
+
+// Track the calling thread's CPU time under name; unregister before it exits
+void profiler_register_thread(const char *name);
+void profiler_unregister_thread(void);
+
+void profiler_begin(profile_span_t *span);
+void profiler_end(profile_span_t *span, profile_stage_t stage);
+
+// Stop the reporter, publish a last snapshot
+void profiler_shutdown(void);
+
+#endif // STAGE_PROFILER_H
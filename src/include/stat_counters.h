@@ -0,0 +1,27 @@
+// stat_counters.h
+// Per-thread statistics counters with consistent snapshots
+//
+// Each thread adds to its own cache-line slot of a counter set, so the hot
+// path never takes a lock or bounces a line between cores. A snapshot sums
+// the slots, reading each under its sequence counter so it never sees a
+// slot halfway through an update.
+
+#ifndef STAT_COUNTERS_H
+#define STAT_COUNTERS_H
+
+#include <stdint.h>
+
+#define STAT_COUNTERS_MAX  7        // counters per set, one slot is a cache line
+
+typedef struct stat_counters stat_counters_t;
+
+// count <= STAT_COUNTERS_MAX counters, all zero
+stat_counters_t* stat_counters_create(int count);
+void stat_counters_destroy(stat_counters_t *c);
+
+void stat_counters_add(stat_counters_t *c, int counter, uint64_t delta);
+
+// Totals of every counter into out[count]
+void stat_counters_snapshot(const stat_counters_t *c, uint64_t *out);
+
+#endif // STAT_COUNTERS_H
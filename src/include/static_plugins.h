@@ -0,0 +1,23 @@
+// static_plugins.h
+// Publisher plugins linked into the binary
+//
+// `make STATIC_PLUGINS="file_publisher udp_publisher"` compiles those
+// plugins into binlog_stream (with -flto) and generates the registry below.
+// A configured library_path whose file name matches a built-in plugin
+// ("./build/lib/file_publisher.so") uses it instead of dlopen; every other
+// plugin is still loaded dynamically.
+
+#ifndef STATIC_PLUGINS_H
+#define STATIC_PLUGINS_H
+
+#include "publisher_api.h"
+
+typedef struct {
+    const char *name;                   // plugin name from PLUGIN_NAMES
+    publisher_plugin_init_fn init;      // its publisher_plugin_init
+} static_plugin_t;
+
+// Generated by make; ends with { NULL, NULL }
+extern const static_plugin_t static_plugins[];
+
+#endif // STATIC_PLUGINS_H
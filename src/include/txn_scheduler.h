@@ -0,0 +1,47 @@
+// txn_scheduler.h
+// Dependency-aware transaction scheduler driven by MySQL logical clocks
+//
+// MySQL 5.7+ stamps each GTID event with last_committed and sequence_number:
+// a transaction may run concurrently with every transaction whose
+// sequence_number is greater than its last_committed. The scheduler tracks
+// the transactions a sink has handed to its workers and lets the next one
+// start as soon as every in-flight transaction it depends on has completed.
+//
+// Transactions must be dispatched in binlog order from a single thread;
+// completions may arrive from any thread in any order. Sequence numbers that
+// are never dispatched (filtered out, not captured) count as completed.
+
+#ifndef TXN_SCHEDULER_H
+#define TXN_SCHEDULER_H
+
+#include <stdint.h>
+
+typedef struct txn_scheduler txn_scheduler_t;
+
+#define TXN_SCHEDULER_DEFAULT_WINDOW 1024
+
+// window bounds the number of in-flight transactions (<= 0: default)
+txn_scheduler_t* txn_scheduler_create(int window);
+void txn_scheduler_destroy(txn_scheduler_t *s);
+
+// Block until every in-flight transaction with sequence_number <=
+// last_committed has completed and there is room in the window.
+// Returns -1 if the scheduler was shut down while waiting.
+int txn_scheduler_wait_ready(txn_scheduler_t *s, int64_t last_committed);
+
+// Record sequence_number as in flight, blocking while the window is full.
+// Must be called in increasing order. Returns -1, without tracking it, for
+// a sequence_number not above the last one or when shut down while waiting.
+int txn_scheduler_dispatched(txn_scheduler_t *s, int64_t sequence_number);
+
+// Mark an in-flight transaction as committed by the sink
+void txn_scheduler_complete(txn_scheduler_t *s, int64_t sequence_number);
+
+// Wait for all in-flight transactions, then forget the sequence. Used when
+// the binlog file changes, since sequence numbers restart in each file.
+void txn_scheduler_drain(txn_scheduler_t *s);
+
+// Wake all waiters with -1 (sink is stopping)
+void txn_scheduler_shutdown(txn_scheduler_t *s);
+
+#endif // TXN_SCHEDULER_H
@@ -71,7 +71,7 @@ static int publish(void *plugin_data, const cdc_event_t *event) {
     printf("%s\n", event->json);
     printf("############### EXAMPLE PLUGIN ###############\n");
     
-    data->events_written++;
+    PLUGIN_STAT_ADD(data->events_written, 1);
     PLUGIN_LOG_TRACE("Published event to example: txn=%s, db=%s, table=%s",
                     event->txn ? event->txn : "",
                     event->db ? event->db : "",
@@ -80,6 +80,42 @@ static int publish(void *plugin_data, const cdc_event_t *event) {
     return 0;
 }
 
+// Publish a columnar batch ("format": "columnar" output profile)
+static int publish_columnar(void *plugin_data, const cdc_column_batch_t *batch) {
+    example_publisher_data_t *data = (example_publisher_data_t*)plugin_data;
+    static const char *kinds[] = { "INSERT", "UPDATE", "DELETE" };
+    
+    if (!data || !data->example_data) {
+        return -1;
+    }
+    
+    printf("############### EXAMPLE PLUGIN ###############\n");
+    printf("%s %s.%s: %d row(s)\n", kinds[batch->kind], batch->db, batch->table,
+           batch->row_count);
+    for (int c = 0; c < batch->column_count; c++) {
+        const cdc_column_t *col = &batch->columns[c];
+        printf("  %s:", col->name);
+        for (int r = 0; r < batch->row_count; r++) {
+            if (!(col->validity[r >> 3] & (1 << (r & 7)))) {
+                printf(" null");
+            } else if (col->type == CDC_COL_STRING || col->type == CDC_COL_BINARY) {
+                printf(" [%u bytes]", col->offsets[r + 1] - col->offsets[r]);
+            } else if (col->type == CDC_COL_DOUBLE) {
+                printf(" %f", ((const double*)col->values)[r]);
+            } else if (col->type == CDC_COL_UINT64) {
+                printf(" %llu", (unsigned long long)((const uint64_t*)col->values)[r]);
+            } else {
+                printf(" %lld", (long long)((const int64_t*)col->values)[r]);
+            }
+        }
+        printf("\n");
+    }
+    printf("############### EXAMPLE PLUGIN ###############\n");
+    
+    PLUGIN_STAT_ADD(data->events_written, 1);
+    return 0;
+}
+
 // Stop publisher
 static int stop(void *plugin_data) {
     example_publisher_data_t *data = (example_publisher_data_t*)plugin_data;
@@ -107,6 +143,14 @@ static int health_check(void *plugin_data) {
     return (data && data->example_data) ? 0 : -1;
 }
 
+// Counters shown by the core (control socket STATS)
+static int get_stats(void *plugin_data, publisher_stat_t *stats, int max) {
+    example_publisher_data_t *data = (example_publisher_data_t*)plugin_data;
+    if (!data || max < 1) return 0;
+    stats[0] = (publisher_stat_t){ "events_written", PLUGIN_STAT_GET(data->events_written) };
+    return 1;
+}
+
 // Plugin callbacks
 static const publisher_callbacks_t callbacks = {
     .get_name = get_name,
@@ -119,6 +163,8 @@ static const publisher_callbacks_t callbacks = {
     .publish = publish,
     .publish_batch = NULL,  // Not implemented
     .health_check = health_check,
+    .publish_columnar = publish_columnar,
+    .get_stats = get_stats,
 };
 
 // Plugin entry point
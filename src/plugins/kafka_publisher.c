@@ -5,6 +5,7 @@
 
 #include "publisher_api.h"
 #include <librdkafka/rdkafka.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <errno.h>
@@ -21,6 +22,7 @@ typedef struct {
     char compression[32];
     int flush_timeout_ms;
     int batch_size;
+    int headers;                // event metadata as message headers
     
     uint64_t messages_sent;
     uint64_t messages_failed;
@@ -48,12 +50,12 @@ static void kafka_delivery_callback(rd_kafka_t *rk,
     kafka_publisher_data_t *data = (kafka_publisher_data_t*)opaque;
     
     if (rkmessage->err) {
-        data->messages_failed++;
+        PLUGIN_STAT_ADD(data->messages_failed, 1);
         PLUGIN_LOG_WARN("Kafka delivery failed: %s",
                        rd_kafka_err2str(rkmessage->err));
     } else {
-        data->messages_sent++;
-        data->bytes_sent += rkmessage->len;
+        PLUGIN_STAT_ADD(data->messages_sent, 1);
+        PLUGIN_STAT_ADD(data->bytes_sent, rkmessage->len);
         
         PLUGIN_LOG_TRACE("Kafka message delivered: topic=%s partition=%d offset=%ld",
                         rd_kafka_topic_name(rkmessage->rkt),
@@ -121,6 +123,7 @@ static int init(const publisher_config_t *config, void **plugin_data) {
     data->flush_timeout_ms = PLUGIN_GET_CONFIG_INT(config, "flush_timeout_ms", 1000);
     data->batch_size = PLUGIN_GET_CONFIG_INT(config, "batch_size", 1000);
     data->topic_per_table = PLUGIN_GET_CONFIG_BOOL(config, "topic_per_table", 0);
+    data->headers = PLUGIN_GET_CONFIG_BOOL(config, "headers", 1);
     
     *plugin_data = data;
     
@@ -212,6 +215,24 @@ static void build_topic_name(const kafka_publisher_data_t *data,
     free(ntb);
 }
 
+// Event metadata as headers, so consumers can route without the body
+static rd_kafka_headers_t* build_headers(const cdc_event_t *event) {
+    rd_kafka_headers_t *hdrs = rd_kafka_headers_new(8);
+    if (!hdrs) return NULL;
+
+    const char *names[] = { "db", "table", "type", "txn", "key", "binlog_file" };
+    const char *values[] = { event->db, event->table, event->type, event->txn,
+                             event->key, event->binlog_file };
+    for (int i = 0; i < 6; i++) {
+        if (values[i]) rd_kafka_header_add(hdrs, names[i], -1, values[i], -1);
+    }
+
+    char position[24];
+    snprintf(position, sizeof(position), "%llu", (unsigned long long)event->position);
+    rd_kafka_header_add(hdrs, "position", -1, position, -1);
+    return hdrs;
+}
+
 // Publish event
 static int publish(void *plugin_data, const cdc_event_t *event) {
     kafka_publisher_data_t *data = (kafka_publisher_data_t*)plugin_data;
@@ -224,20 +245,23 @@ static int publish(void *plugin_data, const cdc_event_t *event) {
     char topic[256];
     build_topic_name(data, event->db, event->table, topic, sizeof(topic));
     
-    // Produce message
+    // Produce message; the headers belong to librdkafka once it succeeds
+    rd_kafka_headers_t *hdrs = data->headers ? build_headers(event) : NULL;
     int ret = rd_kafka_producev(
         data->producer,
         RD_KAFKA_V_TOPIC(topic),
         RD_KAFKA_V_MSGFLAGS(RD_KAFKA_MSG_F_COPY),
         RD_KAFKA_V_VALUE((void*)event->json, strlen(event->json)),
         RD_KAFKA_V_KEY(event->txn, event->txn ? strlen(event->txn) : 0),
+        RD_KAFKA_V_HEADERS(hdrs),
         RD_KAFKA_V_END
     );
     
     if (ret != RD_KAFKA_RESP_ERR_NO_ERROR) {
+        if (hdrs) rd_kafka_headers_destroy(hdrs);
         PLUGIN_LOG_WARN("Failed to produce message: %s",
                        rd_kafka_err2str(rd_kafka_last_error()));
-        data->messages_failed++;
+        PLUGIN_STAT_ADD(data->messages_failed, 1);
         return -1;
     }
     
@@ -331,6 +355,17 @@ static int health_check(void *plugin_data) {
     return 0;
 }
 
+static int get_stats(void *plugin_data, publisher_stat_t *stats, int max) {
+    kafka_publisher_data_t *data = (kafka_publisher_data_t*)plugin_data;
+    if (!data || max < 4) return 0;
+    stats[0] = (publisher_stat_t){ "messages_sent", PLUGIN_STAT_GET(data->messages_sent) };
+    stats[1] = (publisher_stat_t){ "messages_failed", PLUGIN_STAT_GET(data->messages_failed) };
+    stats[2] = (publisher_stat_t){ "bytes_sent", PLUGIN_STAT_GET(data->bytes_sent) };
+    stats[3] = (publisher_stat_t){ "outq_len",
+                                   data->producer ? (uint64_t)rd_kafka_outq_len(data->producer) : 0 };
+    return 4;
+}
+
 // Plugin callbacks
 static const publisher_callbacks_t callbacks = {
     .get_name = get_name,
@@ -343,6 +378,7 @@ static const publisher_callbacks_t callbacks = {
     .publish = publish,
     .publish_batch = publish_batch,
     .health_check = health_check,
+    .get_stats = get_stats,
 };
 
 // Plugin entry point
@@ -1,16 +1,129 @@
 // mysql_publisher.c
 // MySQL Database Publisher Plugin
-// Writes CDC events to a MySQL table for auditing/archival
+// Writes CDC events to a MySQL table for auditing/archival, or (mode=apply)
+// replicates row changes into mirror tables on a target server.
 //
-// Build: gcc -shared -fPIC -o mysql_publisher.so mysql_publisher.c -I. -lmysqlclient
+// Build: gcc -shared -fPIC -o mysql_publisher.so mysql_publisher.c -I. -lmysqlclient -ljson-c -lpthread
+//
+// Configuration:
+//   host, port, username, password, database: target server (required: host, database)
+//   mode: "audit" (default) or "apply"
+//   table: audit table name (required in audit mode)
+//
+// Apply mode:
+//   apply_threads: parallel apply connections (default: 4). A table is always
+//                  applied on the same connection so per-table order holds.
+//   apply_batch_rows: max rows per multi-row statement (default: 500)
+//   apply_use_source_db: write to the source db name instead of `database` (default: no)
+//   apply_flush_ms: apply what is buffered of an open transaction after this much
+//                  idle time (default: 200). The rest of it follows on the same
+//                  lane, and transactions that depend on it wait for all of it.
+//   apply_parallel: "table" (default) or "logical_clock". With logical_clock
+//                  each source transaction is applied whole on the least busy
+//                  lane, and only waits for the transactions it depends on
+//                  according to the MySQL last_committed/sequence_number of
+//                  its GTID event. Transactions without a logical clock
+//                  (MariaDB, no GTIDs) fall back to per-table lanes.
+//   apply_retries: attempts after the first for a transaction that failed on a
+//                  lost connection, deadlock or lock wait timeout (default: 3).
+//                  Each lane reconnects itself between attempts. A transaction
+//                  that still fails, or fails otherwise, halts the apply: later
+//                  transactions are not applied on top of it and every publish
+//                  returns an error until the publisher is restarted.
+//
+//   apply_binary: "base64" (default) or "hex", how the core's binary_output
+//                  encodes BLOB/BINARY values; they are written back as raw bytes
+//
+//   INSERT/UPDATE rows become INSERT ... ON DUPLICATE KEY UPDATE, DELETE rows
+//   become DELETE ... WHERE pk IN (...). The table's primary_key from the
+//   capture config is used as the key. Statements are grouped per source
+//   transaction and committed together on each apply connection.
+//   Only columns of the target table are written, so enrichment columns are
+//   left out. A value the event carries only as a reference or a truncated
+//   preview (blob store, digest) is left out too and keeps the target's value.
+//   Apply mode needs the "full" envelope and the "object" row format; the
+//   core refuses other output profiles for it.
 
 #include "publisher_api.h"
 #include <mysql/mysql.h>
+#include <mysql/errmsg.h>
+#include <mysql/mysqld_error.h>
+#include <json-c/json.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <strings.h>
+#include <pthread.h>
+#include <time.h>
+#include <errno.h>
 
-// Plugin private data
+#define APPLY_MAX_THREADS   64
+#define APPLY_QUEUE_DEPTH   64
+#define APPLY_RETRY_MIN_MS  100
+#define APPLY_RETRY_MAX_MS  5000
+
+// Growable string used to build SQL
 typedef struct {
+    char *buf;
+    size_t len;
+    size_t cap;
+} sql_buf_t;
+
+// Columns of a target table, read from information_schema on first use
+#define APPLY_COL_PLAIN   0
+#define APPLY_COL_BINARY  1         // event carries base64 or hex text
+#define APPLY_COL_JSON    2
+
+typedef struct apply_table_schema {
+    char table[256];                // `db`.`table`, already quoted
+    int count;                      // 0 = no such table on the target
+    char **names;                   // in ordinal order
+    int *kinds;                     // APPLY_COL_*
+    int skip_warned;
+    struct apply_table_schema *next;
+} apply_table_schema_t;
+
+// A batch of rows for one table that will become one statement
+typedef enum { APPLY_OP_UPSERT, APPLY_OP_DELETE } apply_op_t;
+
+typedef struct apply_table_batch {
+    char table[256];                // `db`.`table`, already quoted
+    apply_table_schema_t *schema;
+    int lane;
+    apply_op_t op;
+    char *columns;                  // column list signature of open batch
+    sql_buf_t values;               // open batch: "(..),(..)"
+    int rows;
+    char **stmts;                   // closed statements in order
+    int stmt_count, stmt_cap;
+    struct apply_table_batch *next;
+} apply_table_batch_t;
+
+// One transaction's worth of statements for one lane
+typedef struct apply_unit {
+    char txn[64];
+    int64_t seq;                    // logical clock sequence_number, 0 = untracked
+    char **stmts;
+    int stmt_count;
+    struct apply_unit *next;
+} apply_unit_t;
+
+typedef struct apply_lane {
+    int id;
+    MYSQL *conn;
+    pthread_t thread;
+    int thread_started;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    apply_unit_t *head, *tail;
+    int depth;
+    int busy;
+    int stop;
+    struct mysql_publisher_data *owner;
+} apply_lane_t;
+
+// Plugin private data
+typedef struct mysql_publisher_data {
     MYSQL *conn;
     char host[128];
     int port;
@@ -18,8 +131,38 @@ typedef struct {
     char password[64];
     char database[64];
     char table[128];
-    uint64_t events_written;
-    uint64_t events_failed;
+    uint64_t events_written;            // atomic
+    uint64_t events_failed;             // atomic
+
+    // Apply mode
+    int apply_mode;
+    int apply_threads;
+    int apply_batch_rows;
+    int apply_use_source_db;
+    int apply_flush_ms;
+    int apply_retries;
+    int apply_halted;                   // a transaction failed for good, see apply_retries
+    int apply_binary_hex;               // binary values arrive hex encoded
+    apply_table_schema_t *schemas;      // under txn_mutex
+    apply_lane_t *lanes;
+    int apply_logical_clock;
+    struct txn_scheduler *scheduler;
+    int untracked_in_flight;            // table-hashed units not known to the scheduler
+    pthread_mutex_t txn_mutex;          // guards the open transaction below
+    char cur_txn[64];
+    int64_t cur_last_committed;
+    int64_t cur_seq;
+    int cur_partial;                    // part of the open txn already handed to the lanes
+    int cur_partial_lane;               // its whole-transaction lane, -1 = per-table lanes
+    char cur_binlog[256];               // file the scheduler's sequence belongs to
+    apply_table_batch_t *batches;
+    struct timespec last_event;
+    pthread_t flusher;
+    int flusher_started;
+    int flusher_stop;
+    uint64_t txns_applied;
+    uint64_t rows_applied;
+    uint64_t statements_failed;
 } mysql_publisher_data_t;
 
 static const char* get_name(void) {
@@ -47,8 +190,11 @@ static int init(const publisher_config_t *config, void **plugin_data) {
     const char *host = PLUGIN_GET_CONFIG(config, "host");
     const char *database = PLUGIN_GET_CONFIG(config, "database");
     const char *table = PLUGIN_GET_CONFIG(config, "table");
+    const char *mode = PLUGIN_GET_CONFIG(config, "mode");
     
-    if (!host || !database || !table) {
+    data->apply_mode = (mode && strcasecmp(mode, "apply") == 0);
+    
+    if (!host || !database || (!table && !data->apply_mode)) {
         PLUGIN_LOG_ERROR("Missing required config: host, database, or table");
         free(data);
         return -1;
@@ -56,7 +202,7 @@ static int init(const publisher_config_t *config, void **plugin_data) {
     
     strncpy(data->host, host, sizeof(data->host) - 1);
     strncpy(data->database, database, sizeof(data->database) - 1);
-    strncpy(data->table, table, sizeof(data->table) - 1);
+    if (table) strncpy(data->table, table, sizeof(data->table) - 1);
     
     // Get optional config
     data->port = PLUGIN_GET_CONFIG_INT(config, "port", 3306);
@@ -67,19 +213,1010 @@ static int init(const publisher_config_t *config, void **plugin_data) {
     if (username) strncpy(data->username, username, sizeof(data->username) - 1);
     if (password) strncpy(data->password, password, sizeof(data->password) - 1);
     
+    if (data->apply_mode) {
+        data->apply_threads = PLUGIN_GET_CONFIG_INT(config, "apply_threads", 4);
+        if (data->apply_threads < 1) data->apply_threads = 1;
+        if (data->apply_threads > APPLY_MAX_THREADS) data->apply_threads = APPLY_MAX_THREADS;
+        data->apply_batch_rows = PLUGIN_GET_CONFIG_INT(config, "apply_batch_rows", 500);
+        if (data->apply_batch_rows < 1) data->apply_batch_rows = 1;
+        data->apply_use_source_db = PLUGIN_GET_CONFIG_BOOL(config, "apply_use_source_db", 0);
+        data->apply_flush_ms = PLUGIN_GET_CONFIG_INT(config, "apply_flush_ms", 200);
+        data->apply_retries = PLUGIN_GET_CONFIG_INT(config, "apply_retries", 3);
+        if (data->apply_retries < 0) data->apply_retries = 0;
+        const char *parallel = PLUGIN_GET_CONFIG(config, "apply_parallel");
+        data->apply_logical_clock = parallel && strcasecmp(parallel, "logical_clock") == 0;
+        const char *binary = PLUGIN_GET_CONFIG(config, "apply_binary");
+        data->apply_binary_hex = binary && strcasecmp(binary, "hex") == 0;
+        pthread_mutex_init(&data->txn_mutex, NULL);
+    }
+    
     *plugin_data = data;
     
-    PLUGIN_LOG_INFO("MySQL publisher configured: %s:%d/%s.%s",
-                   data->host, data->port, data->database, data->table);
+    if (data->apply_mode) {
+        PLUGIN_LOG_INFO("MySQL publisher configured (apply): %s:%d/%s threads=%d batch_rows=%d parallel=%s",
+                       data->host, data->port,
+                       data->apply_use_source_db ? "<source db>" : data->database,
+                       data->apply_threads, data->apply_batch_rows,
+                       data->apply_logical_clock ? "logical_clock" : "table");
+    } else {
+        PLUGIN_LOG_INFO("MySQL publisher configured: %s:%d/%s.%s",
+                       data->host, data->port, data->database, data->table);
+    }
     
     return 0;
 }
 
+// ============================================================================
+// APPLY MODE
+// ============================================================================
+
+static int sql_reserve(sql_buf_t *sb, size_t extra) {
+    if (sb->len + extra + 1 <= sb->cap) return 0;
+    size_t cap = sb->cap ? sb->cap : 1024;
+    while (cap < sb->len + extra + 1) cap *= 2;
+    char *nb = realloc(sb->buf, cap);
+    if (!nb) return -1;
+    sb->buf = nb;
+    sb->cap = cap;
+    return 0;
+}
+
+static int sql_append(sql_buf_t *sb, const char *s, size_t n) {
+    if (sql_reserve(sb, n) != 0) return -1;
+    memcpy(sb->buf + sb->len, s, n);
+    sb->len += n;
+    sb->buf[sb->len] = '\0';
+    return 0;
+}
+
+static int sql_puts(sql_buf_t *sb, const char *s) {
+    return sql_append(sb, s, strlen(s));
+}
+
+// Append an identifier quoted with backticks
+static int sql_ident(sql_buf_t *sb, const char *name) {
+    if (sql_append(sb, "`", 1) != 0) return -1;
+    for (const char *c = name; *c; c++) {
+        if (*c == '`' && sql_append(sb, "`", 1) != 0) return -1;
+        if (sql_append(sb, c, 1) != 0) return -1;
+    }
+    return sql_append(sb, "`", 1);
+}
+
+// Append a JSON value from the event as a SQL literal
+static int sql_value(mysql_publisher_data_t *data, sql_buf_t *sb, json_object *val) {
+    if (!val) return sql_puts(sb, "NULL");
+
+    switch (json_object_get_type(val)) {
+        case json_type_null:
+            return sql_puts(sb, "NULL");
+        case json_type_boolean:
+            return sql_puts(sb, json_object_get_boolean(val) ? "1" : "0");
+        case json_type_int:
+        case json_type_double:
+            return sql_puts(sb, json_object_get_string(val));
+        default: {
+            const char *str = json_object_get_string(val);
+            size_t len = strlen(str);
+            if (sql_reserve(sb, len * 2 + 2) != 0) return -1;
+            sb->buf[sb->len++] = '\'';
+            sb->len += mysql_real_escape_string(data->conn, sb->buf + sb->len, str, len);
+            sb->buf[sb->len++] = '\'';
+            sb->buf[sb->len] = '\0';
+            return 0;
+        }
+    }
+}
+
+static int base64_value(int c) {
+    if (c >= 'A' && c <= 'Z') return c - 'A';
+    if (c >= 'a' && c <= 'z') return c - 'a' + 26;
+    if (c >= '0' && c <= '9') return c - '0' + 52;
+    if (c == '+') return 62;
+    if (c == '/') return 63;
+    return -1;
+}
+
+static int hex_value(int c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+// Append binary text from the event (base64 or hex) as a X'..' literal
+static int sql_binary(mysql_publisher_data_t *data, sql_buf_t *sb, const char *text) {
+    static const char digits[] = "0123456789ABCDEF";
+    size_t len = strlen(text);
+    if (sql_reserve(sb, len * 2 + 3) != 0) return -1;
+
+    size_t start = sb->len;
+    sb->buf[sb->len++] = 'X';
+    sb->buf[sb->len++] = '\'';
+    if (data->apply_binary_hex) {
+        if (len % 2) goto bad;
+        for (size_t i = 0; i < len; i++) {
+            if (hex_value((unsigned char)text[i]) < 0) goto bad;
+            sb->buf[sb->len++] = text[i];
+        }
+    } else {
+        uint32_t acc = 0;
+        int bits = 0;
+        for (size_t i = 0; i < len && text[i] != '='; i++) {
+            int v = base64_value((unsigned char)text[i]);
+            if (v < 0) goto bad;
+            acc = (acc << 6) | (uint32_t)v;
+            bits += 6;
+            if (bits >= 8) {
+                bits -= 8;
+                unsigned byte = (acc >> bits) & 0xFF;
+                sb->buf[sb->len++] = digits[byte >> 4];
+                sb->buf[sb->len++] = digits[byte & 15];
+            }
+        }
+    }
+    sb->buf[sb->len++] = '\'';
+    sb->buf[sb->len] = '\0';
+    return 0;
+
+bad:
+    sb->len = start;
+    sb->buf[sb->len] = '\0';
+    return -1;
+}
+
+// Placeholder the core sends instead of a value: blob store reference,
+// digest of a value too large for the event, or a truncated preview
+static int value_is_stub(json_object *val) {
+    if (!json_object_is_type(val, json_type_object)) return 0;
+    json_object *t;
+    return json_object_object_get_ex(val, "blob_ref", NULL) ||
+           (json_object_object_get_ex(val, "truncated", &t) && json_object_get_boolean(t));
+}
+
+// Append a column value; 1 if the event has no usable value for it
+static int sql_column_value(mysql_publisher_data_t *data, sql_buf_t *sb, int kind,
+                            json_object *val) {
+    if (!val || json_object_is_type(val, json_type_null)) return sql_puts(sb, "NULL");
+    if (value_is_stub(val)) return 1;
+
+    switch (kind) {
+        case APPLY_COL_BINARY:
+            if (!json_object_is_type(val, json_type_string)) return 1;
+            return sql_binary(data, sb, json_object_get_string(val)) == 0 ? 0 : 1;
+        case APPLY_COL_JSON: {
+            // The document itself, as JSON text
+            json_object *text = json_object_new_string(
+                json_object_to_json_string_ext(val, JSON_C_TO_STRING_PLAIN));
+            if (!text) return -1;
+            int ret = sql_value(data, sb, text);
+            json_object_put(text);
+            return ret;
+        }
+        default:
+            if (json_object_is_type(val, json_type_object) ||
+                json_object_is_type(val, json_type_array)) {
+                return 1;
+            }
+            return sql_value(data, sb, val);
+    }
+}
+
+static void schema_free(apply_table_schema_t *s) {
+    for (int i = 0; i < s->count; i++) free(s->names[i]);
+    free(s->names);
+    free(s->kinds);
+    free(s);
+}
+
+static void apply_schemas_free(mysql_publisher_data_t *data) {
+    apply_table_schema_t *s = data->schemas;
+    while (s) {
+        apply_table_schema_t *next = s->next;
+        schema_free(s);
+        s = next;
+    }
+    data->schemas = NULL;
+}
+
+static int column_kind(const char *type) {
+    static const char *binary[] = { "binary", "varbinary", "tinyblob", "blob", "mediumblob",
+                                    "longblob", "bit", NULL };
+    if (strcasecmp(type, "json") == 0) return APPLY_COL_JSON;
+    for (int i = 0; binary[i]; i++) {
+        if (strcasecmp(type, binary[i]) == 0) return APPLY_COL_BINARY;
+    }
+    return APPLY_COL_PLAIN;
+}
+
+// Columns of db.table on the target; NULL if they cannot be read now.
+// Caller holds txn_mutex (the control connection).
+static apply_table_schema_t* schema_for_table(mysql_publisher_data_t *data, const char *quoted,
+                                              const char *db, const char *table) {
+    for (apply_table_schema_t *s = data->schemas; s; s = s->next) {
+        if (strcmp(s->table, quoted) == 0) return s;
+    }
+
+    sql_buf_t q = {0};
+    json_object *db_val = json_object_new_string(db);
+    json_object *tbl_val = json_object_new_string(table);
+    sql_puts(&q, "SELECT COLUMN_NAME, DATA_TYPE FROM information_schema.COLUMNS "
+                 "WHERE TABLE_SCHEMA=");
+    sql_value(data, &q, db_val);
+    sql_puts(&q, " AND TABLE_NAME=");
+    sql_value(data, &q, tbl_val);
+    sql_puts(&q, " ORDER BY ORDINAL_POSITION");
+    json_object_put(db_val);
+    json_object_put(tbl_val);
+    if (!q.buf) return NULL;
+
+    int rc = mysql_query(data->conn, q.buf);
+    free(q.buf);
+    MYSQL_RES *res = rc == 0 ? mysql_store_result(data->conn) : NULL;
+    if (!res) {
+        PLUGIN_LOG_ERROR("Apply: cannot read the columns of %s: %s", quoted,
+                         mysql_error(data->conn));
+        return NULL;
+    }
+
+    apply_table_schema_t *s = calloc(1, sizeof(*s));
+    int rows = (int)mysql_num_rows(res);
+    if (s && rows > 0) {
+        s->names = calloc(rows, sizeof(char*));
+        s->kinds = calloc(rows, sizeof(int));
+    }
+    if (!s || (rows > 0 && (!s->names || !s->kinds))) {
+        if (s) schema_free(s);
+        mysql_free_result(res);
+        return NULL;
+    }
+    snprintf(s->table, sizeof(s->table), "%s", quoted);
+
+    MYSQL_ROW row;
+    while ((row = mysql_fetch_row(res)) && s->count < rows) {
+        if (!row[0] || !(s->names[s->count] = strdup(row[0]))) continue;
+        s->kinds[s->count++] = column_kind(row[1] ? row[1] : "");
+    }
+    mysql_free_result(res);
+
+    s->next = data->schemas;
+    data->schemas = s;
+    return s;
+}
+
+static int schema_column_kind(const apply_table_schema_t *s, const char *name) {
+    for (int i = 0; i < s->count; i++) {
+        if (strcasecmp(s->names[i], name) == 0) return s->kinds[i];
+    }
+    return -1;
+}
+
+static void batch_push_stmt(apply_table_batch_t *b, char *sql) {
+    if (b->stmt_count == b->stmt_cap) {
+        int cap = b->stmt_cap ? b->stmt_cap * 2 : 8;
+        char **ns = realloc(b->stmts, cap * sizeof(char*));
+        if (!ns) {
+            free(sql);
+            return;
+        }
+        b->stmts = ns;
+        b->stmt_cap = cap;
+    }
+    b->stmts[b->stmt_count++] = sql;
+}
+
+// Turn the open batch into a statement
+static void batch_close(mysql_publisher_data_t *data, apply_table_batch_t *b) {
+    (void)data;
+    if (b->rows == 0) return;
+
+    sql_buf_t sql = {0};
+    if (b->op == APPLY_OP_UPSERT) {
+        sql_puts(&sql, "INSERT INTO ");
+        sql_puts(&sql, b->table);
+        sql_puts(&sql, " (");
+        sql_puts(&sql, b->columns);
+        sql_puts(&sql, ") VALUES ");
+        sql_append(&sql, b->values.buf, b->values.len);
+        sql_puts(&sql, " ON DUPLICATE KEY UPDATE ");
+
+        // columns is "`a`,`b`" - emit `a`=VALUES(`a`) for each
+        const char *c = b->columns;
+        int first = 1;
+        while (*c) {
+            const char *end = c + 1;
+            while (*end && !(*end == '`' && end[1] != '`')) {
+                end += (*end == '`') ? 2 : 1;
+            }
+            if (*end) end++;
+            if (!first) sql_puts(&sql, ",");
+            first = 0;
+            sql_append(&sql, c, end - c);
+            sql_puts(&sql, "=VALUES(");
+            sql_append(&sql, c, end - c);
+            sql_puts(&sql, ")");
+            c = (*end == ',') ? end + 1 : end;
+        }
+    } else {
+        sql_puts(&sql, "DELETE FROM ");
+        sql_puts(&sql, b->table);
+        sql_puts(&sql, " WHERE (");
+        sql_puts(&sql, b->columns);
+        sql_puts(&sql, ") IN (");
+        sql_append(&sql, b->values.buf, b->values.len);
+        sql_puts(&sql, ")");
+    }
+
+    if (sql.buf) batch_push_stmt(b, sql.buf);
+
+    b->values.len = 0;
+    if (b->values.buf) b->values.buf[0] = '\0';
+    b->rows = 0;
+    free(b->columns);
+    b->columns = NULL;
+}
+
+static void batch_free(apply_table_batch_t *b) {
+    for (int i = 0; i < b->stmt_count; i++) free(b->stmts[i]);
+    free(b->stmts);
+    free(b->values.buf);
+    free(b->columns);
+    free(b);
+}
+
+static int lane_for_table(mysql_publisher_data_t *data, const char *table) {
+    uint32_t h = 2166136261u;
+    for (const unsigned char *c = (const unsigned char*)table; *c; c++) {
+        h = (h ^ *c) * 16777619u;
+    }
+    return (int)(h % (uint32_t)data->apply_threads);
+}
+
+// Batch of db.table; NULL if the target table cannot be written
+static apply_table_batch_t* batch_for_table(mysql_publisher_data_t *data,
+                                            const char *db, const char *table) {
+    const char *target_db = data->apply_use_source_db ? db : data->database;
+    sql_buf_t name = {0};
+    sql_ident(&name, target_db);
+    sql_puts(&name, ".");
+    sql_ident(&name, table);
+    if (!name.buf) return NULL;
+
+    apply_table_batch_t *b = data->batches;
+    apply_table_batch_t *last = NULL;
+    while (b) {
+        if (strcmp(b->table, name.buf) == 0) {
+            free(name.buf);
+            return b;
+        }
+        last = b;
+        b = b->next;
+    }
+
+    apply_table_schema_t *schema = schema_for_table(data, name.buf, target_db, table);
+    if (!schema || schema->count == 0) {
+        if (schema) PLUGIN_LOG_ERROR("Apply: table %s does not exist on the target", name.buf);
+        free(name.buf);
+        return NULL;
+    }
+
+    b = calloc(1, sizeof(*b));
+    if (!b) {
+        free(name.buf);
+        return NULL;
+    }
+    snprintf(b->table, sizeof(b->table), "%s", name.buf);
+    b->schema = schema;
+    free(name.buf);
+    b->lane = lane_for_table(data, b->table);
+
+    // Keep first-seen order so statements are dispatched deterministically
+    if (last) last->next = b;
+    else data->batches = b;
+    return b;
+}
+
+// Add one column to a row being built; 1 if the event has no usable value
+static int row_add_column(mysql_publisher_data_t *data, sql_buf_t *cols, sql_buf_t *vals,
+                          const char *name, int kind, json_object *val) {
+    size_t vals_len = vals->len;
+    if (vals->len) sql_puts(vals, ",");
+    int ret = sql_column_value(data, vals, kind, val);
+    if (ret != 0) {
+        vals->len = vals_len;
+        if (vals->buf) vals->buf[vals->len] = '\0';
+        return ret;
+    }
+    if (cols->len) sql_puts(cols, ",");
+    sql_ident(cols, name);
+    return 0;
+}
+
+// Add one row image to the table batch, closing the open batch when the
+// operation or column set changes or the batch is full. Returns -1 if the
+// row cannot be applied.
+static int batch_add_row(mysql_publisher_data_t *data, apply_table_batch_t *b,
+                         apply_op_t op, json_object *row, json_object *pk) {
+    sql_buf_t cols = {0};
+    sql_buf_t vals = {0};
+    const apply_table_schema_t *s = b->schema;
+    int skipped = 0;
+
+    if (op == APPLY_OP_UPSERT) {
+        for (int i = 0; i < s->count; i++) {
+            json_object *val;
+            if (!json_object_object_get_ex(row, s->names[i], &val)) continue;
+            if (row_add_column(data, &cols, &vals, s->names[i], s->kinds[i], val) != 0) {
+                skipped++;
+            }
+        }
+    } else {
+        int n = pk ? (int)json_object_array_length(pk) : 0;
+        for (int i = 0; i < n; i++) {
+            const char *key = json_object_get_string(json_object_array_get_idx(pk, i));
+            int kind = schema_column_kind(s, key);
+            json_object *val = json_object_object_get(row, key);
+            if (kind < 0 || !val || row_add_column(data, &cols, &vals, key, kind, val) != 0) {
+                PLUGIN_LOG_ERROR("Apply: no usable key column %s for DELETE on %s", key, b->table);
+                free(cols.buf);
+                free(vals.buf);
+                return -1;
+            }
+        }
+    }
+
+    if (skipped && !b->schema->skip_warned) {
+        PLUGIN_LOG_WARN("Apply: %s has values sent only as a reference or preview; "
+                        "those columns keep their target value", b->table);
+        b->schema->skip_warned = 1;
+    }
+
+    if (!cols.buf || !vals.buf) {
+        free(cols.buf);
+        free(vals.buf);
+        return -1;
+    }
+
+    if (b->rows > 0 &&
+        (b->op != op || strcmp(b->columns, cols.buf) != 0 ||
+         b->rows >= data->apply_batch_rows)) {
+        batch_close(data, b);
+    }
+
+    if (b->rows == 0) {
+        b->op = op;
+        b->columns = cols.buf;
+        cols.buf = NULL;
+    } else {
+        sql_puts(&b->values, ",");
+    }
+
+    sql_puts(&b->values, "(");
+    sql_append(&b->values, vals.buf, vals.len);
+    sql_puts(&b->values, ")");
+    b->rows++;
+
+    free(cols.buf);
+    free(vals.buf);
+    return 0;
+}
+
+// Returns 1 if the primary key values differ between before and after images
+static int pk_changed(json_object *before, json_object *after, json_object *pk) {
+    int n = pk ? (int)json_object_array_length(pk) : 0;
+    for (int i = 0; i < n; i++) {
+        const char *key = json_object_get_string(json_object_array_get_idx(pk, i));
+        json_object *bv = json_object_object_get(before, key);
+        json_object *av = json_object_object_get(after, key);
+        const char *bs = bv ? json_object_get_string(bv) : "";
+        const char *as = av ? json_object_get_string(av) : "";
+        if (strcmp(bs, as) != 0) return 1;
+    }
+    return 0;
+}
+
+static void lane_enqueue(apply_lane_t *lane, apply_unit_t *unit) {
+    pthread_mutex_lock(&lane->mutex);
+    while (lane->depth >= APPLY_QUEUE_DEPTH && !lane->stop) {
+        pthread_cond_wait(&lane->cond, &lane->mutex);
+    }
+    if (lane->tail) lane->tail->next = unit;
+    else lane->head = unit;
+    lane->tail = unit;
+    lane->depth++;
+    pthread_cond_broadcast(&lane->cond);
+    pthread_mutex_unlock(&lane->mutex);
+}
+
+// Wait until every lane has emptied its queue and finished its unit
+static void apply_wait_lanes_idle(mysql_publisher_data_t *data) {
+    for (int i = 0; i < data->apply_threads; i++) {
+        apply_lane_t *lane = &data->lanes[i];
+        pthread_mutex_lock(&lane->mutex);
+        while ((lane->depth > 0 || lane->busy) && !lane->stop) {
+            pthread_cond_wait(&lane->cond, &lane->mutex);
+        }
+        pthread_mutex_unlock(&lane->mutex);
+    }
+}
+
+static int apply_least_busy_lane(mysql_publisher_data_t *data) {
+    int best = 0, best_load = -1;
+    for (int i = 0; i < data->apply_threads; i++) {
+        apply_lane_t *lane = &data->lanes[i];
+        pthread_mutex_lock(&lane->mutex);
+        int load = lane->depth + lane->busy;
+        pthread_mutex_unlock(&lane->mutex);
+        if (best_load < 0 || load < best_load) {
+            best = i;
+            best_load = load;
+        }
+    }
+    return best;
+}
+
+// Order the open transaction against what is already running before it is
+// handed to the lanes. Returns the lane for the whole transaction, or -1 to
+// use the per-table lanes. Caller holds txn_mutex.
+static int apply_schedule_locked(mysql_publisher_data_t *data) {
+    if (!data->scheduler) return -1;
+
+    if (data->cur_seq <= 0) {
+        // No logical clock: everything tracked must finish first
+        publisher_helpers->txn_scheduler_drain(data->scheduler);
+        data->untracked_in_flight = 1;
+        return -1;
+    }
+
+    if (data->untracked_in_flight) {
+        apply_wait_lanes_idle(data);
+        data->untracked_in_flight = 0;
+    }
+
+    if (publisher_helpers->txn_scheduler_wait_ready(data->scheduler,
+                                                    data->cur_last_committed) != 0) {
+        return -1;
+    }
+    if (publisher_helpers->txn_scheduler_dispatched(data->scheduler, data->cur_seq) != 0) {
+        // Sequence went backwards or stopping: not tracked, order it like one
+        // without a clock
+        PLUGIN_LOG_WARN("Transaction sequence_number %lld not tracked, applying it serially",
+                        (long long)data->cur_seq);
+        publisher_helpers->txn_scheduler_drain(data->scheduler);
+        data->untracked_in_flight = 1;
+        return -1;
+    }
+    return apply_least_busy_lane(data);
+}
+
+// Hand the open transaction to the lanes; with final unset only what is
+// buffered so far, the rest follows on the same lane and the transaction
+// counts as complete for the scheduler once that last part ran. Caller
+// holds txn_mutex.
+static void apply_commit_locked(mysql_publisher_data_t *data, int final) {
+    if (!data->batches && !data->cur_partial) {
+        data->cur_txn[0] = '\0';
+        return;
+    }
+
+    apply_unit_t *units[APPLY_MAX_THREADS] = {0};
+    int whole_lane = data->cur_partial ? data->cur_partial_lane : apply_schedule_locked(data);
+
+    for (apply_table_batch_t *b = data->batches; b; b = b->next) {
+        batch_close(data, b);
+        if (b->stmt_count == 0) continue;
+
+        int lane = whole_lane >= 0 ? whole_lane : b->lane;
+        apply_unit_t *u = units[lane];
+        if (!u) {
+            u = calloc(1, sizeof(*u));
+            if (!u) continue;
+            snprintf(u->txn, sizeof(u->txn), "%s", data->cur_txn);
+            if (whole_lane >= 0 && final) u->seq = data->cur_seq;
+            units[lane] = u;
+        }
+        char **ns = realloc(u->stmts, (u->stmt_count + b->stmt_count) * sizeof(char*));
+        if (!ns) continue;
+        u->stmts = ns;
+        memcpy(u->stmts + u->stmt_count, b->stmts, b->stmt_count * sizeof(char*));
+        u->stmt_count += b->stmt_count;
+        b->stmt_count = 0;
+    }
+
+    apply_table_batch_t *b = data->batches;
+    while (b) {
+        apply_table_batch_t *next = b->next;
+        batch_free(b);
+        b = next;
+    }
+    data->batches = NULL;
+
+    // Dispatched but nothing left to run: an empty unit completes it behind
+    // the parts already queued
+    if (final && whole_lane >= 0 && !units[whole_lane] && data->cur_partial) {
+        apply_unit_t *u = calloc(1, sizeof(*u));
+        if (u) {
+            snprintf(u->txn, sizeof(u->txn), "%s", data->cur_txn);
+            u->seq = data->cur_seq;
+            units[whole_lane] = u;
+        }
+    }
+
+    for (int i = 0; i < data->apply_threads; i++) {
+        if (units[i]) lane_enqueue(&data->lanes[i], units[i]);
+    }
+
+    // Nothing to run at all (all statements failed to build)
+    if (final && whole_lane >= 0 && !units[whole_lane]) {
+        publisher_helpers->txn_scheduler_complete(data->scheduler, data->cur_seq);
+    }
+
+    if (!final) {
+        data->cur_partial = 1;
+        data->cur_partial_lane = whole_lane;
+        return;
+    }
+    data->cur_partial = 0;
+    data->txns_applied++;
+    data->cur_txn[0] = '\0';
+}
+
+static MYSQL* apply_connect(mysql_publisher_data_t *data);
+
+// Errors after which the same transaction may succeed on a new attempt
+static int apply_retryable(unsigned err) {
+    return err == CR_SERVER_GONE_ERROR || err == CR_SERVER_LOST ||
+           err == CR_CONNECTION_ERROR || err == CR_CONN_HOST_ERROR ||
+           err == ER_LOCK_DEADLOCK || err == ER_LOCK_WAIT_TIMEOUT;
+}
+
+// Apply one unit in a transaction. Returns 0 once committed, otherwise the
+// MySQL error (CR_SERVER_GONE_ERROR without a connection) after rolling back.
+static unsigned apply_unit_run(apply_lane_t *lane, apply_unit_t *u, uint64_t *rows) {
+    MYSQL *conn = lane->conn;
+    *rows = 0;
+    if (u->stmt_count == 0) return 0;
+    if (!conn) return CR_SERVER_GONE_ERROR;
+
+    const char *failed_stmt = NULL;
+    if (mysql_query(conn, "START TRANSACTION") != 0) {
+        failed_stmt = "START TRANSACTION";
+    }
+    for (int i = 0; i < u->stmt_count && !failed_stmt; i++) {
+        if (mysql_query(conn, u->stmts[i]) != 0) {
+            failed_stmt = u->stmts[i];
+        } else {
+            *rows += mysql_affected_rows(conn);
+        }
+    }
+    if (!failed_stmt && mysql_query(conn, "COMMIT") != 0) failed_stmt = "COMMIT";
+    if (!failed_stmt) return 0;
+
+    unsigned err = mysql_errno(conn);
+    PLUGIN_LOG_ERROR("Apply lane %d txn=%s failed: %s", lane->id, u->txn, mysql_error(conn));
+    PLUGIN_LOG_DEBUG("Failed statement: %.512s", failed_stmt);
+    mysql_query(conn, "ROLLBACK");
+    return err ? err : CR_SERVER_GONE_ERROR;
+}
+
+static void* apply_lane_thread(void *arg) {
+    apply_lane_t *lane = (apply_lane_t*)arg;
+    mysql_publisher_data_t *data = lane->owner;
+
+    mysql_thread_init();
+
+    while (1) {
+        pthread_mutex_lock(&lane->mutex);
+        while (!lane->head && !lane->stop) {
+            pthread_cond_wait(&lane->cond, &lane->mutex);
+        }
+        if (!lane->head && lane->stop) {
+            pthread_mutex_unlock(&lane->mutex);
+            break;
+        }
+        apply_unit_t *u = lane->head;
+        lane->head = u->next;
+        if (!lane->head) lane->tail = NULL;
+        lane->depth--;
+        lane->busy = 1;
+        pthread_cond_broadcast(&lane->cond);
+        pthread_mutex_unlock(&lane->mutex);
+
+        if (__atomic_load_n(&data->apply_halted, __ATOMIC_ACQUIRE)) {
+            // Never applied on top of a transaction that was lost
+            PLUGIN_LOG_DEBUG("Apply lane %d: halted, txn=%s not applied", lane->id, u->txn);
+        } else {
+            int delay = APPLY_RETRY_MIN_MS;
+            for (int attempt = 0; ; attempt++) {
+                uint64_t rows = 0;
+                unsigned err = apply_unit_run(lane, u, &rows);
+                if (err == 0) {
+                    __atomic_add_fetch(&data->rows_applied, rows, __ATOMIC_RELAXED);
+                    PLUGIN_LOG_TRACE("Apply lane %d committed txn=%s (%d statements)",
+                                    lane->id, u->txn, u->stmt_count);
+                    break;
+                }
+                if (!apply_retryable(err) || attempt >= data->apply_retries || lane->stop) {
+                    __atomic_add_fetch(&data->statements_failed, 1, __ATOMIC_RELAXED);
+                    __atomic_store_n(&data->apply_halted, 1, __ATOMIC_RELEASE);
+                    PLUGIN_LOG_ERROR("Apply lane %d: txn=%s failed after %d attempt(s), apply halted",
+                                    lane->id, u->txn, attempt + 1);
+                    break;
+                }
+
+                struct timespec ts = {delay / 1000, (long)(delay % 1000) * 1000000L};
+                nanosleep(&ts, NULL);
+                if (delay < APPLY_RETRY_MAX_MS) delay *= 2;
+                if (delay > APPLY_RETRY_MAX_MS) delay = APPLY_RETRY_MAX_MS;
+
+                // Reconnect between transactions only, never under one
+                if (err != ER_LOCK_DEADLOCK && err != ER_LOCK_WAIT_TIMEOUT) {
+                    if (lane->conn) mysql_close(lane->conn);
+                    lane->conn = apply_connect(data);
+                }
+                PLUGIN_LOG_WARN("Apply lane %d: retrying txn=%s (attempt %d of %d)",
+                               lane->id, u->txn, attempt + 2, data->apply_retries + 1);
+            }
+        }
+
+        // Failed or not, dependants must not wait on it forever
+        if (u->seq > 0 && data->scheduler) {
+            publisher_helpers->txn_scheduler_complete(data->scheduler, u->seq);
+        }
+
+        for (int i = 0; i < u->stmt_count; i++) free(u->stmts[i]);
+        free(u->stmts);
+        free(u);
+
+        pthread_mutex_lock(&lane->mutex);
+        lane->busy = 0;
+        pthread_cond_broadcast(&lane->cond);
+        pthread_mutex_unlock(&lane->mutex);
+    }
+
+    mysql_thread_end();
+    return NULL;
+}
+
+// Applies what is buffered of a transaction idle for apply_flush_ms, so the
+// tail of the stream is applied even when no further event arrives
+static void* apply_flusher_thread(void *arg) {
+    mysql_publisher_data_t *data = (mysql_publisher_data_t*)arg;
+
+    while (!__atomic_load_n(&data->flusher_stop, __ATOMIC_RELAXED)) {
+        struct timespec ts = {0, 50 * 1000000L};
+        nanosleep(&ts, NULL);
+
+        pthread_mutex_lock(&data->txn_mutex);
+        if (data->batches) {
+            struct timespec now;
+            clock_gettime(CLOCK_MONOTONIC, &now);
+            long idle_ms = (now.tv_sec - data->last_event.tv_sec) * 1000 +
+                           (now.tv_nsec - data->last_event.tv_nsec) / 1000000;
+            if (idle_ms >= data->apply_flush_ms) {
+                apply_commit_locked(data, 0);
+            }
+        }
+        pthread_mutex_unlock(&data->txn_mutex);
+    }
+    return NULL;
+}
+
+// No MYSQL_OPT_RECONNECT: a silent reconnect inside a transaction would
+// drop its first statements and run the rest in autocommit mode
+static MYSQL* apply_connect(mysql_publisher_data_t *data) {
+    MYSQL *conn = mysql_init(NULL);
+    if (!conn) return NULL;
+
+    if (!mysql_real_connect(conn,
+                            data->host,
+                            data->username[0] ? data->username : NULL,
+                            data->password[0] ? data->password : NULL,
+                            data->apply_use_source_db ? NULL : data->database,
+                            data->port,
+                            NULL,
+                            0)) {
+        PLUGIN_LOG_ERROR("Failed to connect to MySQL: %s", mysql_error(conn));
+        mysql_close(conn);
+        return NULL;
+    }
+    return conn;
+}
+
+static void apply_stop_lanes(mysql_publisher_data_t *data) {
+    if (data->scheduler) {
+        publisher_helpers->txn_scheduler_shutdown(data->scheduler);
+    }
+    if (!data->lanes) return;
+
+    for (int i = 0; i < data->apply_threads; i++) {
+        apply_lane_t *lane = &data->lanes[i];
+        pthread_mutex_lock(&lane->mutex);
+        lane->stop = 1;
+        pthread_cond_broadcast(&lane->cond);
+        pthread_mutex_unlock(&lane->mutex);
+    }
+    for (int i = 0; i < data->apply_threads; i++) {
+        apply_lane_t *lane = &data->lanes[i];
+        if (lane->thread_started) {
+            pthread_join(lane->thread, NULL);
+            lane->thread_started = 0;
+        }
+        if (lane->conn) {
+            mysql_close(lane->conn);
+            lane->conn = NULL;
+        }
+        pthread_mutex_destroy(&lane->mutex);
+        pthread_cond_destroy(&lane->cond);
+    }
+    free(data->lanes);
+    data->lanes = NULL;
+}
+
+static int apply_start(mysql_publisher_data_t *data) {
+    data->lanes = calloc(data->apply_threads, sizeof(apply_lane_t));
+    if (!data->lanes) return -1;
+
+    for (int i = 0; i < data->apply_threads; i++) {
+        apply_lane_t *lane = &data->lanes[i];
+        lane->id = i;
+        lane->owner = data;
+        pthread_mutex_init(&lane->mutex, NULL);
+        pthread_cond_init(&lane->cond, NULL);
+    }
+
+    for (int i = 0; i < data->apply_threads; i++) {
+        apply_lane_t *lane = &data->lanes[i];
+        lane->conn = apply_connect(data);
+        if (!lane->conn ||
+            pthread_create(&lane->thread, NULL, apply_lane_thread, lane) != 0) {
+            PLUGIN_LOG_ERROR("Failed to start apply lane %d", i);
+            apply_stop_lanes(data);
+            return -1;
+        }
+        lane->thread_started = 1;
+    }
+
+    if (data->apply_logical_clock) {
+        if (publisher_helpers->txn_scheduler_create) {
+            data->scheduler = publisher_helpers->txn_scheduler_create(APPLY_MAX_THREADS * APPLY_QUEUE_DEPTH);
+        }
+        if (!data->scheduler) {
+            PLUGIN_LOG_WARN("Logical clock scheduler unavailable, applying with per-table lanes");
+        }
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &data->last_event);
+    data->flusher_stop = 0;
+    if (pthread_create(&data->flusher, NULL, apply_flusher_thread, data) == 0) {
+        data->flusher_started = 1;
+    } else {
+        PLUGIN_LOG_WARN("Failed to start apply flusher; transactions commit on next event only");
+    }
+    return 0;
+}
+
+// A transaction that cannot be applied stops the apply for good
+static void apply_halt(mysql_publisher_data_t *data, const char *txn) {
+    if (!__atomic_exchange_n(&data->apply_halted, 1, __ATOMIC_ACQ_REL)) {
+        PLUGIN_LOG_ERROR("Apply: txn=%s cannot be applied, apply halted", txn);
+    }
+}
+
+static int apply_publish(mysql_publisher_data_t *data, const cdc_event_t *event) {
+    if (__atomic_load_n(&data->apply_halted, __ATOMIC_ACQUIRE)) {
+        __atomic_add_fetch(&data->events_failed, 1, __ATOMIC_RELAXED);
+        return -1;
+    }
+
+    json_object *root = json_tokener_parse(event->json);
+    if (!root) {
+        PLUGIN_LOG_WARN("Apply: cannot parse event JSON (txn=%s)", event->txn ? event->txn : "");
+        __atomic_add_fetch(&data->events_failed, 1, __ATOMIC_RELAXED);
+        return -1;
+    }
+
+    json_object *type_obj = json_object_object_get(root, "type");
+    const char *type = type_obj ? json_object_get_string(type_obj) : "";
+    const char *txn = event->txn ? event->txn : "";
+
+    pthread_mutex_lock(&data->txn_mutex);
+    clock_gettime(CLOCK_MONOTONIC, &data->last_event);
+
+    // A new transaction id closes the previous one even without a COMMIT event
+    if ((data->batches || data->cur_partial) && strcmp(data->cur_txn, txn) != 0) {
+        apply_commit_locked(data, 1);
+    }
+
+    int is_insert = strcmp(type, "INSERT") == 0;
+    int is_update = strcmp(type, "UPDATE") == 0;
+    int is_delete = strcmp(type, "DELETE") == 0;
+    int failed = 0;
+
+    if (is_insert || is_update || is_delete) {
+        if (!data->batches && !data->cur_partial) {
+            // Sequence numbers restart with each binlog file
+            const char *file = event->binlog_file ? event->binlog_file : "";
+            if (data->scheduler && strcmp(data->cur_binlog, file) != 0) {
+                publisher_helpers->txn_scheduler_drain(data->scheduler);
+                snprintf(data->cur_binlog, sizeof(data->cur_binlog), "%s", file);
+            }
+            data->cur_last_committed = event->last_committed;
+            data->cur_seq = event->sequence_number;
+        }
+        snprintf(data->cur_txn, sizeof(data->cur_txn), "%s", txn);
+
+        json_object *rows = json_object_object_get(root, "rows");
+        json_object *pk = json_object_object_get(root, "primary_key");
+        apply_table_batch_t *b = batch_for_table(data, event->db ? event->db : "",
+                                                 event->table ? event->table : "");
+        int nrows = rows ? (int)json_object_array_length(rows) : 0;
+        if (!b) failed = 1;
+
+        if ((is_delete || is_update) && (!pk || json_object_array_length(pk) == 0)) {
+            if (is_delete) {
+                PLUGIN_LOG_WARN("Apply: %s.%s has no primary_key configured, DELETE skipped",
+                               event->db, event->table);
+                nrows = 0;
+            }
+            pk = NULL;
+        }
+
+        for (int i = 0; b && !failed && i < nrows; i++) {
+            json_object *row = json_object_array_get_idx(rows, i);
+            if (is_insert) {
+                failed = batch_add_row(data, b, APPLY_OP_UPSERT, row, NULL) != 0;
+            } else if (is_delete) {
+                failed = batch_add_row(data, b, APPLY_OP_DELETE, row, pk) != 0;
+            } else {
+                json_object *before = json_object_object_get(row, "before");
+                json_object *after = json_object_object_get(row, "after");
+                if (!after) continue;
+                if (pk && before && pk_changed(before, after, pk)) {
+                    failed = batch_add_row(data, b, APPLY_OP_DELETE, before, pk) != 0;
+                }
+                if (!failed) failed = batch_add_row(data, b, APPLY_OP_UPSERT, after, NULL) != 0;
+            }
+        }
+    } else if (strcmp(type, "COMMIT") == 0 || strcmp(type, "ROLLBACK") == 0) {
+        apply_commit_locked(data, 1);
+    } else if (event->table && strcmp(event->table, type) == 0) {
+        // DDL: the target's columns are read again on next use
+        apply_commit_locked(data, 1);
+        apply_schemas_free(data);
+    }
+
+    pthread_mutex_unlock(&data->txn_mutex);
+    json_object_put(root);
+
+    if (failed) {
+        apply_halt(data, txn);
+        __atomic_add_fetch(&data->events_failed, 1, __ATOMIC_RELAXED);
+        return -1;
+    }
+    __atomic_add_fetch(&data->events_written, 1, __ATOMIC_RELAXED);
+    return 0;
+}
+
 static int start(void *plugin_data) {
     mysql_publisher_data_t *data = (mysql_publisher_data_t*)plugin_data;
     
     PLUGIN_LOG_INFO("Starting MySQL publisher");
     
+    if (data->apply_mode) {
+        // Control connection used for escaping and health checks
+        data->conn = apply_connect(data);
+        if (!data->conn) return -1;
+        if (apply_start(data) != 0) {
+            mysql_close(data->conn);
+            data->conn = NULL;
+            return -1;
+        }
+        PLUGIN_LOG_INFO("MySQL publisher started in apply mode: %s:%d (%d lanes)",
+                       data->host, data->port, data->apply_threads);
+        return 0;
+    }
+    
     // Initialize MySQL connection
     data->conn = mysql_init(NULL);
     if (!data->conn) {
@@ -144,11 +1281,15 @@ static int publish(void *plugin_data, const cdc_event_t *event) {
         return -1;
     }
     
+    if (data->apply_mode) {
+        return apply_publish(data, event);
+    }
+    
     // Escape JSON string for SQL
     size_t json_len = strlen(event->json);
     char *escaped_json = malloc(json_len * 2 + 1);
     if (!escaped_json) {
-        data->events_failed++;
+        __atomic_add_fetch(&data->events_failed, 1, __ATOMIC_RELAXED);
         return -1;
     }
     
@@ -172,11 +1313,11 @@ static int publish(void *plugin_data, const cdc_event_t *event) {
     // Execute query
     if (mysql_query(data->conn, query) != 0) {
         PLUGIN_LOG_ERROR("Failed to insert event: %s", mysql_error(data->conn));
-        data->events_failed++;
+        __atomic_add_fetch(&data->events_failed, 1, __ATOMIC_RELAXED);
         return -1;
     }
     
-    data->events_written++;
+    __atomic_add_fetch(&data->events_written, 1, __ATOMIC_RELAXED);
     
     PLUGIN_LOG_TRACE("Written to MySQL: db=%s, table=%s, txn=%s",
                     event->db, event->table, event->txn ? event->txn : "");
@@ -190,6 +1331,20 @@ static int stop(void *plugin_data) {
     PLUGIN_LOG_INFO("Stopping MySQL publisher (written=%llu, failed=%llu)",
                    data->events_written, data->events_failed);
     
+    if (data->apply_mode) {
+        if (data->flusher_started) {
+            __atomic_store_n(&data->flusher_stop, 1, __ATOMIC_RELAXED);
+            pthread_join(data->flusher, NULL);
+            data->flusher_started = 0;
+        }
+        pthread_mutex_lock(&data->txn_mutex);
+        apply_commit_locked(data, 1);
+        pthread_mutex_unlock(&data->txn_mutex);
+        apply_stop_lanes(data);
+        PLUGIN_LOG_INFO("Apply stats: txns=%llu rows=%llu failed_txns=%llu",
+                       data->txns_applied, data->rows_applied, data->statements_failed);
+    }
+    
     if (data->conn) {
         mysql_close(data->conn);
         data->conn = NULL;
@@ -202,6 +1357,20 @@ static void cleanup(void *plugin_data) {
     mysql_publisher_data_t *data = (mysql_publisher_data_t*)plugin_data;
     
     if (data) {
+        if (data->apply_mode) {
+            apply_stop_lanes(data);
+            apply_table_batch_t *b = data->batches;
+            while (b) {
+                apply_table_batch_t *next = b->next;
+                batch_free(b);
+                b = next;
+            }
+            if (data->scheduler) {
+                publisher_helpers->txn_scheduler_destroy(data->scheduler);
+            }
+            apply_schemas_free(data);
+            pthread_mutex_destroy(&data->txn_mutex);
+        }
         if (data->conn) {
             mysql_close(data->conn);
         }
@@ -218,6 +1387,26 @@ static int health_check(void *plugin_data) {
         return -1;
     }
     
+    if (data->apply_mode) {
+        if (__atomic_load_n(&data->apply_halted, __ATOMIC_ACQUIRE)) return -1;
+        // The control connection does not reconnect by itself; publish
+        // escapes with it under txn_mutex
+        int ret = 0;
+        pthread_mutex_lock(&data->txn_mutex);
+        if (mysql_ping(data->conn) != 0) {
+            MYSQL *conn = apply_connect(data);
+            if (conn) {
+                mysql_close(data->conn);
+                data->conn = conn;
+            } else {
+                PLUGIN_LOG_WARN("MySQL connection health check failed");
+                ret = -1;
+            }
+        }
+        pthread_mutex_unlock(&data->txn_mutex);
+        return ret;
+    }
+    
     // Ping the connection
     if (mysql_ping(data->conn) != 0) {
         PLUGIN_LOG_WARN("MySQL connection health check failed");
@@ -142,7 +142,8 @@ static int publish(void *plugin_data, const cdc_event_t *event) {
     redisReply *reply = NULL;
     
     if (data->use_streams) {
-        // Redis Streams mode: XADD stream_name * json <data> db <db> table <table>
+        // Redis Streams mode: XADD stream_name * json <data> db <db> table <table> ...
+        // The metadata fields let consumers filter without parsing json
         char stream_name[256];
         snprintf(stream_name, sizeof(stream_name), "%s%s.%s",
                 data->stream_prefix,
@@ -150,12 +151,17 @@ static int publish(void *plugin_data, const cdc_event_t *event) {
                 event->table ? event->table : "unknown");
         
         reply = redisCommand(data->redis, 
-                           "XADD %s * json %s db %s table %s txn %s",
+                           "XADD %s * json %s db %s table %s txn %s type %s key %s "
+                           "binlog_file %s position %llu",
                            stream_name,
                            event->json,
                            event->db ? event->db : "",
                            event->table ? event->table : "",
-                           event->txn ? event->txn : "");
+                           event->txn ? event->txn : "",
+                           event->type ? event->type : "",
+                           event->key ? event->key : "",
+                           event->binlog_file ? event->binlog_file : "",
+                           (unsigned long long)event->position);
     } else {
         // Pub/Sub mode: PUBLISH channel <json>
         reply = redisCommand(data->redis, "PUBLISH %s %s",
@@ -0,0 +1,718 @@
+// rollup_publisher.c
+// Windowed Rollup Publisher Plugin
+// Aggregates row events into tumbling windows per group and emits one
+// summary event per window and group to other publishers.
+//
+// Build: gcc -shared -fPIC -o rollup_publisher.so rollup_publisher.c -I. -ljson-c -lpthread
+//
+// Configuration:
+//   window_sec: window length in seconds (default: 60)
+//   group_by: columns to group on, e.g. "db,table,status". "db", "table" and
+//             "type" are the event's own fields; other names are row columns
+//             (the after image for UPDATE).
+//   aggregates: e.g. "count,sum(amount),min(amount),max(amount),avg(amount)".
+//               count(col) counts non-NULL values. Non-numeric values are ignored.
+//   types: row event types to include (default: "INSERT,UPDATE,DELETE")
+//   emit_to: publishers that receive the summaries (required)
+//   summary_db: db field of the summary events (default: "rollup")
+//   allowed_lateness_sec: keep a window open this long past its end (default: 0)
+//   max_groups: open window/group pairs kept in memory (default: 100000)
+//
+// Windows follow the binlog event time, so a replay produces the same
+// windows. A window closes once events past its end (plus the allowed
+// lateness) arrive. With "watermarks": true in the publisher entry, WATERMARK
+// events advance event time too, idle ones included; otherwise, while the
+// stream is idle, event time is advanced by the wall clock time elapsed since
+// the last event. Rows for a window that was already emitted open it again
+// and produce an additional summary with "late": true; summaries of the same
+// window and group add up. Open windows are emitted on stop; the
+// core stops publishers with an emit_to setting before all others, so these
+// summaries still reach running publishers.
+//
+// Summary event:
+//   {"type":"ROLLUP","name":"...","window_start":1700000000,"window_end":1700000060,
+//    "group":{"table":"orders","status":"paid"},"count":42,"sum_amount":1234.5}
+
+#include "publisher_api.h"
+#include <json-c/json.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <pthread.h>
+#include <time.h>
+
+#define ROLLUP_MAX_GROUP_BY    16
+#define ROLLUP_MAX_AGGREGATES  32
+#define ROLLUP_GROUP_SEP       '\x1f'
+
+typedef enum { AGG_COUNT, AGG_SUM, AGG_MIN, AGG_MAX, AGG_AVG } agg_fn_t;
+
+typedef struct {
+    agg_fn_t fn;
+    char column[128];           // empty: count(*)
+    char label[160];            // output field, e.g. sum_amount
+} agg_def_t;
+
+typedef struct {
+    uint64_t n;                 // values seen
+    double sum;
+    double min;
+    double max;
+} agg_state_t;
+
+// One open window of one group
+typedef struct {
+    uint64_t hash;              // 0 = empty slot
+    int64_t window_start;
+    int late;
+    char *group;                // group values as JSON, separated by ROLLUP_GROUP_SEP
+    uint64_t count;
+    agg_state_t aggs[];
+} rollup_entry_t;
+
+// Plugin private data
+typedef struct {
+    char name[128];
+    char summary_db[128];
+    char emit_to[512];
+    int window_sec;
+    int lateness_sec;
+    int max_groups;
+    int type_mask;              // 1 << kind for INSERT, UPDATE, DELETE
+
+    char group_by[ROLLUP_MAX_GROUP_BY][128];
+    int group_count;
+    agg_def_t aggs[ROLLUP_MAX_AGGREGATES];
+    int agg_count;
+
+    // Open windows, open addressing with linear probing
+    rollup_entry_t **slots;
+    size_t capacity;
+    size_t count;
+
+    int64_t max_event_time;
+    int64_t last_event_wall;    // wall clock of the event that set max_event_time
+    int64_t emitted_until;      // windows starting before this were emitted
+    int watermarked;            // WATERMARK events seen: they drive idle time, not the ticker
+    pthread_mutex_t mutex;
+
+    pthread_t ticker;
+    int ticker_started;
+    int stop;
+    pthread_cond_t stop_cond;
+
+    uint64_t rows_aggregated;
+    uint64_t rows_dropped;
+    uint64_t summaries_emitted;     // atomic, summaries are emitted without the mutex
+    uint64_t summaries_failed;
+} rollup_publisher_data_t;
+
+// ============================================================================
+// CONFIG
+// ============================================================================
+
+// Split a list given either as "a,b" or as a JSON array string
+static int split_list(const char *s, char out[][128], int max) {
+    int n = 0;
+    while (s && *s && n < max) {
+        while (*s == ',' || *s == ' ' || *s == '[' || *s == ']' || *s == '"') s++;
+        if (!*s) break;
+        const char *end = s;
+        int depth = 0;
+        while (*end && (depth > 0 || (*end != ',' && *end != '"' && *end != ']'))) {
+            if (*end == '(') depth++;
+            else if (*end == ')') depth--;
+            end++;
+        }
+        const char *last = end;
+        while (last > s && last[-1] == ' ') last--;
+        snprintf(out[n++], 128, "%.*s", (int)(last - s), s);
+        s = end;
+    }
+    return n;
+}
+
+static int parse_aggregate(const char *spec, agg_def_t *def) {
+    static const struct { const char *name; agg_fn_t fn; } fns[] = {
+        { "count", AGG_COUNT }, { "sum", AGG_SUM }, { "min", AGG_MIN },
+        { "max", AGG_MAX }, { "avg", AGG_AVG }
+    };
+
+    const char *open = strchr(spec, '(');
+    size_t name_len = open ? (size_t)(open - spec) : strlen(spec);
+    memset(def, 0, sizeof(*def));
+
+    int found = 0;
+    for (size_t i = 0; i < sizeof(fns) / sizeof(fns[0]); i++) {
+        if (strlen(fns[i].name) == name_len && strncasecmp(spec, fns[i].name, name_len) == 0) {
+            def->fn = fns[i].fn;
+            found = 1;
+        }
+    }
+    if (!found) return -1;
+
+    if (open) {
+        const char *close = strchr(open, ')');
+        if (!close) return -1;
+        snprintf(def->column, sizeof(def->column), "%.*s", (int)(close - open - 1), open + 1);
+        if (strcmp(def->column, "*") == 0) def->column[0] = '\0';
+    }
+    if (def->fn != AGG_COUNT && !def->column[0]) return -1;
+
+    if (def->column[0]) {
+        snprintf(def->label, sizeof(def->label), "%.*s_%s", (int)name_len, spec, def->column);
+    } else {
+        snprintf(def->label, sizeof(def->label), "count");
+    }
+    for (char *c = def->label; *c; c++) {
+        if (*c >= 'A' && *c <= 'Z') *c += 'a' - 'A';
+    }
+    return 0;
+}
+
+// ============================================================================
+// WINDOW TABLE
+// ============================================================================
+
+static uint64_t entry_hash(int64_t window_start, int late, const char *group) {
+    uint64_t h = 1469598103934665603ULL ^ (uint64_t)window_start ^ ((uint64_t)late << 63);
+    for (const char *p = group; *p; p++) {
+        h ^= (unsigned char)*p;
+        h *= 1099511628211ULL;
+    }
+    return h ? h : 1;
+}
+
+static size_t entry_size(const rollup_publisher_data_t *data) {
+    return sizeof(rollup_entry_t) + data->agg_count * sizeof(agg_state_t);
+}
+
+static int table_grow(rollup_publisher_data_t *data) {
+    size_t cap = data->capacity ? data->capacity * 2 : 256;
+    rollup_entry_t **slots = calloc(cap, sizeof(rollup_entry_t*));
+    if (!slots) return -1;
+    for (size_t i = 0; i < data->capacity; i++) {
+        rollup_entry_t *e = data->slots[i];
+        if (!e) continue;
+        size_t j = e->hash & (cap - 1);
+        while (slots[j]) j = (j + 1) & (cap - 1);
+        slots[j] = e;
+    }
+    free(data->slots);
+    data->slots = slots;
+    data->capacity = cap;
+    return 0;
+}
+
+// Find or create the entry for a window and group; caller holds mutex
+static rollup_entry_t* table_get(rollup_publisher_data_t *data, int64_t window_start,
+                                 int late, const char *group) {
+    uint64_t hash = entry_hash(window_start, late, group);
+    if (data->capacity) {
+        size_t i = hash & (data->capacity - 1);
+        while (data->slots[i]) {
+            rollup_entry_t *e = data->slots[i];
+            if (e->hash == hash && e->window_start == window_start && e->late == late &&
+                strcmp(e->group, group) == 0) {
+                return e;
+            }
+            i = (i + 1) & (data->capacity - 1);
+        }
+    }
+
+    if ((int)data->count >= data->max_groups) return NULL;
+    if ((data->count + 1) * 4 > data->capacity * 3 && table_grow(data) != 0) return NULL;
+
+    rollup_entry_t *e = calloc(1, entry_size(data));
+    if (!e) return NULL;
+    e->group = strdup(group);
+    if (!e->group) {
+        free(e);
+        return NULL;
+    }
+    e->hash = hash;
+    e->window_start = window_start;
+    e->late = late;
+
+    size_t i = hash & (data->capacity - 1);
+    while (data->slots[i]) i = (i + 1) & (data->capacity - 1);
+    data->slots[i] = e;
+    data->count++;
+    return e;
+}
+
+// ============================================================================
+// SUMMARIES
+// ============================================================================
+
+static void emit_summary(rollup_publisher_data_t *data, const rollup_entry_t *e) {
+    json_object *obj = json_object_new_object();
+    json_object_object_add(obj, "type", json_object_new_string("ROLLUP"));
+    json_object_object_add(obj, "name", json_object_new_string(data->name));
+    json_object_object_add(obj, "window_start", json_object_new_int64(e->window_start));
+    json_object_object_add(obj, "window_end",
+                           json_object_new_int64(e->window_start + data->window_sec));
+
+    json_object *group = json_object_new_object();
+    const char *p = e->group;
+    for (int g = 0; g < data->group_count; g++) {
+        const char *end = strchr(p, ROLLUP_GROUP_SEP);
+        size_t len = end ? (size_t)(end - p) : strlen(p);
+        char *text = strndup(p, len);
+        json_object *v = text ? json_tokener_parse(text) : NULL;
+        json_object_object_add(group, data->group_by[g], v);
+        free(text);
+        p = end ? end + 1 : p + len;
+    }
+    json_object_object_add(obj, "group", group);
+    json_object_object_add(obj, "count", json_object_new_int64((int64_t)e->count));
+
+    for (int a = 0; a < data->agg_count; a++) {
+        const agg_def_t *def = &data->aggs[a];
+        const agg_state_t *st = &e->aggs[a];
+        if (def->fn == AGG_COUNT && !def->column[0]) continue;   // already in "count"
+
+        json_object *v = NULL;
+        switch (def->fn) {
+            case AGG_COUNT: v = json_object_new_int64((int64_t)st->n); break;
+            case AGG_SUM:   v = json_object_new_double(st->sum); break;
+            case AGG_MIN:   v = st->n ? json_object_new_double(st->min) : NULL; break;
+            case AGG_MAX:   v = st->n ? json_object_new_double(st->max) : NULL; break;
+            case AGG_AVG:   v = st->n ? json_object_new_double(st->sum / st->n) : NULL; break;
+        }
+        json_object_object_add(obj, def->label, v);
+    }
+    if (e->late) json_object_object_add(obj, "late", json_object_new_boolean(1));
+
+    char txn[64];
+    snprintf(txn, sizeof(txn), "rollup-%lld", (long long)e->window_start);
+    cdc_event_t event = {
+        .db = data->summary_db,
+        .table = data->name,
+        .json = json_object_to_json_string_ext(obj, JSON_C_TO_STRING_PLAIN),
+        .txn = txn,
+        .timestamp = (uint32_t)(e->window_start + data->window_sec),
+        .type = "ROLLUP"
+    };
+
+    int rc = publisher_helpers->emit_event ?
+             publisher_helpers->emit_event(&event, data->emit_to) : -1;
+    if (rc > 0) {
+        PLUGIN_STAT_ADD(data->summaries_emitted, 1);
+    } else {
+        PLUGIN_STAT_ADD(data->summaries_failed, 1);
+        PLUGIN_LOG_WARN("Rollup %s: no publisher in '%s' accepted the summary",
+                        data->name, data->emit_to);
+    }
+    json_object_put(obj);
+}
+
+// Detach every window that started before cutoff; caller holds mutex. The
+// windows are emitted with emit_windows() after unlocking, since emitting
+// may block on the target queues.
+static rollup_entry_t** take_windows(rollup_publisher_data_t *data, int64_t cutoff,
+                                     size_t *taken) {
+    *taken = 0;
+    if (!data->count) return NULL;
+
+    size_t kept = 0;
+    rollup_entry_t **survivors = calloc(data->capacity, sizeof(rollup_entry_t*));
+    rollup_entry_t **done = calloc(data->count, sizeof(rollup_entry_t*));
+    if (!survivors || !done) {
+        free(survivors);
+        free(done);
+        return NULL;
+    }
+
+    for (size_t i = 0; i < data->capacity; i++) {
+        rollup_entry_t *e = data->slots[i];
+        if (!e) continue;
+        if (e->window_start + data->window_sec <= cutoff) {
+            done[(*taken)++] = e;
+        } else {
+            survivors[kept++] = e;
+        }
+    }
+
+    // Rebuild the probe sequences of what is left
+    memset(data->slots, 0, data->capacity * sizeof(rollup_entry_t*));
+    for (size_t k = 0; k < kept; k++) {
+        size_t i = survivors[k]->hash & (data->capacity - 1);
+        while (data->slots[i]) i = (i + 1) & (data->capacity - 1);
+        data->slots[i] = survivors[k];
+    }
+    data->count = kept;
+    free(survivors);
+
+    if (cutoff > data->emitted_until) data->emitted_until = cutoff - (cutoff % data->window_sec);
+    if (*taken == 0) {
+        free(done);
+        return NULL;
+    }
+    return done;
+}
+
+// Emit and free windows detached by take_windows(); call without the mutex
+static void emit_windows(rollup_publisher_data_t *data, rollup_entry_t **done, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        emit_summary(data, done[i]);
+        free(done[i]->group);
+        free(done[i]);
+    }
+    free(done);
+}
+
+// Close windows by wall clock when events stop arriving
+static void* ticker_thread(void *arg) {
+    rollup_publisher_data_t *data = arg;
+
+    pthread_mutex_lock(&data->mutex);
+    while (!data->stop) {
+        struct timespec ts;
+        clock_gettime(CLOCK_REALTIME, &ts);
+        ts.tv_sec += 1;
+        pthread_cond_timedwait(&data->stop_cond, &data->mutex, &ts);
+        if (data->stop) break;
+
+        // Let event time run on with the wall clock while idle
+        int64_t idle = (int64_t)time(NULL) - data->last_event_wall;
+        if (data->max_event_time && idle > 0 && !data->watermarked) {
+            size_t n;
+            rollup_entry_t **done = take_windows(data, data->max_event_time + idle -
+                                                 data->lateness_sec, &n);
+            if (done) {
+                pthread_mutex_unlock(&data->mutex);
+                emit_windows(data, done, n);
+                pthread_mutex_lock(&data->mutex);
+            }
+        }
+    }
+    pthread_mutex_unlock(&data->mutex);
+    return NULL;
+}
+
+// ============================================================================
+// ROW AGGREGATION
+// ============================================================================
+
+// Advance event time to ts and emit the windows that closed; with watermark
+// set, ts comes from a WATERMARK event
+static void advance_event_time(rollup_publisher_data_t *data, int64_t ts, int watermark) {
+    rollup_entry_t **done = NULL;
+    size_t n = 0;
+
+    pthread_mutex_lock(&data->mutex);
+    if (watermark) data->watermarked = 1;
+    if (ts > data->max_event_time) {
+        data->max_event_time = ts;
+        data->last_event_wall = time(NULL);
+        done = take_windows(data, ts - data->lateness_sec, &n);
+    }
+    pthread_mutex_unlock(&data->mutex);
+
+    if (done) emit_windows(data, done, n);
+}
+
+// Value of a group_by field: the event's own fields or a row column
+static json_object* field_value(json_object *root, json_object *row, const char *name) {
+    json_object *v = NULL;
+    if (strcmp(name, "db") == 0 || strcmp(name, "table") == 0 || strcmp(name, "type") == 0) {
+        json_object_object_get_ex(root, name, &v);
+    } else if (row) {
+        json_object_object_get_ex(row, name, &v);
+    }
+    return v;
+}
+
+static int numeric_value(json_object *v, double *out) {
+    if (!v) return -1;
+    switch (json_object_get_type(v)) {
+        case json_type_int:
+        case json_type_double:
+            *out = json_object_get_double(v);
+            return 0;
+        case json_type_string: {
+            const char *s = json_object_get_string(v);
+            char *end;
+            *out = strtod(s, &end);
+            return (end != s && *end == '\0') ? 0 : -1;
+        }
+        default:
+            return -1;
+    }
+}
+
+static void aggregate_row(rollup_publisher_data_t *data, json_object *root,
+                          json_object *row, int64_t window_start, int late) {
+    char group[2048];
+    size_t off = 0;
+    for (int g = 0; g < data->group_count; g++) {
+        json_object *v = field_value(root, row, data->group_by[g]);
+        const char *text = v ? json_object_to_json_string_ext(v, JSON_C_TO_STRING_PLAIN) : "null";
+        size_t len = strlen(text);
+        if (off + len + 2 > sizeof(group)) {
+            data->rows_dropped++;
+            return;
+        }
+        if (g) group[off++] = ROLLUP_GROUP_SEP;
+        memcpy(group + off, text, len);
+        off += len;
+    }
+    group[off] = '\0';
+
+    rollup_entry_t *e = table_get(data, window_start, late, group);
+    if (!e) {
+        if (data->rows_dropped++ == 0) {
+            PLUGIN_LOG_WARN("Rollup %s: max_groups (%d) reached, dropping rows",
+                            data->name, data->max_groups);
+        }
+        return;
+    }
+
+    e->count++;
+    for (int a = 0; a < data->agg_count; a++) {
+        const agg_def_t *def = &data->aggs[a];
+        if (!def->column[0]) continue;
+
+        json_object *v = NULL;
+        if (row) json_object_object_get_ex(row, def->column, &v);
+        agg_state_t *st = &e->aggs[a];
+
+        if (def->fn == AGG_COUNT) {
+            if (v && !json_object_is_type(v, json_type_null)) st->n++;
+            continue;
+        }
+        double d;
+        if (numeric_value(v, &d) != 0) continue;
+        if (st->n == 0 || d < st->min) st->min = d;
+        if (st->n == 0 || d > st->max) st->max = d;
+        st->sum += d;
+        st->n++;
+    }
+    data->rows_aggregated++;
+}
+
+// ============================================================================
+// PLUGIN CALLBACKS
+// ============================================================================
+
+static const char* get_name(void) {
+    return "rollup_publisher";
+}
+
+static const char* get_version(void) {
+    return "1.0.0";
+}
+
+static int get_api_version(void) {
+    return PUBLISHER_API_VERSION;
+}
+
+static int init(const publisher_config_t *config, void **plugin_data) {
+    rollup_publisher_data_t *data = calloc(1, sizeof(rollup_publisher_data_t));
+    if (!data) {
+        PLUGIN_LOG_ERROR("Failed to allocate rollup publisher data");
+        return -1;
+    }
+
+    snprintf(data->name, sizeof(data->name), "%s", config->name ? config->name : "rollup");
+
+    const char *emit_to = PLUGIN_GET_CONFIG(config, "emit_to");
+    if (!emit_to || !emit_to[0]) {
+        PLUGIN_LOG_ERROR("Rollup %s: missing required config: emit_to", data->name);
+        free(data);
+        return -1;
+    }
+    char targets[16][128];
+    int target_count = split_list(emit_to, targets, 16);
+    for (int i = 0; i < target_count; i++) {
+        size_t len = strlen(data->emit_to);
+        snprintf(data->emit_to + len, sizeof(data->emit_to) - len, "%s%s",
+                 i ? "," : "", targets[i]);
+    }
+
+    const char *summary_db = PLUGIN_GET_CONFIG(config, "summary_db");
+    snprintf(data->summary_db, sizeof(data->summary_db), "%s",
+             summary_db && summary_db[0] ? summary_db : "rollup");
+
+    data->window_sec = PLUGIN_GET_CONFIG_INT(config, "window_sec", 60);
+    if (data->window_sec < 1) data->window_sec = 1;
+    data->lateness_sec = PLUGIN_GET_CONFIG_INT(config, "allowed_lateness_sec", 0);
+    if (data->lateness_sec < 0) data->lateness_sec = 0;
+    data->max_groups = PLUGIN_GET_CONFIG_INT(config, "max_groups", 100000);
+    if (data->max_groups < 1) data->max_groups = 1;
+
+    data->group_count = split_list(PLUGIN_GET_CONFIG(config, "group_by"),
+                                   data->group_by, ROLLUP_MAX_GROUP_BY);
+
+    const char *aggregates = PLUGIN_GET_CONFIG(config, "aggregates");
+    char specs[ROLLUP_MAX_AGGREGATES][128];
+    int spec_count = split_list(aggregates ? aggregates : "count", specs, ROLLUP_MAX_AGGREGATES);
+    for (int i = 0; i < spec_count; i++) {
+        if (parse_aggregate(specs[i], &data->aggs[data->agg_count]) == 0) {
+            data->agg_count++;
+        } else {
+            PLUGIN_LOG_WARN("Rollup %s: ignoring aggregate '%s'", data->name, specs[i]);
+        }
+    }
+
+    char types[3][128];
+    int type_count = split_list(PLUGIN_GET_CONFIG(config, "types"), types, 3);
+    if (type_count == 0) data->type_mask = 7;
+    for (int i = 0; i < type_count; i++) {
+        if (strcasecmp(types[i], "INSERT") == 0) data->type_mask |= 1;
+        else if (strcasecmp(types[i], "UPDATE") == 0) data->type_mask |= 2;
+        else if (strcasecmp(types[i], "DELETE") == 0) data->type_mask |= 4;
+        else PLUGIN_LOG_WARN("Rollup %s: unknown type '%s'", data->name, types[i]);
+    }
+
+    pthread_mutex_init(&data->mutex, NULL);
+    pthread_cond_init(&data->stop_cond, NULL);
+
+    PLUGIN_LOG_INFO("Rollup %s: %d s windows, %d group column(s), %d aggregate(s), emitting to %s",
+                    data->name, data->window_sec, data->group_count, data->agg_count,
+                    data->emit_to);
+
+    *plugin_data = data;
+    return 0;
+}
+
+static int start(void *plugin_data) {
+    rollup_publisher_data_t *data = plugin_data;
+    if (!publisher_helpers->emit_event) {
+        PLUGIN_LOG_ERROR("Rollup %s: core does not support emit_event", data->name);
+        return -1;
+    }
+    if (pthread_create(&data->ticker, NULL, ticker_thread, data) != 0) {
+        PLUGIN_LOG_ERROR("Rollup %s: failed to start window thread", data->name);
+        return -1;
+    }
+    data->ticker_started = 1;
+    return 0;
+}
+
+static int publish(void *plugin_data, const cdc_event_t *event) {
+    rollup_publisher_data_t *data = plugin_data;
+    if (!data || !event || !event->json) return -1;
+
+    if (event->type && strcmp(event->type, "WATERMARK") == 0) {
+        if (event->timestamp) advance_event_time(data, event->timestamp, 1);
+        return 0;
+    }
+
+    json_object *root = json_tokener_parse(event->json);
+    if (!root) {
+        PLUGIN_LOG_WARN("Rollup %s: cannot parse event JSON", data->name);
+        return -1;
+    }
+
+    json_object *type = NULL, *rows = NULL;
+    json_object_object_get_ex(root, "type", &type);
+    json_object_object_get_ex(root, "rows", &rows);
+    const char *t = type ? json_object_get_string(type) : "";
+    int kind = strcmp(t, "INSERT") == 0 ? 1 : strcmp(t, "UPDATE") == 0 ? 2 :
+               strcmp(t, "DELETE") == 0 ? 4 : 0;
+
+    if (!(kind & data->type_mask) || !rows || !json_object_is_type(rows, json_type_array)) {
+        json_object_put(root);
+        return 0;
+    }
+
+    int64_t ts = event->timestamp ? (int64_t)event->timestamp : (int64_t)time(NULL);
+    int64_t window_start = ts - (ts % data->window_sec);
+
+    pthread_mutex_lock(&data->mutex);
+    int late = window_start < data->emitted_until;
+
+    size_t n = json_object_array_length(rows);
+    for (size_t i = 0; i < n; i++) {
+        json_object *row = json_object_array_get_idx(rows, i);
+        if (kind == 2) {
+            json_object *after = NULL;
+            if (json_object_object_get_ex(row, "after", &after)) row = after;
+        }
+        aggregate_row(data, root, json_object_is_type(row, json_type_object) ? row : NULL,
+                      window_start, late);
+    }
+    pthread_mutex_unlock(&data->mutex);
+
+    advance_event_time(data, ts, 0);
+
+    json_object_put(root);
+    return 0;
+}
+
+static int stop(void *plugin_data) {
+    rollup_publisher_data_t *data = plugin_data;
+
+    pthread_mutex_lock(&data->mutex);
+    data->stop = 1;
+    pthread_cond_signal(&data->stop_cond);
+    pthread_mutex_unlock(&data->mutex);
+    if (data->ticker_started) {
+        pthread_join(data->ticker, NULL);
+        data->ticker_started = 0;
+    }
+
+    // Emit whatever is still open
+    size_t n;
+    pthread_mutex_lock(&data->mutex);
+    rollup_entry_t **done = take_windows(data, INT64_MAX - data->window_sec, &n);
+    pthread_mutex_unlock(&data->mutex);
+    if (done) emit_windows(data, done, n);
+
+    PLUGIN_LOG_INFO("Stopping rollup %s (rows=%llu dropped=%llu summaries=%llu failed=%llu)",
+                    data->name, (unsigned long long)data->rows_aggregated,
+                    (unsigned long long)data->rows_dropped,
+                    (unsigned long long)PLUGIN_STAT_GET(data->summaries_emitted),
+                    (unsigned long long)PLUGIN_STAT_GET(data->summaries_failed));
+    return 0;
+}
+
+static void cleanup(void *plugin_data) {
+    rollup_publisher_data_t *data = plugin_data;
+    if (!data) return;
+
+    for (size_t i = 0; i < data->capacity; i++) {
+        if (data->slots[i]) {
+            free(data->slots[i]->group);
+            free(data->slots[i]);
+        }
+    }
+    free(data->slots);
+    pthread_mutex_destroy(&data->mutex);
+    pthread_cond_destroy(&data->stop_cond);
+    free(data);
+}
+
+static int health_check(void *plugin_data) {
+    rollup_publisher_data_t *data = plugin_data;
+    return (data && data->ticker_started) ? 0 : -1;
+}
+
+// Plugin callbacks
+static const publisher_callbacks_t callbacks = {
+    .get_name = get_name,
+    .get_version = get_version,
+    .get_api_version = get_api_version,
+    .init = init,
+    .start = start,
+    .stop = stop,
+    .cleanup = cleanup,
+    .publish = publish,
+    .publish_batch = NULL,
+    .health_check = health_check,
+};
+
+// Plugin entry point
+PUBLISHER_PLUGIN_DEFINE(rollup_publisher) {
+    publisher_plugin_t *p = malloc(sizeof(publisher_plugin_t));
+    if (!p) return -1;
+
+    p->callbacks = &callbacks;
+    p->plugin_data = NULL;
+
+    *plugin = p;
+    return 0;
+}
@@ -1,13 +1,58 @@
 // udp_publisher.c
 // UDP Publisher Plugin - Send CDC events via UDP datagrams
 //
-// Build: gcc -shared -fPIC -o udp_publisher.so udp_publisher.c -I.
+// Build: gcc -shared -fPIC -o udp_publisher.so udp_publisher.c -I. -lpthread
 //
 // Configuration:
 //   udp_host: Target hostname or IP address (required)
 //   udp_port: Target UDP port (required)
 //   max_packet_size: Maximum UDP packet size in bytes (default: 65507)
 //   add_newline: Add newline after each JSON event (default: yes)
+//   metadata_header: Prefix each datagram with the binary header below (default: no)
+//
+// Multicast (on when udp_host is a 224.0.0.0/4 group):
+//   multicast_ttl: Hops the datagrams may travel (default: 1, the local subnet)
+//   multicast_interface: IPv4 address of the outgoing interface (default: routing table)
+//   multicast_loop: Deliver to receivers on this host too (default: yes)
+//   retransmit_buffer: Datagrams kept for retransmission (default: 4096)
+//   nack_port: Local port NACKs are sent to (default: ephemeral, the source
+//              port of the datagrams)
+//   heartbeat_ms: Interval of idle heartbeats announcing the last sequence
+//                 (default: 1000)
+//
+// In multicast mode every datagram starts with a sequence header, integers
+// in network byte order:
+//   0   4  magic "BLSQ"
+//   4   1  version (1)
+//   5   1  flags: 1 retransmission, 2 heartbeat (no payload),
+//                 4 lost (payload: be32 count of sequences no longer buffered)
+//   6   2  reserved (0)
+//   8   8  session, new each time the publisher starts
+//   16  8  sequence, from 1; a heartbeat carries the last one sent
+//   24     payload, as sent in unicast mode
+//
+// A receiver that sees a gap sends a NACK to the datagram's source address:
+//   0   4  magic "BLNK"
+//   4   4  reserved (0)
+//   8   8  session
+//   16  8  first missing sequence
+//   24  4  count
+// Buffered datagrams are multicast again, once per NACK holdoff, so every
+// receiver missing them recovers. See scripts/monitors/udp_multicast_receiver.py.
+//
+// Metadata header, integers in network byte order:
+//   0   4  magic "BLSH"
+//   4   1  version (1)
+//   5   1  event type: 0 other, 1 INSERT, 2 UPDATE, 3 DELETE, 4 COMMIT,
+//            5 DDL or other statement (QUERY), 6 WATERMARK, 7 ROLLUP
+//   6   2  header length, strings included (JSON starts here)
+//   8   8  binlog position
+//   16  4  event timestamp
+//   20  2  db length          22  2  table length     24  2  txn length
+//   26  2  key length         28  2  binlog_file length
+//   30  1  flags: 1 a string was cut to its first 4096 bytes
+//   31  1  reserved (0)
+//   32     db, table, txn, key, binlog_file, not NUL terminated
 
 #include "publisher_api.h"
 #include <stdio.h>
@@ -19,6 +64,35 @@
 #include <arpa/inet.h>
 #include <netdb.h>
 #include <errno.h>
+#include <poll.h>
+#include <pthread.h>
+#include <time.h>
+
+#define UDP_HEADER_MAGIC    "BLSH"
+#define UDP_HEADER_VERSION  1
+#define UDP_HEADER_FIXED    32
+#define UDP_HEADER_STR_MAX  4096
+#define UDP_HEADER_TRUNCATED 1
+
+#define UDP_SEQ_MAGIC       "BLSQ"
+#define UDP_NACK_MAGIC      "BLNK"
+#define UDP_SEQ_VERSION     1
+#define UDP_SEQ_HEADER      24
+#define UDP_NACK_LEN        28
+#define UDP_FLAG_RETRANSMIT 1
+#define UDP_FLAG_HEARTBEAT  2
+#define UDP_FLAG_LOST       4
+#define UDP_NACK_HOLDOFF_MS 20      // one resend per datagram per holdoff
+#define UDP_NACK_POLL_MS    100
+
+// Sent datagram kept for NACKs, at slot seq % retransmit_buffer
+typedef struct {
+    uint64_t seq;                   // 0 = empty
+    unsigned char *buf;             // sequence header + payload
+    size_t len;
+    size_t cap;
+    uint64_t resent_ms;
+} udp_slot_t;
 
 // Plugin private data
 typedef struct {
@@ -28,6 +102,24 @@ typedef struct {
     struct sockaddr_in server_addr;
     int max_packet_size;
     int add_newline;
+    int metadata_header;
+    
+    // Multicast: sequenced datagrams, NACK thread resends from the ring
+    int multicast;
+    int heartbeat_ms;
+    uint64_t session;
+    uint64_t last_seq;              // under ring_mutex
+    uint64_t last_send_ms;
+    udp_slot_t *ring;
+    int ring_size;
+    pthread_mutex_t ring_mutex;
+    pthread_t nack_thread;
+    int nack_started;
+    volatile int nack_stop;
+    uint64_t nacks_received;
+    uint64_t packets_resent;
+    uint64_t packets_lost;          // NACKed after leaving the ring
+    
     uint64_t events_sent;
     uint64_t events_failed;
     uint64_t bytes_sent;
@@ -66,6 +158,168 @@ static int resolve_hostname(const char *hostname, struct in_addr *addr) {
     return 0;
 }
 
+static uint64_t now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000 + (uint64_t)ts.tv_nsec / 1000000;
+}
+
+static void put_be32(unsigned char *p, uint32_t v) {
+    for (int i = 0; i < 4; i++) p[i] = (unsigned char)(v >> (24 - 8 * i));
+}
+
+static void put_be64(unsigned char *p, uint64_t v) {
+    for (int i = 0; i < 8; i++) p[i] = (unsigned char)(v >> (56 - 8 * i));
+}
+
+static uint32_t get_be32(const unsigned char *p) {
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+static uint64_t get_be64(const unsigned char *p) {
+    uint64_t v = 0;
+    for (int i = 0; i < 8; i++) v = (v << 8) | p[i];
+    return v;
+}
+
+static void build_seq_header(const udp_publisher_data_t *data, unsigned char *buf,
+                             int flags, uint64_t seq) {
+    memcpy(buf, UDP_SEQ_MAGIC, 4);
+    buf[4] = UDP_SEQ_VERSION;
+    buf[5] = (unsigned char)flags;
+    buf[6] = buf[7] = 0;
+    put_be64(buf + 8, data->session);
+    put_be64(buf + 16, seq);
+}
+
+static ssize_t send_datagram(udp_publisher_data_t *data, const void *buf, size_t len) {
+    return sendto(data->sockfd, buf, len, 0,
+                  (struct sockaddr*)&data->server_addr, sizeof(data->server_addr));
+}
+
+// Announce the last sequence so receivers notice a lost tail
+static void send_heartbeat(udp_publisher_data_t *data) {
+    unsigned char buf[UDP_SEQ_HEADER];
+    pthread_mutex_lock(&data->ring_mutex);
+    build_seq_header(data, buf, UDP_FLAG_HEARTBEAT, data->last_seq);
+    data->last_send_ms = now_ms();
+    pthread_mutex_unlock(&data->ring_mutex);
+    send_datagram(data, buf, sizeof(buf));
+}
+
+// Resend first..first+count-1 from the ring, report the rest as lost
+static void handle_nack(udp_publisher_data_t *data, const unsigned char *msg, size_t len) {
+    if (len < UDP_NACK_LEN || memcmp(msg, UDP_NACK_MAGIC, 4) != 0) return;
+    if (get_be64(msg + 8) != data->session) return;    // for an earlier run
+    uint64_t first = get_be64(msg + 16);
+    uint32_t count = get_be32(msg + 24);
+    if (first == 0 || count == 0) return;
+    if (count > (uint32_t)data->ring_size) count = (uint32_t)data->ring_size;
+
+    PLUGIN_STAT_ADD(data->nacks_received, 1);
+    uint64_t now = now_ms();
+    uint64_t lost_first = 0;
+    uint32_t lost = 0;
+
+    pthread_mutex_lock(&data->ring_mutex);
+    for (uint64_t seq = first; seq < first + count && seq <= data->last_seq; seq++) {
+        udp_slot_t *slot = &data->ring[seq % data->ring_size];
+        if (slot->seq != seq) {
+            if (!lost) lost_first = seq;
+            lost++;
+            continue;
+        }
+        if (slot->resent_ms && now - slot->resent_ms < UDP_NACK_HOLDOFF_MS) continue;
+        slot->resent_ms = now;
+        slot->buf[5] = UDP_FLAG_RETRANSMIT;
+        send_datagram(data, slot->buf, slot->len);
+        PLUGIN_STAT_ADD(data->packets_resent, 1);
+    }
+    pthread_mutex_unlock(&data->ring_mutex);
+
+    if (lost) {
+        unsigned char buf[UDP_SEQ_HEADER + 4];
+        build_seq_header(data, buf, UDP_FLAG_LOST, lost_first);
+        put_be32(buf + UDP_SEQ_HEADER, lost);
+        send_datagram(data, buf, sizeof(buf));
+        PLUGIN_STAT_ADD(data->packets_lost, lost);
+        PLUGIN_LOG_WARN("NACK for %u datagram(s) from %llu no longer buffered",
+                        lost, (unsigned long long)lost_first);
+    }
+}
+
+// Reads NACKs arriving on the sending socket and sends idle heartbeats
+static void* nack_loop(void *arg) {
+    udp_publisher_data_t *data = (udp_publisher_data_t*)arg;
+    struct pollfd pfd = { .fd = data->sockfd, .events = POLLIN };
+    unsigned char msg[64];
+
+    while (!data->nack_stop) {
+        if (poll(&pfd, 1, UDP_NACK_POLL_MS) > 0) {
+            ssize_t n = recv(data->sockfd, msg, sizeof(msg), MSG_DONTWAIT);
+            if (n > 0) handle_nack(data, msg, (size_t)n);
+        }
+        pthread_mutex_lock(&data->ring_mutex);
+        uint64_t idle = now_ms() - data->last_send_ms;
+        pthread_mutex_unlock(&data->ring_mutex);
+        if (idle >= (uint64_t)data->heartbeat_ms) send_heartbeat(data);
+    }
+    return NULL;
+}
+
+static int setup_multicast(udp_publisher_data_t *data, const publisher_config_t *config) {
+    unsigned char ttl = (unsigned char)PLUGIN_GET_CONFIG_INT(config, "multicast_ttl", 1);
+    unsigned char loop = (unsigned char)PLUGIN_GET_CONFIG_BOOL(config, "multicast_loop", 1);
+    if (setsockopt(data->sockfd, IPPROTO_IP, IP_MULTICAST_TTL, &ttl, sizeof(ttl)) != 0 ||
+        setsockopt(data->sockfd, IPPROTO_IP, IP_MULTICAST_LOOP, &loop, sizeof(loop)) != 0) {
+        PLUGIN_LOG_ERROR("Failed to configure multicast: %s", strerror(errno));
+        return -1;
+    }
+
+    const char *iface = PLUGIN_GET_CONFIG(config, "multicast_interface");
+    if (iface) {
+        struct in_addr ifaddr;
+        if (inet_pton(AF_INET, iface, &ifaddr) != 1 ||
+            setsockopt(data->sockfd, IPPROTO_IP, IP_MULTICAST_IF, &ifaddr, sizeof(ifaddr)) != 0) {
+            PLUGIN_LOG_ERROR("Invalid multicast_interface: %s", iface);
+            return -1;
+        }
+    }
+
+    // NACKs come back to the port the datagrams are sent from
+    struct sockaddr_in local;
+    memset(&local, 0, sizeof(local));
+    local.sin_family = AF_INET;
+    local.sin_addr.s_addr = htonl(INADDR_ANY);
+    local.sin_port = htons((uint16_t)PLUGIN_GET_CONFIG_INT(config, "nack_port", 0));
+    if (bind(data->sockfd, (struct sockaddr*)&local, sizeof(local)) != 0) {
+        PLUGIN_LOG_ERROR("Failed to bind NACK port: %s", strerror(errno));
+        return -1;
+    }
+
+    data->ring_size = PLUGIN_GET_CONFIG_INT(config, "retransmit_buffer", 4096);
+    if (data->ring_size < 1) data->ring_size = 1;
+    data->heartbeat_ms = PLUGIN_GET_CONFIG_INT(config, "heartbeat_ms", 1000);
+    if (data->heartbeat_ms < 10) data->heartbeat_ms = 10;
+    data->ring = calloc(data->ring_size, sizeof(udp_slot_t));
+    if (!data->ring) {
+        PLUGIN_LOG_ERROR("Failed to allocate retransmit buffer");
+        return -1;
+    }
+    pthread_mutex_init(&data->ring_mutex, NULL);
+    data->session = ((uint64_t)time(NULL) << 32) ^ ((uint64_t)getpid() << 16) ^ now_ms();
+    data->multicast = 1;
+    return 0;
+}
+
+static void free_ring(udp_publisher_data_t *data) {
+    if (!data->ring) return;
+    for (int i = 0; i < data->ring_size; i++) free(data->ring[i].buf);
+    free(data->ring);
+    data->ring = NULL;
+    pthread_mutex_destroy(&data->ring_mutex);
+}
+
 // Initialize publisher
 static int init(const publisher_config_t *config, void **plugin_data) {
     PLUGIN_LOG_INFO("Initializing UDP publisher");
@@ -118,6 +372,8 @@ static int init(const publisher_config_t *config, void **plugin_data) {
         data->add_newline = 1;  // Default: add newline
     }
     
+    data->metadata_header = PLUGIN_GET_CONFIG_BOOL(config, "metadata_header", 0);
+    
     // Create UDP socket
     data->sockfd = socket(AF_INET, SOCK_DGRAM, 0);
     if (data->sockfd < 0) {
@@ -141,11 +397,28 @@ static int init(const publisher_config_t *config, void **plugin_data) {
     data->server_addr.sin_port = htons(data->port);
     data->server_addr.sin_addr = server_ip;
     
+    if (IN_MULTICAST(ntohl(server_ip.s_addr))) {
+        if (setup_multicast(data, config) != 0) {
+            free_ring(data);
+            close(data->sockfd);
+            free(data);
+            return -1;
+        }
+        if (data->max_packet_size > 65507 - UDP_SEQ_HEADER) {
+            data->max_packet_size = 65507 - UDP_SEQ_HEADER;
+        }
+    }
+    
     *plugin_data = data;
     
-    PLUGIN_LOG_INFO("UDP publisher configured: host=%s, port=%d, max_packet_size=%d, add_newline=%s",
+    PLUGIN_LOG_INFO("UDP publisher configured: host=%s, port=%d, max_packet_size=%d, add_newline=%s, metadata_header=%s",
                    data->host, data->port, data->max_packet_size, 
-                   data->add_newline ? "yes" : "no");
+                   data->add_newline ? "yes" : "no",
+                   data->metadata_header ? "yes" : "no");
+    if (data->multicast) {
+        PLUGIN_LOG_INFO("UDP multicast: session=%016llx, retransmit_buffer=%d, heartbeat_ms=%d",
+                       (unsigned long long)data->session, data->ring_size, data->heartbeat_ms);
+    }
     
     return 0;
 }
@@ -161,6 +434,19 @@ static int start(void *plugin_data) {
     
     PLUGIN_LOG_INFO("Starting UDP publisher: %s:%d", data->host, data->port);
     
+    if (data->multicast) {
+        // A heartbeat instead of the test packet, receivers expect sequenced datagrams
+        data->nack_stop = 0;
+        send_heartbeat(data);
+        if (pthread_create(&data->nack_thread, NULL, nack_loop, data) != 0) {
+            PLUGIN_LOG_ERROR("Failed to start NACK thread");
+            return -1;
+        }
+        data->nack_started = 1;
+        PLUGIN_LOG_INFO("UDP publisher started: multicast %s:%d", data->host, data->port);
+        return 0;
+    }
+    
     // Test connectivity by sending a small test packet
     const char *test_msg = "{\"test\":\"connection\"}";
     ssize_t sent = sendto(data->sockfd, test_msg, strlen(test_msg), 0,
@@ -178,6 +464,66 @@ static int start(void *plugin_data) {
     return 0;
 }
 
+static void put_be16(unsigned char *p, uint16_t v) {
+    p[0] = (unsigned char)(v >> 8);
+    p[1] = (unsigned char)v;
+}
+
+static int event_type_code(const char *type) {
+    if (!type) return 0;
+    if (strcmp(type, "INSERT") == 0) return 1;
+    if (strcmp(type, "UPDATE") == 0) return 2;
+    if (strcmp(type, "DELETE") == 0) return 3;
+    if (strcmp(type, "COMMIT") == 0) return 4;
+    static const char *statements[] = { "QUERY", "CREATE", "ALTER", "DROP",
+                                        "TRUNCATE", "RENAME" };
+    for (size_t i = 0; i < sizeof(statements) / sizeof(statements[0]); i++) {
+        if (strcmp(type, statements[i]) == 0) return 5;
+    }
+    if (strcmp(type, "WATERMARK") == 0) return 6;
+    if (strcmp(type, "ROLLUP") == 0) return 7;
+    return 0;
+}
+
+// Write the metadata header into buf (NULL: size only); returns its length
+static size_t build_metadata_header(const cdc_event_t *event, unsigned char *buf) {
+    const char *strs[5] = { event->db, event->table, event->txn, event->key,
+                            event->binlog_file };
+    uint16_t lens[5];
+    size_t total = UDP_HEADER_FIXED;
+    int flags = 0;
+    for (int i = 0; i < 5; i++) {
+        size_t l = strs[i] ? strlen(strs[i]) : 0;
+        if (l > UDP_HEADER_STR_MAX) {
+            l = UDP_HEADER_STR_MAX;
+            flags |= UDP_HEADER_TRUNCATED;
+        }
+        lens[i] = (uint16_t)l;
+        total += lens[i];
+    }
+    if (!buf) return total;
+
+    memcpy(buf, UDP_HEADER_MAGIC, 4);
+    buf[4] = UDP_HEADER_VERSION;
+    buf[5] = (unsigned char)event_type_code(event->type);
+    put_be16(buf + 6, (uint16_t)total);
+    for (int i = 0; i < 8; i++) {
+        buf[8 + i] = (unsigned char)(event->position >> (56 - 8 * i));
+    }
+    for (int i = 0; i < 4; i++) {
+        buf[16 + i] = (unsigned char)(event->timestamp >> (24 - 8 * i));
+    }
+    unsigned char *dst = buf + UDP_HEADER_FIXED;
+    for (int i = 0; i < 5; i++) {
+        put_be16(buf + 20 + 2 * i, lens[i]);
+        if (lens[i]) memcpy(dst, strs[i], lens[i]);
+        dst += lens[i];
+    }
+    buf[30] = (unsigned char)flags;
+    buf[31] = 0;
+    return total;
+}
+
 // Publish event
 static int publish(void *plugin_data, const cdc_event_t *event) {
     udp_publisher_data_t *data = (udp_publisher_data_t*)plugin_data;
@@ -189,47 +535,76 @@ static int publish(void *plugin_data, const cdc_event_t *event) {
     
     if (!event || !event->json) {
         PLUGIN_LOG_ERROR("Invalid event data");
-        data->events_failed++;
+        PLUGIN_STAT_ADD(data->events_failed, 1);
         return -1;
     }
     
     // Prepare packet
     size_t json_len = strlen(event->json);
-    size_t packet_len = json_len + (data->add_newline ? 1 : 0);
+    size_t seq_len = data->multicast ? UDP_SEQ_HEADER : 0;
+    size_t header_len = data->metadata_header ? build_metadata_header(event, NULL) : 0;
+    size_t packet_len = header_len + json_len + (data->add_newline ? 1 : 0);
     
     // Check if packet fits
     if (packet_len > data->max_packet_size) {
         PLUGIN_LOG_WARN("Event too large for UDP packet: %zu bytes (max: %d) - dropping",
                        packet_len, data->max_packet_size);
-        data->packets_dropped++;
-        data->events_failed++;
+        PLUGIN_STAT_ADD(data->packets_dropped, 1);
+        PLUGIN_STAT_ADD(data->events_failed, 1);
         return -1;
     }
     
     // Allocate buffer
+    packet_len += seq_len;
     char *packet = malloc(packet_len);
     if (!packet) {
         PLUGIN_LOG_ERROR("Failed to allocate packet buffer");
-        data->events_failed++;
+        PLUGIN_STAT_ADD(data->events_failed, 1);
         return -1;
     }
     
-    // Copy JSON and optionally add newline
-    memcpy(packet, event->json, json_len);
+    // Header, JSON and optionally a newline
+    if (header_len) build_metadata_header(event, (unsigned char*)packet + seq_len);
+    memcpy(packet + seq_len + header_len, event->json, json_len);
     if (data->add_newline) {
-        packet[json_len] = '\n';
+        packet[seq_len + header_len + json_len] = '\n';
     }
     
-    // Send UDP packet
-    ssize_t sent = sendto(data->sockfd, packet, packet_len, 0,
-                         (struct sockaddr*)&data->server_addr,
-                         sizeof(data->server_addr));
+    ssize_t sent;
+    if (data->multicast) {
+        // Numbered and kept in the ring before it goes out, so a NACK
+        // racing the send can already be answered
+        pthread_mutex_lock(&data->ring_mutex);
+        uint64_t seq = PLUGIN_STAT_ADD(data->last_seq, 1) + 1;
+        build_seq_header(data, (unsigned char*)packet, 0, seq);
+        udp_slot_t *slot = &data->ring[seq % data->ring_size];
+        if (slot->cap < packet_len) {
+            unsigned char *nb = realloc(slot->buf, packet_len);
+            if (nb) {
+                slot->buf = nb;
+                slot->cap = packet_len;
+            }
+        }
+        if (slot->cap >= packet_len) {
+            memcpy(slot->buf, packet, packet_len);
+            slot->len = packet_len;
+            slot->seq = seq;
+            slot->resent_ms = 0;
+        } else {
+            slot->seq = 0;
+        }
+        data->last_send_ms = now_ms();
+        sent = send_datagram(data, packet, packet_len);
+        pthread_mutex_unlock(&data->ring_mutex);
+    } else {
+        sent = send_datagram(data, packet, packet_len);
+    }
     
     free(packet);
     
     if (sent < 0) {
         PLUGIN_LOG_ERROR("Failed to send UDP packet: %s", strerror(errno));
-        data->events_failed++;
+        PLUGIN_STAT_ADD(data->events_failed, 1);
         return -1;
     }
     
@@ -237,8 +612,8 @@ static int publish(void *plugin_data, const cdc_event_t *event) {
         PLUGIN_LOG_WARN("Partial UDP send: %zd of %zu bytes", sent, packet_len);
     }
     
-    data->events_sent++;
-    data->bytes_sent += sent;
+    PLUGIN_STAT_ADD(data->events_sent, 1);
+    PLUGIN_STAT_ADD(data->bytes_sent, (uint64_t)sent);
     
     PLUGIN_LOG_TRACE("Published event to UDP %s:%d: txn=%s, db=%s, table=%s, size=%zu",
                     data->host, data->port,
@@ -259,10 +634,23 @@ static int stop(void *plugin_data) {
         return -1;
     }
     
+    if (data->nack_started) {
+        data->nack_stop = 1;
+        pthread_join(data->nack_thread, NULL);
+        data->nack_started = 0;
+    }
+    
     PLUGIN_LOG_INFO("Stopping UDP publisher: %s:%d (sent=%llu, failed=%llu, dropped=%llu, bytes=%llu)",
                    data->host, data->port,
                    data->events_sent, data->events_failed, 
                    data->packets_dropped, data->bytes_sent);
+    if (data->multicast) {
+        PLUGIN_LOG_INFO("UDP multicast: last_seq=%llu, nacks=%llu, resent=%llu, lost=%llu",
+                       (unsigned long long)data->last_seq,
+                       (unsigned long long)data->nacks_received,
+                       (unsigned long long)data->packets_resent,
+                       (unsigned long long)data->packets_lost);
+    }
     
     return 0;
 }
@@ -275,10 +663,16 @@ static void cleanup(void *plugin_data) {
         return;
     }
     
+    if (data->nack_started) {
+        data->nack_stop = 1;
+        pthread_join(data->nack_thread, NULL);
+    }
+    
     if (data->sockfd >= 0) {
         close(data->sockfd);
     }
     
+    free_ring(data);
     free(data);
     
     PLUGIN_LOG_INFO("UDP publisher cleaned up");
@@ -308,6 +702,21 @@ static int health_check(void *plugin_data) {
     return 0;
 }
 
+static int get_stats(void *plugin_data, publisher_stat_t *stats, int max) {
+    udp_publisher_data_t *data = (udp_publisher_data_t*)plugin_data;
+    if (!data || max < 8) return 0;
+    stats[0] = (publisher_stat_t){ "events_sent", PLUGIN_STAT_GET(data->events_sent) };
+    stats[1] = (publisher_stat_t){ "events_failed", PLUGIN_STAT_GET(data->events_failed) };
+    stats[2] = (publisher_stat_t){ "bytes_sent", PLUGIN_STAT_GET(data->bytes_sent) };
+    stats[3] = (publisher_stat_t){ "packets_dropped", PLUGIN_STAT_GET(data->packets_dropped) };
+    if (!data->multicast) return 4;
+    stats[4] = (publisher_stat_t){ "last_seq", PLUGIN_STAT_GET(data->last_seq) };
+    stats[5] = (publisher_stat_t){ "nacks_received", PLUGIN_STAT_GET(data->nacks_received) };
+    stats[6] = (publisher_stat_t){ "packets_resent", PLUGIN_STAT_GET(data->packets_resent) };
+    stats[7] = (publisher_stat_t){ "packets_lost", PLUGIN_STAT_GET(data->packets_lost) };
+    return 8;
+}
+
 // Plugin callbacks
 static const publisher_callbacks_t callbacks = {
     .get_name = get_name,
@@ -320,6 +729,7 @@ static const publisher_callbacks_t callbacks = {
     .publish = publish,
     .publish_batch = NULL,  // Not implemented
     .health_check = health_check,
+    .get_stats = get_stats,
 };
 
 // Plugin entry point
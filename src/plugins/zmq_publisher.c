@@ -5,6 +5,7 @@
 
 #include "publisher_api.h"
 #include <zmq.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <errno.h>
@@ -16,6 +17,7 @@ typedef struct {
     char endpoint[256];
     int send_timeout_ms;
     int subscriber_filtering;
+    int metadata_frames;        // event metadata frames before the JSON
     uint64_t messages_sent;
     uint64_t send_failures;
 } zmq_publisher_data_t;
@@ -56,6 +58,7 @@ static int init(const publisher_config_t *config, void **plugin_data) {
     // Get optional timeout
     data->send_timeout_ms = PLUGIN_GET_CONFIG_INT(config, "send_timeout_ms", 1000);
     data->subscriber_filtering = PLUGIN_GET_CONFIG_BOOL(config, "subscriber_filtering", 0);
+    data->metadata_frames = PLUGIN_GET_CONFIG_BOOL(config, "metadata_frames", 0);
     *plugin_data = data;
     
     PLUGIN_LOG_INFO("ZMQ publisher configured: endpoint=%s, timeout=%dms",
@@ -64,25 +67,11 @@ static int init(const publisher_config_t *config, void **plugin_data) {
     return 0;
 }
 
-// Start publisher
-static int start(void *plugin_data) {
-    zmq_publisher_data_t *data = (zmq_publisher_data_t*)plugin_data;
-    
-    PLUGIN_LOG_INFO("Starting ZMQ publisher: %s", data->endpoint);
-    
-    // Create ZMQ context
-    data->zmq_context = zmq_ctx_new();
-    if (!data->zmq_context) {
-        PLUGIN_LOG_ERROR("Failed to create ZMQ context");
-        return -1;
-    }
-    
-    // Create PUB socket
+// Create and bind the PUB socket
+static int open_socket(zmq_publisher_data_t *data) {
     data->zmq_socket = zmq_socket(data->zmq_context, ZMQ_PUB);
     if (!data->zmq_socket) {
         PLUGIN_LOG_ERROR("Failed to create ZMQ socket");
-        zmq_ctx_destroy(data->zmq_context);
-        data->zmq_context = NULL;
         return -1;
     }
     
@@ -95,8 +84,41 @@ static int start(void *plugin_data) {
         PLUGIN_LOG_ERROR("Failed to bind ZMQ socket to %s: %s",
                         data->endpoint, zmq_strerror(errno));
         zmq_close(data->zmq_socket);
-        zmq_ctx_destroy(data->zmq_context);
         data->zmq_socket = NULL;
+        return -1;
+    }
+    return 0;
+}
+
+// A send failed after the first frame: the socket is left inside a
+// multipart message, and the next send would continue it. Replace the
+// socket; if that fails publish() retries on the next event.
+static void reset_socket(zmq_publisher_data_t *data) {
+    int linger = 0;
+    zmq_setsockopt(data->zmq_socket, ZMQ_LINGER, &linger, sizeof(linger));
+    zmq_unbind(data->zmq_socket, data->endpoint);
+    zmq_close(data->zmq_socket);
+    data->zmq_socket = NULL;
+    if (open_socket(data) == 0) {
+        PLUGIN_LOG_WARN("ZMQ socket on %s recreated after a partial message", data->endpoint);
+    }
+}
+
+// Start publisher
+static int start(void *plugin_data) {
+    zmq_publisher_data_t *data = (zmq_publisher_data_t*)plugin_data;
+    
+    PLUGIN_LOG_INFO("Starting ZMQ publisher: %s", data->endpoint);
+    
+    // Create ZMQ context
+    data->zmq_context = zmq_ctx_new();
+    if (!data->zmq_context) {
+        PLUGIN_LOG_ERROR("Failed to create ZMQ context");
+        return -1;
+    }
+    
+    if (open_socket(data) != 0) {
+        zmq_ctx_destroy(data->zmq_context);
         data->zmq_context = NULL;
         return -1;
     }
@@ -109,36 +131,53 @@ static int start(void *plugin_data) {
 static int publish(void *plugin_data, const cdc_event_t *event) {
     zmq_publisher_data_t *data = (zmq_publisher_data_t*)plugin_data;
     
-    if (!data->zmq_socket || !event || !event->json) {
+    if (!data || !event || !event->json) {
         return -1;
     }
-    int rc = -1;
+    if (!data->zmq_socket && (!data->zmq_context || open_socket(data) != 0)) {
+        PLUGIN_STAT_ADD(data->send_failures, 1);
+        return -1;
+    }
+    
+    // Frames: ["db.table" topic], [type, db, table, txn,
+    // "binlog_file:position", key (empty when unknown)], JSON. All are
+    // built first so a failure cannot come from preparing a frame.
+    const char *frames[8];
+    int nframes = 0;
     char topic[256];
-    // Build topic: "db.table"
+    char position[320];
     if(data->subscriber_filtering){
         snprintf(topic, sizeof(topic), "%s.%s",
                 event->db ? event->db : "unknown",
                 event->table ? event->table : "unknown");
-
-        // Send multi-part message: [topic, json]
-        rc = zmq_send(data->zmq_socket, topic, strlen(topic), ZMQ_SNDMORE);
-        if (rc < 0) {
-            data->send_failures++;
-            PLUGIN_LOG_WARN("ZMQ send topic failed: %s", zmq_strerror(errno));
-            return -1;
-        }
+        frames[nframes++] = topic;
     } else {
         topic[0] = '\0';
     }
+    if (data->metadata_frames) {
+        snprintf(position, sizeof(position), "%s:%llu",
+                 event->binlog_file ? event->binlog_file : "",
+                 (unsigned long long)event->position);
+        const char *meta[] = { event->type, event->db, event->table, event->txn,
+                               position, event->key };
+        for (int i = 0; i < 6; i++) frames[nframes++] = meta[i] ? meta[i] : "";
+    }
+    frames[nframes++] = event->json;
     
-    rc = zmq_send(data->zmq_socket, event->json, strlen(event->json), 0);
-    if (rc < 0) {
-        data->send_failures++;
-        PLUGIN_LOG_WARN("ZMQ send message failed: %s", zmq_strerror(errno));
-        return -1;
+    for (int i = 0; i < nframes; i++) {
+        int last = i == nframes - 1;
+        if (zmq_send(data->zmq_socket, frames[i], strlen(frames[i]),
+                     last ? 0 : ZMQ_SNDMORE) < 0) {
+            PLUGIN_STAT_ADD(data->send_failures, 1);
+            PLUGIN_LOG_WARN("ZMQ send of frame %d/%d failed: %s", i + 1, nframes,
+                            zmq_strerror(errno));
+            // Nothing was queued if the first frame failed
+            if (i > 0) reset_socket(data);
+            return -1;
+        }
     }
     
-    data->messages_sent++;
+    PLUGIN_STAT_ADD(data->messages_sent, 1);
     
     PLUGIN_LOG_TRACE("Published to ZMQ: topic=%s, txn=%s",
                     strlen(topic) > 0 ? topic : "none", event->txn ? event->txn : "");
@@ -202,6 +241,14 @@ static int health_check(void *plugin_data) {
     return (data && data->zmq_socket) ? 0 : -1;
 }
 
+static int get_stats(void *plugin_data, publisher_stat_t *stats, int max) {
+    zmq_publisher_data_t *data = (zmq_publisher_data_t*)plugin_data;
+    if (!data || max < 2) return 0;
+    stats[0] = (publisher_stat_t){ "messages_sent", PLUGIN_STAT_GET(data->messages_sent) };
+    stats[1] = (publisher_stat_t){ "send_failures", PLUGIN_STAT_GET(data->send_failures) };
+    return 2;
+}
+
 // Plugin callbacks
 static const publisher_callbacks_t callbacks = {
     .get_name = get_name,
@@ -214,6 +261,7 @@ static const publisher_callbacks_t callbacks = {
     .publish = publish,
     .publish_batch = publish_batch,
     .health_check = health_check,
+    .get_stats = get_stats,
 };
 
 // Plugin entry point
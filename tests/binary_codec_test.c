@@ -0,0 +1,153 @@
+// binary_codec_test.c
+// base64 SIMD against scalar, SHA-256 known answers and the blob store
+//
+// Includes binary_codec.c to reach its static encoders.
+
+#include "../src/core/binary_codec.c"
+#include "unit.h"
+#include <stdlib.h>
+#include <sys/stat.h>
+
+static int hex_is(const unsigned char digest[SHA256_DIGEST_LEN], const char *expect) {
+    char hex[SHA256_HEX_LEN + 1];
+    hex_encode(digest, SHA256_DIGEST_LEN, hex);
+    return strcmp(hex, expect) == 0;
+}
+
+static void test_base64_vectors(void) {
+    // RFC 4648 section 10
+    static const char *in[] = { "", "f", "fo", "foo", "foob", "fooba", "foobar" };
+    static const char *out[] = { "", "Zg==", "Zm8=", "Zm9v", "Zm9vYg==", "Zm9vYmE=", "Zm9vYmFy" };
+    int ok = 1;
+    for (int i = 0; i < 7; i++) {
+        char dst[16];
+        size_t n = base64_encode((const unsigned char*)in[i], strlen(in[i]), dst);
+        ok &= n == strlen(out[i]) && strcmp(dst, out[i]) == 0;
+    }
+    CHECK("base64: RFC 4648 test vectors", ok);
+}
+
+// Every length up to 4 blocks past the 12/16 byte steps, all residues mod 3,
+// random bytes: the SIMD encoder must produce exactly the scalar output
+static void test_base64_simd_matches_scalar(void) {
+#ifdef HAVE_SSSE3_BASE64
+    if (!cpu_has_ssse3()) {
+        CHECK("base64: ssse3 not supported by this CPU, scalar only", 1);
+        return;
+    }
+    unsigned char src[1024];
+    char a[BASE64_ENCODED_LEN(sizeof(src)) + 1];
+    char b[BASE64_ENCODED_LEN(sizeof(src)) + 1];
+    srand(12345);
+
+    int mismatches = 0, boundary_mismatches = 0;
+    for (int round = 0; round < 50; round++) {
+        for (size_t i = 0; i < sizeof(src); i++) src[i] = (unsigned char)rand();
+        for (size_t len = 0; len <= 80 || (round == 0 && len <= sizeof(src)); len++) {
+            size_t na = base64_encode_scalar(src, len, a);
+            size_t nb = len >= 16 ? base64_encode_ssse3(src, len, b) : base64_encode(src, len, b);
+            if (na != nb || na != BASE64_ENCODED_LEN(len) || memcmp(a, b, na + 1) != 0) {
+                mismatches++;
+                if (len % 12 <= 4 || len % 16 <= 1) boundary_mismatches++;
+            }
+        }
+    }
+    CHECK("base64: ssse3 matches scalar for every length 0-1024, all residues mod 3",
+          mismatches == 0);
+    CHECK("base64: ssse3 matches scalar across the 12/16 byte block boundaries",
+          boundary_mismatches == 0);
+
+    // All 256 byte values in every lane position
+    int ok = 1;
+    for (int shift = 0; shift < 3; shift++) {
+        for (int i = 0; i < 256; i++) src[i] = (unsigned char)(i + shift * 85);
+        size_t na = base64_encode_scalar(src, 256, a);
+        size_t nb = base64_encode_ssse3(src, 256, b);
+        ok &= na == nb && memcmp(a, b, na + 1) == 0;
+    }
+    CHECK("base64: ssse3 matches scalar for every byte value", ok);
+#else
+    CHECK("base64: no ssse3 encoder on this architecture, scalar only", 1);
+#endif
+}
+
+static void test_sha256_known_answers(void) {
+    static const struct { const char *in; const char *hex; } kat[] = {
+        { "", "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855" },
+        { "abc", "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad" },
+        { "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq",
+          "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1" },
+    };
+    unsigned char d[SHA256_DIGEST_LEN];
+    int ok = 1;
+    for (size_t i = 0; i < sizeof(kat) / sizeof(kat[0]); i++) {
+        sha256(kat[i].in, strlen(kat[i].in), d);
+        ok &= hex_is(d, kat[i].hex);
+    }
+    CHECK("sha256: FIPS 180-2 test vectors", ok);
+
+    // Padding edge cases: the length field fits the last block or not
+    static const struct { size_t len; const char *hex; } pad[] = {
+        { 55, "d5e285683cd4efc02d021a5c62014694958901005d6f71e89e0989fac77e4072" },
+        { 56, "04c26261370ee7541549d16dee320c723e3fd14671e66a099afe0a377c16888e" },
+        { 63, "75220b47218278e656f2013bb8f0c455a25eaf01e86c64924e9d48d89776d6f2" },
+        { 64, "7ce100971f64e7001e8fe5a51973ecdfe1ced42befe7ee8d5fd6219506b5393c" },
+        { 65, "9537c5fdf120482f7d58d25e9ed583f52c02b4e304ea814db1633ad565aed7e9" },
+    };
+    char xs[65];
+    memset(xs, 'x', sizeof(xs));
+    ok = 1;
+    for (size_t i = 0; i < sizeof(pad) / sizeof(pad[0]); i++) {
+        sha256(xs, pad[i].len, d);
+        ok &= hex_is(d, pad[i].hex);
+    }
+    CHECK("sha256: 55, 56, 63, 64 and 65 byte inputs", ok);
+
+    char *million = malloc(1000000);
+    memset(million, 'a', 1000000);
+    sha256(million, 1000000, d);
+    free(million);
+    CHECK("sha256: one million 'a'",
+          hex_is(d, "cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0"));
+}
+
+static void test_blob_store(void) {
+    char dir[] = "/tmp/blob_store_test_XXXXXX";
+    if (!mkdtemp(dir)) {
+        CHECK("blob store: temporary directory", 0);
+        return;
+    }
+    char store[64];
+    snprintf(store, sizeof(store), "%s/blobs", dir);
+
+    char hex[SHA256_HEX_LEN + 1];
+    const char *data = "abc";
+    CHECK("blob store: put", blob_store_put(store, (const unsigned char*)data, 3, hex) == 0);
+    CHECK("blob store: named by the SHA-256 of the content",
+          strcmp(hex, "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad") == 0);
+
+    char path[256], got[8] = { 0 };
+    snprintf(path, sizeof(path), "%s/ba/%s", store, hex);
+    FILE *fp = fopen(path, "rb");
+    size_t n = fp ? fread(got, 1, sizeof(got), fp) : 0;
+    if (fp) fclose(fp);
+    CHECK("blob store: file under <dir>/<h0h1>/<hex> holds the bytes",
+          n == 3 && memcmp(got, data, 3) == 0);
+    CHECK("blob store: same content again is a no-op",
+          blob_store_put(store, (const unsigned char*)data, 3, hex) == 0);
+
+    unlink(path);
+    snprintf(path, sizeof(path), "%s/ba", store);
+    rmdir(path);
+    rmdir(store);
+    rmdir(dir);
+}
+
+int main(void) {
+    printf("base64 implementation: %s\n", base64_impl_name());
+    test_base64_vectors();
+    test_base64_simd_matches_scalar();
+    test_sha256_known_answers();
+    test_blob_store();
+    return unit_result();
+}
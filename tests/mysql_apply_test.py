@@ -0,0 +1,150 @@
+#!/usr/bin/env python3
+"""
+mysql_apply_test.py
+End-to-end test of mysql_publisher.so in apply mode against a local server
+
+Runs build/bin/binlog_stream with a generated config that captures the
+`apply_src` database and applies it into `apply_dst` on the same server
+(the server needs binlog_format=ROW). Then:
+  1. INSERT, UPDATE (including primary key changes and NULLs) and DELETE
+     on the source, in single and multi-statement transactions: the target
+     table must end up identical, BLOB and JSON columns included, and the
+     enrichment columns of the event must not reach it
+  2. killing the apply connections loses nothing: the failed transactions
+     are rolled back, retried on a new connection and applied
+  3. a transaction that cannot be applied (target table dropped) halts the
+     apply: rows written afterwards never reach the target
+
+    python3 tests/mysql_apply_test.py --port 3306 --user root
+"""
+
+import sys
+import time
+
+import pymysql
+
+import harness
+
+SRC = 'apply_src'
+DST = 'apply_dst'
+TABLE_DDL = ("CREATE TABLE `{db}`.`t` (id INT PRIMARY KEY, v VARCHAR(64), n INT, "
+             "b VARBINARY(64), j JSON, ref_id INT)")
+COLUMNS = "id, v, n, HEX(b), CAST(j AS CHAR), ref_id"
+
+
+def setup(conn):
+    for db in (SRC, DST):
+        harness.query(conn, f"DROP DATABASE IF EXISTS `{db}`")
+        harness.query(conn, f"CREATE DATABASE `{db}`")
+        harness.query(conn, TABLE_DDL.format(db=db))
+    harness.query(conn, f"CREATE TABLE `{SRC}`.`ref` (id INT PRIMARY KEY, label VARCHAR(32))")
+    harness.query(conn, f"INSERT INTO `{SRC}`.`ref` VALUES (1, 'one'), (2, 'two')")
+
+
+def rows(conn, db):
+    return harness.query(conn, f"SELECT {COLUMNS} FROM `{db}`.`t` ORDER BY id")
+
+
+def same_tables(conn):
+    return rows(conn, SRC) == rows(conn, DST)
+
+
+def first_difference(conn):
+    src, dst = rows(conn, SRC), rows(conn, DST)
+    for a, b in zip(src, dst):
+        if a != b:
+            return f"source {a} target {b}"
+    return f"{len(src)} source rows, {len(dst)} target rows"
+
+
+def write_workload(conn, base):
+    # Single row autocommit statements
+    for i in range(base, base + 50):
+        harness.query(conn, f"INSERT INTO `{SRC}`.`t` VALUES (%s, %s, %s, %s, %s, %s)",
+                      (i, f"row {i}", i * 3, bytes([i % 256, 0, 255, 10]),
+                       '{"k": %d, "a": [1, "x"]}' % i, 1 + i % 2))
+    # Multi-row statement and multi-statement transaction
+    harness.query(conn, "BEGIN")
+    harness.query(conn, f"UPDATE `{SRC}`.`t` SET v = CONCAT(v, ' updated'), n = NULL "
+                        f"WHERE id BETWEEN %s AND %s", (base, base + 9))
+    harness.query(conn, f"UPDATE `{SRC}`.`t` SET id = id + 100000 WHERE id BETWEEN %s AND %s",
+                  (base + 10, base + 14))
+    harness.query(conn, f"DELETE FROM `{SRC}`.`t` WHERE id BETWEEN %s AND %s",
+                  (base + 20, base + 29))
+    harness.query(conn, "COMMIT")
+    harness.query(conn, f"UPDATE `{SRC}`.`t` SET b = NULL, j = JSON_SET(j, '$.k', 'changed') "
+                        f"WHERE id = %s", (base + 30,))
+    harness.query(conn, f"DELETE FROM `{SRC}`.`t` WHERE id = %s", (base + 31,))
+
+
+def kill_apply_connections(conn):
+    own = harness.query(conn, "SELECT CONNECTION_ID()")[0][0]
+    killed = 0
+    for (pid,) in harness.query(conn, "SELECT ID FROM information_schema.PROCESSLIST "
+                                      "WHERE DB = %s AND ID <> %s", (DST, own)):
+        try:
+            harness.query(conn, f"KILL {int(pid)}")
+            killed += 1
+        except pymysql.MySQLError:
+            pass
+    return killed
+
+
+def main():
+    args = harness.parse_args(__doc__.split('\n')[2])
+    conn = harness.connect(args)
+    setup(conn)
+
+    capture = [{SRC: {
+        'capture_dml': True,
+        'capture_ddl': False,
+        'tables': [{'t': {
+            'primary_key': ['id'],
+            'columns': ['*'],
+            'enrich': [{'column': 'ref_id', 'table': 'ref', 'key': 'id',
+                        'columns': ['label'], 'prefix': 'ref_'}],
+        }}],
+    }}]
+    publisher = {
+        'name': 'apply',
+        'active': True,
+        'library_path': f"{args.lib_dir}/mysql_publisher.so",
+        'config': {
+            'host': args.host, 'port': args.port,
+            'username': args.user, 'password': args.password,
+            'database': DST, 'mode': 'apply',
+            'apply_threads': 4, 'apply_retries': 5, 'apply_flush_ms': 100,
+        },
+    }
+
+    failures = 0
+    with harness.Streamer(args, capture, [publisher]):
+        write_workload(conn, 1)
+        ok = harness.wait_for(lambda: same_tables(conn), args.timeout)
+        failures += harness.report("INSERT/UPDATE/DELETE applied, tables identical", ok,
+                                   '' if ok else first_difference(conn))
+
+        # Kill the lanes while transactions are in flight
+        write_workload(conn, 1001)
+        killed = kill_apply_connections(conn)
+        write_workload(conn, 2001)
+        ok = harness.wait_for(lambda: same_tables(conn), args.timeout)
+        failures += harness.report(f"applied after {killed} apply connection(s) were killed", ok,
+                                   '' if ok else first_difference(conn))
+
+        # A failure that is not retried halts the apply
+        harness.query(conn, f"DROP TABLE `{DST}`.`t`")
+        harness.query(conn, f"INSERT INTO `{SRC}`.`t` (id) VALUES (5001)")
+        time.sleep(2)
+        harness.query(conn, TABLE_DDL.format(db=DST))
+        harness.query(conn, f"INSERT INTO `{SRC}`.`t` (id) VALUES (5002)")
+        time.sleep(min(args.timeout, 5))
+        late = harness.query(conn, f"SELECT id FROM `{DST}`.`t`")
+        failures += harness.report("apply halted after a transaction could not be applied",
+                                   not late, late)
+
+    return 1 if failures else 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
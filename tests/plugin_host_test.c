@@ -0,0 +1,375 @@
+// plugin_host_test.c
+// Ring, ack checks, robust mutex recovery and restart with replay of
+// plugin_host.c
+//
+// Includes plugin_host.c to reach the ring. The host process is this
+// binary run with PLUGIN_HOST_ARG; the loader is replaced by the stubs
+// below, which load a recorder plugin appending each event's JSON as a
+// line to the file in its "out" setting.
+
+#include "../src/core/plugin_host.c"
+#include "logger.h"
+#include "unit.h"
+
+#define RING_SIZE HOST_MIN_RING_SIZE
+
+// ============================================================================
+// LOADER STUBS AND RECORDER PLUGIN (host side)
+// ============================================================================
+
+typedef struct {
+    int fd;
+    long delay_us;
+} recorder_t;
+
+static const char* recorder_setting(const publisher_config_t *config, const char *key) {
+    for (int i = 0; i < config->config_count; i++) {
+        if (strcmp(config->config_keys[i], key) == 0) return config->config_values[i];
+    }
+    return NULL;
+}
+
+static int recorder_init(const publisher_config_t *config, void **plugin_data) {
+    const char *out = recorder_setting(config, "out");
+    const char *delay = recorder_setting(config, "delay_us");
+    recorder_t *r = calloc(1, sizeof(recorder_t));
+    if (!r || !out) return -1;
+    r->fd = open(out, O_WRONLY | O_CREAT | O_APPEND, 0644);
+    r->delay_us = delay ? atol(delay) : 0;
+    *plugin_data = r;
+    return r->fd >= 0 ? 0 : -1;
+}
+
+// One write per event, so a host killed mid-stream leaves whole lines
+static int recorder_publish(void *plugin_data, const cdc_event_t *event) {
+    recorder_t *r = (recorder_t*)plugin_data;
+    static char line[RING_SIZE];
+    size_t n = strlen(event->json);
+    memcpy(line, event->json, n);
+    line[n++] = '\n';
+    if (write(r->fd, line, n) != (ssize_t)n) return -1;
+    if (r->delay_us) unit_sleep_us(r->delay_us);
+    return 0;
+}
+
+static void recorder_cleanup(void *plugin_data) {
+    recorder_t *r = (recorder_t*)plugin_data;
+    if (r->fd >= 0) close(r->fd);
+    free(r);
+}
+
+static const publisher_callbacks_t recorder_callbacks = {
+    .init = recorder_init,
+    .cleanup = recorder_cleanup,
+    .publish = recorder_publish,
+};
+
+int publisher_manager_init(publisher_manager_t **manager) {
+    *manager = calloc(1, sizeof(publisher_manager_t));
+    return *manager ? 0 : -1;
+}
+
+int publisher_manager_load_plugin(publisher_manager_t *manager, const char *name,
+                                  const char *library_path, const publisher_config_t *config,
+                                  publisher_instance_t **instance) {
+    publisher_instance_t *inst = calloc(1, sizeof(publisher_instance_t));
+    publisher_plugin_t *p = calloc(1, sizeof(publisher_plugin_t));
+    if (!inst || !p) return -1;
+    snprintf(inst->name, sizeof(inst->name), "%s", name);
+    snprintf(inst->library_path, sizeof(inst->library_path), "%s", library_path);
+    p->callbacks = &recorder_callbacks;
+    inst->plugin = p;
+    if (recorder_init(config, &p->plugin_data) != 0) return -1;
+    manager->instances = inst;
+    *instance = inst;
+    return 0;
+}
+
+void publisher_manager_destroy(publisher_manager_t *manager) {
+    publisher_instance_t *inst = manager->instances;
+    if (inst) {
+        recorder_cleanup(inst->plugin->plugin_data);
+        free(inst->plugin);
+        free(inst);
+    }
+    free(manager);
+}
+
+// ============================================================================
+// CORE SIDE
+// ============================================================================
+
+static uint64_t acks = 0;
+static uint64_t ack_failures = 0;
+
+void publisher_instance_ack(publisher_instance_t *instance, int status) {
+    (void)instance;
+    __atomic_add_fetch(&acks, 1, __ATOMIC_RELAXED);
+    if (status != 0) __atomic_add_fetch(&ack_failures, 1, __ATOMIC_RELAXED);
+}
+
+static char out_path[64];
+static char *config_keys[] = { "out", "delay_us" };
+static char *config_values[2];
+static char delay_value[16];
+
+static publisher_instance_t* make_instance(long delay_us) {
+    publisher_instance_t *inst = calloc(1, sizeof(publisher_instance_t));
+    snprintf(inst->name, sizeof(inst->name), "test");
+    snprintf(inst->library_path, sizeof(inst->library_path), "recorder.so");
+    snprintf(delay_value, sizeof(delay_value), "%ld", delay_us);
+    config_values[0] = out_path;
+    config_values[1] = delay_value;
+    inst->config.name = inst->name;
+    inst->config.config_keys = config_keys;
+    inst->config.config_values = config_values;
+    inst->config.config_count = 2;
+    inst->host_ring_size = RING_SIZE;
+    pthread_mutex_init(&inst->q_mutex, NULL);
+    __atomic_store_n(&acks, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&ack_failures, 0, __ATOMIC_RELAXED);
+    unlink(out_path);
+    plugin_host_attach(inst);
+    return inst;
+}
+
+static void free_instance(publisher_instance_t *inst) {
+    pthread_mutex_destroy(&inst->q_mutex);
+    free(inst->plugin);
+    free(inst);
+}
+
+static plugin_host_t* host_of(publisher_instance_t *inst) {
+    return (plugin_host_t*)inst->plugin->plugin_data;
+}
+
+// Event n: "e<n>" and up to 3000 bytes of padding that depend on n
+static int publish_event(publisher_instance_t *inst, int n) {
+    static char json[4096];
+    int len = snprintf(json, sizeof(json), "e%06d ", n);
+    int pad = (n * 37) % 3000;
+    memset(json + len, 'a' + n % 26, pad);
+    json[len + pad] = '\0';
+    cdc_event_t event = { .db = "db", .table = "t", .json = json, .type = "INSERT",
+                          .position = (uint64_t)n };
+    return inst->plugin->callbacks->publish(inst->plugin->plugin_data, &event);
+}
+
+static int line_is_event(const char *line, int n) {
+    char expect[16];
+    int len = snprintf(expect, sizeof(expect), "e%06d ", n);
+    if (strncmp(line, expect, len) != 0) return 0;
+    int pad = (n * 37) % 3000;
+    for (int i = 0; i < pad; i++) {
+        if (line[len + i] != 'a' + n % 26) return 0;
+    }
+    return line[len + pad] == '\0';
+}
+
+static int wait_acks(uint64_t want, double timeout_sec) {
+    double deadline = unit_now_sec() + timeout_sec;
+    while (__atomic_load_n(&acks, __ATOMIC_RELAXED) < want && unit_now_sec() < deadline) {
+        unit_sleep_us(1000);
+    }
+    return __atomic_load_n(&acks, __ATOMIC_RELAXED) == want;
+}
+
+// Reads the recorder output: every event 1..count at least once, each
+// intact, in order once repeats are skipped. Returns the number of repeats
+// or -1.
+static int check_output(int count) {
+    FILE *fp = fopen(out_path, "r");
+    if (!fp) return -1;
+    static char line[RING_SIZE];
+    int next = 1, repeats = 0, ok = 1;
+    while (ok && fgets(line, sizeof(line), fp)) {
+        line[strcspn(line, "\n")] = '\0';
+        int n = atoi(line + 1);
+        if (n < 1 || n > count || !line_is_event(line, n)) ok = 0;
+        else if (n == next) next++;
+        else if (n < next) repeats++;
+        else ok = 0;
+    }
+    fclose(fp);
+    return ok && next == count + 1 ? repeats : -1;
+}
+
+// Records of up to 3 KB through a 64 KB ring: it wraps every few dozen
+static void test_ring(void) {
+    publisher_instance_t *inst = make_instance(0);
+    const publisher_callbacks_t *cb = inst->plugin->callbacks;
+    int count = 5000, rc = 0;
+
+    int up = cb->init(&inst->config, &inst->plugin->plugin_data) == 0 &&
+             cb->start(inst->plugin->plugin_data) == 0;
+    CHECK("ring: host initialized and started", up);
+    if (!up) {
+        cb->cleanup(inst->plugin->plugin_data);
+        free_instance(inst);
+        return;
+    }
+    for (int n = 1; n <= count; n++) rc |= publish_event(inst, n);
+    CHECK("ring: every event written", rc == 0);
+    CHECK("ring: every event acked", wait_acks(count, 30));
+    CHECK("ring: no failed acks", ack_failures == 0);
+
+    host_shm_t *shm = host_of(inst)->shm;
+    shm_lock(shm);
+    int released = shm->tail == shm->head && shm->head > 4 * RING_SIZE;
+    shm_unlock(shm);
+    CHECK("ring: wrapped and released all its space", released);
+
+    static char big[RING_SIZE / 2 + 1];
+    memset(big, 'x', sizeof(big) - 1);
+    cdc_event_t event = { .json = big };
+    CHECK("ring: event larger than half the ring refused",
+          cb->publish(inst->plugin->plugin_data, &event) == -1);
+
+    cb->stop(inst->plugin->plugin_data);
+    cb->cleanup(inst->plugin->plugin_data);
+    free_instance(inst);
+    CHECK("ring: delivered once each, in order, intact", check_output(count) == 0);
+}
+
+// Core side only, no host process: acks are written into the ring by hand
+static void test_ack_checks(void) {
+    publisher_instance_t *inst = make_instance(0);
+    plugin_host_t *h = host_of(inst);
+    if (host_create_shm(h, RING_SIZE) != 0) {
+        CHECK("acks: shared memory", 0);
+        return;
+    }
+    host_shm_t *shm = h->shm;
+    publish_event(inst, 1);
+    publish_event(inst, 2);
+    publish_event(inst, 3);
+    uint64_t end1 = ((host_record_t*)h->ring)->size;
+    uint64_t end2 = end1 + ((host_record_t*)(h->ring + end1))->size;
+
+    host_ack(shm, 1, 0, end1);
+    host_drain_acks(h);
+    CHECK("acks: in order ack taken", acks == 1 && shm->tail == end1);
+
+    host_ack(shm, 3, 0, end2);
+    host_drain_acks(h);
+    CHECK("acks: out of order seq refused", acks == 1 && shm->tail == end1);
+
+    host_ack(shm, 2, 0, shm->head + 64);
+    host_drain_acks(h);
+    CHECK("acks: read position past head refused", acks == 1 && shm->tail == end1);
+
+    host_ack(shm, 2, 0, 0);
+    host_drain_acks(h);
+    CHECK("acks: read position before tail refused", acks == 1 && shm->tail == end1);
+    CHECK("acks: refused acks are discarded", shm->ack_tail == shm->ack_head);
+
+    host_ack(shm, 2, 0, end2);
+    host_drain_acks(h);
+    CHECK("acks: next ack taken afterwards", acks == 2 && shm->tail == end2);
+
+    proxy_cleanup(h);
+    free_instance(inst);
+}
+
+// A host that dies holding the mutex must not lock out the core
+static void test_robust_mutex(void) {
+    publisher_instance_t *inst = make_instance(0);
+    plugin_host_t *h = host_of(inst);
+    if (host_create_shm(h, RING_SIZE) != 0) {
+        CHECK("robust mutex: shared memory", 0);
+        return;
+    }
+
+    pid_t pid = fork();
+    if (pid == 0) {
+        pthread_mutex_lock(&h->shm->mutex);
+        _exit(0);
+    }
+    int status = 0;
+    waitpid(pid, &status, 0);
+
+    // A lock that never returns fails the test through the alarm
+    alarm(10);
+    shm_lock(h->shm);
+    h->shm->head = 1;
+    shm_unlock(h->shm);
+    int again = pthread_mutex_trylock(&h->shm->mutex);
+    if (again == 0) pthread_mutex_unlock(&h->shm->mutex);
+    alarm(0);
+    CHECK("robust mutex: locked after its owner died", h->shm->head == 1);
+    CHECK("robust mutex: consistent again afterwards", again == 0);
+
+    proxy_cleanup(h);
+    free_instance(inst);
+}
+
+static publisher_instance_t *victim = NULL;
+static uint64_t kill_after = 0;
+
+static void* killer_thread(void *arg) {
+    (void)arg;
+    while (__atomic_load_n(&acks, __ATOMIC_RELAXED) < kill_after) unit_sleep_us(500);
+    plugin_host_t *h = host_of(victim);
+    pthread_mutex_lock(&h->mutex);
+    pid_t pid = h->pid;
+    pthread_mutex_unlock(&h->mutex);
+    if (pid > 0) kill(pid, SIGKILL);
+    return NULL;
+}
+
+// The host is killed mid-stream: the restarted host replays what was not
+// acked, so every event is delivered at least once and acked exactly once
+static void test_restart_replay(void) {
+    publisher_instance_t *inst = make_instance(200);
+    const publisher_callbacks_t *cb = inst->plugin->callbacks;
+    int count = 2000, rc = 0;
+
+    int up = cb->init(&inst->config, &inst->plugin->plugin_data) == 0 &&
+             cb->start(inst->plugin->plugin_data) == 0;
+    CHECK("restart: host initialized and started", up);
+    if (!up) {
+        cb->cleanup(inst->plugin->plugin_data);
+        free_instance(inst);
+        return;
+    }
+
+    victim = inst;
+    kill_after = 300;
+    pthread_t killer;
+    pthread_create(&killer, NULL, killer_thread, NULL);
+    for (int n = 1; n <= count; n++) rc |= publish_event(inst, n);
+    pthread_join(killer, NULL);
+
+    CHECK("restart: every event written", rc == 0);
+    CHECK("restart: every event acked exactly once", wait_acks(count, 60));
+    unit_sleep_us(200000);
+    CHECK("restart: no late acks", acks == (uint64_t)count && ack_failures == 0);
+
+    plugin_host_t *h = host_of(inst);
+    pthread_mutex_lock(&h->mutex);
+    int restarts = h->restarts;
+    pthread_mutex_unlock(&h->mutex);
+    CHECK("restart: host restarted once", restarts == 1);
+
+    cb->stop(inst->plugin->plugin_data);
+    cb->cleanup(inst->plugin->plugin_data);
+    free_instance(inst);
+    int repeats = check_output(count);
+    CHECK("restart: every event delivered, in order once replays are skipped", repeats >= 0);
+    printf("      %d event(s) replayed\n", repeats);
+}
+
+int main(int argc, char **argv) {
+    if (argc >= 2 && strcmp(argv[1], PLUGIN_HOST_ARG) == 0) {
+        return plugin_host_main(argc, argv);
+    }
+    log_set_level(LOG_FATAL);
+    snprintf(out_path, sizeof(out_path), "/tmp/plugin_host_test_%d.out", (int)getpid());
+
+    test_ring();
+    test_ack_checks();
+    test_robust_mutex();
+    test_restart_replay();
+    unlink(out_path);
+    return unit_result();
+}
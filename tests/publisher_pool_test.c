@@ -0,0 +1,188 @@
+// publisher_pool_test.c
+// Work stealing, fairness and the out of memory path of publisher_pool.c
+//
+// The loader is replaced by the publisher_instance_run() below: an
+// instance's q_count is its backlog, each event takes event_us.
+
+#include "publisher_pool.h"
+#include "publisher_loader.h"
+#include "logger.h"
+#include "unit.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_INSTANCES 8
+
+static publisher_instance_t insts[MAX_INSTANCES];
+static int ninsts = 0;
+static publisher_pool_t *pool = NULL;
+
+static long event_us = 200;
+static int spawn_from_worker = 0;       // first turn of insts[0] schedules the rest
+
+static int thread_count = 0;
+static __thread int thread_id = -1;
+
+static unsigned ran_on[MAX_INSTANCES];  // bit per worker thread
+static int running[MAX_INSTANCES];
+static int overlaps = 0;
+static int finish_seq = 0;
+static int finished[MAX_INSTANCES];     // order in which backlogs drained, from 1
+static int backlog_at_finish[MAX_INSTANCES][MAX_INSTANCES];
+
+// Fails malloc while set (linked with -Wl,--wrap=malloc)
+static volatile int fail_malloc = 0;
+void* __real_malloc(size_t size);
+void* __wrap_malloc(size_t size) {
+    return fail_malloc ? NULL : __real_malloc(size);
+}
+
+int publisher_instance_run(publisher_instance_t *inst, int quantum) {
+    int idx = (int)(inst - insts);
+    if (thread_id < 0) thread_id = __atomic_fetch_add(&thread_count, 1, __ATOMIC_RELAXED);
+    if (__atomic_exchange_n(&running[idx], 1, __ATOMIC_ACQ_REL)) {
+        __atomic_add_fetch(&overlaps, 1, __ATOMIC_RELAXED);
+    }
+    __atomic_or_fetch(&ran_on[idx], 1u << (thread_id % 32), __ATOMIC_RELAXED);
+
+    if (idx == 0 && spawn_from_worker) {
+        spawn_from_worker = 0;
+        for (int i = 1; i < ninsts; i++) {
+            pthread_mutex_lock(&insts[i].q_mutex);
+            insts[i].sched_state = PUBLISHER_SCHEDULED;
+            pthread_mutex_unlock(&insts[i].q_mutex);
+            publisher_pool_schedule(pool, &insts[i]);
+        }
+    }
+
+    for (int n = 0; ; n++) {
+        pthread_mutex_lock(&inst->q_mutex);
+        if (inst->q_count == 0) {
+            inst->sched_state = PUBLISHER_IDLE;
+            pthread_mutex_unlock(&inst->q_mutex);
+            finished[idx] = __atomic_add_fetch(&finish_seq, 1, __ATOMIC_RELAXED);
+            for (int i = 0; i < ninsts; i++) {
+                backlog_at_finish[idx][i] = __atomic_load_n(&insts[i].q_count, __ATOMIC_RELAXED);
+            }
+            __atomic_store_n(&running[idx], 0, __ATOMIC_RELEASE);
+            return 0;
+        }
+        if (n >= quantum) {
+            pthread_mutex_unlock(&inst->q_mutex);
+            __atomic_store_n(&running[idx], 0, __ATOMIC_RELEASE);
+            return 1;
+        }
+        inst->q_count--;
+        pthread_mutex_unlock(&inst->q_mutex);
+        unit_sleep_us(event_us);
+    }
+}
+
+static void setup(int count, const int *backlog) {
+    memset(insts, 0, sizeof(insts));
+    memset(ran_on, 0, sizeof(ran_on));
+    memset(finished, 0, sizeof(finished));
+    finish_seq = 0;
+    overlaps = 0;
+    ninsts = count;
+    for (int i = 0; i < count; i++) {
+        snprintf(insts[i].name, sizeof(insts[i].name), "inst%d", i);
+        pthread_mutex_init(&insts[i].q_mutex, NULL);
+        insts[i].q_count = backlog[i];
+    }
+}
+
+static void schedule(int idx) {
+    pthread_mutex_lock(&insts[idx].q_mutex);
+    insts[idx].sched_state = PUBLISHER_SCHEDULED;
+    pthread_mutex_unlock(&insts[idx].q_mutex);
+    publisher_pool_schedule(pool, &insts[idx]);
+}
+
+static int all_idle(void) {
+    for (int i = 0; i < ninsts; i++) {
+        pthread_mutex_lock(&insts[i].q_mutex);
+        int busy = insts[i].q_count > 0 || insts[i].sched_state != PUBLISHER_IDLE;
+        pthread_mutex_unlock(&insts[i].q_mutex);
+        if (busy) return 0;
+    }
+    return 1;
+}
+
+static int wait_idle(double timeout_sec) {
+    double deadline = unit_now_sec() + timeout_sec;
+    while (unit_now_sec() < deadline) {
+        if (all_idle()) return 1;
+        unit_sleep_us(1000);
+    }
+    return all_idle();
+}
+
+static void teardown(void) {
+    publisher_pool_destroy(pool);
+    pool = NULL;
+    for (int i = 0; i < ninsts; i++) pthread_mutex_destroy(&insts[i].q_mutex);
+}
+
+// Everything is queued on one worker's deque; the idle workers must steal
+static void test_stealing(void) {
+    int backlog[8] = { 1, 40, 40, 40, 40, 40, 40, 40 };
+    setup(8, backlog);
+    event_us = 200;
+    pool = publisher_pool_create(4, 4);
+    spawn_from_worker = 1;
+    schedule(0);
+
+    CHECK("stealing: every backlog drained", wait_idle(30));
+    unsigned all = 0;
+    for (int i = 1; i < ninsts; i++) all |= ran_on[i];
+    CHECK("stealing: work queued on one worker ran on others", __builtin_popcount(all) >= 2);
+    CHECK("stealing: an instance never runs on two workers at once", overlaps == 0);
+    teardown();
+}
+
+// One worker: a short backlog queued behind a long one is done after a
+// few quanta, not after the whole long backlog
+static void test_fairness(void) {
+    int backlog[2] = { 400, 8 };
+    setup(2, backlog);
+    event_us = 50;
+    pool = publisher_pool_create(1, 4);
+    schedule(0);
+    schedule(1);
+
+    CHECK("fairness: both backlogs drained", wait_idle(30));
+    CHECK("fairness: the short backlog finished first", finished[1] == 1 && finished[0] == 2);
+    CHECK("fairness: the long one was only a few quanta in",
+          backlog_at_finish[1][0] >= 400 - 4 * 4);
+    teardown();
+}
+
+// A deque that cannot grow must not strand a SCHEDULED instance
+static void test_out_of_memory(void) {
+    int backlog[1] = { 5 };
+    setup(1, backlog);
+    event_us = 10;
+    pool = publisher_pool_create(2, 2);
+
+    fail_malloc = 1;
+    schedule(0);
+    fail_malloc = 0;
+
+    CHECK("out of memory: backlog delivered inline", insts[0].q_count == 0);
+    CHECK("out of memory: instance back to IDLE", insts[0].sched_state == PUBLISHER_IDLE);
+
+    // And the pool still works afterwards
+    insts[0].q_count = 5;
+    schedule(0);
+    CHECK("out of memory: pool schedules again afterwards", wait_idle(10));
+    teardown();
+}
+
+int main(void) {
+    log_set_level(LOG_FATAL);
+    test_stealing();
+    test_fairness();
+    test_out_of_memory();
+    return unit_result();
+}
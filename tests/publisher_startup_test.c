@@ -0,0 +1,208 @@
+// publisher_startup_test.c
+// Parallel startup of publisher_loader.c: plugins load concurrently, one
+// that fails is dropped without holding up the others
+//
+// The test plugins are registered as built-ins (static_plugins[] below),
+// so no library is loaded. Their behaviour comes from the "mode" setting:
+// "ok", "fail_init" or "fail_start"; every init takes INIT_US.
+
+#include "publisher_loader.h"
+#include "static_plugins.h"
+#include "logger.h"
+#include "unit.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define INIT_US     200000
+#define PUBLISHERS  6
+
+static int inits_running = 0;
+static int inits_max = 0;
+static uint64_t published = 0;
+
+typedef struct {
+    int fail_start;
+} test_plugin_t;
+
+static const char* test_get_name(void) {
+    return "test_plugin";
+}
+
+static int test_init(const publisher_config_t *config, void **plugin_data) {
+    const char *mode = "ok";
+    for (int i = 0; i < config->config_count; i++) {
+        if (strcmp(config->config_keys[i], "mode") == 0) mode = config->config_values[i];
+    }
+
+    int running = __atomic_add_fetch(&inits_running, 1, __ATOMIC_ACQ_REL);
+    int max = __atomic_load_n(&inits_max, __ATOMIC_RELAXED);
+    while (running > max &&
+           !__atomic_compare_exchange_n(&inits_max, &max, running, 0,
+                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED)) { }
+    unit_sleep_us(INIT_US);
+    __atomic_sub_fetch(&inits_running, 1, __ATOMIC_ACQ_REL);
+
+    if (strcmp(mode, "fail_init") == 0) return -1;
+    test_plugin_t *p = calloc(1, sizeof(test_plugin_t));
+    if (!p) return -1;
+    p->fail_start = strcmp(mode, "fail_start") == 0;
+    *plugin_data = p;
+    return 0;
+}
+
+static int test_start(void *plugin_data) {
+    return ((test_plugin_t*)plugin_data)->fail_start ? -1 : 0;
+}
+
+static int test_publish(void *plugin_data, const cdc_event_t *event) {
+    (void)plugin_data;
+    (void)event;
+    __atomic_add_fetch(&published, 1, __ATOMIC_RELAXED);
+    return 0;
+}
+
+static void test_cleanup(void *plugin_data) {
+    free(plugin_data);
+}
+
+static const publisher_callbacks_t test_callbacks = {
+    .get_name = test_get_name,
+    .init = test_init,
+    .start = test_start,
+    .cleanup = test_cleanup,
+    .publish = test_publish,
+};
+
+static int test_plugin_init(publisher_plugin_t **plugin) {
+    publisher_plugin_t *p = calloc(1, sizeof(publisher_plugin_t));
+    if (!p) return -1;
+    p->callbacks = &test_callbacks;
+    *plugin = p;
+    return 0;
+}
+
+const static_plugin_t static_plugins[] = {
+    { "test_plugin", test_plugin_init },
+    { NULL, NULL }
+};
+
+static publisher_instance_t *insts[PUBLISHERS];
+
+// Publishers 0..count-1, the one at failing (if >= 0) in the given mode
+static publisher_manager_t* setup(int count, int failing, const char *fail_mode) {
+    publisher_manager_t *mgr = NULL;
+    if (publisher_manager_init(&mgr) != 0) return NULL;
+
+    for (int i = 0; i < count; i++) {
+        char name[32];
+        char *keys[] = { "mode" };
+        char *values[] = { i == failing ? (char*)fail_mode : "ok" };
+        publisher_config_t config = { .name = name, .active = 1, .config_keys = keys,
+                                      .config_values = values, .config_count = 1 };
+        snprintf(name, sizeof(name), "pub%d", i);
+        if (publisher_manager_add_plugin(mgr, name, "./build/lib/test_plugin.so",
+                                         &config, &insts[i]) != 0) {
+            publisher_manager_destroy(mgr);
+            return NULL;
+        }
+        insts[i]->critical = 1;
+    }
+    inits_max = 0;
+    published = 0;
+    return mgr;
+}
+
+static int enqueue(publisher_instance_t *inst, int count) {
+    int queued = 0;
+    for (int i = 0; i < count; i++) {
+        cdc_event_t event = { .db = "db", .table = "t", .json = "{}", .type = "INSERT",
+                              .position = (uint64_t)i + 1 };
+        if (publisher_instance_enqueue(inst, &event) == 0) queued++;
+    }
+    return queued;
+}
+
+static int wait_published(uint64_t want, double timeout_sec) {
+    double deadline = unit_now_sec() + timeout_sec;
+    while (__atomic_load_n(&published, __ATOMIC_RELAXED) < want && unit_now_sec() < deadline) {
+        unit_sleep_us(1000);
+    }
+    return __atomic_load_n(&published, __ATOMIC_RELAXED) == want;
+}
+
+// Six publishers on three threads take two init times, not six
+static void test_concurrent_init(void) {
+    publisher_manager_t *mgr = setup(PUBLISHERS, -1, NULL);
+    if (!mgr) {
+        CHECK("concurrent: publishers registered", 0);
+        return;
+    }
+    int queued = 0;
+    for (int i = 0; i < PUBLISHERS; i++) queued += enqueue(insts[i], 10);
+    CHECK("concurrent: events queued while loading", queued == PUBLISHERS * 10);
+
+    double t0 = unit_now_sec();
+    publisher_manager_start_all(mgr, 3);
+    int remaining = publisher_manager_wait_ready(mgr, 10000);
+    double sec = unit_now_sec() - t0;
+
+    CHECK("concurrent: every critical publisher ready", remaining == 0);
+    int ready = 1;
+    for (int i = 0; i < PUBLISHERS; i++) ready &= insts[i]->load_state == PUBLISHER_READY;
+    CHECK("concurrent: all loaded", ready);
+    CHECK("concurrent: inits ran three at a time", inits_max == 3);
+    CHECK("concurrent: startup took two init times, not six",
+          sec < 4 * INIT_US / 1e6);
+    CHECK("concurrent: events queued while loading delivered",
+          wait_published(PUBLISHERS * 10, 10));
+
+    publisher_manager_join_startup(mgr);
+    publisher_manager_stop_all(mgr);
+    publisher_manager_destroy(mgr);
+}
+
+static void test_one_fails(const char *mode) {
+    char name[96];
+    publisher_manager_t *mgr = setup(PUBLISHERS, 2, mode);
+    if (!mgr) {
+        CHECK("failure: publishers registered", 0);
+        return;
+    }
+    for (int i = 0; i < PUBLISHERS; i++) enqueue(insts[i], 10);
+
+    publisher_manager_start_all(mgr, PUBLISHERS);
+    int remaining = publisher_manager_wait_ready(mgr, 10000);
+
+    snprintf(name, sizeof(name), "failure (%s): wait_ready does not wait for the failed one", mode);
+    CHECK(name, remaining == 0);
+    snprintf(name, sizeof(name), "failure (%s): failed publisher marked failed and inactive", mode);
+    CHECK(name, insts[2]->load_state == PUBLISHER_FAILED && !insts[2]->active);
+
+    publisher_stats_t stats;
+    publisher_stats_snapshot(insts[2], &stats);
+    snprintf(name, sizeof(name), "failure (%s): its backlog dropped", mode);
+    CHECK(name, stats.events_dropped == 10 && insts[2]->q_count == 0);
+    snprintf(name, sizeof(name), "failure (%s): no more events queued to it", mode);
+    CHECK(name, enqueue(insts[2], 1) == 0);
+
+    int others = 1;
+    for (int i = 0; i < PUBLISHERS; i++) {
+        if (i != 2) others &= insts[i]->load_state == PUBLISHER_READY && insts[i]->started;
+    }
+    snprintf(name, sizeof(name), "failure (%s): the others started", mode);
+    CHECK(name, others);
+    snprintf(name, sizeof(name), "failure (%s): and deliver their backlog", mode);
+    CHECK(name, wait_published((PUBLISHERS - 1) * 10, 10));
+
+    publisher_manager_join_startup(mgr);
+    publisher_manager_stop_all(mgr);
+    publisher_manager_destroy(mgr);
+}
+
+int main(void) {
+    log_set_level(LOG_FATAL);
+    test_concurrent_init();
+    test_one_fails("fail_init");
+    test_one_fails("fail_start");
+    return unit_result();
+}
@@ -0,0 +1,106 @@
+// txn_scheduler_test.c
+// Dependencies, the full window and shutdown of txn_scheduler.c
+
+#include "txn_scheduler.h"
+#include "unit.h"
+#include <pthread.h>
+
+static txn_scheduler_t *sched = NULL;
+static int64_t arg_seq = 0;
+static int result = 0;
+static int returned = 0;
+
+static void* dispatch_thread(void *arg) {
+    (void)arg;
+    int rc = txn_scheduler_dispatched(sched, arg_seq);
+    __atomic_store_n(&result, rc, __ATOMIC_RELAXED);
+    __atomic_store_n(&returned, 1, __ATOMIC_RELEASE);
+    return NULL;
+}
+
+static void* wait_ready_thread(void *arg) {
+    (void)arg;
+    int rc = txn_scheduler_wait_ready(sched, arg_seq);
+    __atomic_store_n(&result, rc, __ATOMIC_RELAXED);
+    __atomic_store_n(&returned, 1, __ATOMIC_RELEASE);
+    return NULL;
+}
+
+// Runs fn on a thread; 1 if it is still blocked after 50 ms
+static int blocks(pthread_t *t, void *(*fn)(void*), int64_t seq) {
+    arg_seq = seq;
+    returned = 0;
+    pthread_create(t, NULL, fn, NULL);
+    unit_sleep_us(50000);
+    return !__atomic_load_n(&returned, __ATOMIC_ACQUIRE);
+}
+
+static int joined(pthread_t t) {
+    pthread_join(t, NULL);
+    return returned;
+}
+
+static void test_dependencies(void) {
+    sched = txn_scheduler_create(8);
+    pthread_t t;
+
+    txn_scheduler_dispatched(sched, 1);
+    txn_scheduler_dispatched(sched, 2);
+    CHECK("dependencies: independent of what runs", txn_scheduler_wait_ready(sched, 0) == 0);
+    CHECK("dependencies: waits for last_committed", blocks(&t, wait_ready_thread, 2));
+    txn_scheduler_complete(sched, 2);
+    unit_sleep_us(20000);
+    CHECK("dependencies: still waits for an older one", !returned);
+    txn_scheduler_complete(sched, 1);
+    CHECK("dependencies: released once all completed", joined(t) && result == 0);
+
+    CHECK("dependencies: sequence_number not above the last refused",
+          txn_scheduler_dispatched(sched, 2) == -1);
+    txn_scheduler_drain(sched);
+    CHECK("dependencies: sequence restarts after drain", txn_scheduler_dispatched(sched, 1) == 0);
+    txn_scheduler_complete(sched, 1);
+    txn_scheduler_destroy(sched);
+}
+
+// Dispatching into a full window blocks instead of dropping the transaction
+static void test_full_window(void) {
+    sched = txn_scheduler_create(4);
+    pthread_t t;
+
+    for (int64_t seq = 1; seq <= 4; seq++) txn_scheduler_dispatched(sched, seq);
+    CHECK("full window: wait_ready blocks", blocks(&t, wait_ready_thread, 0));
+    txn_scheduler_complete(sched, 1);
+    CHECK("full window: wait_ready released by a completion", joined(t) && result == 0);
+
+    txn_scheduler_dispatched(sched, 5);
+    CHECK("full window: dispatched blocks", blocks(&t, dispatch_thread, 6));
+    txn_scheduler_complete(sched, 2);
+    CHECK("full window: dispatched released by a completion", joined(t) && result == 0);
+
+    // 6 is tracked: a transaction depending on it waits for it
+    for (int64_t seq = 3; seq <= 5; seq++) txn_scheduler_complete(sched, seq);
+    CHECK("full window: the blocked transaction is tracked", blocks(&t, wait_ready_thread, 6));
+    txn_scheduler_complete(sched, 6);
+    CHECK("full window: and completes", joined(t) && result == 0);
+    txn_scheduler_destroy(sched);
+}
+
+static void test_shutdown(void) {
+    sched = txn_scheduler_create(2);
+    pthread_t t;
+
+    txn_scheduler_dispatched(sched, 1);
+    txn_scheduler_dispatched(sched, 2);
+    CHECK("shutdown: dispatched blocks on a full window", blocks(&t, dispatch_thread, 3));
+    txn_scheduler_shutdown(sched);
+    CHECK("shutdown: blocked dispatch returns -1", joined(t) && result == -1);
+    CHECK("shutdown: wait_ready returns -1", txn_scheduler_wait_ready(sched, 0) == -1);
+    txn_scheduler_destroy(sched);
+}
+
+int main(void) {
+    test_dependencies();
+    test_full_window();
+    test_shutdown();
+    return unit_result();
+}
@@ -0,0 +1,43 @@
+// unit.h
+// Checks for the C unit tests in tests/, built and run by `make test`
+//
+// Each test prints one PASS / FAIL line per check, like the end-to-end
+// tests, and main() returns unit_result().
+
+#ifndef UNIT_H
+#define UNIT_H
+
+#include <stdio.h>
+#include <time.h>
+
+static int unit_failures = 0;
+
+#define CHECK(name, cond) unit_check((name), (cond), __FILE__, __LINE__)
+
+static inline int unit_check(const char *name, int ok, const char *file, int line) {
+    if (ok) {
+        printf("PASS  %s\n", name);
+    } else {
+        printf("FAIL  %s (%s:%d)\n", name, file, line);
+        unit_failures++;
+    }
+    fflush(stdout);
+    return ok;
+}
+
+static inline int unit_result(void) {
+    return unit_failures ? 1 : 0;
+}
+
+static inline void unit_sleep_us(long us) {
+    struct timespec ts = { us / 1000000, (us % 1000000) * 1000 };
+    nanosleep(&ts, NULL);
+}
+
+static inline double unit_now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+#endif // UNIT_H
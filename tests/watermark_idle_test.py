@@ -0,0 +1,90 @@
+#!/usr/bin/env python3
+"""
+watermark_idle_test.py
+End-to-end test of WATERMARK events while the primary is idle
+
+Runs build/bin/binlog_stream with a file publisher that has "watermarks"
+set, writes one row, then leaves the server idle. MySQL heartbeats carry
+no timestamp, yet:
+  1. idle watermarks keep arriving, flagged "idle": true
+  2. their timestamp moves forward with the idle time, starting from the
+     time of the last binlog event
+  3. timestamps never go backwards, idle or not
+
+    python3 tests/watermark_idle_test.py --port 3306 --user root
+"""
+
+import json
+import os
+import sys
+import tempfile
+import time
+
+import harness
+
+DB = 'watermark_test'
+IDLE_SEC = 6
+
+
+def watermarks(path):
+    if not os.path.exists(path):
+        return []
+    out = []
+    with open(path) as f:
+        for line in f:
+            try:
+                ev = json.loads(line)
+            except ValueError:
+                continue
+            if ev.get('type') == 'WATERMARK':
+                out.append(ev)
+    return out
+
+
+def main():
+    args = harness.parse_args(__doc__.split('\n')[2])
+    conn = harness.connect(args)
+    harness.query(conn, f"DROP DATABASE IF EXISTS `{DB}`")
+    harness.query(conn, f"CREATE DATABASE `{DB}`")
+    harness.query(conn, f"CREATE TABLE `{DB}`.`t` (id INT PRIMARY KEY)")
+
+    failures = 0
+    capture = [{DB: {'capture_dml': True, 'capture_ddl': False,
+                     'tables': [{'t': {'primary_key': ['id'], 'columns': ['*']}}]}}]
+    out = os.path.join(tempfile.mkdtemp(prefix='watermark_test_'), 'events.jsonl')
+    publisher = {
+        'name': 'file',
+        'active': True,
+        'library_path': f"{args.lib_dir}/file_publisher.so",
+        'watermarks': True,
+        'config': {'file_path': out, 'flush_every_event': 1},
+    }
+    with harness.Streamer(args, capture, [publisher], watermark={'interval_ms': 500}):
+        harness.query(conn, f"INSERT INTO `{DB}`.`t` VALUES (1)")
+        written = int(time.time())
+        time.sleep(IDLE_SEC)
+
+    marks = watermarks(out)
+    if not marks:
+        harness.report("watermarks written", False, out)
+        return 1
+    # Those after the row: at its end position
+    idle = [m for m in marks if m.get('idle') and m['position'] == marks[-1]['position']]
+    failures += harness.report("idle watermarks sent on heartbeats", len(idle) >= 2,
+                               f"{len(marks)} watermark(s), {len(idle)} idle")
+    if len(idle) >= 2:
+        moved = idle[-1]['timestamp'] - idle[0]['timestamp']
+        failures += harness.report("idle watermark timestamp moves with the idle time",
+                                   moved >= IDLE_SEC // 2, f"moved {moved} s")
+        failures += harness.report("idle watermark starts from the last event time",
+                                   abs(idle[0]['timestamp'] - written) <= 2,
+                                   f"first idle {idle[0]['timestamp']}, row written {written}")
+    ts = [m['timestamp'] for m in marks]
+    failures += harness.report("watermark timestamps never go backwards",
+                               ts == sorted(ts), ts)
+
+    return 1 if failures else 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())